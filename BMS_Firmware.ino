@@ -8,7 +8,6 @@
  * REQUIRED LIBRARIES (install via Library Manager):
  *   - Adafruit INA219            (current sensor)
  *   - DHT sensor library         (temperature)
- *   - ArduinoJson                (WiFi geolocation JSON parsing)
  *   - TinyGPS++                  (optional – only if hardware GPS wired)
  *   - hd44780                    (LCD I2C)
  *   - Preferences                (ESP32 NVS – built-in)
@@ -18,6 +17,7 @@
 #include <Arduino.h>
 
 #include "config.h"
+#include "logger.h"
 #include "system.h"
 #include "voltage.h"
 #include "current.h"
@@ -29,6 +29,15 @@
 #include "nvs_logger.h"
 #include "lcd.h"
 #include "wifi_cloud.h"
+#include "gsm_sms.h"
+#include "telegram.h"
+#include "loop_profiler.h"
+#include "telemetry_stream.h"
+#include "actuator.h"
+
+#if ENABLE_BENCHMARKS
+  #include "bench.h"
+#endif
 
 #if ENABLE_GEOLOCATION
   #include "gps.h"
@@ -38,11 +47,60 @@
   #include "accelerometer.h"
 #endif
 
+#if ENABLE_OFFLINE_QUEUE
+  #include "telemetry_queue.h"
+#endif
+
+#if ENABLE_MQTT
+  #include "mqtt_client.h"
+#endif
+
+#if ENABLE_HEAP_GUARD
+  #include "heap_guard.h"
+#endif
+
+#if ENABLE_RANGE_ESTIMATOR
+  #include "range.h"
+#endif
+
+#if ENABLE_BLACKBOX
+  #include "blackbox.h"
+#endif
+
+#if ENABLE_TSDB
+  #include "tsdb.h"
+#endif
+
+#if ENABLE_ROLLUPS
+  #include "rollup.h"
+#endif
+
+#if ENABLE_SNAPSHOT
+  #include "snapshot.h"
+#endif
+
+#if ENABLE_PARKING
+  #include "parking.h"
+#endif
+
+#if ENABLE_ADAPTIVE_SAMPLING
+  #include "sampler.h"
+#endif
+
+#if ENABLE_INRUSH_CAPTURE
+  #include "inrush.h"
+#endif
+
+#if ENABLE_PRECHARGE
+  #include "precharge.h"
+#endif
+
 /* ──────────────────────────────────────────────────────────────
    TIMING
    ────────────────────────────────────────────────────────────── */
 
 #define LOOP_INTERVAL_MS       100UL   // main loop cadence (100 ms)
+#define LOOP_IDLE_INTERVAL_MS 1000UL   // cadence while the sampler is idle
 #define TELEMETRY_INTERVAL_MS 2000UL   // serial print cadence
 #define WATCHDOG_INTERVAL_MS 30000UL   // reboot if loop stalls
 
@@ -55,15 +113,26 @@ static unsigned long lastWatchdog      = 0;
    ────────────────────────────────────────────────────────────── */
 
 void setup() {
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER_SIZE);   // interrupt-driven TX, must precede begin()
   Serial.begin(115200);
-  delay(500);
+  logInit();
+#if ENABLE_PARKING
+  bool fromPark = parkingBoot();   // timer wake with nothing to do: back to sleep here
+#else
+  bool fromPark = false;
+#endif
+  if (!fromPark) delay(500);
+
+#if ENABLE_BENCHMARKS
+  runBenchmarks();   // benchmark build – never returns
+#endif
 
   printSystemBanner();
 
   /* ── 1. Sensor calibration reads (voltage first – needed for SOC init) ── */
   initVoltage();
   float bootVoltage = readPackVoltage();
-  Serial.printf("[BOOT] Pack voltage at startup: %.2f V\n", bootVoltage);
+  LOGI("BOOT", "Pack voltage at startup: %.2f V", bootVoltage);
 
   initCurrent();
   initTemperature();
@@ -72,14 +141,28 @@ void setup() {
   initializeAllSystems(bootVoltage);
 
   /* ── 3. Post-init diagnostics ── */
-  delay(1000);   // let GPS/GSM settle
+  if (!fromPark) delay(1000);   // let GPS/GSM settle
   performSystemDiagnostics();
+  profilerInit();
+#if ENABLE_INRUSH_CAPTURE
+  inrushInit();        // learned envelope, before the sampler feeds it
+#endif
+#if ENABLE_ADAPTIVE_SAMPLING
+  samplerInit();       // shares Wire / the ADC with loop() from here on
+#endif
 
   lastLoopTime      = millis();
   lastTelemetryTime = millis();
   lastWatchdog      = millis();
 
-  Serial.println("[BOOT] Setup complete – entering monitoring loop\n");
+  LOGI("BOOT", "Setup complete – entering monitoring loop");
+#if ENABLE_PARKING
+  parkingBootDone();   // release relay outputs held through deep sleep
+#endif
+
+#if ENABLE_HEAP_GUARD
+  heapGuardArm();      // from here on: no net heap growth
+#endif
 }
 
 /* ──────────────────────────────────────────────────────────────
@@ -90,27 +173,58 @@ void loop() {
 
   unsigned long now = millis();
 
-  /* ── Enforce fixed loop cadence ── */
+  /* ── Enforce loop cadence (decimated while the pack is idle) ── */
+#if ENABLE_ADAPTIVE_SAMPLING
+  unsigned long interval = samplerIdle() ? LOOP_IDLE_INTERVAL_MS : LOOP_INTERVAL_MS;
+#else
+  unsigned long interval = LOOP_INTERVAL_MS;
+#endif
   unsigned long elapsed = now - lastLoopTime;
-  if (elapsed < LOOP_INTERVAL_MS) {
-    delay(LOOP_INTERVAL_MS - elapsed);
+  if (elapsed < interval) {
+#if ENABLE_ADAPTIVE_SAMPLING
+    samplerWait(interval - elapsed);   // returns early when the pack wakes up
+#else
+    delay(interval - elapsed);
+#endif
     return;
   }
-  unsigned long dtMs = elapsed;   // actual elapsed (may be slightly > 100 ms)
+  unsigned long dtMs = elapsed;   // actual elapsed (may be slightly > interval)
+
+  /* A 1 s wait cut short by the sampler is not a deadline miss */
+  static unsigned long prevInterval = LOOP_INTERVAL_MS;
+  unsigned long budgetMs = max(interval, prevInterval);
+  prevInterval = interval;
   lastLoopTime = millis();
+  profilerBeginLoop();
 
   /* ── Watchdog pet ── */
   lastWatchdog = millis();
 
+  /* ── Serial console (profiler dump etc.) ── */
+  handleSerialCommands();
+
   /* ── WiFi keep-alive ── */
   wifiEnsure();
+#if ENABLE_MQTT
+  mqttLoop();          // broker session, incoming commands, PUBACKs
+#endif
+  gsmLoop();           // AT replies, URCs, queued SMS
+  telegramService();   // alert held while the link was down
+  profilerMark(STAGE_WIFI);
 
   /* ══════════════════════════════════════════════════════════
      STEP 1 – CONTINUOUS SENSING
      ══════════════════════════════════════════════════════════ */
 
   float        packVoltage = readPackVoltage();
+#if ENABLE_ADAPTIVE_SAMPLING
+  SamplerWindow win        = samplerTake();
+  CurrentData  iData       = classifyCurrent(win.current, win.avgPowerW);
+  float        avgCurrent  = win.avgCurrent;   // ∫I·dt / dt over the window, any rate
+#else
   CurrentData  iData       = readCurrentData();
+  float        avgCurrent  = iData.current;
+#endif
   float        temperature = readPackTemperature();
 
   /* For 3S pack, estimate per-cell values from pack voltage */
@@ -118,6 +232,7 @@ void loop() {
   float cellMin    = cellAvg;   // single sensor → treat avg as min/max
   float cellMax    = cellAvg;
   float cellImbal  = 0.0f;      // individual cell monitoring not wired – use 0
+  profilerMark(STAGE_SENSING);
 
   /* ══════════════════════════════════════════════════════════
      STEP 2 – EDGE PROCESSING (moving average + anomaly score)
@@ -128,7 +243,8 @@ void loop() {
                                             temperature);
 
   if (edge.anomalyDetected)
-    Serial.printf("[EDGE] Anomaly score=%u – monitoring\n", edge.anomalyScore);
+    LOGW("EDGE", "Anomaly score=%u – monitoring", edge.anomalyScore);
+  profilerMark(STAGE_EDGE);
 
   /* ══════════════════════════════════════════════════════════
      STEP 3 – BATTERY INTELLIGENCE  (SOC / SOH / RUL)
@@ -137,7 +253,7 @@ void loop() {
   bool fault = isFaulted();
 
   updateSystemHealth(
-    iData.current,
+    avgCurrent,
     packVoltage,
     fault,
     temperature,
@@ -146,22 +262,59 @@ void loop() {
   );
 
   float soc = getSOC();
+#if ENABLE_SNAPSHOT
+  snapshotService();   // SOC + SOH record every SNAPSHOT_INTERVAL_MS
+#endif
+
+#if ENABLE_RANGE_ESTIMATOR
+  float speedKmh = 0.0f;
+#if ENABLE_GEOLOCATION
+  GPSData gps = getGPSData();
+  if (gps.valid) speedKmh = gps.speed;
+#endif
+  /* Signed (+ = discharge) so regen earns energy back – the INA219
+     power register, and so iData.powerWatts, is a magnitude        */
+  rangeUpdate(packVoltage * avgCurrent, speedKmh, dtMs);
+#endif
+  profilerMark(STAGE_HEALTH);
 
   /* ══════════════════════════════════════════════════════════
      STEP 4 – PROTECTION LOGIC
      ══════════════════════════════════════════════════════════ */
 
+#if ENABLE_INRUSH_CAPTURE
+  /* ── Motor inrush: the sampler checks every start against the learned
+        envelope at the burst rate, so nothing is blanked.  Only UV is
+        judged on the voltage from before the relay closed – the sag is
+        the inrush itself.                                              ── */
+  inrushService();     // latch an envelope trip, learn a finished start
+  const bool blanking       = false;
+  bool       capturing      = inrushActive();
+  float      protectV       = capturing ? inrushStartVoltage() : packVoltage;
+  float      protectCellMin = capturing ? protectV / (float)NUM_CELLS : cellMin;
+#elif ENABLE_PRECHARGE
+  /* ── The main relay closes onto a pre-charged bus: no capacitor
+        inrush, nothing to blank.                                 ── */
+  const bool blanking       = false;
+  float      protectV       = packVoltage;
+  float      protectCellMin = cellMin;
+#else
   /* ── Skip fault evaluation + current logic during motor inrush (500 ms) ── */
+  static bool wasBlanking = false;
   bool blanking = isMotorStartBlanking();
-  if (blanking) {
-    Serial.println("[BLANK] Motor inrush – skipping fault eval");
+  if (blanking && !wasBlanking) {
+    LOGD("BLANK", "Motor inrush – skipping fault eval");
   }
+  wasBlanking = blanking;
+  float protectV       = packVoltage;
+  float protectCellMin = cellMin;
+#endif
 
   /* Electrical + thermal protection (skip during motor inrush) */
   if (!blanking) {
     evaluateSystemFaults(
-      packVoltage,
-      cellMin,
+      protectV,
+      protectCellMin,
       cellMax,
       cellImbal,
       iData.current,
@@ -171,6 +324,10 @@ void loop() {
     );
   }
 
+#if ENABLE_GEOLOCATION
+  updateGPS();         // NMEA drain; WiFi-geo scan completes in the background
+#endif
+
   /* GPS / Impact external events */
   checkExternalEvents();
 
@@ -191,12 +348,18 @@ void loop() {
   if (needsReplacement() && !isFaultActive(FAULT_BATTERY_AGING))
     triggerExternalFault(FAULT_BATTERY_AGING, "BATTERY AGING");
 
+#if ENABLE_BLACKBOX
+  recordBlackbox(packVoltage, iData, temperature, soc);
+  blackboxService();   // post-trigger flush to flash, serial dump
+#endif
+  profilerMark(STAGE_PROTECTION);
+
   /* ══════════════════════════════════════════════════════════
      STEP 5 – RELAY / ACTUATOR CONTROL
      ══════════════════════════════════════════════════════════ */
 
   /* Charging interlock (also handles motor relay during charge) */
-  controlCharging(packVoltage, fault);
+  controlCharging(packVoltage, iData.current, temperature, fault);
 
   /* Motor relay – driven purely by live current, never relay state */
   controlMotorRelay(fault, iData.current);
@@ -207,6 +370,15 @@ void loop() {
   /* Thermal management */
   controlThermalManagement(temperature, fault);
 
+#if ENABLE_PRECHARGE
+  /* Motor wanted → charge the bus first; releases the main relay when ready */
+  prechargeUpdate(packVoltage, iData.current);
+#endif
+
+  /* Merge the relay votes above; GPIO written only on change */
+  actuatorApply();
+  profilerMark(STAGE_RELAYS);
+
   /* ══════════════════════════════════════════════════════════
      STEP 6 – DISPLAY  (LCD)
      ══════════════════════════════════════════════════════════ */
@@ -225,21 +397,50 @@ void loop() {
     isFanActive()
   );
 #endif
+  profilerMark(STAGE_DISPLAY);
 
   /* ══════════════════════════════════════════════════════════
-     STEP 7 – SERIAL TELEMETRY  (every 2 s)
+     STEP 7 – SERIAL TELEMETRY  (binary stream + text every 2 s on demand)
      ══════════════════════════════════════════════════════════ */
 
-  if (millis() - lastTelemetryTime >= TELEMETRY_INTERVAL_MS) {
+  telemetryStreamUpdate(packVoltage, iData, temperature, soc, fault);
+#if ENABLE_MQTT
+  mqttStreamUpdate(packVoltage, iData, temperature, soc, fault);
+#endif
+#if ENABLE_TSDB
+  tsdbUpdate(packVoltage, iData.current, temperature, soc);   // on-flash history
+#endif
+#if ENABLE_ROLLUPS
+  rollupUpdate(packVoltage, iData.current, temperature, soc, iData.powerWatts, dtMs);
+#endif
+
+  if (telemetryTextEnabled() &&
+      millis() - lastTelemetryTime >= TELEMETRY_INTERVAL_MS) {
     displayTelemetry(packVoltage, iData, temperature, soc, fault);
     lastTelemetryTime = millis();
   }
+  profilerMark(STAGE_SERIAL);
 
   /* ══════════════════════════════════════════════════════════
      STEP 8 – CLOUD UPLOAD  (throttled inside uploadSystemData)
+              + paced replay of the offline backlog
      ══════════════════════════════════════════════════════════ */
 
 #if ENABLE_CLOUD_DASHBOARD
   uploadSystemData(packVoltage, iData, temperature, soc, fault);
 #endif
+#if ENABLE_CLOUD_DASHBOARD && ENABLE_OFFLINE_QUEUE
+  telemetryQueueService();
+#endif
+  profilerMark(STAGE_CLOUD);
+
+#if ENABLE_HEAP_GUARD
+  heapGuardCheck();
+#endif
+
+  profilerEndLoop(dtMs, budgetMs);
+
+#if ENABLE_PARKING
+  parkingUpdate(iData.current);   // after a full pass – may sleep
+#endif
 }
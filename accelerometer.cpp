@@ -1,5 +1,7 @@
 #include "accelerometer.h"
 #include "config.h"
+#include "logger.h"
+#include "bus_lock.h"
 #include <Wire.h>
 #include <math.h>
 #include <string.h>
@@ -8,7 +10,16 @@
 
 #define MPU_ADDR          0x68
 #define REG_PWR_MGMT_1    0x6B
+#define REG_PWR_MGMT_2    0x6C
 #define REG_ACCEL_XOUT_H  0x3B
+#define REG_ACCEL_CONFIG  0x1C
+#define REG_MOT_THR       0x1F
+#define REG_MOT_DUR       0x20
+#define REG_INT_PIN_CFG   0x37
+#define REG_INT_ENABLE    0x38
+#define REG_INT_STATUS    0x3A
+
+#define MOT_THR_G_PER_LSB 0.002f  // motion threshold register: 2 mg / LSB
 
 /* ================= Detection Thresholds ================= */
 
@@ -33,19 +44,36 @@ static uint32_t shockCount    = 0;
 
 /* ================= Low-level I2C ================= */
 
+/* Each access holds the shared Wire bus (the sampler reads the INA219) */
 static void writeReg(uint8_t reg, uint8_t val) {
+  busLock(BUS_I2C);
   Wire.beginTransmission(MPU_ADDR);
   Wire.write(reg);
   Wire.write(val);
   Wire.endTransmission();
+  busUnlock(BUS_I2C);
+}
+
+static uint8_t read8(uint8_t reg) {
+  busLock(BUS_I2C);
+  Wire.beginTransmission(MPU_ADDR);
+  Wire.write(reg);
+  Wire.endTransmission(false);
+  Wire.requestFrom(MPU_ADDR, (uint8_t)1);
+  uint8_t v = (uint8_t)Wire.read();
+  busUnlock(BUS_I2C);
+  return v;
 }
 
 static int16_t read16(uint8_t reg) {
+  busLock(BUS_I2C);
   Wire.beginTransmission(MPU_ADDR);
   Wire.write(reg);
   Wire.endTransmission(false);
   Wire.requestFrom(MPU_ADDR, (uint8_t)2);
-  return (int16_t)((Wire.read() << 8) | Wire.read());
+  int16_t v = (int16_t)((Wire.read() << 8) | Wire.read());
+  busUnlock(BUS_I2C);
+  return v;
 }
 
 /* ================= Init ================= */
@@ -53,18 +81,54 @@ static int16_t read16(uint8_t reg) {
 void initAccelerometer() {
   if (initialized) return;
 
-  Serial.println("[ACCEL] Initializing MPU6050");
+  LOGI("ACCEL", "Initializing MPU6050");
 
   Wire.begin(ACCEL_SDA, ACCEL_SCL);
   Wire.setClock(400000);
 
   writeReg(REG_PWR_MGMT_1, 0x00);  // wake up, use internal 8 MHz oscillator
   delay(100);
+  accelDisarmMotionWake();          // may still be in parking's cycle mode
 
   memset(&currentData, 0, sizeof(currentData));
   initialized = true;
 
-  Serial.println("[ACCEL] MPU6050 ready");
+  LOGI("ACCEL", "MPU6050 ready");
+}
+
+/* ================= Wake-on-Motion (parking) ================= */
+
+/*
+ * MPU6050 low-power accelerometer mode: gyros in standby, temperature
+ * sensor off, one accel sample at 5 Hz (~10 µA).  Any axis moving by
+ * more than the threshold (after the high-pass filter) raises INT,
+ * latched until INT_STATUS is read.
+ */
+void accelArmMotionWake(float thresholdG) {
+  if (!initialized) initAccelerometer();
+
+  int thr = (int)(thresholdG / MOT_THR_G_PER_LSB + 0.5f);
+  if (thr < 1)   thr = 1;
+  if (thr > 255) thr = 255;
+
+  writeReg(REG_ACCEL_CONFIG, 0x01);       // ±2 g, DHPF 5 Hz
+  writeReg(REG_MOT_THR,      (uint8_t)thr);
+  writeReg(REG_MOT_DUR,      1);          // 1 ms above threshold
+  writeReg(REG_INT_PIN_CFG,  0x20);       // active high, push-pull, latched
+  writeReg(REG_INT_ENABLE,   0x40);       // motion interrupt only
+  read8(REG_INT_STATUS);                  // drop anything already latched
+  writeReg(REG_PWR_MGMT_2,   0x47);       // LP_WAKE 5 Hz, gyros standby
+  writeReg(REG_PWR_MGMT_1,   0x28);       // CYCLE, TEMP_DIS
+
+  LOGD("ACCEL", "Wake-on-motion armed (%.2fg, MOT_THR=%d)", thresholdG, thr);
+}
+
+void accelDisarmMotionWake() {
+  writeReg(REG_PWR_MGMT_1,   0x00);
+  writeReg(REG_PWR_MGMT_2,   0x00);
+  writeReg(REG_INT_ENABLE,   0x00);
+  writeReg(REG_ACCEL_CONFIG, 0x00);
+  read8(REG_INT_STATUS);                  // release a latched INT
 }
 
 /* ================= Read (single authoritative call) ================= */
@@ -101,7 +165,7 @@ AccelData readAccelerometer() {
       inFreeFall   = true;
       freeFallTime = now;
       currentData.freeFallDetected = true;
-      Serial.println("[ACCEL] FREE FALL detected");
+      LOGW("ACCEL", "FREE FALL detected");
     }
   } else {
     freeFallCount = 0;
@@ -116,8 +180,8 @@ AccelData readAccelerometer() {
     impactCount++;
     inFreeFall    = false;
     freeFallCount = 0;
-    Serial.printf("[ACCEL] IMPACT detected (mag=%.2fg, total=%u)\n",
-                  currentData.magnitude, impactCount);
+    LOGW("ACCEL", "IMPACT detected (mag=%.2fg, total=%u)",
+         currentData.magnitude, impactCount);
   }
 
   /* ── SHOCK (high-g any time) ── */
@@ -126,8 +190,8 @@ AccelData readAccelerometer() {
     shockCount++;
     inFreeFall    = false;
     freeFallCount = 0;
-    Serial.printf("[ACCEL] SHOCK detected (mag=%.2fg, total=%u)\n",
-                  currentData.magnitude, shockCount);
+    LOGW("ACCEL", "SHOCK detected (mag=%.2fg, total=%u)",
+         currentData.magnitude, shockCount);
   }
 
   /* ── Free-fall timeout (no impact arrived) ── */
@@ -148,6 +212,7 @@ float getAccelMagnitude(float x, float y, float z) {
   return sqrtf(x * x + y * y + z * z);
 }
 
+AccelData getAccelData()   { return currentData; }
 uint32_t getImpactCount()  { return impactCount; }
 uint32_t getShockCount()   { return shockCount;  }
 
@@ -22,6 +22,9 @@ struct AccelData {
 void initAccelerometer();
 AccelData readAccelerometer();
 
+/** Last readAccelerometer() result, no I2C traffic. */
+AccelData getAccelData();
+
 float getAccelMagnitude(float x, float y, float z);
 
 bool checkImpact();
@@ -33,4 +36,13 @@ uint32_t getShockCount();
 void resetImpactCounters();
 
 bool accelerometerHealthy();
+
+/**
+ * Low-power cycle mode with the motion interrupt on the INT pin
+ * (ACCEL_INT_PIN) – for waking the ESP32 while parked.
+ */
+void accelArmMotionWake(float thresholdG);
+
+/** Back to normal sampling, INT off.  initAccelerometer() calls this. */
+void accelDisarmMotionWake();
 float getTiltAngle(const AccelData& data);
@@ -0,0 +1,258 @@
+#include "actuator.h"
+#include "config.h"
+#include "logger.h"
+#include <Preferences.h>
+#include <string.h>
+#if ENABLE_ADAPTIVE_SAMPLING
+  #include "sampler.h"
+#endif
+#if ENABLE_INRUSH_CAPTURE
+  #include "inrush.h"
+#endif
+#if ENABLE_PRECHARGE
+  #include "precharge.h"
+#endif
+
+/* ================= State ================= */
+
+static const uint8_t  relayPin[ACT_RELAYS] = {
+  CHARGE_RELAY_PIN, LOAD_MOTOR_RELAY_PIN, COOLING_FAN_RELAY_PIN, PRECHARGE_RELAY_PIN
+};
+static const uint32_t minOnMs[ACT_RELAYS]  = {
+  CHARGE_RELAY_MIN_ON_MS, MOTOR_RELAY_MIN_ON_MS, FAN_RELAY_MIN_ON_MS, 0
+};
+static const uint32_t minOffMs[ACT_RELAYS] = {
+  CHARGE_RELAY_MIN_OFF_MS, MOTOR_RELAY_MIN_OFF_MS, FAN_RELAY_MIN_OFF_MS, 0
+};
+
+static ActCmd     votes[ACT_RELAYS][ACT_SRC_COUNT];
+static RelayStats relays[ACT_RELAYS];
+static bool       pending[ACT_RELAYS];      // a deferred change is waiting
+static uint32_t   savedOps = 0;             // total ops at the last NVS save
+
+/* The sampler task may open the motor relay (actuatorForceOff) */
+static portMUX_TYPE actLock = portMUX_INITIALIZER_UNLOCKED;
+
+static Preferences prefs;
+
+/* ================= Helpers ================= */
+
+static uint32_t totalOps() {
+  uint32_t n = 0;
+  for (uint8_t r = 0; r < ACT_RELAYS; r++) n += relays[r].ops;
+  return n;
+}
+
+static void saveLifetime() {
+  uint32_t life[ACT_RELAYS];
+  for (uint8_t r = 0; r < ACT_RELAYS; r++) life[r] = relays[r].lifetimeOps;
+  prefs.begin("relays", false);
+  prefs.putBytes("ops", life, sizeof(life));
+  prefs.end();
+  savedOps = totalOps();
+}
+
+/* Highest-priority opinion; nobody asking = open.  The pre-charge
+   path feeds the motor bus: a safety vote opening the motor opens it too. */
+static bool merged(ActRelay r, ActSource* src) {
+  for (uint8_t s = 0; s < ACT_SRC_COUNT; s++) {
+    ActCmd c = votes[r][s];
+    if (r == ACT_PRECHARGE && s < ACT_SRC_CONTROL && votes[ACT_MOTOR][s] == ACT_OFF) c = ACT_OFF;
+    if (c != ACT_NONE) {
+      *src = (ActSource)s;
+      return c == ACT_ON;
+    }
+  }
+  *src = ACT_SRC_CONTROL;
+  return false;
+}
+
+/* Pin + cache + counters.  Caller holds actLock. */
+static void drive(ActRelay r, bool on, ActSource src, uint32_t now) {
+  RelayStats& s = relays[r];
+  digitalWrite(relayPin[r], on ? HIGH : LOW);
+  if (s.on && s.lastChangeMs) s.onMs += now - s.lastChangeMs;
+  s.on           = on;
+  s.owner        = src;
+  s.lastChangeMs = now ? now : 1;           // 0 = never switched
+  s.ops++;
+  s.lifetimeOps++;
+  pending[r] = false;
+}
+
+/* A relay edge is a current transient: sample it at the burst rate.
+   A closing motor relay is a motor start for the inrush capture.    */
+static void onEdge(ActRelay r, bool on, ActSource src) {
+#if ENABLE_ADAPTIVE_SAMPLING
+  samplerTrigger(SAMPLE_TRIG_RELAY);
+#endif
+#if ENABLE_INRUSH_CAPTURE
+  if (r == ACT_MOTOR) {
+    if (on) inrushStart();
+    else    inrushAbort();
+  }
+#endif
+  LOGI("RELAY", "%s %s (%s)", actRelayName(r), on ? "ON" : "OFF", actSourceName(src));
+}
+
+static void applyRelay(ActRelay r, uint32_t now) {
+  ActSource src;
+  bool      want = merged(r, &src);
+  bool      safety = src < ACT_SRC_CONTROL;
+
+  portENTER_CRITICAL(&actLock);
+  RelayStats& s = relays[r];
+  if (want == s.on) {
+    s.skipped++;
+    pending[r] = false;
+    portEXIT_CRITICAL(&actLock);
+    return;
+  }
+  /* Minimum on / off time – control changes only, never a safety OFF */
+  uint32_t minMs = s.on ? minOnMs[r] : minOffMs[r];
+  if (!safety && s.lastChangeMs && now - s.lastChangeMs < minMs) {
+    if (!pending[r]) s.deferred++;
+    pending[r] = true;
+    portEXIT_CRITICAL(&actLock);
+    return;
+  }
+#if ENABLE_PRECHARGE
+  /* The main motor relay closes onto a pre-charged bus only */
+  if (r == ACT_MOTOR && want && !prechargeReady()) {
+    portEXIT_CRITICAL(&actLock);
+    return;
+  }
+#endif
+  drive(r, want, src, now);
+  portEXIT_CRITICAL(&actLock);
+
+  onEdge(r, want, src);
+}
+
+/* ================= API ================= */
+
+void actuatorInit() {
+  memset(votes,   0, sizeof(votes));
+  memset(relays,  0, sizeof(relays));
+  memset(pending, 0, sizeof(pending));
+
+  for (uint8_t r = 0; r < ACT_RELAYS; r++) {
+    pinMode(relayPin[r], OUTPUT);
+    digitalWrite(relayPin[r], LOW);
+    relays[r].owner = ACT_SRC_CONTROL;
+  }
+
+  /* A shorter blob is from a build with fewer relays: keep its counts */
+  uint32_t life[ACT_RELAYS] = {};
+  prefs.begin("relays", true);
+  size_t len = prefs.getBytesLength("ops");
+  if (len && len <= sizeof(life) && len % sizeof(uint32_t) == 0)
+    prefs.getBytes("ops", life, len);
+  prefs.end();
+  for (uint8_t r = 0; r < ACT_RELAYS; r++) relays[r].lifetimeOps = life[r];
+
+  LOGI("RELAY", "Actuators ready – lifetime ops chg/motor/fan/pre %lu/%lu/%lu/%lu",
+       (unsigned long)life[ACT_CHARGE], (unsigned long)life[ACT_MOTOR],
+       (unsigned long)life[ACT_FAN], (unsigned long)life[ACT_PRECHARGE]);
+}
+
+void actuatorRequest(ActRelay r, ActSource src, ActCmd cmd) {
+  if (r >= ACT_RELAYS || src >= ACT_SRC_COUNT) return;
+  portENTER_CRITICAL(&actLock);
+  votes[r][src] = cmd;
+  portEXIT_CRITICAL(&actLock);
+
+  /* Protection does not wait for the end of the loop */
+  if (src < ACT_SRC_CONTROL && cmd == ACT_OFF) {
+    applyRelay(r, millis());
+    if (r == ACT_MOTOR) applyRelay(ACT_PRECHARGE, millis());
+  }
+}
+
+void actuatorApply() {
+  uint32_t now = millis();
+  for (uint8_t r = 0; r < ACT_RELAYS; r++) applyRelay((ActRelay)r, now);
+
+  if (totalOps() - savedOps >= RELAY_OPS_SAVE_EVERY) saveLifetime();
+}
+
+void actuatorForceOff(ActRelay r) {
+  if (r >= ACT_RELAYS) return;
+  portENTER_CRITICAL(&actLock);
+  votes[r][ACT_SRC_INRUSH] = ACT_OFF;
+  if (relays[r].on) drive(r, false, ACT_SRC_INRUSH, millis());
+  if (r == ACT_MOTOR && relays[ACT_PRECHARGE].on)
+    drive(ACT_PRECHARGE, false, ACT_SRC_INRUSH, millis());
+  portEXIT_CRITICAL(&actLock);
+}
+
+void actuatorPark() {
+  static const ActRelay parked[] = { ACT_CHARGE, ACT_MOTOR, ACT_PRECHARGE };
+  uint32_t now = millis();
+  for (ActRelay r : parked) {
+    portENTER_CRITICAL(&actLock);
+    votes[r][ACT_SRC_CONTROL] = ACT_OFF;
+    bool edge = relays[r].on;
+    if (edge) drive(r, false, ACT_SRC_CONTROL, now);
+    portEXIT_CRITICAL(&actLock);
+    if (edge) onEdge(r, false, ACT_SRC_CONTROL);
+  }
+  if (totalOps() != savedOps) saveLifetime();   // RAM counts do not survive deep sleep
+}
+
+void actuatorAssume(ActRelay r, bool on) {
+  if (r >= ACT_RELAYS) return;
+  portENTER_CRITICAL(&actLock);
+  relays[r].on           = on;
+  relays[r].lastChangeMs = millis() | 1;
+  portEXIT_CRITICAL(&actLock);
+}
+
+void actuatorResync() {
+  portENTER_CRITICAL(&actLock);
+  for (uint8_t r = 0; r < ACT_RELAYS; r++)
+    digitalWrite(relayPin[r], relays[r].on ? HIGH : LOW);
+  portEXIT_CRITICAL(&actLock);
+}
+
+bool actuatorWanted(ActRelay r) {
+  if (r >= ACT_RELAYS) return false;
+  ActSource src;
+  portENTER_CRITICAL(&actLock);
+  bool want = merged(r, &src);
+  portEXIT_CRITICAL(&actLock);
+  return want;
+}
+
+bool     actuatorState(ActRelay r)     { return r < ACT_RELAYS && relays[r].on; }
+uint32_t actuatorChangedAt(ActRelay r) { return r < ACT_RELAYS ? relays[r].lastChangeMs : 0; }
+
+RelayStats actuatorGetStats(ActRelay r) {
+  RelayStats s = {};
+  if (r >= ACT_RELAYS) return s;
+  portENTER_CRITICAL(&actLock);
+  s = relays[r];
+  portEXIT_CRITICAL(&actLock);
+  if (s.on && s.lastChangeMs) s.onMs += millis() - s.lastChangeMs;
+  return s;
+}
+
+const char* actRelayName(ActRelay r) {
+  switch (r) {
+    case ACT_CHARGE:    return "CHARGE";
+    case ACT_MOTOR:     return "MOTOR";
+    case ACT_FAN:       return "FAN";
+    case ACT_PRECHARGE: return "PRECHG";
+    default:            return "?";
+  }
+}
+
+const char* actSourceName(ActSource s) {
+  switch (s) {
+    case ACT_SRC_FAULT:   return "fault";
+    case ACT_SRC_THERMAL: return "thermal";
+    case ACT_SRC_INRUSH:  return "inrush";
+    case ACT_SRC_CONTROL: return "control";
+    default:              return "?";
+  }
+}
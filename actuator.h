@@ -0,0 +1,105 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Relay Actuator Manager
+ *  Sole owner of the charge, motor, fan and pre-charge relay
+ *  outputs.
+ *  Requesters vote per relay; the highest-priority vote that is
+ *  not ACT_NONE wins (no vote at all = open):
+ *
+ *    ACT_SRC_FAULT    latched fault               (safety)
+ *    ACT_SRC_THERMAL  thermal trip                (safety)
+ *    ACT_SRC_INRUSH   envelope trip, sampler task (safety)
+ *    ACT_SRC_CONTROL  charge / motor / fan control loops
+ *
+ *  actuatorApply() merges the votes once per loop and touches the
+ *  GPIO only when the output changes.  Control changes honour
+ *  a per-relay minimum on / off time; a safety OFF bypasses it and
+ *  is written at once.  Every edge bursts the sampler and, for the
+ *  motor, starts / aborts the inrush capture.
+ *
+ *  With ENABLE_PRECHARGE the motor relay only closes once the
+ *  pre-charge sequence reports the bus ready, and the pre-charge
+ *  relay obeys every safety vote held against the motor.
+ *
+ *  Switching operations are counted per relay; the lifetime count
+ *  (contact wear) is kept in NVS.
+ * ============================================================
+ */
+
+enum ActRelay : uint8_t {
+  ACT_CHARGE = 0,
+  ACT_MOTOR,
+  ACT_FAN,
+  ACT_PRECHARGE,                    // motor bus pre-charge (open without ENABLE_PRECHARGE)
+  ACT_RELAYS
+};
+
+enum ActSource : uint8_t {          // lower value = higher priority
+  ACT_SRC_FAULT = 0,
+  ACT_SRC_THERMAL,
+  ACT_SRC_INRUSH,
+  ACT_SRC_CONTROL,
+  ACT_SRC_COUNT
+};
+
+enum ActCmd : uint8_t {
+  ACT_NONE = 0,                     // no opinion – release
+  ACT_OFF,
+  ACT_ON
+};
+
+struct RelayStats {
+  bool      on;
+  ActSource owner;                  // source that set the current state
+  uint32_t  ops;                    // switching operations since boot
+  uint32_t  lifetimeOps;            // including previous boots (NVS)
+  uint32_t  skipped;                // applies with no change – GPIO untouched
+  uint32_t  deferred;               // changes held back by a minimum on / off time
+  uint32_t  lastChangeMs;
+  uint64_t  onMs;                   // time closed since boot
+};
+
+/** Configure the relay pins, all open.  First thing in initializeAllSystems(). */
+void actuatorInit();
+
+/** Set this source's vote.  A safety OFF is applied immediately. */
+void actuatorRequest(ActRelay r, ActSource src, ActCmd cmd);
+
+/** Merge the votes and write what changed.  Once per loop, after the controllers. */
+void actuatorApply();
+
+/** Open a relay now from any task (sampler trip); holds an ACT_SRC_INRUSH OFF vote. */
+void actuatorForceOff(ActRelay r);
+
+/**
+ * Deep-sleep parking: open charge, motor and pre-charge now (no
+ * minimum on-time) and save the switch counts.  The fan keeps its
+ * state.  Call before latching the pins with gpio_hold_en().
+ */
+void actuatorPark();
+
+/** Rewrite every cached output to its pin (after GPIO hold / reset). */
+void actuatorResync();
+
+/**
+ * Take outputs held through deep sleep as already driven: cache
+ * only, no edge, no sequencing.  Before actuatorResync().
+ */
+void actuatorAssume(ActRelay r, bool on);
+
+/** Merged vote – what the relay will be driven to, minimum times and sequencing aside. */
+bool actuatorWanted(ActRelay r);
+
+/** Cached output – what the pin was last driven to. */
+bool actuatorState(ActRelay r);
+
+/** millis() of the last edge, 0 if never switched. */
+uint32_t actuatorChangedAt(ActRelay r);
+
+RelayStats actuatorGetStats(ActRelay r);
+
+const char* actRelayName(ActRelay r);
+const char* actSourceName(ActSource s);
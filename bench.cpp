@@ -0,0 +1,447 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+   BENCHMARKS – ns/op, cycles/op and heap use of the firmware's hot routines
+   ─────────────────────────────────────────────────────────────────────────
+   Target: ESP32 CCOUNT cycle counter, heap measured with the IDF local
+           minimum-free-size monitor (transient peak) and free-heap delta.
+           Heap is taken per call in a separate pass after the timed
+           loop, so the monitor does not slow the timing.
+   Host  : std::chrono::steady_clock, no heap figures (test/host: make bench).
+
+   Output (one line per case, grep for "BENCH "):
+     BENCH {"name":"soc_from_voltage","iters":10000,"ns_op":412.5,
+            "cycles_op":99.0,"heap_op_peak":0.0,"heap_op_net":0.0,
+            "platform":"esp32"}
+   ═══════════════════════════════════════════════════════════════════════════ */
+
+#include "bench.h"
+#include "config.h"
+
+#if ENABLE_BENCHMARKS
+
+#include "voltage.h"
+#include "current.h"
+#include "soc.h"
+#include "fault_manager.h"
+#include "wifi_cloud.h"
+#include "telemetry_codec.h"
+#include "charge.h"
+#include "telegram.h"
+#include "accelerometer.h"
+#include "gps.h"
+#include "geofence.h"
+#include "tsdb.h"
+#include "rollup.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_heap_caps.h>
+  #define BENCH_PLATFORM "esp32"
+#else
+  #include <chrono>
+  #define BENCH_PLATFORM "host"
+#endif
+
+/* ═══════════════════════════════════════════
+   CLOCK / HEAP  (platform specific)
+   ═══════════════════════════════════════════ */
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+static uint32_t cpuMHz = 240;
+
+static uint64_t clockStart()              { return ESP.getCycleCount(); }
+static uint64_t clockElapsed(uint64_t t0) { return (uint32_t)(ESP.getCycleCount() - (uint32_t)t0); }
+static float    elapsedToNs(uint64_t cyc) { return (float)cyc * 1000.0f / (float)cpuMHz; }
+
+static void heapMonitorStart() { heap_caps_monitor_local_minimum_free_size_start(); }
+static void heapMonitorStop()  { heap_caps_monitor_local_minimum_free_size_stop();  }
+static int32_t freeHeap()      { return (int32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT); }
+static int32_t localMinHeap()  { return (int32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT); }
+
+#else
+
+static uint64_t clockStart() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static uint64_t clockElapsed(uint64_t t0) { return clockStart() - t0; }
+static float    elapsedToNs(uint64_t ns)  { return (float)ns; }
+
+static void    heapMonitorStart() {}
+static void    heapMonitorStop()  {}
+static int32_t freeHeap()         { return 0; }
+static int32_t localMinHeap()     { return 0; }
+
+#endif
+
+/* ═══════════════════════════════════════════
+   HARNESS
+   ═══════════════════════════════════════════ */
+
+#define BENCH_HEAP_CALLS  16     // calls measured one by one for heap use
+
+static volatile float    sinkF = 0.0f;
+static volatile uint32_t sinkU = 0;
+static uint32_t          benchIter = 0;   // varies inputs between calls
+
+BenchResult benchRun(const char* name, void (*fn)(), uint32_t iterations) {
+  BenchResult r = {};
+  r.name       = name;
+  r.iterations = iterations;
+
+  fn();   // warm-up: caches, lazy init, first-call allocations
+
+  uint64_t t0 = clockStart();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchIter = i;
+    fn();
+  }
+  uint64_t elapsed = clockElapsed(t0);
+
+  r.nsPerOp     = elapsedToNs(elapsed) / (float)iterations;
+#if defined(ARDUINO_ARCH_ESP32)
+  r.cyclesPerOp = (float)elapsed / (float)iterations;
+#endif
+
+  /* Heap, call by call: transient peak and what the call keeps */
+  uint32_t calls   = min(iterations, (uint32_t)BENCH_HEAP_CALLS);
+  int64_t  peakSum = 0;
+  int64_t  netSum  = 0;
+  for (uint32_t i = 0; i < calls; i++) {
+    benchIter = i;
+    int32_t before = freeHeap();
+    heapMonitorStart();
+    fn();
+    int32_t lowest = localMinHeap();
+    heapMonitorStop();
+    peakSum += before - lowest;
+    netSum  += before - freeHeap();
+  }
+  r.heapPeakPerOp = (float)peakSum / (float)calls;
+  r.heapNetPerOp  = (float)netSum  / (float)calls;
+  return r;
+}
+
+void benchPrint(const BenchResult& r) {
+  Serial.printf("BENCH {\"name\":\"%s\",\"iters\":%lu,\"ns_op\":%.1f,"
+                "\"cycles_op\":%.1f,\"heap_op_peak\":%.1f,\"heap_op_net\":%.1f,"
+                "\"platform\":\"%s\",\"fw\":\"%s\"}\n",
+                r.name, (unsigned long)r.iterations, r.nsPerOp, r.cyclesPerOp,
+                r.heapPeakPerOp, r.heapNetPerOp,
+                BENCH_PLATFORM, FIRMWARE_VERSION);
+}
+
+/* ═══════════════════════════════════════════
+   CASES
+   Inputs stay inside the normal operating window so
+   no fault latches (and no alert I/O) during a run.
+   ═══════════════════════════════════════════ */
+
+#if defined(ARDUINO_ARCH_ESP32)
+static void benchReadADC() {
+  sinkF = readPackVoltage();   // 300-sample ADC average inside
+}
+#endif
+
+static void benchSocFromVoltage() {
+  sinkF = estimateSOCFromVoltage(9.5f + (float)(benchIter % 300) * 0.01f);
+}
+
+static void benchUpdateSOC() {
+  updateSOC((benchIter & 1) ? 5.0f : -5.0f, 100);
+  sinkF = getSOC();
+}
+
+static void benchEdgeAnalytics() {
+  EdgeAnalytics e = performEdgeAnalytics(11.4f + (float)(benchIter % 8) * 0.01f,
+                                         4.0f, 28.0f);
+  sinkU = e.anomalyScore;
+}
+
+static void benchEvaluateFaults() {
+  evaluateSystemFaults(11.4f, 3.8f, 3.8f, 0.0f, 4.0f, false, 28.0f, 28.0f);
+  sinkU = isFaulted();
+}
+
+static TelemetrySnapshot benchSnap;
+
+static void benchTelemetryJson() {
+  char body[1024];
+  benchSnap.uptimeMs = benchIter;
+  sinkU = formatTelemetryJson(benchSnap, body, sizeof(body));
+}
+
+/* 20-sample batch: JSON array (replay path) vs CBOR delta batch */
+#define BENCH_BATCH  20
+static uint8_t batchBuf[BENCH_BATCH * 1024];
+
+static void varySnap(TelemetrySnapshot& s, uint32_t i) {
+  s.uptimeMs    = 600000UL + i * CLOUD_UPLOAD_INTERVAL_MS;
+  s.packVoltage = 11.42f - (float)(i % 7) * 0.003f;
+  s.current     = 4.37f  + (float)(i % 5) * 0.02f;
+  s.power       = s.packVoltage * s.current;
+  s.soc         = 63.4f  - (float)i * 0.01f;
+}
+
+static size_t encodeJsonBatch() {
+  TelemetrySnapshot s = benchSnap;
+  size_t len = 0;
+  batchBuf[len++] = '[';
+  for (uint32_t i = 0; i < BENCH_BATCH; i++) {
+    varySnap(s, i);
+    if (i) batchBuf[len++] = ',';
+    len += formatTelemetryJson(s, (char*)&batchBuf[len], sizeof(batchBuf) - len - 1);
+  }
+  batchBuf[len++] = ']';
+  return len;
+}
+
+static size_t encodeCborBatch(uint32_t samples) {
+  TelemetrySnapshot s = benchSnap;
+  CborBufferSink   sink = { batchBuf, sizeof(batchBuf), 0 };
+  CborWriter       w;
+  TelemetryEncoder enc;
+  cborBegin(w, cborSinkBuffer, &sink);
+  telemetryEncodeBegin(enc, w);
+  for (uint32_t i = 0; i < samples; i++) {
+    varySnap(s, i);
+    telemetryEncodeSample(enc, s);
+  }
+  telemetryEncodeEnd(enc);
+  return sink.len;
+}
+
+static void benchJsonBatch()     { sinkU = encodeJsonBatch(); }
+static void benchCborSingle()    { sinkU = encodeCborBatch(1); }
+static void benchCborBatch()     { sinkU = encodeCborBatch(BENCH_BATCH); }
+
+static const char* BENCH_ALERT =
+  "BMS INFO [" DEVICE_ID "]\nCHARGING IN PROGRESS\n"
+  "Current: 9.85A  Voltage: 12.02V  SOC: 63.4%\n\"quoted\" \\ path";
+
+static void benchTelegramEscape() {
+  char escaped[256];
+  sinkU = telegramEscapeJson(BENCH_ALERT, escaped, sizeof(escaped));
+}
+
+/* 256 zones scattered over ~20 x 20 km around the configured home:
+   half circles (50–500 m), half octagons.  Fixes walk a diagonal
+   through the area so the grid cell changes between calls. */
+#define BENCH_ZONES  256
+
+static uint32_t benchLcg = 12345;
+static float benchRand() {              // 0 … 1, deterministic
+  benchLcg = benchLcg * 1664525u + 1013904223u;
+  return (float)(benchLcg >> 8) / 16777216.0f;
+}
+
+static GeoPoint benchCentres[BENCH_ZONES];
+static float    benchRadii[BENCH_ZONES];
+
+static void setupBenchZones() {
+  geofenceClear();
+  for (int i = 0; i < BENCH_ZONES; i++) {
+    float lat = GEOFENCE_LAT + (benchRand() - 0.5f) * 0.18f;
+    float lon = GEOFENCE_LON + (benchRand() - 0.5f) * 0.18f;
+    float r   = 50.0f + benchRand() * 450.0f;
+    benchCentres[i] = { lat, lon };
+    benchRadii[i]   = r;
+    GeoZoneKind kind = (i % 4 == 0) ? GeoZoneKind::KEEP_IN : GeoZoneKind::KEEP_OUT;
+
+    if (i & 1) {
+      geofenceAddCircle("bench", kind, lat, lon, r);
+    } else {
+      GeoPoint oct[8];
+      for (int k = 0; k < 8; k++) {
+        float a = k * (float)M_PI / 4.0f;
+        oct[k] = { lat + r / 111195.0f * sinf(a),
+                   lon + r / (111195.0f * cosf(lat * (float)M_PI / 180.0f)) * cosf(a) };
+      }
+      geofenceAddPolygon("bench", kind, oct, 8);
+    }
+  }
+}
+
+static void benchFix(float& lat, float& lon) {
+  float t = (float)(benchIter % 1000) / 1000.0f;
+  lat = GEOFENCE_LAT - 0.09f + t * 0.18f;
+  lon = GEOFENCE_LON - 0.09f + t * 0.18f;
+}
+
+static void benchGeofence() {
+  float lat, lon;
+  benchFix(lat, lon);
+  geofenceUpdate(lat, lon, 10.0f);
+  sinkU = geofenceGetStatus().zonesInside;
+}
+
+/* Baseline: haversine to every zone centre, no prefilter */
+static void benchGeofenceNaive() {
+  float lat, lon;
+  benchFix(lat, lon);
+  uint32_t inside = 0;
+  for (int i = 0; i < BENCH_ZONES; i++)
+    if (calculateDistance(benchCentres[i].lat, benchCentres[i].lon, lat, lon) < benchRadii[i])
+      inside++;
+  sinkU = inside;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+static void benchReadAccel() {
+  AccelData a = readAccelerometer();
+  sinkF = a.magnitude;
+}
+#endif
+
+/* 1 Hz pack history: slow load cycle plus sensor noise, quantised
+   the way tsdbUpdate() stores it.  A 4 KB block is the unit the
+   store encodes into and decodes on a query.                       */
+#define BENCH_TSDB_BYTES  3936      // TSDB_DATA_BYTES
+
+static uint8_t     tsdbAppendBuf[BENCH_TSDB_BYTES];
+static TsdbEncoder tsdbAppendEnc;
+static uint32_t    tsdbAppendT = 0;
+
+static uint8_t     tsdbBlock[BENCH_TSDB_BYTES];   // one full block for decoding
+static uint16_t    tsdbBlockCount = 0;
+static uint32_t    tsdbBlockBits  = 0;
+
+static TsdbSample benchHistorySample(uint32_t i) {
+  TsdbSample s;
+  float load = 4.0f + 3.0f * sinf(i * (2.0f * (float)M_PI / 600.0f));
+  s.t    = 1700000000UL + i;
+  s.v[0] = 12.40f - 0.05f * load + (benchRand() - 0.5f) * 0.004f;
+  s.v[1] = load + (benchRand() - 0.5f) * 0.10f;
+  s.v[2] = 28.0f + (i % 3600) * 0.0005f + (benchRand() - 0.5f) * 0.05f;
+  s.v[3] = 80.0f - (i % 3600) * 0.0015f;
+  tsdbQuantise(s);
+  return s;
+}
+
+static void setupBenchTsdb() {
+  TsdbEncoder e;
+  memset(tsdbBlock, 0xFF, sizeof(tsdbBlock));
+  tsdbEncBegin(e, tsdbBlock, sizeof(tsdbBlock));
+  uint32_t i = 0;
+  while (tsdbEncAppend(e, benchHistorySample(i))) i++;
+  tsdbBlockCount = e.p.count;
+  tsdbBlockBits  = e.bitPos;
+
+  memset(tsdbAppendBuf, 0xFF, sizeof(tsdbAppendBuf));
+  tsdbEncBegin(tsdbAppendEnc, tsdbAppendBuf, sizeof(tsdbAppendBuf));
+}
+
+static void benchTsdbAppend() {
+  TsdbSample s = benchHistorySample(tsdbAppendT++);
+  if (!tsdbEncAppend(tsdbAppendEnc, s)) {      // block full – start the next
+    memset(tsdbAppendBuf, 0xFF, sizeof(tsdbAppendBuf));
+    tsdbEncBegin(tsdbAppendEnc, tsdbAppendBuf, sizeof(tsdbAppendBuf));
+    tsdbEncAppend(tsdbAppendEnc, s);
+  }
+  sinkU = tsdbAppendEnc.bitPos;
+}
+
+static void benchTsdbDecodeBlock() {
+  TsdbDecoder d;
+  TsdbSample  s;
+  float sum = 0.0f;
+  tsdbDecBegin(d, tsdbBlock, sizeof(tsdbBlock), tsdbBlockCount);
+  while (tsdbDecNext(d, s)) sum += s.v[0];
+  sinkF = sum;
+}
+
+static void benchRollupUpdate() {
+  float v = 12.0f + (float)(benchIter % 100) * 0.001f;
+  rollupUpdate(v, 4.37f, 28.0f, 63.4f, v * 4.37f, 100);
+}
+
+struct BenchCase {
+  const char* name;
+  void      (*fn)();
+  uint32_t    iterations;
+};
+
+static const BenchCase CASES[] = {
+#if defined(ARDUINO_ARCH_ESP32)             // host: no ADC / I2C to time
+  { "read_adc_voltage",    benchReadADC,          20 },
+#endif
+  { "soc_from_voltage",    benchSocFromVoltage,   10000 },
+  { "update_soc",          benchUpdateSOC,        10000 },
+  { "edge_analytics",      benchEdgeAnalytics,    10000 },
+  { "evaluate_faults",     benchEvaluateFaults,   10000 },
+  { "telemetry_json",      benchTelemetryJson,    1000 },
+  { "telemetry_json_x20",  benchJsonBatch,        100 },
+  { "telemetry_cbor_x1",   benchCborSingle,       1000 },
+  { "telemetry_cbor_x20",  benchCborBatch,        100 },
+  { "telegram_escape",     benchTelegramEscape,   1000 },
+#if defined(ARDUINO_ARCH_ESP32)
+  { "read_accelerometer",  benchReadAccel,        200 },
+#endif
+  { "geofence_256_zones",  benchGeofence,         1000 },
+  { "geofence_naive_256",  benchGeofenceNaive,    1000 },
+  { "tsdb_append",         benchTsdbAppend,       10000 },
+  { "tsdb_decode_block",   benchTsdbDecodeBlock,  20 },
+  { "rollup_update",       benchRollupUpdate,     10000 },
+};
+
+/* ═══════════════════════════════════════════
+   ENTRY
+   ═══════════════════════════════════════════ */
+
+void runBenchmarks() {
+#if defined(ARDUINO_ARCH_ESP32)
+  cpuMHz = ESP.getCpuFreqMHz();
+#endif
+
+  Serial.println("[BENCH] Initialising modules under test");
+  initVoltage();
+  initSOC(CELL_CAPACITY_AH, 11.4f);
+  initFaultManager();
+  initAccelerometer();
+  setupBenchZones();
+  setupBenchTsdb();
+  rollupInit();
+
+  memset(&benchSnap, 0, sizeof(benchSnap));
+  benchSnap.packVoltage = 11.42f;
+  benchSnap.current     = 4.37f;
+  benchSnap.power       = 49.9f;
+  benchSnap.tempPack    = 28.0f;
+  benchSnap.soc         = 63.4f;
+  benchSnap.soh         = 97.25f;
+  benchSnap.rulCycles   = 972;
+  strncpy(benchSnap.faultMessage, "NONE", sizeof(benchSnap.faultMessage) - 1);
+  benchSnap.latitude    = 12.971600f;
+  benchSnap.longitude   = 77.594600f;
+  benchSnap.whPerKm     = 11.8f;
+  benchSnap.rangeKm     = 38.4f;
+  benchSnap.rangeLoKm   = 31.0f;
+  benchSnap.rangeHiKm   = 45.2f;
+  benchSnap.chargePhase = CHG_CV;
+  benchSnap.chargeEtaMin = 42.0f;
+
+  Serial.println("[BENCH] Start");
+  for (const BenchCase& c : CASES)
+    benchPrint(benchRun(c.name, c.fn, c.iterations));
+  /* Wire size of the cloud payload, JSON vs CBOR delta */
+  char one[1024];
+  Serial.printf("BENCH_SIZE {\"json_x1\":%u,\"json_x20\":%u,"
+                "\"cbor_x1\":%u,\"cbor_x20\":%u}\n",
+                (unsigned)formatTelemetryJson(benchSnap, one, sizeof(one)),
+                (unsigned)encodeJsonBatch(),
+                (unsigned)encodeCborBatch(1),
+                (unsigned)encodeCborBatch(BENCH_BATCH));
+  /* History compression on the synthetic hour, vs 20 B raw samples */
+  Serial.printf("BENCH_TSDB {\"samples_per_block\":%u,\"bits_per_sample\":%.1f,"
+                "\"ratio\":%.1f}\n",
+                tsdbBlockCount, tsdbBlockBits / (float)tsdbBlockCount,
+                160.0f * tsdbBlockCount / tsdbBlockBits);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  Serial.println("[BENCH] Done – halting");
+  while (true) delay(1000);
+#else
+  Serial.println("[BENCH] Done");
+#endif
+}
+
+#endif  // ENABLE_BENCHMARKS
@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Hot-path Microbenchmarks
+ *  Built when ENABLE_BENCHMARKS is true: setup() calls
+ *  runBenchmarks() instead of starting the BMS.  Each case prints
+ *  one JSON line so results can be diffed between firmware builds.
+ * ============================================================
+ */
+
+struct BenchResult {
+  const char* name;
+  uint32_t    iterations;
+  float       nsPerOp;
+  float       cyclesPerOp;     // 0 where no cycle counter exists (host)
+  float       heapPeakPerOp;   // transient heap high-water of one call, averaged
+  float       heapNetPerOp;    // heap one call does not return, averaged
+};
+
+/**
+ * Run every registered benchmark and print one JSON object per line
+ * prefixed with "BENCH ".  On target it then halts; the host build
+ * (test/host) returns.
+ */
+void runBenchmarks();
+
+/**
+ * Time `fn` for `iterations` calls (after one warm-up call).
+ * Exposed so feature modules can benchmark their own internals.
+ */
+BenchResult benchRun(const char* name, void (*fn)(), uint32_t iterations);
+
+/** Print a result as a single JSON line. */
+void benchPrint(const BenchResult& r);
@@ -0,0 +1,266 @@
+#include "blackbox.h"
+#include "config.h"
+#include "logger.h"
+#include "telemetry_stream.h"   // crc16Ccitt
+#include <esp_partition.h>
+
+#define BB_RING             256        // samples, power of two
+#define BB_SLOT_SIZE        4096       // one flash sector per capture
+#define BB_HDR_SIZE         64
+#define BB_MAX_SAMPLES      ((BB_SLOT_SIZE - BB_HDR_SIZE) / sizeof(BlackboxSample))
+#define BB_CHUNK_SAMPLES    25         // 500 B flash write per loop
+#define BB_DUMP_ROWS        8          // CSV rows per loop
+#define BB_MAGIC            0x58424242UL   // "BBBX"
+#define BB_PART_SUBTYPE     0x40       // partitions.csv: data, 0x40, "blackbox"
+
+#define BB_CAPTURE          (BLACKBOX_PRE_SAMPLES + BLACKBOX_POST_SAMPLES)
+
+static_assert(sizeof(BlackboxSample) == 20, "BlackboxSample layout");
+static_assert(BB_CAPTURE <= BB_MAX_SAMPLES, "capture does not fit one flash sector");
+/* The ring keeps recording while a capture is flushed; the slack must
+   cover the flush loops so the capture is not overwritten.           */
+static_assert(BB_RING - BB_CAPTURE >= BB_CAPTURE / BB_CHUNK_SAMPLES + 2,
+              "BB_RING too small for the capture");
+
+/* ================= Flash Format ================= */
+
+struct BB_Header {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t triggerMs;
+  uint16_t count;            // samples in the capture
+  uint16_t pre;              // of which before the trigger
+  uint8_t  reason;           // FaultType
+  uint8_t  reserved[3];
+  char     msg[40];
+  uint16_t dataCrc;          // over the samples
+  uint16_t hdrCrc;           // over everything above
+};
+static_assert(sizeof(BB_Header) == BB_HDR_SIZE, "BB_Header layout");
+
+/* ================= State ================= */
+
+enum class BbState : uint8_t { RECORDING, POST, FLUSH };
+
+static BlackboxSample ring[BB_RING];
+static uint32_t       ringHead = 0;       // samples ever written
+
+static BbState   state    = BbState::RECORDING;
+static uint32_t  capStart = 0;            // ring position of the first sample
+static uint16_t  postLeft = 0;
+static uint16_t  flushed  = 0;            // samples written so far
+static uint16_t  flushCrc = 0xFFFF;
+static BB_Header capHdr;
+
+static const esp_partition_t* part = nullptr;
+static uint32_t nextSeq = 0;              // slot = seq % stats.slots
+
+static bool      dumping  = false;
+static uint16_t  dumpRow  = 0;
+static BB_Header dumpHdr;
+
+static BlackboxStats stats = {};
+
+/* ================= Helpers ================= */
+
+static size_t slotBase(uint32_t seq) {
+  return (size_t)(seq % stats.slots) * BB_SLOT_SIZE;
+}
+
+static uint16_t headerCrc(const BB_Header& h) {
+  return crc16Ccitt((const uint8_t*)&h, offsetof(BB_Header, hdrCrc));
+}
+
+static bool readHeader(uint32_t seq, BB_Header& h) {
+  return esp_partition_read(part, slotBase(seq), &h, sizeof(h)) == ESP_OK &&
+         h.magic == BB_MAGIC && h.hdrCrc == headerCrc(h) &&
+         h.seq == seq && h.count <= BB_MAX_SAMPLES;
+}
+
+static bool readSample(const BB_Header& h, uint16_t i, BlackboxSample& s) {
+  size_t off = slotBase(h.seq) + BB_HDR_SIZE + (size_t)i * sizeof(BlackboxSample);
+  return esp_partition_read(part, off, &s, sizeof(s)) == ESP_OK;
+}
+
+static void eraseSlot(uint32_t seq) {
+  if (esp_partition_erase_range(part, slotBase(seq), BB_SLOT_SIZE) != ESP_OK)
+    stats.flashErrors++;
+}
+
+/* One chunk per call; header last so a torn capture stays invisible */
+static void flushStep() {
+  if (!part) {
+    state = BbState::RECORDING;
+    return;
+  }
+
+  BlackboxSample chunk[BB_CHUNK_SAMPLES];
+  uint16_t n = min<uint16_t>(BB_CHUNK_SAMPLES, capHdr.count - flushed);
+  for (uint16_t i = 0; i < n; i++)
+    chunk[i] = ring[(capStart + flushed + i) & (BB_RING - 1)];
+
+  size_t off = slotBase(capHdr.seq) + BB_HDR_SIZE + (size_t)flushed * sizeof(BlackboxSample);
+  if (esp_partition_write(part, off, chunk, n * sizeof(BlackboxSample)) != ESP_OK) {
+    stats.flashErrors++;
+    LOGE("BLACKBOX", "Flash write failed – capture #%lu dropped", (unsigned long)capHdr.seq);
+    state = BbState::RECORDING;
+    return;
+  }
+  flushCrc = crc16Ccitt((const uint8_t*)chunk, n * sizeof(BlackboxSample), flushCrc);
+  flushed += n;
+  if (flushed < capHdr.count) return;
+
+  capHdr.dataCrc = flushCrc;
+  capHdr.hdrCrc  = headerCrc(capHdr);
+  if (esp_partition_write(part, slotBase(capHdr.seq), &capHdr, sizeof(capHdr)) != ESP_OK) {
+    stats.flashErrors++;
+    state = BbState::RECORDING;
+    return;
+  }
+
+  stats.flushes++;
+  if (stats.stored < stats.slots - 1) stats.stored++;   // one slot is always the erased spare
+  LOGW("BLACKBOX", "Capture #%lu saved: %s (%u samples, %u pre-trigger)",
+       (unsigned long)capHdr.seq, capHdr.msg, capHdr.count, capHdr.pre);
+
+  nextSeq++;
+  eraseSlot(nextSeq);      // oldest capture makes room for the next
+  state = BbState::RECORDING;
+}
+
+static void dumpStep() {
+  for (uint8_t r = 0; r < BB_DUMP_ROWS && dumpRow < dumpHdr.count; r++, dumpRow++) {
+    BlackboxSample s;
+    if (!readSample(dumpHdr, dumpRow, s)) { dumpRow = dumpHdr.count; break; }
+    Serial.printf("%ld,%.3f,%.2f,%.1f,%.3f,%.3f,%.3f,%u,%u,%u\n",
+                  (long)(int32_t)(s.tMs - dumpHdr.triggerMs),
+                  s.packMv / 1000.0f, s.currentCa / 100.0f, s.tempDc / 10.0f,
+                  s.accelMg[0] / 1000.0f, s.accelMg[1] / 1000.0f, s.accelMg[2] / 1000.0f,
+                  s.socPct, s.flags, s.faultBits);
+  }
+  if (dumpRow >= dumpHdr.count) {
+    Serial.println("BB_END");
+    dumping = false;
+  }
+}
+
+/* ================= API ================= */
+
+void blackboxInit() {
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                  (esp_partition_subtype_t)BB_PART_SUBTYPE, "blackbox");
+  if (!part) {
+    LOGW("BLACKBOX", "No 'blackbox' partition – captures will not be stored");
+    return;
+  }
+  stats.slots = (uint8_t)min<uint32_t>(part->size / BB_SLOT_SIZE, 255);
+  if (stats.slots < 2) {
+    LOGW("BLACKBOX", "'blackbox' partition too small (%lu B)", (unsigned long)part->size);
+    part = nullptr;
+    return;
+  }
+  stats.flashReady = true;
+
+  /* Newest valid header decides where the ring continues */
+  bool found = false;
+  for (uint8_t i = 0; i < stats.slots; i++) {
+    BB_Header h;
+    if (esp_partition_read(part, (size_t)i * BB_SLOT_SIZE, &h, sizeof(h)) != ESP_OK ||
+        h.magic != BB_MAGIC || h.hdrCrc != headerCrc(h) || h.seq % stats.slots != i)
+      continue;
+    stats.stored++;
+    if (!found || h.seq >= nextSeq) nextSeq = h.seq + 1;
+    found = true;
+  }
+  eraseSlot(nextSeq);
+  if (stats.stored == stats.slots) stats.stored--;   // that slot was just erased
+
+  LOGI("BLACKBOX", "Initialized – %u/%u captures stored, %u+%u samples each",
+       stats.stored, stats.slots, BLACKBOX_PRE_SAMPLES, BLACKBOX_POST_SAMPLES);
+}
+
+void blackboxRecord(const BlackboxSample& s) {
+  ring[ringHead & (BB_RING - 1)] = s;
+  ringHead++;
+  stats.samples++;
+
+  if (state == BbState::POST && --postLeft == 0) {
+    state    = BbState::FLUSH;
+    flushed  = 0;
+    flushCrc = 0xFFFF;
+  }
+}
+
+void blackboxTrigger(uint8_t reason, const char* msg) {
+  if (state != BbState::RECORDING) {
+    stats.suppressed++;
+    return;
+  }
+  stats.triggers++;
+
+  uint16_t pre = (uint16_t)min<uint32_t>(ringHead, BLACKBOX_PRE_SAMPLES);
+  capStart = ringHead - pre;
+
+  memset(&capHdr, 0, sizeof(capHdr));
+  capHdr.magic     = BB_MAGIC;
+  capHdr.seq       = nextSeq;
+  capHdr.triggerMs = millis();
+  capHdr.pre       = pre;
+  capHdr.count     = pre + BLACKBOX_POST_SAMPLES;
+  capHdr.reason    = reason;
+  strncpy(capHdr.msg, msg ? msg : "", sizeof(capHdr.msg) - 1);
+
+  postLeft = BLACKBOX_POST_SAMPLES;
+  state    = postLeft ? BbState::POST : BbState::FLUSH;
+  flushed  = 0;
+  flushCrc = 0xFFFF;
+  LOGI("BLACKBOX", "Triggered: %s", capHdr.msg);
+}
+
+void blackboxService() {
+  if (state == BbState::FLUSH) flushStep();
+  if (dumping) dumpStep();
+}
+
+void blackboxList() {
+  if (!part) { Serial.println("[BLACKBOX] no partition"); return; }
+  Serial.printf("[BLACKBOX] %u/%u captures (newest first)\n", stats.stored, stats.slots);
+  for (uint32_t i = 1; i <= stats.slots && i <= nextSeq; i++) {
+    BB_Header h;
+    if (!readHeader(nextSeq - i, h)) continue;
+    Serial.printf("  #%lu  reason=%u  \"%s\"  at %lus  %u samples (%u pre)\n",
+                  (unsigned long)h.seq, h.reason, h.msg,
+                  (unsigned long)(h.triggerMs / 1000), h.count, h.pre);
+  }
+}
+
+void blackboxDumpLatest() {
+  if (!part || nextSeq == 0 || !readHeader(nextSeq - 1, dumpHdr)) {
+    Serial.println("[BLACKBOX] nothing stored");
+    return;
+  }
+
+  /* Verify before streaming – a bad capture is reported, not printed */
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < dumpHdr.count; i++) {
+    BlackboxSample s;
+    if (!readSample(dumpHdr, i, s)) break;
+    crc = crc16Ccitt((const uint8_t*)&s, sizeof(s), crc);
+  }
+  if (crc != dumpHdr.dataCrc) {
+    Serial.printf("[BLACKBOX] capture #%lu CRC mismatch\n", (unsigned long)dumpHdr.seq);
+    return;
+  }
+
+  Serial.printf("BB_CAPTURE,%lu,%u,\"%s\",%lu,%u,%u\n",
+                (unsigned long)dumpHdr.seq, dumpHdr.reason, dumpHdr.msg,
+                (unsigned long)dumpHdr.triggerMs, dumpHdr.pre, dumpHdr.count);
+  Serial.println("t_ms,pack_v,current_a,temp_c,ax_g,ay_g,az_g,soc,flags,faults");
+  dumpRow = 0;
+  dumping = true;
+}
+
+BlackboxStats blackboxGetStats() {
+  stats.capturing = state != BbState::RECORDING;
+  return stats;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Black-box Recorder
+ *  Every loop's V / I / T / accel / relay state goes into a RAM
+ *  ring (constant time, one 20-byte copy).  A trigger – fault
+ *  latch, impact, shock – freezes the BLACKBOX_PRE_SAMPLES
+ *  before it, keeps recording BLACKBOX_POST_SAMPLES after, then
+ *  writes the capture to the "blackbox" flash partition
+ *  (partitions.csv) a chunk per loop.
+ *
+ *  Flash: one 4 KB sector per capture, used as a ring; the header
+ *  is written last so a torn capture is never listed.  The next
+ *  sector is erased ahead of time, off the trigger path.
+ *
+ *  Retrieval: console 'x' lists captures, 'X' dumps the newest
+ *  as CSV (a few rows per loop).
+ * ============================================================
+ */
+
+/* One loop sample, 20 bytes */
+struct BlackboxSample {
+  uint32_t tMs;
+  uint16_t packMv;
+  int16_t  currentCa;        // 0.01 A, + = discharge
+  int16_t  tempDc;           // 0.1 °C
+  int16_t  accelMg[3];       // x, y, z
+  uint16_t faultBits;        // getFaultBitmap() low 16
+  uint8_t  socPct;
+  uint8_t  flags;            // BB_FLAG_*
+};
+
+#define BB_FLAG_CHARGE_RELAY  (1u << 0)
+#define BB_FLAG_MOTOR_RELAY   (1u << 1)
+#define BB_FLAG_FAN           (1u << 2)
+#define BB_FLAG_CHARGING      (1u << 3)
+#define BB_FLAG_BLANKING      (1u << 4)   // motor inrush window
+
+struct BlackboxStats {
+  bool     flashReady;       // partition found
+  uint8_t  slots;            // captures the partition holds
+  uint8_t  stored;           // valid captures in flash
+  bool     capturing;        // trigger seen, post window / flush running
+  uint32_t samples;
+  uint32_t triggers;
+  uint32_t suppressed;       // triggers during an active capture
+  uint32_t flushes;
+  uint32_t flashErrors;
+};
+
+/** Find the partition, index stored captures, pre-erase the next slot. */
+void blackboxInit();
+
+/** Append one sample (every loop). */
+void blackboxRecord(const BlackboxSample& s);
+
+/**
+ * Freeze the ring around this instant.  Ignored while a capture
+ * is still in its post window or being written.
+ * @param reason  FaultType (or 0)
+ */
+void blackboxTrigger(uint8_t reason, const char* msg);
+
+/** Flash write / serial dump progress – call every loop. */
+void blackboxService();
+
+/** Print one line per stored capture. */
+void blackboxList();
+
+/** Start a CSV dump of the newest capture (streamed by blackboxService). */
+void blackboxDumpLatest();
+
+BlackboxStats blackboxGetStats();
@@ -0,0 +1,29 @@
+#include "bus_lock.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+
+static SemaphoreHandle_t locks[BUS_COUNT] = {};
+static BusLockStats      stats = {};        // per bus, written under that bus's lock
+
+void busLockInit() {
+  for (uint8_t b = 0; b < BUS_COUNT; b++)
+    if (!locks[b]) locks[b] = xSemaphoreCreateMutex();
+}
+
+void busLock(SharedBus b) {
+  if (!locks[b]) return;
+  if (xSemaphoreTake(locks[b], 0) == pdTRUE) return;      // uncontended: no timing
+
+  int64_t t0 = esp_timer_get_time();
+  xSemaphoreTake(locks[b], portMAX_DELAY);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  stats.contended[b]++;
+  if (us > stats.maxWaitUs[b]) stats.maxWaitUs[b] = us;
+}
+
+void busUnlock(SharedBus b) {
+  if (locks[b]) xSemaphoreGive(locks[b]);
+}
+
+BusLockStats busLockGetStats() { return stats; }
@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Shared Bus Locks
+ *  The sampler task (sampler.cpp) reads the INA219 on Wire and
+ *  one pack-voltage conversion while loop() drives the LCD and
+ *  the MPU6050 on the same Wire bus and averages the same ADC
+ *  pin.  Neither Wire nor analogRead() is safe across tasks, so
+ *  every access takes its bus's mutex, held as briefly as the
+ *  access allows:
+ *
+ *    BUS_I2C   one register access / one LCD line (≈2–3 ms)
+ *    BUS_ADC   one conversion – readPackVoltage()'s 300-sample
+ *              average locks each, not the whole ~30 ms run
+ *
+ *  The sampler therefore waits at most one loop-side access;
+ *  FreeRTOS mutexes lift loop() to the sampler's priority while
+ *  it holds one, so nothing in between can stretch the wait.
+ *  Not recursive: lock around Wire / analogRead() calls only.
+ *  Until busLockInit() – before the sampler task exists –
+ *  locking is a no-op.
+ * ============================================================
+ */
+
+enum SharedBus : uint8_t {
+  BUS_I2C = 0,
+  BUS_ADC,
+  BUS_COUNT
+};
+
+struct BusLockStats {
+  uint32_t contended[BUS_COUNT];   // lock found held by the other task
+  uint32_t maxWaitUs[BUS_COUNT];   // longest wait for it
+};
+
+/** Create the mutexes.  samplerInit(), before its task starts. */
+void busLockInit();
+
+/** Block until the bus is free. */
+void busLock(SharedBus b);
+
+void busUnlock(SharedBus b);
+
+BusLockStats busLockGetStats();
@@ -0,0 +1,315 @@
+#include "charge.h"
+#include "config.h"
+#include "logger.h"
+#include "soc.h"
+#include <math.h>
+
+#define CHARGE_TERM_A   (CHARGE_TERM_C * CELL_CAPACITY_AH)
+
+/* ================= State ================= */
+
+static ChargePhase phase        = CHG_IDLE;
+static uint32_t    phaseStartMs = 0;
+static uint32_t    lastMs       = 0;
+static bool        seeded       = false;    // filters hold a first sample
+
+static float    filtV        = 0.0f;
+static float    filtA        = 0.0f;        // + = into the pack
+static float    limitA       = 0.0f;
+static float    plateauA     = 0.0f;
+static float    etaMin       = -1.0f;
+
+static bool     inSession    = false;
+static bool     sessionDerated = false;     // one derate alert per session
+static bool     sessionCv    = false;       // taper reached – an interruption resumes in CV
+static bool     ceilingAlerted = false;     // one ceiling alert until a charge completes
+static uint32_t sessionStartMs = 0;
+static uint32_t sessionEndMs = 0;
+static float    sessionAh    = 0.0f;
+
+static uint32_t overSinceMs  = 0;           // above the derated limit since (0 = not)
+static uint32_t termSinceMs  = 0;           // at / below C/20 since (0 = not)
+
+/* CV taper: ln(I) sampled every CHARGE_ETA_SAMPLE_MS */
+static float    lnPrev       = 0.0f;
+static uint32_t lnPrevMs     = 0;
+static float    invTau       = 0.0f;        // 1/min, 0 = not measured this CV
+static float    lastTauMin   = CHARGE_TAU_DEFAULT_MIN;
+
+static uint32_t completed    = 0;
+static uint32_t derates      = 0;
+static uint32_t ceilingStops = 0;
+
+/* ================= Helpers ================= */
+
+static bool relayPhase(ChargePhase p) {
+  return p == CHG_WAITING || p == CHG_PRECONDITION || p == CHG_CC || p == CHG_CV;
+}
+
+static bool needsPrecondition(float temp, float cellV) {
+  return temp < CHARGE_COLD_TEMP || cellV < CHARGE_PRECOND_CELL_V;
+}
+
+/* Charge current the pack accepts at this temperature / cell voltage */
+static float derateLimit(float temp, float cellV) {
+  if (temp < CHARGE_MIN_TEMP || temp >= CHARGE_MAX_TEMP) return 0.0f;
+  float limit = MAX_CHARGE_CURRENT;
+  if (temp > CHARGE_WARM_TEMP)
+    limit *= (CHARGE_MAX_TEMP - temp) / (CHARGE_MAX_TEMP - CHARGE_WARM_TEMP);
+  if (needsPrecondition(temp, cellV))
+    limit = fminf(limit, CHARGE_PRECOND_C * CELL_CAPACITY_AH);
+  return limit;
+}
+
+static void enter(ChargePhase p, uint32_t now) {
+  LOGI("CHG", "%s → %s  (%.2fV %.2fA limit %.1fA)",
+       chargePhaseName(phase), chargePhaseName(p), filtV, filtA, limitA);
+  phase        = p;
+  phaseStartMs = now;
+  overSinceMs  = 0;
+  termSinceMs  = 0;
+}
+
+static void enterCV(uint32_t now) {
+  enter(CHG_CV, now);
+  lnPrev   = logf(fmaxf(filtA, 0.01f));
+  lnPrevMs = now;
+  invTau   = 0.0f;
+}
+
+/* Live taper slope: d ln(I)/dt = −1/τ */
+static void sampleTaper(uint32_t now) {
+  if (now - lnPrevMs < CHARGE_ETA_SAMPLE_MS) return;
+  float lnNow = logf(fmaxf(filtA, 0.01f));
+  float k     = (lnPrev - lnNow) / ((float)(now - lnPrevMs) / 60000.0f);
+  if (k > 0.0f)
+    invTau = invTau > 0.0f ? invTau + CHARGE_ETA_ALPHA * (k - invTau) : k;
+  lnPrev   = lnNow;
+  lnPrevMs = now;
+}
+
+static void updateEta() {
+  if (phase == CHG_CV) {
+    float tau = invTau > 0.0f ? 1.0f / invTau : lastTauMin;
+    etaMin = filtA > CHARGE_TERM_A ? tau * logf(filtA / CHARGE_TERM_A) : 0.0f;
+    return;
+  }
+  if ((phase == CHG_CC || phase == CHG_PRECONDITION) && filtA > CHARGE_TERM_A) {
+    /* CC until the taper starts, then an exponential taper from this
+       current down to C/20, which itself delivers (I − I_term)·τ     */
+    float missingAh = CELL_CAPACITY_AH * (100.0f - getSOC()) / 100.0f;
+    float taperAh   = (filtA - CHARGE_TERM_A) * lastTauMin / 60.0f;
+    float ccMin     = fmaxf(missingAh - taperAh, 0.0f) / filtA * 60.0f;
+    etaMin = ccMin + lastTauMin * logf(filtA / CHARGE_TERM_A);
+    return;
+  }
+  etaMin = -1.0f;
+}
+
+static ChargeEvent finish(uint32_t now, bool timedOut) {
+  if (!timedOut && invTau > 0.0f) lastTauMin = 1.0f / invTau;
+  inSession    = false;
+  sessionEndMs = now;
+  if (!timedOut) { completed++; ceilingAlerted = false; }
+  LOGI("CHG", "%s – %.2f Ah in %lu min, τ %.0f min",
+       timedOut ? "CV timeout" : "Terminated at C/20", sessionAh,
+       (unsigned long)((now - sessionStartMs) / 60000UL), lastTauMin);
+  enter(CHG_MAINTENANCE, now);
+  return timedOut ? CHG_EV_CV_TIMEOUT : CHG_EV_COMPLETE;
+}
+
+/* Charger above the limit: open the relay, retry after CHARGE_DERATE_RETRY_MS */
+static ChargeEvent derate(uint32_t now) {
+  derates++;
+  LOGW("CHG", "Derated: charger %.1fA > limit %.1fA – paused", filtA, limitA);
+  enter(CHG_DERATED, now);
+  if (sessionDerated) return CHG_EV_NONE;
+  sessionDerated = true;
+  return CHG_EV_DERATED;
+}
+
+/* Pack average above the ceiling with the relay closed: the charger
+   holds a higher CV than the BMS allows.  Open and wait for a top-up. */
+static ChargeEvent ceiling(uint32_t now) {
+  ceilingStops++;
+  LOGW("CHG", "Pack %.2fV above the %.2fV ceiling – relay opened",
+       filtV, CHARGE_CEILING_V);
+  if (inSession) sessionEndMs = now;
+  inSession = false;
+  enter(CHG_MAINTENANCE, now);
+  if (ceilingAlerted) return CHG_EV_NONE;
+  ceilingAlerted = true;
+  return CHG_EV_CEILING;
+}
+
+/* PRECONDITION / CC / CV: current flowing with the relay closed.
+   Unplugging is judged on the raw current – the filtered one would
+   first sag through the CV detection.                              */
+static ChargeEvent charging(float temp, float inA, uint32_t now) {
+  if (inA < CHARGE_DETECT_A) {                // charger unplugged / off
+    enter(CHG_WAITING, now);
+    return CHG_EV_NONE;
+  }
+
+  if (filtA > limitA * (1.0f + CHARGE_DERATE_MARGIN)) {
+    if (!overSinceMs) overSinceMs = now ? now : 1;
+    if (limitA <= 0.0f || now - overSinceMs >= CHARGE_DERATE_HOLD_MS) return derate(now);
+  } else {
+    overSinceMs = 0;
+  }
+
+  switch (phase) {
+    case CHG_PRECONDITION:
+      if (!needsPrecondition(temp, filtV / NUM_CELLS)) enter(CHG_CC, now);
+      break;
+
+    case CHG_CC:
+      if (filtA > plateauA) plateauA = filtA;
+      if (filtV >= CHARGE_CV_V - CHARGE_CV_BAND ||
+          filtA < plateauA * CHARGE_CV_DETECT_FRAC) {
+        enterCV(now);
+        sessionCv = true;
+        updateEta();
+        return CHG_EV_CV;
+      }
+      break;
+
+    case CHG_CV:
+      sampleTaper(now);
+      if (filtA <= CHARGE_TERM_A) {
+        if (!termSinceMs) termSinceMs = now ? now : 1;
+        if (now - termSinceMs >= CHARGE_TERM_CONFIRM_MS) return finish(now, false);
+      } else {
+        termSinceMs = 0;
+      }
+      if (now - phaseStartMs >= CHARGE_CV_TIMEOUT_MS) return finish(now, true);
+      break;
+
+    default:
+      break;
+  }
+  return CHG_EV_NONE;
+}
+
+/* ================= API ================= */
+
+ChargeEvent chargeUpdate(float packVoltage, float currentA, float temperature, bool blocked) {
+  uint32_t now = millis();
+  float    inA = -currentA;
+
+  if (!seeded) {
+    filtV  = packVoltage;
+    filtA  = inA;
+    seeded = true;
+  } else {
+    float dt = (float)(now - lastMs);
+    float a  = dt / (CHARGE_FILTER_MS + dt);
+    filtV += a * (packVoltage - filtV);
+    filtA += a * (inA - filtA);
+    if (inSession && relayPhase(phase) && inA > 0.0f)
+      sessionAh += inA * dt / 3600000.0f;
+  }
+  lastMs = now;
+  limitA = derateLimit(temperature, filtV / NUM_CELLS);
+
+  ChargeEvent ev = CHG_EV_NONE;
+
+  if (blocked) {
+    if (phase != CHG_IDLE) {
+      ev = relayPhase(phase) ? CHG_EV_STOPPED : CHG_EV_NONE;
+      if (inSession) sessionEndMs = now;
+      inSession = false;
+      enter(CHG_IDLE, now);
+    }
+    etaMin = -1.0f;
+    return ev;
+  }
+
+  if (relayPhase(phase) && filtV > CHARGE_CEILING_V) {
+    etaMin = -1.0f;
+    return ceiling(now);
+  }
+
+  switch (phase) {
+    case CHG_IDLE:
+    case CHG_MAINTENANCE:
+      /* Never armed yet / finished: (top-up) charge once the pack has sagged */
+      if (filtV <= CHARGE_START_V) {
+        sessionDerated = false;
+        enter(CHG_WAITING, now);
+        ev = CHG_EV_ARMED;
+      }
+      break;
+
+    case CHG_DERATED:
+      if (now - phaseStartMs >= CHARGE_DERATE_RETRY_MS && limitA > 0.0f)
+        enter(CHG_WAITING, now);
+      break;
+
+    case CHG_WAITING:
+      if (inA >= CHARGE_DETECT_A && filtA >= CHARGE_DETECT_A) {
+        /* Current steps back in after a pause / replug: a filter still
+           rising from zero would read as taper or plateau loss         */
+        filtA = inA;
+        if (!inSession) {
+          inSession      = true;
+          sessionCv      = false;
+          sessionStartMs = now;
+          sessionAh      = 0.0f;
+          plateauA       = 0.0f;
+        }
+        if (sessionCv)                                           enterCV(now);
+        else if (needsPrecondition(temperature, filtV / NUM_CELLS)) enter(CHG_PRECONDITION, now);
+        else                                                     enter(CHG_CC, now);
+      }
+      break;
+
+    default:
+      ev = charging(temperature, inA, now);
+      break;
+  }
+
+  if (ev != CHG_EV_CV) updateEta();
+  return ev;
+}
+
+bool chargeRelayWanted() { return relayPhase(phase); }
+
+void chargeRestore(bool armed) {
+  phase        = armed ? CHG_WAITING : CHG_IDLE;
+  phaseStartMs = millis();
+  seeded       = false;
+  inSession    = false;
+}
+
+ChargeStatus chargeGetStatus() {
+  ChargeStatus s = {};
+  uint32_t now = millis();
+  s.phase     = phase;
+  s.packV     = filtV;
+  s.chargeA   = filtA;
+  s.limitA    = limitA;
+  s.plateauA  = plateauA;
+  s.tauMin    = (phase == CHG_CV && invTau > 0.0f) ? 1.0f / invTau : lastTauMin;
+  s.etaMin    = etaMin;
+  s.sessionAh = sessionAh;
+  s.phaseMs   = now - phaseStartMs;
+  s.sessionMs = sessionStartMs ? (inSession ? now : sessionEndMs) - sessionStartMs : 0;
+  s.completed = completed;
+  s.derates   = derates;
+  s.ceilingStops = ceilingStops;
+  return s;
+}
+
+const char* chargePhaseName(ChargePhase p) {
+  switch (p) {
+    case CHG_IDLE:         return "IDLE";
+    case CHG_WAITING:      return "WAITING";
+    case CHG_PRECONDITION: return "PRECOND";
+    case CHG_CC:           return "CC";
+    case CHG_CV:           return "CV";
+    case CHG_MAINTENANCE:  return "MAINT";
+    case CHG_DERATED:      return "DERATED";
+    default:               return "?";
+  }
+}
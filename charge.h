@@ -0,0 +1,87 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  CC/CV Charge Controller
+ *  Follows the external CC/CV charger through its phases on
+ *  filtered pack voltage and current (CHARGE_FILTER_MS):
+ *
+ *    WAITING       relay armed, no charge current yet
+ *    PRECONDITION  cold pack or deeply discharged cells:
+ *                  limited to CHARGE_PRECOND_C
+ *    CC            constant current, voltage rising
+ *    CV            at the charger's CV voltage (or current
+ *                  leaving the CC plateau), current tapering
+ *    MAINTENANCE   terminated at C/20 (CHARGE_TERM_C): relay
+ *                  open, re-armed for a top-up at CHARGE_START_V
+ *    DERATED       charger current above the temperature-derated
+ *                  limit: relay open for CHARGE_DERATE_RETRY_MS
+ *
+ *  The charger has no control link, so the derated limit is
+ *  enforced by pausing – a duty cycle on the charge relay – and
+ *  reported as the current a smarter charger should be asked for.
+ *
+ *  ETA to full: in CV the taper is taken as exponential and its
+ *  time constant is measured live from the slope of ln(I) every
+ *  CHARGE_ETA_SAMPLE_MS; ETA = τ · ln(I / I_term).  In CC it is
+ *  the CC time for the missing Ah not left to the taper, plus a
+ *  taper with the last measured τ (CHARGE_TAU_DEFAULT_MIN until
+ *  one has been seen).
+ * ============================================================
+ */
+
+enum ChargePhase : uint8_t {
+  CHG_IDLE = 0,              // not armed since boot / fault / thermal trip
+  CHG_WAITING,
+  CHG_PRECONDITION,
+  CHG_CC,
+  CHG_CV,
+  CHG_MAINTENANCE,
+  CHG_DERATED
+};
+
+/** What changed this call – system.cpp turns these into alerts. */
+enum ChargeEvent : uint8_t {
+  CHG_EV_NONE = 0,
+  CHG_EV_ARMED,              // relay armed – charger may be connected
+  CHG_EV_CV,                 // entered CV – first taper ETA
+  CHG_EV_COMPLETE,           // C/20 reached
+  CHG_EV_CV_TIMEOUT,         // CV ran CHARGE_CV_TIMEOUT_MS without reaching C/20
+  CHG_EV_DERATED,            // paused: charger above the derated limit
+  CHG_EV_STOPPED,            // fault / thermal trip while armed
+  CHG_EV_CEILING             // relay opened: pack above CHARGE_CEILING_V (once until complete)
+};
+
+struct ChargeStatus {
+  ChargePhase phase;
+  float    packV;            // filtered
+  float    chargeA;          // filtered, + = into the pack
+  float    limitA;           // temperature / precondition derated limit
+  float    plateauA;         // CC plateau (highest filtered current in CC)
+  float    tauMin;           // CV taper time constant: live in CV, else the last measured
+  float    etaMin;           // minutes to full, < 0 = unknown
+  float    sessionAh;        // charge delivered since current started
+  uint32_t phaseMs;          // time in the current phase
+  uint32_t sessionMs;        // since charge current started
+  uint32_t completed;        // terminations at C/20 since boot
+  uint32_t derates;          // pauses since boot
+  uint32_t ceilingStops;     // relay opened above the voltage ceiling since boot
+};
+
+/**
+ * Main loop, in controlCharging().
+ * @param currentA  signed (+ = discharge)
+ * @param blocked   fault or thermal trip – relay open, back to IDLE
+ */
+ChargeEvent chargeUpdate(float packVoltage, float currentA, float temperature, bool blocked);
+
+/** The charge relay should be closed. */
+bool chargeRelayWanted();
+
+/** Parking resume: the charge relay was held armed through deep sleep. */
+void chargeRestore(bool armed);
+
+ChargeStatus chargeGetStatus();
+
+const char* chargePhaseName(ChargePhase p);
@@ -6,6 +6,12 @@
 static const char* WIFI_SSID = "coder";
 static const char* WIFI_PASS = "we4rscrap!";
 
+#define WIFI_CONNECT_TIMEOUT_MS  10000UL   // begin() → GOT_IP before giving up
+#define WIFI_RETRY_BASE_MS         500UL   // first retry; doubles per failure
+#define WIFI_RETRY_MAX_MS        30000UL
+
+static const char* NTP_SERVER = "pool.ntp.org";   // wall clock for tsdb timestamps
+
 /* =========================================================
    SUPABASE CLOUD
    ========================================================= */
@@ -15,6 +21,11 @@ static const char* SUPABASE_URL =
 static const char* SUPABASE_KEY =
   "anon key here";
 
+/* Ingest endpoint for CBOR batches (TQ_REPLAY_CBOR); decodes with
+   the logic in tools/telemetry_cbor_decode.py and inserts the rows. */
+static const char* CBOR_INGEST_URL =
+  "enter your ingest endpoint";
+
 /* =========================================================
    GSM MODULE
    ========================================================= */
@@ -22,6 +33,12 @@ static const char* SUPABASE_KEY =
 #define GSM_RX            16
 #define GSM_TX            17
 #define GSM_BAUD          9600
+#define GSM_BOOT_DELAY_MS 1000UL    // modem power-up before the first AT
+#define GSM_RETRY_MS      10000UL   // re-run init after a failure
+#define GSM_REG_TIMEOUT_MS 60000UL  // configured → registered, else re-init
+#define GSM_SMS_SLOTS     4         // queued outgoing SMS
+#define GSM_SMS_RETRIES   3
+#define GSM_SMS_TIMEOUT_MS 15000UL  // AT+CMGS → OK (network round trip)
 
 /* =========================================================
    GPS / GEOLOCATION
@@ -38,6 +55,13 @@ static const char* SUPABASE_KEY =
 #define GPS_TX               19
 #define GPS_BAUD             9600
 
+/* Fix smoothing + trip odometer (gps_track.cpp), hardware GPS only */
+#define GPS_TRACK_ENABLED      true
+#define GPS_TRACK_ACCEL_SIGMA  1.0f    // m/s², process noise (vehicle manoeuvres)
+#define ODO_MIN_SPEED_MPS      1.5f    // below this the fix wander is not distance
+#define ODO_MIN_STEP_M         10.0f   // distance is counted in steps of at least this
+#define ODO_SAVE_STEP_M        500.0f  // NVS write interval (plus each stop)
+
 /* =========================================================
    I2C BUS
    ========================================================= */
@@ -54,6 +78,7 @@ static const char* SUPABASE_KEY =
 #define CHARGE_RELAY_PIN       25
 #define LOAD_MOTOR_RELAY_PIN   33
 #define COOLING_FAN_RELAY_PIN  27
+#define PRECHARGE_RELAY_PIN    26   // motor bus pre-charge (through PRECHARGE_RESISTOR_OHM)
 
 /* Unified aliases used throughout system.cpp */
 #define MOTOR_RELAY_PIN   LOAD_MOTOR_RELAY_PIN
@@ -127,6 +152,7 @@ static const char* SUPABASE_KEY =
 #define ENABLE_IMPACT_DETECTION  true
 #define ACCEL_SDA  I2C_SDA
 #define ACCEL_SCL  I2C_SCL
+#define ACCEL_INT_PIN  35   // MPU6050 INT → RTC GPIO, wake-on-motion (parking)
 
 /* Thresholds are defined internally in accelerometer.cpp */
 
@@ -134,12 +160,31 @@ static const char* SUPABASE_KEY =
    GPS / GEOFENCE
    ========================================================= */
 #define ENABLE_GEOLOCATION  true
-#define GEOFENCE_ENABLED    true
+#define GEOFENCE_ENABLED    false   // set the zone below first; violations alert only
 
 #define GEOFENCE_LAT       12.9716f
 #define GEOFENCE_LON       77.5946f
 #define GEOFENCE_RADIUS_M  100.0f
 
+/* Zone engine (geofence.cpp).  The zone above is loaded as a
+   KEEP_IN "home" circle; more zones via geofenceAdd*(). */
+#define GEOFENCE_MAX_ZONES      256
+#define GEOFENCE_VERTEX_POOL    1024    // polygon vertices, all zones
+#define GEOFENCE_GRID_N         16      // prefilter grid, N x N cells
+#define GEOFENCE_HYSTERESIS_M   20.0f   // min enter/leave band (fix accuracy if larger)
+#define GEOFENCE_BBOX_MARGIN_M  200.0f  // cap on the band; zone boxes grow by this
+
+/* =========================================================
+   RANGE ESTIMATOR  (range.cpp)
+   Wh/km from pack power vs GPS distance → km remaining.
+   Shown on the LCD and sent with cloud telemetry.
+   ========================================================= */
+#define ENABLE_RANGE_ESTIMATOR   true
+#define RANGE_MIN_SPEED_KMH      3.0f    // below this, power is not charged to distance
+#define RANGE_DEFAULT_WH_PER_KM  12.0f   // until a horizon has 1 km of data
+#define RANGE_MIN_WH_PER_KM      2.0f    // floor (long downhill regen)
+#define RANGE_ENERGY_UNCERT      0.05f   // ± fraction of usable energy (SOC error)
+
 /* =========================================================
    DISPLAY
    ========================================================= */
@@ -172,6 +217,272 @@ static const char* SUPABASE_KEY =
    ========================================================= */
 #define CLOUD_UPLOAD_INTERVAL_MS  10000
 
+/* Offline store-and-forward (telemetry_queue.cpp): samples taken while
+   WiFi is down go to a record ring on the "tlmq" flash partition
+   (capacity follows the partition size) and are replayed in batches. */
+#define ENABLE_OFFLINE_QUEUE       true
+#define TQ_BATCH_RECORDS             20    // rows per replay POST
+#define TQ_BATCH_BUF_SIZE         16384    // bytes, static
+#define TQ_REPLAY_INTERVAL_MS      2000    // min gap between batches
+#define TQ_REPLAY_MAX_BACKOFF_MS  60000
+#define TQ_LIVE_GUARD_MS           1500    // no replay this close to a live upload
+
+/* Replay encoding: false = JSON array straight into the Supabase table,
+   true = CBOR delta batch (telemetry_codec.cpp) to CBOR_INGEST_URL,
+   about 10x smaller per record. */
+#define TQ_REPLAY_CBOR             false
+#define TQ_BATCH_RECORDS_CBOR       200    // rows per replay POST (CBOR)
+
+/* =========================================================
+   MQTT  (mqtt_client.cpp)
+   =========================================================
+   One persistent broker session next to the HTTP upload:
+   telemetry rows at QoS 1, the binary state frame at QoS 0,
+   remote commands on <prefix>/<device>/cmd.  While connected the
+   periodic telemetry row goes over MQTT; otherwise the HTTP /
+   offline-queue path is used as before.
+   Local test: mosquitto on the LAN, MQTT_USE_TLS false, port 1883.
+   ========================================================= */
+#define ENABLE_MQTT            false
+#define MQTT_HOST              "192.168.1.10"
+#define MQTT_PORT              8883
+#define MQTT_USE_TLS           true
+#define MQTT_USER              ""
+#define MQTT_PASS              ""
+#define MQTT_TOPIC_PREFIX      "bms"
+#define MQTT_KEEPALIVE_S       30
+#define MQTT_INFLIGHT_WINDOW   8       // QoS 1 publishes awaiting PUBACK
+#define MQTT_ACK_TIMEOUT_MS    10000   // overdue PUBACK → reconnect
+#define MQTT_STREAM_HZ         2       // QoS 0 binary frame rate
+
+/* Broker CA (PEM).  Empty = encrypt without verifying the server; the
+   session is then untrusted and state-changing commands (clear_faults,
+   reset_soc) are refused, as they are over plain TCP.  Set
+   MQTT_INSECURE_COMMANDS only for a bench broker on a closed LAN. */
+static const char* MQTT_CA_CERT = "";
+#define MQTT_INSECURE_COMMANDS false
+
+/* =========================================================
+   SERIAL TELEMETRY
+   =========================================================
+   Binary stream: COBS-framed, CRC-16 records of the full state
+   (telemetry_stream.cpp), decoded on the host with
+   tools/telemetry_decode.py.  The text dump is still available
+   on demand with the 't' console command.
+   ========================================================= */
+#define ENABLE_BINARY_TELEMETRY  true
+#define TELEMETRY_STREAM_HZ      10      // max 100; capped by loop cadence
+#define SERIAL_TX_BUFFER_SIZE    2048    // UART driver TX ring (bytes)
+
+/* =========================================================
+   LOGGING
+   =========================================================
+   Module logs go through logger.cpp (LOGE/LOGW/LOGI/LOGD): they
+   are formatted into a RAM ring and printed by a background task,
+   so the control loop never waits on the UART.  Levels above
+   LOG_LEVEL are compiled out.
+     0 = none   1 = error   2 = warn   3 = info   4 = debug
+   ========================================================= */
+#define LOG_LEVEL  3
+
+/* =========================================================
+   HEAP GUARD
+   =========================================================
+   Steady state after setup() must not grow the heap.  The guard
+   compares allocated blocks against the post-setup baseline; a
+   few blocks of slack cover lazily created driver objects (first
+   TLS session, WiFi reconnect).  STRICT aborts on a violation –
+   use it on the bench to find the offending call.
+   ========================================================= */
+#define ENABLE_HEAP_GUARD        true
+#define HEAP_GUARD_STRICT        false
+#define HEAP_GUARD_BLOCK_SLACK   16
+#define HEAP_GUARD_CHECK_MS      1000UL
+#define HEAP_GUARD_REPORT_MS     60000UL
+
+/* =========================================================
+   BLACK-BOX RECORDER
+   =========================================================
+   Loop samples (100 ms) kept in RAM; a fault latch or impact
+   saves PRE + POST samples to the "blackbox" flash partition
+   (partitions.csv, one 4 KB sector per capture).
+   ========================================================= */
+#define ENABLE_BLACKBOX          true
+#define BLACKBOX_PRE_SAMPLES     100     // 10 s before the trigger
+#define BLACKBOX_POST_SAMPLES    30      // 3 s after
+
+/* =========================================================
+   TIME-SERIES HISTORY
+   =========================================================
+   V / I / T / SOC averaged per interval, delta + Rice coded
+   into the "tsdb" flash partition (partitions.csv, 768 KB ≈
+   5 days at 1 Hz).  The open block is committed to flash
+   every TSDB_FLUSH_MS – at most that much history is lost on
+   a power cut.
+   ========================================================= */
+#define ENABLE_TSDB              true
+#define TSDB_INTERVAL_MS         1000UL
+#define TSDB_FLUSH_MS            60000UL
+
+/* =========================================================
+   STATE SNAPSHOT  (snapshot.cpp)
+   SOC + SOH + counters as one CRC'd record on the "snapshot"
+   partition (partitions.csv).  Replaces the separate 2 / 5 min
+   NVS saves in soc.cpp / soh.cpp.
+   ========================================================= */
+#define ENABLE_SNAPSHOT          true
+#define SNAPSHOT_INTERVAL_MS     20000UL   // max Coulomb counting lost without brownout warning
+#define SNAPSHOT_ON_BROWNOUT     true      // write from the brownout interrupt, then reset
+
+/* =========================================================
+   ROLLUPS  (rollup.cpp)
+   Count / min / max / dt-weighted sum / sum² per bucket for V, I, T, SOC,
+   power at three resolutions.  ~144 B per bucket, static.
+   ========================================================= */
+#define ENABLE_ROLLUPS           true
+#define ROLLUP_SEC_BUCKETS       60      // 1 s  × 60  = last minute
+#define ROLLUP_MIN_BUCKETS       120     // 1 min × 120 = last 2 h
+#define ROLLUP_HOUR_BUCKETS      48      // 1 h  × 48  = last 2 days
+
+/* =========================================================
+   PARKING MODE  (parking.cpp)
+   Sleep after PARK_IDLE_MS with |I| < PARK_IDLE_CURRENT_A and no
+   GPS speed.  Wakes every PARK_WAKE_INTERVAL_S to check V / I and
+   on MPU6050 motion (ACCEL_INT_PIN).
+   Deep parking opens the motor and charge relays while asleep (no
+   pack protection runs between wakes) and reads temperature every
+   PARK_TEMP_EVERY_WAKES wakes, so a charger plugged in mid-sleep only
+   charges after motion or a voltage wake.  Light parking keeps the
+   relays and runs a full protection pass per wake – the default.
+   PARK_SLEEP_MA_* is the board's draw while asleep (bench-measured,
+   not visible to the INA219) for the per-mode average.
+   ========================================================= */
+#define ENABLE_PARKING           true
+#define PARK_MODE_LIGHT          1       // RAM kept, radio off, loop pass per wake
+#define PARK_MODE_DEEP           2       // RTC memory only, quick V / I check per wake
+#define PARK_MODE                PARK_MODE_LIGHT
+#define PARK_IDLE_MS             600000UL  // 10 min idle before parking
+#define PARK_IDLE_CURRENT_A      0.30f
+#define PARK_MAX_SPEED_KMH       2.0f
+#define PARK_WAKE_INTERVAL_S     60
+#define PARK_TEMP_EVERY_WAKES    5       // deep: DHT11 read every 5th timer wake
+#define PARK_MOTION_G            0.10f   // MPU6050 motion threshold
+#define PARK_SLEEP_MA_LIGHT      0.8f
+#define PARK_SLEEP_MA_DEEP       0.15f
+
+/* =========================================================
+   ADAPTIVE SAMPLING  (sampler.cpp)
+   V / I task: burst on relay edges, dI/dt and accelerometer
+   events, decimate when idle.  The main loop follows (100 ms /
+   1 s).  An idle pack notices a new load within one idle period.
+   ========================================================= */
+#define ENABLE_ADAPTIVE_SAMPLING true
+#define SAMPLE_BURST_HZ          1000
+#define SAMPLE_NORMAL_HZ         100
+#define SAMPLE_IDLE_HZ           1
+#define SAMPLE_BURST_MS          500     // after the last trigger
+#define SAMPLE_BURST_MAX_MS      2000UL  // longest continuous burst …
+#define SAMPLE_BURST_REST_MS     2000UL  // … then no burst for this long (≤ 50 % duty)
+#define SAMPLE_DIDT_A_PER_S      20.0f   // slew that starts a burst
+#define SAMPLE_IDLE_CURRENT_A    0.15f
+#define SAMPLE_IDLE_AFTER_MS     30000UL
+
+/* =========================================================
+   MOTOR INRUSH  (inrush.cpp)
+   Each motor start is captured at SAMPLE_BURST_HZ and checked
+   sample by sample against an envelope learned from earlier
+   starts (peak, decay τ, I²t) – replaces the fixed 500 ms
+   fault blanking.  Needs ENABLE_ADAPTIVE_SAMPLING.  With
+   ENABLE_PRECHARGE it learns a separate envelope, only from
+   starts whose pre-charge completed (see inrush.h).
+   ========================================================= */
+#define ENABLE_INRUSH_CAPTURE    true
+#define INRUSH_WINDOW_MS         500
+#define INRUSH_LEARN_STARTS      5       // starts before the learned envelope applies
+#define INRUSH_LEARN_ALPHA       0.1f    // EMA weight of each later start
+#define INRUSH_MIN_PEAK_A        2.0f    // below: no load connected, not learned
+#define INRUSH_PEAK_MARGIN       1.5f    // × learned peak
+#define INRUSH_TAU_MARGIN        2.0f    // × learned time-to-peak and τ
+#define INRUSH_I2T_MARGIN        2.0f    // × learned I²t
+#define INRUSH_TRIP_SAMPLES      3       // consecutive samples above the curve
+#define INRUSH_HARD_LIMIT_A      (MAX_DISCHARGE_CURRENT * 4.0f)   // one sample trips
+#define INRUSH_DEFAULT_PEAK_A    (MAX_DISCHARGE_CURRENT * 3.0f)   // until learned
+#define INRUSH_DEFAULT_TPEAK_MS  20.0f
+#define INRUSH_DEFAULT_TAU_MS    150.0f
+#define INRUSH_DEFAULT_I2T       4000.0f // A²s over the window
+#define INRUSH_HISTORY           16      // per-start metrics kept in RAM
+
+/* =========================================================
+   RELAY ACTUATORS  (actuator.cpp)
+   One owner for the charge / motor / fan outputs.  Minimum on /
+   off times stop control loops chattering a relay; protection
+   (fault, thermal, inrush trip) opens it regardless.
+   ========================================================= */
+#define CHARGE_RELAY_MIN_ON_MS   2000UL
+#define CHARGE_RELAY_MIN_OFF_MS  5000UL
+#define MOTOR_RELAY_MIN_ON_MS    INRUSH_WINDOW_MS   // let a start finish
+#define MOTOR_RELAY_MIN_OFF_MS   1000UL  // motor spun down before re-closing
+#define FAN_RELAY_MIN_ON_MS      30000UL
+#define FAN_RELAY_MIN_OFF_MS     30000UL
+#define RELAY_OPS_SAVE_EVERY     16      // switching ops between NVS saves
+
+/* =========================================================
+   MOTOR BUS PRE-CHARGE  (precharge.cpp)
+   The motor controller's DC-link is charged through a resistor
+   before the main relay closes.  Bus voltage is inferred as
+   pack − ΔI·R (no bus sense), ΔI relative to the steady current
+   just before the pre-charge relay closed.  47 Ω × 2200 µF → τ ≈ 0.1 s;
+   95 % is 3τ.  Failure latches FAULT_PRECHARGE_FAILURE.
+   ========================================================= */
+#define ENABLE_PRECHARGE          true
+#define PRECHARGE_RESISTOR_OHM    47.0f
+#define PRECHARGE_DONE_PCT        95.0f  // bus / pack to close the main relay
+#define PRECHARGE_MIN_PCT         85.0f  // settled above this also counts (controller draw)
+#define PRECHARGE_SETTLE_V        0.05f  // bus change between reads that counts as settled
+#define PRECHARGE_SETTLE_READS    2      // consecutive reads to accept / reject
+#define PRECHARGE_TIMEOUT_MS      2000UL // ≈ 20τ
+#define PRECHARGE_OVERLAP_MS      50UL   // both relays closed before the resistor drops out
+#define PRECHARGE_BYPASS_FACTOR   1.5f   // current above this × V/R: resistor bypassed
+#define PRECHARGE_BASE_STEADY_A   0.20f  // pass-to-pass change that counts as a steady baseline
+#define PRECHARGE_BASE_WAIT_MS    5000UL // no steady baseline this long: fail
+
+/* =========================================================
+   CC/CV CHARGE CONTROL  (charge.cpp)
+   Charge phases on filtered V / I instead of relay bang-bang
+   at CHARGE_START_V / CHARGE_STOP_V.  Terminates at C/20 in CV;
+   re-arms for a top-up at CHARGE_START_V.  The charger is a
+   fixed CC/CV source: a derated limit it exceeds pauses the
+   relay.  ETA to full from the live CV taper.
+   CHARGE_CV_V is the charger's CV setpoint and only drives phase
+   detection.  Only the pack average is measured, so the charger
+   is set to the old CHARGE_STOP_V until there is per-cell sensing.
+   Independently, the relay opens in any phase once the filtered
+   pack voltage passes CHARGE_CEILING_V (a charger set higher than
+   CHARGE_CV_V); a charger at CHARGE_CV_V never reaches it.
+   ========================================================= */
+#define ENABLE_CHARGE_CONTROL     true
+#define CHARGE_FILTER_MS          5000.0f // V / I low-pass time constant
+#define CHARGE_DETECT_A           0.2f    // filtered charge current that counts as charging
+#define CHARGE_CV_V               (4.10f * NUM_CELLS)   // charger CV setpoint, ≤ CHARGE_STOP_V
+#define CHARGE_CV_BAND            (0.02f * NUM_CELLS)   // within this of CV = CV phase
+#define CHARGE_CEILING_V          (CHARGE_STOP_V + 0.05f * NUM_CELLS)   // < MAX_VOLTAGE
+#define CHARGE_CV_DETECT_FRAC     0.85f   // or current below this × CC plateau
+#define CHARGE_TERM_C             0.05f   // C/20 taper termination
+#define CHARGE_TERM_CONFIRM_MS    30000UL
+#define CHARGE_CV_TIMEOUT_MS      (3UL * 3600UL * 1000UL)   // give up on a taper that never ends
+#define CHARGE_PRECOND_CELL_V     3.20f   // below: deeply discharged → precondition
+#define CHARGE_PRECOND_C          0.1f    // precondition current limit (× capacity)
+#define CHARGE_MIN_TEMP           0.0f    // no charge below
+#define CHARGE_COLD_TEMP          10.0f   // below: precondition
+#define CHARGE_WARM_TEMP          45.0f   // above: limit falls linearly …
+#define CHARGE_MAX_TEMP           55.0f   // … to zero here
+#define CHARGE_DERATE_MARGIN      0.10f   // allowed over the limit before pausing
+#define CHARGE_DERATE_HOLD_MS     10000UL // over the limit this long → pause
+#define CHARGE_DERATE_RETRY_MS    60000UL // pause length
+#define CHARGE_ETA_SAMPLE_MS      60000UL // CV taper slope interval
+#define CHARGE_ETA_ALPHA          0.3f    // τ smoothing between slope samples
+#define CHARGE_TAU_DEFAULT_MIN    30.0f   // taper τ until one has been measured
+
 /* =========================================================
    TIMING / SYSTEM
    ========================================================= */
@@ -180,6 +491,34 @@ static const char* SUPABASE_KEY =
 #define SENSOR_READ_INTERVAL_MS 200
 #define WATCHDOG_TIMEOUT_MS   30000
 
+/* =========================================================
+   PLANT SIMULATION  (bench only – NEVER enable on a vehicle)
+   =========================================================
+   Replaces the voltage / current / temperature drivers with a
+   closed-loop pack model (plant_sim.cpp) that reacts to the relay
+   GPIOs.  Scenarios: 0 = drive cycle, 1 = charger connect,
+   2 = fan failure, 3 = pre-charge fault (leaking motor bus).
+   ========================================================= */
+#ifndef ENABLE_PLANT_SIM
+#define ENABLE_PLANT_SIM      false
+#endif
+#ifndef PLANT_SIM_SCENARIO
+#define PLANT_SIM_SCENARIO    0
+#endif
+#define PLANT_SIM_TIME_SCALE  20.0f   // plant seconds per wall second
+
+/* =========================================================
+   BENCHMARKS
+   =========================================================
+   true → setup() runs the hot-path microbenchmarks (bench.cpp),
+   prints one "BENCH {json}" line per case and halts.
+   The host build (test/host, make bench) sets it on the
+   command line.
+   ========================================================= */
+#ifndef ENABLE_BENCHMARKS
+#define ENABLE_BENCHMARKS  false
+#endif
+
 /* =========================================================
    TELEGRAM
    ========================================================= */
@@ -3,6 +3,12 @@
 #include <Adafruit_INA219.h>
 #include "current.h"
 #include "config.h"
+#include "logger.h"
+#include "bus_lock.h"
+
+#if ENABLE_PLANT_SIM
+  #include "plant_sim.h"
+#endif
 
 /* ================= Private ================= */
 
@@ -18,12 +24,19 @@ static float peakCurrent = 0.0f;
 void initCurrent() {
   if (initialized) return;
 
+#if ENABLE_PLANT_SIM
+  initialized = true;
+  LOGI("INA219", "Bypassed – plant simulation");
+  return;
+#endif
+
   if (!ina219.begin()) {
-    Serial.println("[INA219] Sensor not detected – halting");
+    LOGE("INA219", "Sensor not detected – halting");
+    logFlush();
     while (1) { delay(1000); }
   }
 
-  Serial.println("[INA219] Initialized");
+  LOGI("INA219", "Initialized");
   initialized = true;
 }
 
@@ -45,9 +58,15 @@ void initCurrent() {
 float readCurrent() {
   if (!initialized) initCurrent();
 
+#if ENABLE_PLANT_SIM
+  float current_A = plantSimCurrent();
+#else
+  busLock(BUS_I2C);
   float current_A = ina219.getCurrent_mA() / 1000.0f;
+  busUnlock(BUS_I2C);
   // If charging and discharging are still swapped, uncomment:
   current_A = -current_A;
+#endif
 
   float absA = fabsf(current_A);
   if (absA > peakCurrent) peakCurrent = absA;
@@ -56,9 +75,21 @@ float readCurrent() {
 }
 
 CurrentData readCurrentData() {
+  float currentA = readCurrent();
+#if ENABLE_PLANT_SIM
+  float powerW = plantSimPower();
+#else
+  busLock(BUS_I2C);
+  float powerW = ina219.getPower_mW() / 1000.0f;   // INA219 power register: always positive
+  busUnlock(BUS_I2C);
+#endif
+  return classifyCurrent(currentA, powerW);
+}
+
+CurrentData classifyCurrent(float currentA, float powerW) {
   CurrentData data = {};
 
-  data.current = readCurrent();
+  data.current = currentA;
 
   if (data.current > IDLE_THRESHOLD_A)
     data.direction = CURRENT_DISCHARGING;
@@ -67,8 +98,7 @@ CurrentData readCurrentData() {
   else
     data.direction = CURRENT_IDLE;
 
-  /* INA219 power register: always positive, in mW */
-  data.powerWatts = ina219.getPower_mW() / 1000.0f;
+  data.powerWatts = powerW;
 
   data.overCurrent       = checkOvercurrent(data.current, data.direction);
   data.overcurrentWarning = (fabsf(data.current) > MAX_DISCHARGE_CURRENT * 0.8f);
@@ -109,7 +139,7 @@ bool checkOvercurrent(float current, CurrentDirection direction) {
 bool currentSensorHealthy() {
   float c = readCurrent();
   if (fabsf(c) > 100.0f) {
-    Serial.println("[INA219] Reading out of range");
+    LOGW("INA219", "Reading out of range");
     return false;
   }
   return true;
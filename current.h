@@ -22,6 +22,12 @@ struct CurrentData {
 void initCurrent();
 CurrentData readCurrentData();
 
+/**
+ * Direction + overcurrent classification of a reading taken
+ * elsewhere (sampler.cpp owns the INA219 when it is running).
+ */
+CurrentData classifyCurrent(float currentA, float powerW);
+
 float readCurrent();
 float calculatePower(float current, float voltage);
 
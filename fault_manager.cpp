@@ -1,8 +1,13 @@
 #include "fault_manager.h"
 #include "config.h"
+#include "logger.h"
 #include "gsm_sms.h"
 #include "telegram.h"
 #include "nvs_logger.h"
+#include "actuator.h"
+#if ENABLE_BLACKBOX
+  #include "blackbox.h"
+#endif
 #include <string.h>
 #include <math.h>
 
@@ -36,15 +41,50 @@ static float avgWindow(const float* w) {
 
 static uint8_t max8(uint8_t a, uint8_t b) { return (a > b) ? a : b; }
 
-/* Relay helpers – use config pin names */
-static void cutMotor()   { digitalWrite(LOAD_MOTOR_RELAY_PIN, LOW);  }
-static void allowMotor() { digitalWrite(LOAD_MOTOR_RELAY_PIN, HIGH); }
+/* Motor relay: a latched fault holds it open through its own vote;
+   clearing releases the vote and the motor control decides again. */
+static void cutMotor()   { actuatorRequest(ACT_MOTOR, ACT_SRC_FAULT, ACT_OFF);  }
+static void allowMotor() { actuatorRequest(ACT_MOTOR, ACT_SRC_FAULT, ACT_NONE); }
+
+/* Walk the bitmap from highest severity down and make that the primary fault */
+static void selectPrimaryFault() {
+  static const struct { FaultType t; const char* msg; } priority[] = {
+    { FAULT_THERMAL_RUNAWAY,        "THERMAL RUNAWAY"       },
+    { FAULT_OVER_TEMPERATURE,       "OVER TEMPERATURE"      },
+    { FAULT_UNDER_TEMPERATURE,      "UNDER TEMPERATURE"     },
+    { FAULT_OVER_VOLTAGE,           "OVER VOLTAGE"          },
+    { FAULT_UNDER_VOLTAGE,          "UNDER VOLTAGE"         },
+    { FAULT_OVER_CURRENT_CHARGE,    "OVER CURRENT CHARGE"   },
+    { FAULT_OVER_CURRENT_DISCHARGE, "OVER CURRENT DISCHARGE"},
+    { FAULT_MOTOR_INRUSH,           "MOTOR INRUSH"          },
+    { FAULT_PRECHARGE_FAILURE,      "PRECHARGE FAILED"      },
+    { FAULT_CELL_IMBALANCE,         "CELL IMBALANCE"        },
+    { FAULT_IMPACT_DETECTED,        "IMPACT DETECTED"       },
+    { FAULT_GEOFENCE_VIOLATION,     "GEOFENCE VIOLATION"    },
+    { FAULT_BATTERY_AGING,          "BATTERY AGING"         },
+    { FAULT_SENSOR_FAILURE,         "SENSOR FAILURE"        },
+    { FAULT_COMMUNICATION_LOSS,     "COMMUNICATION LOSS"    },
+  };
+  for (auto& p : priority) {
+    if (isBitSet(p.t)) {
+      strncpy(currentFault.faultMessage, p.msg,
+              sizeof(currentFault.faultMessage) - 1);
+      currentFault.primaryFault = p.t;
+      return;
+    }
+  }
+}
 
 static void latchFault(const char* msg, FaultType type, uint8_t sev) {
   bool isNew = !isBitSet(type);
   setFaultBit(type);
 
   if (isNew) currentFault.faultCount++;
+
+#if ENABLE_BLACKBOX
+  /* Each new fault type, and every impact, freezes the recorder */
+  if (isNew || type == FAULT_IMPACT_DETECTED) blackboxTrigger(type, msg);
+#endif
   currentFault.primaryFault = type;
   strncpy(currentFault.faultMessage, msg, sizeof(currentFault.faultMessage) - 1);
   currentFault.severity = max8(currentFault.severity, sev);
@@ -62,9 +102,9 @@ static void latchFault(const char* msg, FaultType type, uint8_t sev) {
     snprintf(alert, sizeof(alert), "BMS ALERT [%s]\nFAULT: %s", DEVICE_ID, msg);
 
     gsmSendSMS(alert);
-    sendTelegramForced(String(alert));   // fault latch – must never be skipped
+    sendTelegramForced(alert);   // fault latch – must never be skipped
 
-    Serial.printf("[FAULT] Latched: %s (sev=%u)\n", msg, sev);
+    LOGE("FAULT", "Latched: %s (sev=%u)", msg, sev);
   }
 }
 
@@ -77,11 +117,8 @@ void initFaultManager() {
   strncpy(currentFault.faultMessage, "NONE", sizeof(currentFault.faultMessage));
   currentFault.primaryFault = FAULT_NONE;
 
-  pinMode(LOAD_MOTOR_RELAY_PIN, OUTPUT);
-  digitalWrite(LOAD_MOTOR_RELAY_PIN, LOW);  // keep OFF during init – enabled after all systems ready
-
   initialized = true;
-  Serial.println("[FAULT] Manager initialized");
+  LOGI("FAULT", "Manager initialized");
 }
 
 /* ================= Fault Evaluation ================= */
@@ -138,6 +175,7 @@ bool        isFaultActive(FaultType type) { return isBitSet(type); }
 const char* faultReason()                 { return currentFault.faultMessage; }
 FaultData   getFaultData()                { return currentFault; }
 uint8_t     getFaultSeverity()            { return currentFault.severity; }
+uint32_t    getFaultBitmap()              { return faultBitmap; }
 
 /* ================= Auto Fault Recovery ================= */
 
@@ -163,14 +201,14 @@ void autoCheckFaultRecovery(
   /* ── Over Voltage recovery ── */
   if (isBitSet(FAULT_OVER_VOLTAGE) && packVoltage < (MAX_VOLTAGE - 0.1f)) {
     faultBitmap &= ~(1UL << FAULT_OVER_VOLTAGE);
-    Serial.println("[FAULT] OV cleared");
+    LOGI("FAULT", "OV cleared");
     changed = true;
   }
 
   /* ── Under Voltage recovery ── */
   if (isBitSet(FAULT_UNDER_VOLTAGE) && packVoltage > (MIN_VOLTAGE + 0.1f)) {
     faultBitmap &= ~(1UL << FAULT_UNDER_VOLTAGE);
-    Serial.println("[FAULT] UV cleared");
+    LOGI("FAULT", "UV cleared");
     changed = true;
   }
 
@@ -178,12 +216,12 @@ void autoCheckFaultRecovery(
   if (!overcurrent) {
     if (isBitSet(FAULT_OVER_CURRENT_CHARGE)) {
       faultBitmap &= ~(1UL << FAULT_OVER_CURRENT_CHARGE);
-      Serial.println("[FAULT] OC-CHG cleared");
+      LOGI("FAULT", "OC-CHG cleared");
       changed = true;
     }
     if (isBitSet(FAULT_OVER_CURRENT_DISCHARGE)) {
       faultBitmap &= ~(1UL << FAULT_OVER_CURRENT_DISCHARGE);
-      Serial.println("[FAULT] OC-DIS cleared");
+      LOGI("FAULT", "OC-DIS cleared");
       changed = true;
     }
   }
@@ -191,14 +229,14 @@ void autoCheckFaultRecovery(
   /* ── Over Temperature recovery (2 °C hysteresis) ── */
   if (isBitSet(FAULT_OVER_TEMPERATURE) && temperature < (MAX_CELL_TEMP - 2.0f)) {
     faultBitmap &= ~(1UL << FAULT_OVER_TEMPERATURE);
-    Serial.println("[FAULT] OT cleared");
+    LOGI("FAULT", "OT cleared");
     changed = true;
   }
 
   /* ── Under Temperature recovery (2 °C hysteresis) ── */
   if (isBitSet(FAULT_UNDER_TEMPERATURE) && temperature > (MIN_CELL_TEMP + 2.0f)) {
     faultBitmap &= ~(1UL << FAULT_UNDER_TEMPERATURE);
-    Serial.println("[FAULT] UT cleared");
+    LOGI("FAULT", "UT cleared");
     changed = true;
   }
 
@@ -209,7 +247,9 @@ void autoCheckFaultRecovery(
    * Non-recoverable faults that always require manual clearFaults():
    *   FAULT_THERMAL_RUNAWAY, FAULT_IMPACT_DETECTED,
    *   FAULT_GEOFENCE_VIOLATION, FAULT_BATTERY_AGING,
-   *   FAULT_CELL_IMBALANCE, FAULT_SENSOR_FAILURE, FAULT_COMMUNICATION_LOSS
+   *   FAULT_CELL_IMBALANCE, FAULT_SENSOR_FAILURE, FAULT_COMMUNICATION_LOSS,
+   *   FAULT_MOTOR_INRUSH (a start outside the envelope is not retried),
+   *   FAULT_PRECHARGE_FAILURE (bus leak / short until inspected)
    */
 
   if (!changed) return;
@@ -224,33 +264,12 @@ void autoCheckFaultRecovery(
     strncpy(currentFault.faultMessage, "NONE", sizeof(currentFault.faultMessage));
     currentFault.primaryFault = FAULT_NONE;
     allowMotor();
-    Serial.println("[FAULT] All faults resolved – system recovered, motor relay ON");
+    LOGI("FAULT", "All faults resolved – system recovered, motor released");
   } else {
-    /* Still faulted on other bits – update primary fault message to most recent set bit */
-    /* Walk the bitmap from highest severity down */
-    static const struct { FaultType t; const char* msg; } priority[] = {
-      { FAULT_THERMAL_RUNAWAY,        "THERMAL RUNAWAY"       },
-      { FAULT_OVER_TEMPERATURE,       "OVER TEMPERATURE"      },
-      { FAULT_UNDER_TEMPERATURE,      "UNDER TEMPERATURE"     },
-      { FAULT_OVER_VOLTAGE,           "OVER VOLTAGE"          },
-      { FAULT_UNDER_VOLTAGE,          "UNDER VOLTAGE"         },
-      { FAULT_OVER_CURRENT_CHARGE,    "OVER CURRENT CHARGE"   },
-      { FAULT_OVER_CURRENT_DISCHARGE, "OVER CURRENT DISCHARGE"},
-      { FAULT_CELL_IMBALANCE,         "CELL IMBALANCE"        },
-      { FAULT_IMPACT_DETECTED,        "IMPACT DETECTED"       },
-      { FAULT_GEOFENCE_VIOLATION,     "GEOFENCE VIOLATION"    },
-      { FAULT_BATTERY_AGING,          "BATTERY AGING"         },
-    };
-    for (auto& p : priority) {
-      if (isBitSet(p.t)) {
-        strncpy(currentFault.faultMessage, p.msg,
-                sizeof(currentFault.faultMessage) - 1);
-        currentFault.primaryFault = p.t;
-        break;
-      }
-    }
-    Serial.printf("[FAULT] Partial recovery – remaining: %s\n",
-                  currentFault.faultMessage);
+    /* Still faulted on other bits – primary becomes the most severe remaining */
+    selectPrimaryFault();
+    LOGI("FAULT", "Partial recovery – remaining: %s",
+         currentFault.faultMessage);
   }
 }
 
@@ -260,7 +279,27 @@ void clearFaults() {
   currentFault.primaryFault = FAULT_NONE;
   faultBitmap = 0;
   allowMotor();   // re-enable motor only after manual clear
-  Serial.println("[FAULT] Cleared – motor relay restored");
+  LOGI("FAULT", "Cleared – motor released");
+}
+
+/* ================= Parking Restore ================= */
+
+/* No alert / blackbox / NVS count: these faults were already
+   reported before the device went to sleep.                   */
+void restoreFaultState(uint32_t bitmap, uint32_t faultCount, uint8_t severity) {
+  if (!initialized) initFaultManager();
+  currentFault.faultCount = faultCount;
+  if (bitmap == 0) return;
+
+  faultBitmap                 = bitmap;
+  currentFault.active         = true;
+  currentFault.latched        = true;
+  currentFault.faultTimestamp = millis();
+  currentFault.severity       = severity;
+  selectPrimaryFault();
+  cutMotor();
+  LOGW("FAULT", "Restored latched: %s (bitmap 0x%04lX)",
+       currentFault.faultMessage, (unsigned long)bitmap);
 }
 
 bool shouldAllowMotor() { return !currentFault.latched; }
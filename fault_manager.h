@@ -17,7 +17,9 @@ enum FaultType {
   FAULT_GEOFENCE_VIOLATION    = 10,
   FAULT_IMPACT_DETECTED       = 11,
   FAULT_THERMAL_RUNAWAY       = 12,
-  FAULT_BATTERY_AGING         = 13
+  FAULT_BATTERY_AGING         = 13,
+  FAULT_MOTOR_INRUSH          = 14,
+  FAULT_PRECHARGE_FAILURE     = 15
 };
 
 /* ================= Fault Data ================= */
@@ -63,6 +65,7 @@ bool        isFaultActive(FaultType type);
 const char* faultReason();
 FaultData   getFaultData();
 uint8_t     getFaultSeverity();
+uint32_t    getFaultBitmap();      // bit n set ⇔ FaultType n active
 void        clearFaults();
 
 /**
@@ -82,6 +85,13 @@ void autoCheckFaultRecovery(
   float temperature
 );
 
+/**
+ * Re-latch faults carried across deep sleep (parking.cpp): sets the
+ * bitmap, fault count and severity, cuts the motor – no alerts
+ * are re-sent.
+ */
+void restoreFaultState(uint32_t bitmap, uint32_t faultCount, uint8_t severity);
+
 /* Motor permission */
 bool shouldAllowMotor();
 
@@ -0,0 +1,287 @@
+#include "geofence.h"
+#include "config.h"
+#include "logger.h"
+#include "gps.h"
+#include <math.h>
+
+#define GEO_EARTH_R_M   6371000.0f
+#define GEO_DEG2RAD     ((float)M_PI / 180.0f)
+#define GEO_WORDS       ((GEOFENCE_MAX_ZONES + 31) / 32)
+
+/* ================= Zones ================= */
+
+enum : uint8_t { SHAPE_CIRCLE, SHAPE_POLYGON };
+
+struct Zone {
+  char        name[16];
+  GeoZoneKind kind;
+  uint8_t     shape;
+  uint8_t     vCount;
+  uint16_t    vFirst;              // into vx / vy
+  float       lat0, lon0;          // circle centre / polygon projection origin
+  float       mPerDegLon;          // at lat0
+  float       radiusM;
+  float       innerM;              // inradius (polygons: half the shorter bbox side)
+  float       minLat, maxLat, minLon, maxLon;   // bbox incl. GEOFENCE_BBOX_MARGIN_M
+};
+
+static Zone     zones[GEOFENCE_MAX_ZONES];
+static uint16_t zoneCount   = 0;
+static uint16_t keepInCount = 0;
+
+/* Polygon vertices, metres east / north of the zone origin */
+static float    vx[GEOFENCE_VERTEX_POOL];
+static float    vy[GEOFENCE_VERTEX_POOL];
+static uint16_t vUsed = 0;
+
+/* ================= Grid index ================= */
+
+static uint32_t gridBits[GEOFENCE_GRID_N * GEOFENCE_GRID_N][GEO_WORDS];
+static float    gridMinLat, gridMinLon, cellLat, cellLon;
+static bool     indexDirty = true;
+
+/* ================= State ================= */
+
+static uint32_t       insideBits[GEO_WORDS];
+static bool           primed = false;      // first fix decides by sign, no hysteresis
+static GeofenceStatus status = {};
+
+static const float M_PER_DEG_LAT = GEO_EARTH_R_M * GEO_DEG2RAD;
+
+/* ================= Helpers ================= */
+
+static int addZone(const char* name, GeoZoneKind kind, uint8_t shape,
+                   float lat0, float lon0) {
+  if (zoneCount >= GEOFENCE_MAX_ZONES) {
+    LOGW("GEOFENCE", "Zone table full – '%s' not added", name);
+    return -1;
+  }
+  Zone& z = zones[zoneCount];
+  memset(&z, 0, sizeof(z));
+  strncpy(z.name, name, sizeof(z.name) - 1);
+  z.kind       = kind;
+  z.shape      = shape;
+  z.lat0       = lat0;
+  z.lon0       = lon0;
+  z.mPerDegLon = M_PER_DEG_LAT * cosf(lat0 * GEO_DEG2RAD);
+
+  if (kind == GeoZoneKind::KEEP_IN) keepInCount++;
+  indexDirty = true;
+  return zoneCount++;
+}
+
+static void setBBox(Zone& z, float southM, float northM, float westM, float eastM) {
+  z.minLat = z.lat0 + (southM - GEOFENCE_BBOX_MARGIN_M) / M_PER_DEG_LAT;
+  z.maxLat = z.lat0 + (northM + GEOFENCE_BBOX_MARGIN_M) / M_PER_DEG_LAT;
+  z.minLon = z.lon0 + (westM  - GEOFENCE_BBOX_MARGIN_M) / z.mPerDegLon;
+  z.maxLon = z.lon0 + (eastM  + GEOFENCE_BBOX_MARGIN_M) / z.mPerDegLon;
+}
+
+static void buildIndex() {
+  memset(gridBits, 0, sizeof(gridBits));
+  indexDirty = false;
+  if (zoneCount == 0) return;
+
+  float minLat = zones[0].minLat, maxLat = zones[0].maxLat;
+  float minLon = zones[0].minLon, maxLon = zones[0].maxLon;
+  for (uint16_t i = 1; i < zoneCount; i++) {
+    minLat = fminf(minLat, zones[i].minLat);  maxLat = fmaxf(maxLat, zones[i].maxLat);
+    minLon = fminf(minLon, zones[i].minLon);  maxLon = fmaxf(maxLon, zones[i].maxLon);
+  }
+  gridMinLat = minLat;
+  gridMinLon = minLon;
+  cellLat    = (maxLat - minLat) / GEOFENCE_GRID_N;
+  cellLon    = (maxLon - minLon) / GEOFENCE_GRID_N;
+
+  for (uint16_t i = 0; i < zoneCount; i++) {
+    const Zone& z = zones[i];
+    int r0 = constrain((int)((z.minLat - gridMinLat) / cellLat), 0, GEOFENCE_GRID_N - 1);
+    int r1 = constrain((int)((z.maxLat - gridMinLat) / cellLat), 0, GEOFENCE_GRID_N - 1);
+    int c0 = constrain((int)((z.minLon - gridMinLon) / cellLon), 0, GEOFENCE_GRID_N - 1);
+    int c1 = constrain((int)((z.maxLon - gridMinLon) / cellLon), 0, GEOFENCE_GRID_N - 1);
+    for (int r = r0; r <= r1; r++)
+      for (int c = c0; c <= c1; c++)
+        gridBits[r * GEOFENCE_GRID_N + c][i >> 5] |= 1UL << (i & 31);
+  }
+}
+
+/* Bitset of candidate zones for a point, or nullptr if outside the grid */
+static const uint32_t* cellFor(float lat, float lon) {
+  if (zoneCount == 0) return nullptr;
+  int r = (int)floorf((lat - gridMinLat) / cellLat);
+  int c = (int)floorf((lon - gridMinLon) / cellLon);
+  if (r < 0 || c < 0 || r >= GEOFENCE_GRID_N || c >= GEOFENCE_GRID_N) return nullptr;
+  return gridBits[r * GEOFENCE_GRID_N + c];
+}
+
+static float segmentDist(float px, float py, float ax, float ay, float bx, float by) {
+  float dx = bx - ax, dy = by - ay;
+  float len2 = dx * dx + dy * dy;
+  float t = len2 > 0.0f ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0.0f;
+  t = constrain(t, 0.0f, 1.0f);
+  float ex = ax + t * dx - px, ey = ay + t * dy - py;
+  return sqrtf(ex * ex + ey * ey);
+}
+
+/* Signed depth in metres: + inside, − outside */
+static float zoneDepth(const Zone& z, float lat, float lon, float h) {
+  if (lat < z.minLat || lat > z.maxLat || lon < z.minLon || lon > z.maxLon)
+    return -GEOFENCE_BBOX_MARGIN_M;
+
+  float x = (lon - z.lon0) * z.mPerDegLon;
+  float y = (lat - z.lat0) * M_PER_DEG_LAT;
+
+  if (z.shape == SHAPE_CIRCLE) {
+    float depth = z.radiusM - sqrtf(x * x + y * y);
+    if (fabsf(depth) < 2.0f * h) {
+      /* Near the edge: projection error matters, use the great circle */
+      status.haversineFallbacks++;
+      depth = z.radiusM - calculateDistance(z.lat0, z.lon0, lat, lon);
+    }
+    return depth;
+  }
+
+  /* Polygon: even-odd ray cast + distance to the nearest edge */
+  bool  in   = false;
+  float best = INFINITY;
+  const float* px = &vx[z.vFirst];
+  const float* py = &vy[z.vFirst];
+  for (uint8_t i = 0, j = z.vCount - 1; i < z.vCount; j = i++) {
+    if (((py[i] > y) != (py[j] > y)) &&
+        (x < (px[j] - px[i]) * (y - py[i]) / (py[j] - py[i]) + px[i]))
+      in = !in;
+    best = fminf(best, segmentDist(x, y, px[j], py[j], px[i], py[i]));
+  }
+  return in ? best : -best;
+}
+
+/* ================= API ================= */
+
+void geofenceClear() {
+  zoneCount   = 0;
+  keepInCount = 0;
+  vUsed       = 0;
+  primed      = false;
+  indexDirty  = true;
+  memset(insideBits, 0, sizeof(insideBits));
+  status = {};
+  status.zone = -1;
+}
+
+void geofenceInit() {
+  geofenceClear();
+  geofenceAddCircle("home", GeoZoneKind::KEEP_IN,
+                    GEOFENCE_LAT, GEOFENCE_LON, GEOFENCE_RADIUS_M);
+  LOGI("GEOFENCE", "Initialized – %u zone(s)", zoneCount);
+}
+
+int geofenceAddCircle(const char* name, GeoZoneKind kind,
+                      float lat, float lon, float radiusM) {
+  int idx = addZone(name, kind, SHAPE_CIRCLE, lat, lon);
+  if (idx < 0) return -1;
+  Zone& z = zones[idx];
+  z.radiusM = radiusM;
+  z.innerM  = radiusM;
+  setBBox(z, -radiusM, radiusM, -radiusM, radiusM);
+  return idx;
+}
+
+int geofenceAddPolygon(const char* name, GeoZoneKind kind,
+                       const GeoPoint* pts, uint8_t count) {
+  if (count < 3 || vUsed + count > GEOFENCE_VERTEX_POOL) {
+    LOGW("GEOFENCE", "Polygon '%s' rejected (%u vertices, pool %u/%u)",
+         name, count, vUsed, GEOFENCE_VERTEX_POOL);
+    return -1;
+  }
+  int idx = addZone(name, kind, SHAPE_POLYGON, pts[0].lat, pts[0].lon);
+  if (idx < 0) return -1;
+  Zone& z = zones[idx];
+  z.vFirst = vUsed;
+  z.vCount = count;
+
+  float s = 0, n = 0, w = 0, e = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    float x = (pts[i].lon - z.lon0) * z.mPerDegLon;
+    float y = (pts[i].lat - z.lat0) * M_PER_DEG_LAT;
+    vx[vUsed + i] = x;
+    vy[vUsed + i] = y;
+    s = fminf(s, y);  n = fmaxf(n, y);
+    w = fminf(w, x);  e = fmaxf(e, x);
+  }
+  vUsed += count;
+  z.innerM = 0.5f * fminf(n - s, e - w);
+  setBBox(z, s, n, w, e);
+  return idx;
+}
+
+bool geofenceUpdate(float lat, float lon, float accuracyM) {
+  if (indexDirty) buildIndex();
+
+  float h = fminf(fmaxf(GEOFENCE_HYSTERESIS_M, accuracyM), GEOFENCE_BBOX_MARGIN_M);
+  const uint32_t* cell = cellFor(lat, lon);
+
+  status.checks++;
+  status.lastCandidates = 0;
+
+  for (uint16_t w = 0; w < GEO_WORDS; w++) {
+    uint32_t cand = cell ? cell[w] : 0;
+
+    /* Not a candidate ⇒ at least the bbox margin outside */
+    insideBits[w] &= cand;
+
+    while (cand) {
+      uint8_t  b   = __builtin_ctz(cand);
+      cand        &= cand - 1;
+      uint16_t i   = w * 32 + b;
+      uint32_t bit = 1UL << b;
+      status.lastCandidates++;
+
+      /* The band never exceeds half the inradius, or a zone smaller than
+         2h could not be re-entered once left.  A fix coarser than the
+         zone itself says nothing about it: hold the state. */
+      const Zone& z  = zones[i];
+      float       zh = fminf(h, 0.5f * z.innerM);
+      float depth = zoneDepth(z, lat, lon, zh);
+      bool  in    = insideBits[w] & bit;
+      if (!primed)                   in = depth > 0.0f;
+      else if (accuracyM > z.innerM) status.coarseSkips++;
+      else if (depth >  zh)          in = true;
+      else if (depth < -zh)          in = false;
+
+      if (in) insideBits[w] |= bit;
+      else    insideBits[w] &= ~bit;
+    }
+  }
+  primed = true;
+
+  /* KEEP_OUT entered beats outside-all-KEEP_IN */
+  int16_t  culprit   = -1;
+  bool     inKeepIn  = false;
+  uint16_t insideCnt = 0;
+  for (uint16_t w = 0; w < GEO_WORDS; w++) {
+    uint32_t bits = insideBits[w];
+    insideCnt += __builtin_popcount(bits);
+    while (bits) {
+      uint16_t i = w * 32 + __builtin_ctz(bits);
+      bits &= bits - 1;
+      if (zones[i].kind == GeoZoneKind::KEEP_IN) inKeepIn = true;
+      else if (culprit < 0)                      culprit  = i;
+    }
+  }
+
+  bool violation = (culprit >= 0) || (keepInCount > 0 && !inKeepIn);
+  bool changed   = (violation != status.violation);
+
+  status.violation   = violation;
+  status.zone        = culprit;
+  status.zoneName    = culprit >= 0 ? zones[culprit].name : "permitted area";
+  status.zones       = zoneCount;
+  status.zonesInside = insideCnt;
+  if (changed) status.transitions++;
+  return changed;
+}
+
+GeofenceStatus geofenceGetStatus() {
+  status.zones = zoneCount;
+  return status;
+}
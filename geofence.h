@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Geofence Engine
+ *  Circle and polygon zones, each either KEEP_IN (home, depot –
+ *  the vehicle must be inside at least one) or KEEP_OUT
+ *  (forbidden area).
+ *
+ *  Per fix:
+ *    1. Grid prefilter – the union of all zone boxes is split
+ *       into GEOFENCE_GRID_N² cells; each cell holds a bitset of
+ *       the zones whose (margin-expanded) bounding box touches
+ *       it.  Zones not in the fix's cell are outside, no maths.
+ *    2. Candidates: equirectangular projection around the zone
+ *       origin → signed depth in metres (+ inside, − outside).
+ *       Circles near their edge are re-measured with haversine
+ *       (calculateDistance()).
+ *    3. Hysteresis: a zone is entered at depth > h and left at
+ *       depth < −h, h = max(GEOFENCE_HYSTERESIS_M, fix accuracy),
+ *       capped at half the zone's inradius.  A fix whose accuracy
+ *       is worse than the inradius leaves that zone's state alone.
+ *
+ *  Polygons are projected to metres once, when added; keep
+ *  them under a few tens of km across.
+ * ============================================================
+ */
+
+enum class GeoZoneKind : uint8_t { KEEP_IN, KEEP_OUT };
+
+struct GeoPoint {
+  float lat;
+  float lon;
+};
+
+struct GeofenceStatus {
+  bool        violation;
+  int16_t     zone;                 // KEEP_OUT zone entered, -1 = outside all KEEP_IN
+  const char* zoneName;
+  uint16_t    zones;
+  uint16_t    zonesInside;
+  uint16_t    lastCandidates;       // zones past the prefilter on the last fix
+  uint32_t    checks;
+  uint32_t    haversineFallbacks;
+  uint32_t    coarseSkips;          // zone evaluations held: fix accuracy > zone inradius
+  uint32_t    transitions;          // violation state changes
+};
+
+/** Reset and load the zone from config.h (GEOFENCE_LAT/LON/RADIUS_M, KEEP_IN). */
+void geofenceInit();
+
+void geofenceClear();
+
+/** @return zone index, or -1 if the table is full */
+int geofenceAddCircle(const char* name, GeoZoneKind kind,
+                      float lat, float lon, float radiusM);
+
+/** @return zone index, or -1 if the table / vertex pool is full */
+int geofenceAddPolygon(const char* name, GeoZoneKind kind,
+                       const GeoPoint* pts, uint8_t count);
+
+/**
+ * Evaluate one fix against every zone.
+ * @return true if the violation state changed
+ */
+bool geofenceUpdate(float lat, float lon, float accuracyM);
+
+GeofenceStatus geofenceGetStatus();
@@ -6,33 +6,41 @@
    1. Hardware GPS module (UART1, TinyGPS++)
       Tried first on every update cycle.  If a valid fix exists (location age
       < 2 s) it is used and WiFi geo is skipped entirely.
+      Sentences are assembled in the UART event task (onReceive) and queued;
+      the loop parses whole sentences.  New fixes go through gps_track.cpp
+      (Kalman smoothing, trip odometer) when GPS_TRACK_ENABLED.
 
    2. WiFi MAC geolocation  (BeaconDB – free, no API key)
       Activated automatically when hardware GPS has no fix.
-      The ESP32 scans nearby APs → sends BSSIDs + RSSI to BeaconDB →
-      receives lat/lon + accuracy estimate.
+      The ESP32 scans nearby APs (async) → sends BSSIDs + RSSI to BeaconDB →
+      receives lat/lon + accuracy estimate.  Fixes are cached by a hash of
+      the strongest BSSIDs, so a parked vehicle does not re-query.
       Accuracy: 15–100 m in urban areas.
 
    GEOFENCE
    ─────────────────────────────────────────────────────────────────────────
-   Geofence violation checking is done on the UI side.
-   Firmware reports only raw coordinates.  The UI compares them against the
-   saved home location and radius that the user configured.
+   Zones are evaluated on-device by geofence.cpp (called from
+   checkExternalEvents() with each fix); a violation sends an alert
+   but does not fault or cut the motor.  The UI still gets the raw
+   coordinates.
    ═══════════════════════════════════════════════════════════════════════════ */
 
 #include "gps.h"
 #include "config.h"
+#include "logger.h"
+#include "wifi_manager.h"
 
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <NetworkClientSecure.h>
-#include <ArduinoJson.h>
 #include <math.h>
 
 /* ── Hardware GPS (always compiled when ENABLE_HARDWARE_GPS is set) ── */
 #if ENABLE_HARDWARE_GPS
   #include <TinyGPS++.h>
   #include <HardwareSerial.h>
+  #include <atomic>
+  #include "gps_track.h"
   static TinyGPSPlus    hwGps;
   static HardwareSerial hwGpsSerial(1);
   /* Track whether the module has ever produced a sentence so we know
@@ -42,6 +50,58 @@
   /* Give the module this many ms to prove it exists before we decide
      it is absent and drop straight to WiFi geo.                    */
   #define HW_GPS_DETECT_TIMEOUT_MS  5000
+
+  /* UART driver buffer: ~1 s of NMEA at 9600 baud */
+  #define HW_GPS_RX_BUFFER          1024
+  /* 1-σ error per unit HDOP (user equivalent range error) */
+  #define HW_GPS_UERE_M             5.0f
+
+  /* ── NMEA sentence ring (UART event task → loop) ──
+     The driver's event task assembles '$'…'\n' sentences; updateGPS()
+     feeds whole sentences to TinyGPS++, so a slow loop costs at most
+     a dropped (and counted) sentence, never a torn one.             */
+  #define NMEA_LEN    96      // NMEA 0183 max is 82
+  #define NMEA_SLOTS  16      // power of two
+
+  static char                  nmea[NMEA_SLOTS][NMEA_LEN];
+  static std::atomic<uint32_t> nmeaHead{0};     // producer: onGpsReceive
+  static std::atomic<uint32_t> nmeaTail{0};     // consumer: pollHardwareGPS
+  static std::atomic<uint32_t> nmeaDropped{0};  // ring full
+  static std::atomic<uint32_t> nmeaTooLong{0};
+  static std::atomic<uint32_t> uartOverruns{0}; // driver buffer / FIFO overflow
+  static std::atomic<uint32_t> nmeaSentences{0};
+
+  static char   rxSentence[NMEA_LEN];           // producer-only
+  static size_t rxLen = 0;
+
+  static void onGpsReceive() {
+    while (hwGpsSerial.available()) {
+      char c = (char)hwGpsSerial.read();
+      if (c == '$') { rxSentence[0] = c; rxLen = 1; continue; }
+      if (rxLen == 0) continue;                  // mid-sentence after a drop
+      if (c == '\r') continue;
+      if (c == '\n') {
+        rxSentence[rxLen] = '\0';
+        rxLen = 0;
+        nmeaSentences.fetch_add(1, std::memory_order_relaxed);
+        uint32_t h = nmeaHead.load(std::memory_order_relaxed);
+        if (h - nmeaTail.load(std::memory_order_acquire) >= NMEA_SLOTS) {
+          nmeaDropped.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        memcpy(nmea[h & (NMEA_SLOTS - 1)], rxSentence, sizeof(rxSentence));
+        nmeaHead.store(h + 1, std::memory_order_release);
+        continue;
+      }
+      if (rxLen < NMEA_LEN - 1) rxSentence[rxLen++] = c;
+      else { nmeaTooLong.fetch_add(1, std::memory_order_relaxed); rxLen = 0; }
+    }
+  }
+
+  static void onGpsReceiveError(hardwareSerial_error_t err) {
+    if (err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR)
+      uartOverruns.fetch_add(1, std::memory_order_relaxed);
+  }
 #endif
 
 /* ═══════════════════════════════════════════
@@ -59,6 +119,21 @@
 
 static const char* GEO_API_URL = "https://api.beacondb.net/v1/geolocate";
 
+/* Async scan dwell per channel and overall deadline */
+#define GEO_SCAN_MS_PER_CHAN   100
+#define GEO_SCAN_TIMEOUT_MS    10000UL
+
+/* Request / response buffers – static so a fix never touches the heap */
+#define GEO_MAX_APS            20
+static char geoBody[40 + GEO_MAX_APS * 80];
+static char geoResp[384];
+
+/* Fingerprint cache: top-k strongest BSSIDs → last resolved fix.
+   A parked vehicle sees the same APs, so repeat lookups stay local. */
+#define GEO_FP_TOP_K           3
+#define GEO_CACHE_SLOTS        16
+#define GEO_CACHE_TTL_MS       (6UL * 3600UL * 1000UL)
+
 /* ═══════════════════════════════════════════
    STATE
    ═══════════════════════════════════════════ */
@@ -67,6 +142,10 @@ static bool          initialized  = false;
 static GPSData       currentData  = {};
 static unsigned long lastGeoMs    = 0;
 
+static bool          geoScanning  = false;
+static unsigned long geoScanMs    = 0;
+static GeoStats      geoStats     = {};
+
 #define EARTH_RADIUS_M 6371000.0f
 static float toRadians(float deg) { return deg * (float)M_PI / 180.0f; }
 
@@ -81,16 +160,22 @@ void initGPS() {
   currentData.source = GPSData::Source::NONE;
 
 #if ENABLE_HARDWARE_GPS
+  hwGpsSerial.setRxBufferSize(HW_GPS_RX_BUFFER);
   hwGpsSerial.begin(GPS_BAUD, SERIAL_8N1, GPS_RX, GPS_TX);
+  hwGpsSerial.onReceive(onGpsReceive);
+  hwGpsSerial.onReceiveError(onGpsReceiveError);
   hwGpsInitMs = millis();
-  Serial.println("[GPS] Hardware GPS module initialised on UART1 (primary)");
+#if GPS_TRACK_ENABLED
+  gpsTrackInit();
+#endif
+  LOGI("GPS", "Hardware GPS module initialised on UART1 (primary)");
 #endif
 
-  Serial.println("[GPS] WiFi geolocation ready as fallback (BeaconDB)");
-  Serial.printf("[GPS] Device MAC: %s\n", WiFi.macAddress().c_str());
+  LOGI("GPS", "WiFi geolocation ready as fallback (BeaconDB)");
+  LOGI("GPS", "Device MAC: %s", WiFi.macAddress().c_str());
 
   initialized = true;
-  Serial.println("[GPS] Initialized");
+  LOGI("GPS", "Initialized");
 }
 
 /* ═══════════════════════════════════════════
@@ -100,16 +185,20 @@ void initGPS() {
 
 static bool pollHardwareGPS() {
 #if ENABLE_HARDWARE_GPS
-  /* Drain UART buffer */
-  while (hwGpsSerial.available()) {
-    char c = hwGpsSerial.read();
-    hwGps.encode(c);
-    /* Any character means the module is wired and talking */
+  /* Feed queued sentences to the parser */
+  uint32_t t = nmeaTail.load(std::memory_order_relaxed);
+  uint32_t h = nmeaHead.load(std::memory_order_acquire);
+  for (; t != h; t++) {
+    for (const char* p = nmea[t & (NMEA_SLOTS - 1)]; *p; p++) hwGps.encode(*p);
+    hwGps.encode('\r');
+    hwGps.encode('\n');
+    /* Any sentence means the module is wired and talking */
     if (!hwGpsModulePresent) {
       hwGpsModulePresent = true;
-      Serial.println("[GPS] Hardware GPS module detected");
+      LOGI("GPS", "Hardware GPS module detected");
     }
   }
+  nmeaTail.store(t, std::memory_order_release);
 
   /* If no NMEA data seen within the detect timeout, treat as absent */
   if (!hwGpsModulePresent &&
@@ -122,16 +211,37 @@ static bool pollHardwareGPS() {
     return false;
   }
 
+  /* Nothing new since the last call – keep the current fix */
+  if (!hwGps.location.isUpdated())
+    return currentData.source == GPSData::Source::HARDWARE_GPS;
+
   /* Valid hardware fix ─ update shared state */
+  float hdop = hwGps.hdop.isValid() ? (float)hwGps.hdop.hdop() : 1.0f;
   currentData.valid      = true;
   currentData.latitude   = (float)hwGps.location.lat();
   currentData.longitude  = (float)hwGps.location.lng();
-  currentData.accuracy   = 5.0f;   // hardware GPS ~3–5 m CEP
+  currentData.accuracy   = HW_GPS_UERE_M * hdop;
   currentData.altitude   = hwGps.altitude.isValid()   ? (float)hwGps.altitude.meters()    : 0.0f;
   currentData.speed      = hwGps.speed.isValid()      ? (float)hwGps.speed.kmph()         : 0.0f;
   currentData.satellites = hwGps.satellites.isValid() ? (uint8_t)hwGps.satellites.value() : 0;
   currentData.source     = GPSData::Source::HARDWARE_GPS;
 
+#if GPS_TRACK_ENABLED
+  /* Smoothed position / speed replace the raw fix.  GGA and RMC both
+     mark the location updated; feed the filter each epoch once.     */
+  static float    lastRawLat, lastRawLon;
+  static TrackFix track = {};
+  if (currentData.latitude != lastRawLat || currentData.longitude != lastRawLon) {
+    lastRawLat = currentData.latitude;
+    lastRawLon = currentData.longitude;
+    float sog  = hwGps.speed.isValid() ? (float)hwGps.speed.mps() : -1.0f;
+    track = gpsTrackUpdate(lastRawLat, lastRawLon, currentData.accuracy, sog, millis());
+  }
+  currentData.latitude  = track.lat;
+  currentData.longitude = track.lon;
+  currentData.speed     = track.speedMps * 3.6f;
+#endif
+
   return true;
 
 #else
@@ -141,38 +251,113 @@ static bool pollHardwareGPS() {
 
 /* ═══════════════════════════════════════════
    WiFi GEOLOCATION
-   Scan nearby APs → POST to BeaconDB → parse lat/lon
-   Returns true on a good fix.
+   Async scan → fingerprint cache → (miss) POST to BeaconDB → parse lat/lon
    ═══════════════════════════════════════════ */
 
-static bool wifiGeolocate() {
-  if (WiFi.status() != WL_CONNECTED) return false;
+/* Value of the first "key": <number> in a flat JSON text, or fallback. */
+static float jsonNumber(const char* json, const char* key, float fallback) {
+  const char* p = strstr(json, key);
+  if (!p) return fallback;
+  p = strchr(p + strlen(key), ':');
+  if (!p) return fallback;
+  char* end;
+  float v = strtof(p + 1, &end);
+  return (end == p + 1) ? fallback : v;
+}
+
+static void applyWifiFix(float lat, float lng, float acc) {
+  currentData.valid      = true;
+  currentData.latitude   = lat;
+  currentData.longitude  = lng;
+  currentData.accuracy   = acc;
+  currentData.satellites = 0;
+  currentData.altitude   = 0.0f;
+  currentData.speed      = 0.0f;
+  currentData.source     = GPSData::Source::WIFI_GEO;
+}
+
+/* ── Fingerprint: FNV-1a over the top-k BSSIDs by RSSI, sorted by MAC
+      so RSSI reordering among the k strongest does not change it ── */
+
+static uint32_t scanFingerprint(int n) {
+  int top[GEO_FP_TOP_K];
+  int k = 0;
+  for (int i = 0; i < n; i++) {
+    int pos = k;
+    while (pos > 0 && WiFi.RSSI(i) > WiFi.RSSI(top[pos - 1])) pos--;
+    if (pos >= GEO_FP_TOP_K) continue;
+    if (k < GEO_FP_TOP_K) k++;
+    for (int j = k - 1; j > pos; j--) top[j] = top[j - 1];
+    top[pos] = i;
+  }
 
-  Serial.println("[GPS] HW GPS unavailable – trying WiFi geolocation...");
+  uint8_t macs[GEO_FP_TOP_K][6];
+  for (int i = 0; i < k; i++) memcpy(macs[i], WiFi.BSSID(top[i]), 6);
+  for (int i = 1; i < k; i++)
+    for (int j = i; j > 0 && memcmp(macs[j - 1], macs[j], 6) > 0; j--) {
+      uint8_t t[6];
+      memcpy(t, macs[j], 6); memcpy(macs[j], macs[j - 1], 6); memcpy(macs[j - 1], t, 6);
+    }
 
-  int n = WiFi.scanNetworks(false, true, false, 100);
+  uint32_t h = 2166136261u;
+  for (int i = 0; i < k; i++)
+    for (int b = 0; b < 6; b++) { h ^= macs[i][b]; h *= 16777619u; }
+  return h;
+}
 
-  if (n < MIN_APS_FOR_GEO) {
-    Serial.printf("[GPS] Only %d APs found – cannot geolocate\n", n);
-    WiFi.scanDelete();
-    return false;
+/* ── LRU fix cache ── */
+
+struct GeoCacheEntry {
+  uint32_t      fingerprint;     // 0 = empty
+  float         lat, lng, acc;
+  unsigned long storedMs;
+  uint32_t      lastUse;         // LRU stamp
+};
+
+static GeoCacheEntry geoCache[GEO_CACHE_SLOTS];
+static uint32_t      geoUseStamp = 0;
+
+static GeoCacheEntry* cacheFind(uint32_t fp) {
+  for (GeoCacheEntry& e : geoCache) {
+    if (e.fingerprint != fp) continue;
+    if (millis() - e.storedMs > GEO_CACHE_TTL_MS) { e.fingerprint = 0; return nullptr; }
+    e.lastUse = ++geoUseStamp;
+    return &e;
+  }
+  return nullptr;
+}
+
+static void cacheStore(uint32_t fp, float lat, float lng, float acc) {
+  GeoCacheEntry* victim = &geoCache[0];
+  for (GeoCacheEntry& e : geoCache) {
+    if (e.fingerprint == 0) { victim = &e; break; }
+    if (e.lastUse < victim->lastUse) victim = &e;
   }
+  victim->fingerprint = fp;
+  victim->lat         = lat;
+  victim->lng         = lng;
+  victim->acc         = acc;
+  victim->storedMs    = millis();
+  victim->lastUse     = ++geoUseStamp;
+}
 
-  int count = min(n, 20);
-  DynamicJsonDocument doc(50 + count * 90);
-  JsonArray aps = doc.createNestedArray("wifiAccessPoints");
+/* ── BeaconDB lookup from the completed scan (blocking HTTPS) ── */
+
+static bool beaconDbLookup(int n, float& lat, float& lng, float& acc) {
+  int    count = min(n, GEO_MAX_APS);
+  size_t len   = snprintf(geoBody, sizeof(geoBody), "{\"wifiAccessPoints\":[");
 
   for (int i = 0; i < count; i++) {
-    JsonObject ap = aps.createNestedObject();
-    ap["macAddress"]     = WiFi.BSSIDstr(i);
-    ap["signalStrength"] = WiFi.RSSI(i);
-    ap["channel"]        = WiFi.channel(i);
+    const uint8_t* b = WiFi.BSSID(i);
+    len += snprintf(&geoBody[len], sizeof(geoBody) - len,
+      "%s{\"macAddress\":\"%02X:%02X:%02X:%02X:%02X:%02X\","
+      "\"signalStrength\":%d,\"channel\":%d}",
+      i ? "," : "", b[0], b[1], b[2], b[3], b[4], b[5],
+      (int)WiFi.RSSI(i), (int)WiFi.channel(i));
   }
+  len += snprintf(&geoBody[len], sizeof(geoBody) - len, "]}");
 
-  WiFi.scanDelete();
-
-  String body;
-  serializeJson(doc, body);
+  geoStats.httpCalls++;
 
   NetworkClientSecure client;
   client.setInsecure();
@@ -182,48 +367,98 @@ static bool wifiGeolocate() {
   http.setTimeout(GEO_API_TIMEOUT_MS);
 
   if (!http.begin(client, GEO_API_URL)) {
-    Serial.println("[GPS] geo http.begin failed");
+    LOGE("GPS", "geo http.begin failed");
     return false;
   }
 
   http.addHeader("Content-Type", "application/json");
-  int code = http.POST(body);
+  int code = http.POST((uint8_t*)geoBody, len);
 
   if (code != 200) {
-    Serial.printf("[GPS] Geo API returned HTTP %d\n", code);
+    LOGW("GPS", "Geo API returned HTTP %d", code);
     http.end();
     return false;
   }
 
-  String resp = http.getString();
+  /* {"location":{"lat":..,"lng":..},"accuracy":..} – small, flat */
+  Stream* s   = http.getStreamPtr();
+  size_t  got = s ? s->readBytes(geoResp, sizeof(geoResp) - 1) : 0;
+  geoResp[got] = '\0';
   http.end();
 
-  DynamicJsonDocument resp_doc(256);
-  if (deserializeJson(resp_doc, resp)) {
-    Serial.println("[GPS] JSON parse error from geo API");
+  if (!strstr(geoResp, "\"location\"")) {
+    LOGW("GPS", "Unexpected geo API response");
     return false;
   }
 
-  float lat = resp_doc["location"]["lat"] | 0.0f;
-  float lng = resp_doc["location"]["lng"] | 0.0f;
-  float acc = resp_doc["accuracy"]        | 999.0f;
+  lat = jsonNumber(geoResp, "\"lat\"",      0.0f);
+  lng = jsonNumber(geoResp, "\"lng\"",      0.0f);
+  acc = jsonNumber(geoResp, "\"accuracy\"", 999.0f);
 
   if (lat == 0.0f && lng == 0.0f) {
-    Serial.println("[GPS] Geo API returned 0,0 – no fix");
+    LOGW("GPS", "Geo API returned 0,0 – no fix");
+    return false;
+  }
+  return true;
+}
+
+/* ── Scan lifecycle: start async, collect on completion ── */
+
+static bool wifiGeoStartScan() {
+  /* A scan during an association attempt would stall it */
+  if (wifiGetStats().state == WifiState::CONNECTING) return false;
+
+  LOGD("GPS", "HW GPS unavailable – scanning for WiFi geolocation...");
+  if (WiFi.scanNetworks(true, true, false, GEO_SCAN_MS_PER_CHAN) == WIFI_SCAN_FAILED) {
+    geoStats.scanFailures++;
     return false;
   }
+  geoScanning = true;
+  geoScanMs   = millis();
+  geoStats.scans++;
+  return true;
+}
 
-  currentData.valid      = true;
-  currentData.latitude   = lat;
-  currentData.longitude  = lng;
-  currentData.accuracy   = acc;
-  currentData.satellites = 0;
-  currentData.altitude   = 0.0f;
-  currentData.speed      = 0.0f;
-  currentData.source     = GPSData::Source::WIFI_GEO;
+/* @return true on a fix (cache or BeaconDB) */
+static bool wifiGeoFinishScan(int n) {
+  geoScanning = false;
+
+  if (n < MIN_APS_FOR_GEO) {
+    LOGW("GPS", "Only %d APs found – cannot geolocate", n);
+    WiFi.scanDelete();
+    return false;
+  }
+
+  uint32_t fp = scanFingerprint(n);
+  if (fp == 0) fp = 1;                      // 0 marks an empty slot
+  geoStats.lookups++;
+
+  if (GeoCacheEntry* e = cacheFind(fp)) {
+    WiFi.scanDelete();
+    geoStats.cacheHits++;
+    applyWifiFix(e->lat, e->lng, e->acc);
+    LOGD("GPS", "WiFi geo fix (cached %08lX)  lat=%.6f  lon=%.6f  acc=%.0fm",
+         (unsigned long)fp, e->lat, e->lng, e->acc);
+    return true;
+  }
+
+  if (!wifiConnected()) {
+    WiFi.scanDelete();
+    return false;
+  }
 
-  Serial.printf("[GPS] WiFi geo fix  lat=%.6f  lon=%.6f  acc=%.0fm\n",
-                lat, lng, acc);
+  float lat, lng, acc;
+  bool  ok = beaconDbLookup(n, lat, lng, acc);
+  WiFi.scanDelete();
+  if (!ok) {
+    geoStats.httpFailures++;
+    return false;
+  }
+
+  cacheStore(fp, lat, lng, acc);
+  applyWifiFix(lat, lng, acc);
+  LOGD("GPS", "WiFi geo fix  lat=%.6f  lon=%.6f  acc=%.0fm",
+       lat, lng, acc);
   return true;
 }
 
@@ -242,23 +477,36 @@ void updateGPS() {
     return;
   }
 
-  /* ── 2. Fall back to WiFi geolocation on its own interval ── */
-  if (millis() - lastGeoMs >= WIFI_GEO_INTERVAL_MS) {
-    lastGeoMs = millis();
-
-    bool wfFix = wifiGeolocate();
+  /* ── 2. Fall back to WiFi geolocation on its own interval ──
+        The scan runs in the background; results are picked up on a
+        later call once WiFi.scanComplete() reports them.          */
+  if (geoScanning) {
+    int n = WiFi.scanComplete();
+    if (n == WIFI_SCAN_RUNNING) {
+      if (millis() - geoScanMs < GEO_SCAN_TIMEOUT_MS) return;
+      LOGW("GPS", "WiFi scan timed out");
+      WiFi.scanDelete();
+      geoScanning = false;
+      geoStats.scanFailures++;
+      n = -1;
+    } else if (n == WIFI_SCAN_FAILED) {
+      geoScanning = false;
+      geoStats.scanFailures++;
+    }
 
-    if (!wfFix) {
+    if (n < 0 || !wifiGeoFinishScan(n)) {
       /* Both sources failed */
       currentData.valid  = false;
       currentData.source = GPSData::Source::NONE;
-      Serial.println("[GPS] No fix from hardware GPS or WiFi geo");
+      LOGW("GPS", "No fix from hardware GPS or WiFi geo");
     }
+    return;
   }
 
-  /* NOTE: Geofence checking removed from firmware.
-           The UI receives lat/lon and compares against user-configured
-           home coordinates and radius.                              */
+  if (millis() - lastGeoMs >= WIFI_GEO_INTERVAL_MS) {
+    lastGeoMs = millis();
+    wifiGeoStartScan();
+  }
 }
 
 /* ═══════════════════════════════════════════
@@ -268,11 +516,24 @@ void updateGPS() {
 GPSData getGPSData()     { return currentData; }
 bool    hasGPSFix()      { return currentData.valid; }
 bool    gpsHealthy()     { return currentData.valid; }
+GeoStats gpsGetGeoStats(){ return geoStats; }
+
+NmeaStats gpsGetNmeaStats() {
+  NmeaStats n = {};
+#if ENABLE_HARDWARE_GPS
+  n.sentences    = nmeaSentences.load(std::memory_order_relaxed);
+  n.ringDrops    = nmeaDropped.load(std::memory_order_relaxed);
+  n.tooLong      = nmeaTooLong.load(std::memory_order_relaxed);
+  n.uartOverruns = uartOverruns.load(std::memory_order_relaxed);
+  n.checksumFail = hwGps.failedChecksum();
+#endif
+  return n;
+}
 float   gpsGetLatitude() { return currentData.valid ? currentData.latitude  : 0.0f; }
 float   gpsGetLongitude(){ return currentData.valid ? currentData.longitude : 0.0f; }
 
 /* ═══════════════════════════════════════════
-   HAVERSINE DISTANCE  (kept as utility – UI may call via cloud)
+   HAVERSINE DISTANCE  (geofence edge checks)
    ═══════════════════════════════════════════ */
 
 float calculateDistance(float lat1, float lon1, float lat2, float lon2) {
@@ -16,9 +16,25 @@ struct GPSData {
 
   // Source of fix
   enum class Source { NONE, HARDWARE_GPS, WIFI_GEO } source;
+};
+
+/* WiFi geolocation counters */
+struct GeoStats {
+  uint32_t scans;
+  uint32_t scanFailures;
+  uint32_t lookups;         // scans with enough APs to fingerprint
+  uint32_t cacheHits;       // answered from the fingerprint cache
+  uint32_t httpCalls;       // BeaconDB requests made
+  uint32_t httpFailures;
+};
 
-  // NOTE: Geofence comparison is handled by the UI.
-  //       Firmware only reports coordinates.
+/* Hardware GPS ingest counters (all zero without ENABLE_HARDWARE_GPS) */
+struct NmeaStats {
+  uint32_t sentences;       // assembled by the UART event handler
+  uint32_t ringDrops;       // loop too slow, sentence discarded
+  uint32_t tooLong;         // no line end within NMEA_LEN
+  uint32_t uartOverruns;    // driver RX buffer or FIFO overflow
+  uint32_t checksumFail;    // rejected by TinyGPS++
 };
 
 /* ═══════════════════════════════════════════
@@ -32,6 +48,12 @@ GPSData getGPSData();
 bool    hasGPSFix();
 bool    gpsHealthy();
 
+/** WiFi geo scan / cache / HTTP counters. */
+GeoStats gpsGetGeoStats();
+
+/** Hardware GPS sentence / overrun counters. */
+NmeaStats gpsGetNmeaStats();
+
 /* ═══════════════════════════════════════════
    UTILITIES
    ═══════════════════════════════════════════ */
@@ -0,0 +1,201 @@
+#include "gps_track.h"
+#include "config.h"
+#include "logger.h"
+#include <Preferences.h>
+#include <math.h>
+
+#define TRACK_M_PER_DEG    111195.0f
+#define TRACK_GATE_SIGMA2  25.0f      // 5 σ, squared
+#define TRACK_MAX_REJECTS  3
+#define TRACK_MAX_DT_S     10.0f      // longer gap → re-seed
+#define TRACK_REORIGIN_M   50000.0f   // keep the flat-earth frame small
+
+/* ================= Kalman (per axis: position, velocity) ================= */
+
+struct Axis {
+  float p, v;              // state
+  float P00, P01, P11;     // covariance (symmetric)
+};
+
+static void axisSeed(Axis& a, float z, float r2) {
+  a.p   = z;
+  a.v   = 0.0f;
+  a.P00 = r2;
+  a.P01 = 0.0f;
+  a.P11 = 25.0f;           // ±5 m/s unknown initial speed
+}
+
+static void axisPredict(Axis& a, float dt, float q) {
+  float dt2 = dt * dt;
+  a.p   += a.v * dt;
+  a.P00 += dt * (2.0f * a.P01 + dt * a.P11) + q * dt2 * dt2 * 0.25f;
+  a.P01 += dt * a.P11                       + q * dt2 * dt  * 0.5f;
+  a.P11 +=                                    q * dt2;
+}
+
+/* Normalised innovation squared, for gating before the update */
+static float axisNis(const Axis& a, float z, float r2) {
+  float y = z - a.p;
+  return y * y / (a.P00 + r2);
+}
+
+static void axisUpdate(Axis& a, float z, float r2) {
+  float s  = a.P00 + r2;
+  float k0 = a.P00 / s;
+  float k1 = a.P01 / s;
+  float y  = z - a.p;
+  a.p += k0 * y;
+  a.v += k1 * y;
+  float P00 = a.P00, P01 = a.P01;
+  a.P00 = (1.0f - k0) * P00;
+  a.P01 = (1.0f - k0) * P01;
+  a.P11 = a.P11 - k1 * P01;
+}
+
+/* ================= State ================= */
+
+static Preferences prefs;
+
+static Axis     ax, ay;              // east, north
+static bool     seeded      = false;
+static float    originLat, originLon, mPerDegLon;
+static uint32_t lastMs      = 0;
+static uint8_t  rejectRun   = 0;
+
+static float    lastX, lastY;        // odometer anchor
+static bool     wasMoving   = false;
+static double   savedTotalM = 0.0;   // value in NVS
+static float    movingSumMps = 0.0f;
+static uint32_t movingSamples = 0;
+static uint32_t movingMs    = 0;
+
+static TripStats stats = {};
+
+static void saveTotal() {
+  prefs.begin("odo", false);
+  prefs.putDouble("total_m64", stats.totalM);
+  prefs.end();
+  savedTotalM = stats.totalM;
+}
+
+static void seed(float lat, float lon, float r2, uint32_t tMs) {
+  originLat  = lat;
+  originLon  = lon;
+  mPerDegLon = TRACK_M_PER_DEG * cosf(lat * (float)M_PI / 180.0f);
+  axisSeed(ax, 0.0f, r2);
+  axisSeed(ay, 0.0f, r2);
+  lastX = lastY = 0.0f;
+  lastMs    = tMs;
+  rejectRun = 0;
+  seeded    = true;
+}
+
+/* ================= API ================= */
+
+void gpsTrackInit() {
+  prefs.begin("odo", true);
+  /* double since the float odometer lost its ODO_MIN_STEP_M steps to
+     rounding past ~10⁴ km; a total saved as float is carried over */
+  stats.totalM = prefs.isKey("total_m64") ? prefs.getDouble("total_m64", 0.0)
+                                          : prefs.getFloat("total_m", 0.0f);
+  prefs.end();
+  savedTotalM = stats.totalM;
+  LOGI("TRACK", "Odometer %.1f km", stats.totalM / 1000.0f);
+}
+
+TrackFix gpsTrackUpdate(float lat, float lon, float accuracyM,
+                        float sogMps, uint32_t tMs) {
+  float r2 = accuracyM * accuracyM;
+  stats.fixes++;
+
+  float dt = (tMs - lastMs) / 1000.0f;
+  if (!seeded || dt > TRACK_MAX_DT_S) {
+    if (seeded) stats.resets++;
+    seed(lat, lon, r2, tMs);
+    return { lat, lon, fmaxf(sogMps, 0.0f), 0.0f, false };
+  }
+
+  float zx = (lon - originLon) * mPerDegLon;
+  float zy = (lat - originLat) * TRACK_M_PER_DEG;
+
+  if (dt > 0.0f) {
+    float q = GPS_TRACK_ACCEL_SIGMA * GPS_TRACK_ACCEL_SIGMA;
+    axisPredict(ax, dt, q);
+    axisPredict(ay, dt, q);
+    lastMs = tMs;
+  }
+
+  if (axisNis(ax, zx, r2) + axisNis(ay, zy, r2) > TRACK_GATE_SIGMA2) {
+    stats.rejected++;
+    if (++rejectRun >= TRACK_MAX_REJECTS) {
+      stats.resets++;
+      seed(lat, lon, r2, tMs);
+    }
+  } else {
+    rejectRun = 0;
+    axisUpdate(ax, zx, r2);
+    axisUpdate(ay, zy, r2);
+  }
+
+  /* Receiver Doppler speed is far less noisy than the filter's */
+  float speed  = sogMps >= 0.0f ? sogMps : sqrtf(ax.v * ax.v + ay.v * ay.v);
+  bool  moving = speed >= ODO_MIN_SPEED_MPS;
+
+  /* ── Odometer ──
+     Distance is counted between anchor points ODO_MIN_STEP_M apart, so
+     residual jitter of the smoothed track does not add up.          */
+  float dx = ax.p - lastX, dy = ay.p - lastY;
+  float d  = sqrtf(dx * dx + dy * dy);
+  if (d >= ODO_MIN_STEP_M) {
+    if (moving || wasMoving) {
+      stats.tripM  += d;
+      stats.totalM += d;
+    }
+    lastX = ax.p;
+    lastY = ay.p;
+  }
+  if (moving) {
+    movingMs     += (uint32_t)(dt * 1000.0f);
+    movingSumMps += speed;
+    movingSamples++;
+    if (speed > stats.maxSpeedMps) stats.maxSpeedMps = speed;
+  }
+
+  if (stats.totalM - savedTotalM >= ODO_SAVE_STEP_M ||
+      (wasMoving && !moving && stats.totalM > savedTotalM))
+    saveTotal();
+  wasMoving = moving;
+
+  TrackFix f;
+  f.lat        = originLat + ay.p / TRACK_M_PER_DEG;
+  f.lon        = originLon + ax.p / mPerDegLon;
+  f.speedMps   = speed;
+  f.headingDeg = fmodf(atan2f(ax.v, ay.v) * 180.0f / (float)M_PI + 360.0f, 360.0f);
+  f.moving     = moving;
+
+  /* Re-centre before the flat-earth error grows */
+  if (fabsf(ax.p) > TRACK_REORIGIN_M || fabsf(ay.p) > TRACK_REORIGIN_M) {
+    float vx = ax.v, vy = ay.v;
+    float rx = ax.p - lastX, ry = ay.p - lastY;
+    seed(f.lat, f.lon, r2, tMs);
+    ax.v  = vx;
+    ay.v  = vy;
+    lastX = -rx;
+    lastY = -ry;
+  }
+  return f;
+}
+
+void gpsTrackResetTrip() {
+  stats.tripM       = 0.0f;
+  stats.maxSpeedMps = 0.0f;
+  movingSumMps      = 0.0f;
+  movingSamples     = 0;
+  movingMs          = 0;
+}
+
+TripStats gpsTrackGetStats() {
+  stats.movingS      = movingMs / 1000;
+  stats.avgMovingMps = movingSamples ? movingSumMps / movingSamples : 0.0f;
+  return stats;
+}
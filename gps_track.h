@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  GPS Track – position smoothing + trip odometer
+ *  Constant-velocity Kalman filter, one per axis (east / north,
+ *  metres from the first fix).  Measurement noise comes from the
+ *  fix (HDOP × UERE), process noise from GPS_TRACK_ACCEL_SIGMA.
+ *  Fixes more than 5 σ from the prediction are rejected; three
+ *  in a row re-seed the filter (teleport after a cold start).
+ *
+ *  The odometer integrates the smoothed position in steps of at
+ *  least ODO_MIN_STEP_M while moving faster than ODO_MIN_SPEED_MPS
+ *  (receiver Doppler speed when available), so a parked
+ *  receiver's wander does not add distance.  The lifetime total lives in NVS and is
+ *  written every ODO_SAVE_STEP_M and when the vehicle stops.
+ * ============================================================
+ */
+
+struct TrackFix {
+  float lat;
+  float lon;
+  float speedMps;        // receiver SOG, else filter velocity
+  float headingDeg;      // 0 = north, clockwise
+  bool  moving;
+};
+
+struct TripStats {
+  float    tripM;
+  double   totalM;           // lifetime, persisted (float steps would round at 10⁴ km)
+  float    maxSpeedMps;
+  float    avgMovingMps;
+  uint32_t movingS;
+  uint32_t fixes;
+  uint32_t rejected;         // 5 σ gate
+  uint32_t resets;
+};
+
+/** Load the persisted odometer. */
+void gpsTrackInit();
+
+/**
+ * Feed one receiver fix.
+ * @param accuracyM  1-σ horizontal error estimate of this fix
+ * @param sogMps     receiver speed over ground, < 0 if not reported
+ * @return the smoothed fix
+ */
+TrackFix gpsTrackUpdate(float lat, float lon, float accuracyM,
+                        float sogMps, uint32_t tMs);
+
+/** Start a new trip (trip distance / speed stats to zero). */
+void gpsTrackResetTrip();
+
+TripStats gpsTrackGetStats();
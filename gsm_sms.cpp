@@ -1,56 +1,310 @@
 #include <Arduino.h>
 #include "gsm_sms.h"
 #include "config.h"
+#include "logger.h"
+#include <atomic>
 
 static HardwareSerial gsm(2);   // UART2
-static bool gsmReady = false;
 
-static bool sendAT(const char* cmd, const char* expected, uint32_t timeoutMs = 2000) {
-  gsm.flush();
-  gsm.println(cmd);
+/* ================= RX line ring (UART event task → loop) ================= */
 
-  uint32_t t0 = millis();
-  String   resp;
+#define GSM_LINE_LEN     96
+#define GSM_LINE_SLOTS   16     // power of two
 
-  while (millis() - t0 < timeoutMs) {
-    while (gsm.available())
-      resp += (char)gsm.read();
-    if (resp.indexOf(expected) >= 0) return true;
-    delay(1);
+static char                  lines[GSM_LINE_SLOTS][GSM_LINE_LEN];
+static std::atomic<uint32_t> lineHead{0};     // producer: onGsmReceive
+static std::atomic<uint32_t> lineTail{0};     // consumer: gsmLoop
+static std::atomic<uint32_t> linesDropped{0};
+
+static char   rxLine[GSM_LINE_LEN];           // producer-only
+static size_t rxLen = 0;
+
+static void pushLine() {
+  rxLine[rxLen] = '\0';
+  rxLen = 0;
+
+  uint32_t h = lineHead.load(std::memory_order_relaxed);
+  if (h - lineTail.load(std::memory_order_acquire) >= GSM_LINE_SLOTS) {
+    linesDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  memcpy(lines[h & (GSM_LINE_SLOTS - 1)], rxLine, sizeof(rxLine));
+  lineHead.store(h + 1, std::memory_order_release);
+}
+
+/* Runs in the UART driver's event task on RX FIFO full / RX timeout */
+static void onGsmReceive() {
+  while (gsm.available()) {
+    char c = (char)gsm.read();
+    if (c == '\r') continue;
+    if (c == '\n') { if (rxLen) pushLine(); continue; }
+    if (c == ' ' && rxLen == 0) continue;     // "> " prompt trailer
+
+    if (rxLen < GSM_LINE_LEN - 1) rxLine[rxLen++] = c;
+
+    /* The SMS prompt is "> " with no line end */
+    if (rxLen == 1 && c == '>') pushLine();
+  }
+}
+
+static bool popLine(char* out) {
+  uint32_t t = lineTail.load(std::memory_order_relaxed);
+  if (t == lineHead.load(std::memory_order_acquire)) return false;
+  memcpy(out, lines[t & (GSM_LINE_SLOTS - 1)], GSM_LINE_LEN);
+  lineTail.store(t + 1, std::memory_order_release);
+  return true;
+}
+
+/* ================= Command queue ================= */
+
+#define GSM_CMD_SLOTS    8
+
+struct AtCommand {
+  char        cmd[40];
+  const char* expect;        // final success line (prefix match)
+  const char* payload;       // written after the '>' prompt, then Ctrl-Z
+  uint32_t    timeoutMs;
+  void      (*done)(bool ok);
+};
+
+static AtCommand     cmdQueue[GSM_CMD_SLOTS];
+static uint8_t       cmdHead   = 0;
+static uint8_t       cmdCount  = 0;
+static bool          cmdActive = false;   // cmdQueue[cmdHead] is on the wire
+static unsigned long cmdStartMs = 0;
+
+static GsmStats stats = {};
+
+/* SMS outbox */
+#define GSM_SMS_LEN      161
+
+static char    smsBox[GSM_SMS_SLOTS][GSM_SMS_LEN];
+static uint8_t smsHead    = 0;
+static uint8_t smsCount   = 0;
+static uint8_t smsTries   = 0;
+static bool    smsPending = false;   // AT+CMGS for smsBox[smsHead] queued
+
+static bool enqueue(const char* cmd, const char* expect, uint32_t timeoutMs,
+                    void (*done)(bool), const char* payload = nullptr) {
+  if (cmdCount >= GSM_CMD_SLOTS) return false;
+  AtCommand& c = cmdQueue[(cmdHead + cmdCount) % GSM_CMD_SLOTS];
+  strncpy(c.cmd, cmd, sizeof(c.cmd) - 1);
+  c.cmd[sizeof(c.cmd) - 1] = '\0';
+  c.expect    = expect;
+  c.payload   = payload;
+  c.timeoutMs = timeoutMs;
+  c.done      = done;
+  cmdCount++;
+  return true;
+}
+
+static void finish(bool ok) {
+  void (*done)(bool) = cmdQueue[cmdHead].done;
+  cmdHead   = (cmdHead + 1) % GSM_CMD_SLOTS;
+  cmdCount--;
+  cmdActive = false;
+  if (done) done(ok);
+}
+
+static void flushQueue() {
+  cmdHead   = 0;
+  cmdCount  = 0;
+  cmdActive = false;
+}
+
+/* ================= Init sequence ================= */
+
+static unsigned long stateMs    = 0;
+static bool          waitingReg = false;   // INIT done, READY once +CREG says registered
+
+static void initFailed(const char* step) {
+  LOGE("GSM", "%s failed – retry in %lus", step, GSM_RETRY_MS / 1000);
+  flushQueue();
+  smsPending  = false;
+  waitingReg  = false;
+  stats.state = GsmState::RETRY_WAIT;
+  stateMs     = millis();
+}
+
+static void onAt(bool ok)   { if (!ok) initFailed("AT (no response)"); }
+static void onEcho(bool ok) { if (!ok) initFailed("Echo-off"); }
+static void onCmgf(bool ok) { if (!ok) initFailed("SMS mode"); }
+static void onCnmi(bool ok) { if (!ok) LOGW("GSM", "New-SMS indication not enabled"); }
+static void onCreg(bool ok) {
+  if (stats.state != GsmState::INIT) return;
+  if (!ok) { initFailed("Registration query"); return; }
+  if (stats.registered) {
+    stats.state = GsmState::READY;
+    LOGI("GSM", "Ready (registered)");
+    return;
+  }
+  /* Configured but not on a network yet: the +CREG URC finishes init */
+  waitingReg = true;
+  stateMs    = millis();
+  LOGI("GSM", "Configured – waiting for network registration");
+}
+
+static void startInit() {
+  stats.state = GsmState::INIT;
+  waitingReg  = false;
+  enqueue("AT",           "OK", 1000, onAt);
+  enqueue("ATE0",         "OK", 1000, onEcho);
+  enqueue("AT+CMGF=1",    "OK", 1000, onCmgf);
+  enqueue("AT+CNMI=2,1",  "OK", 1000, onCnmi);   // +CMTI on new SMS
+  enqueue("AT+CREG=1",    "OK", 1000, nullptr);  // +CREG on registration change
+  enqueue("AT+CREG?",     "OK", 1000, onCreg);
+}
+
+/* ================= SMS outbox ================= */
+
+static void onCmgs(bool ok) {
+  smsPending = false;
+  if (ok) {
+    stats.smsSent++;
+    LOGI("GSM", "SMS sent");
+  } else if (++smsTries < GSM_SMS_RETRIES) {
+    LOGW("GSM", "SMS failed – retry %u", smsTries);
+    return;                                  // stays at head
+  } else {
+    stats.smsFailed++;
+    LOGE("GSM", "SMS failed – dropped");
+  }
+  smsTries = 0;
+  smsHead  = (smsHead + 1) % GSM_SMS_SLOTS;
+  smsCount--;
+}
+
+static void serviceOutbox() {
+  if (smsPending || smsCount == 0 || stats.state != GsmState::READY) return;
+
+  static char cmgs[40];
+  snprintf(cmgs, sizeof(cmgs), "AT+CMGS=\"%s\"", GSM_ALERT_NUMBER);
+  if (enqueue(cmgs, "OK", GSM_SMS_TIMEOUT_MS, onCmgs, smsBox[smsHead]))
+    smsPending = true;
+}
+
+/* ================= URCs ================= */
+
+static bool handleUrc(const char* line) {
+  if (strncmp(line, "+CREG:", 6) == 0) {
+    /* URC "+CREG: <stat>"  or query reply "+CREG: <n>,<stat>" */
+    const char* comma = strchr(line, ',');
+    int  stat = atoi(comma ? comma + 1 : line + 6);
+    bool reg  = (stat == 1 || stat == 5);
+    if (reg != stats.registered)
+      LOGI("GSM", "Network %s (stat=%d)", reg ? "registered" : "lost", stat);
+    stats.registered = reg;
+
+    if (reg && waitingReg) {
+      waitingReg  = false;
+      stats.state = GsmState::READY;
+      LOGI("GSM", "Ready (registered)");
+    } else if (!reg && stats.state == GsmState::READY) {
+      /* Hold SMS until the network is back (or re-init on timeout) */
+      stats.state = GsmState::INIT;
+      waitingReg  = true;
+      stateMs     = millis();
+    }
+    return true;
+  }
+  if (strncmp(line, "+CMTI:", 6) == 0) {
+    const char* comma = strchr(line, ',');
+    stats.smsReceived++;
+    LOGI("GSM", "Incoming SMS stored at index %d", comma ? atoi(comma + 1) : -1);
+    return true;
+  }
+  if (strcmp(line, "RDY") == 0 || strcmp(line, "Call Ready") == 0 ||
+      strcmp(line, "SMS Ready") == 0 || strncmp(line, "+CFUN:", 6) == 0 ||
+      strncmp(line, "+CPIN:", 6) == 0) {
+    LOGD("GSM", "URC %s", line);
+    return true;
   }
   return false;
 }
 
+/* ================= Engine ================= */
+
+static void handleLine(const char* line) {
+  if (handleUrc(line) || !cmdActive) return;
+
+  AtCommand& c = cmdQueue[cmdHead];
+
+  if (line[0] == '>' && c.payload) {
+    gsm.print(c.payload);
+    gsm.write(26);                           // Ctrl-Z → send
+    return;
+  }
+  if (strncmp(line, c.expect, strlen(c.expect)) == 0) {
+    finish(true);
+    return;
+  }
+  if (strcmp(line, "ERROR") == 0 ||
+      strncmp(line, "+CME ERROR", 10) == 0 ||
+      strncmp(line, "+CMS ERROR", 10) == 0) {
+    stats.errors++;
+    LOGW("GSM", "%s → %s", c.cmd, line);
+    finish(false);
+  }
+  /* anything else is an intermediate reply (+CMGS: <mr>, echo …) */
+}
+
 void gsmInit() {
   /* GSM_RX, GSM_TX, GSM_BAUD all come from config.h */
+  gsm.setTxBufferSize(256);                  // SMS body is queued, not bit-banged
   gsm.begin(GSM_BAUD, SERIAL_8N1, GSM_RX, GSM_TX);
-  delay(1000);
+  gsm.onReceive(onGsmReceive);
+
+  stats.state = GsmState::BOOTING;
+  stateMs     = millis();
+}
+
+void gsmLoop() {
+  unsigned long now = millis();
+
+  if ((stats.state == GsmState::BOOTING    && now - stateMs >= GSM_BOOT_DELAY_MS) ||
+      (stats.state == GsmState::RETRY_WAIT && now - stateMs >= GSM_RETRY_MS))
+    startInit();
 
-  if (!sendAT("AT",        "OK")) { Serial.println("[GSM] No response");      return; }
-  if (!sendAT("ATE0",      "OK")) { Serial.println("[GSM] Echo-off failed");  return; }
-  if (!sendAT("AT+CMGF=1", "OK")) { Serial.println("[GSM] SMS mode failed");  return; }
+  if (waitingReg && now - stateMs >= GSM_REG_TIMEOUT_MS)
+    initFailed("Network registration");
 
-  gsmReady = true;
-  Serial.println("[GSM] Ready");
+  char line[GSM_LINE_LEN];
+  while (popLine(line)) handleLine(line);
+
+  if (cmdActive && now - cmdStartMs >= cmdQueue[cmdHead].timeoutMs) {
+    stats.timeouts++;
+    LOGW("GSM", "%s timed out", cmdQueue[cmdHead].cmd);
+    if (cmdQueue[cmdHead].payload) gsm.write(27);   // ESC: leave text-entry mode
+    finish(false);
+  }
+
+  serviceOutbox();
+
+  if (!cmdActive && cmdCount) {
+    gsm.println(cmdQueue[cmdHead].cmd);
+    cmdActive  = true;
+    cmdStartMs = millis();
+    stats.commands++;
+  }
 }
 
-bool gsmIsReady() { return gsmReady; }
+bool gsmIsReady()      { return stats.state == GsmState::READY; }
+bool gsmIsRegistered() { return stats.registered; }
 
 bool gsmSendSMS(const char* msg) {
-  if (!gsmReady) {
-    Serial.println("[GSM] Not ready – SMS skipped");
+  if (smsCount >= GSM_SMS_SLOTS) {
+    LOGW("GSM", "SMS queue full – skipped");
     return false;
   }
+  char* slot = smsBox[(smsHead + smsCount) % GSM_SMS_SLOTS];
+  strncpy(slot, msg, GSM_SMS_LEN - 1);
+  slot[GSM_SMS_LEN - 1] = '\0';
+  smsCount++;
+  stats.smsQueued++;
+  return true;
+}
 
-  gsm.print("AT+CMGS=\"");
-  gsm.print(GSM_ALERT_NUMBER);
-  gsm.println("\"");
-  delay(500);
-
-  gsm.print(msg);
-  gsm.write(26);   // CTRL+Z → send
-
-  bool ok = sendAT("", "OK", 5000);
-  Serial.println(ok ? "[GSM] SMS sent" : "[GSM] SMS failed");
-  return ok;
+GsmStats gsmGetStats() {
+  stats.linesDropped = linesDropped.load(std::memory_order_relaxed);
+  return stats;
 }
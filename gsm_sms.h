@@ -1,5 +1,55 @@
 #pragma once
+#include <Arduino.h>
 
+/*
+ * ============================================================
+ *  GSM Modem  (SIM800-class, AT over UART2)
+ *  Event-driven: the UART RX event feeds a line assembler that
+ *  runs in the driver's event task; complete lines go through a
+ *  lock-free ring to gsmLoop(), which runs a queue of AT commands
+ *  (each with its own expected reply and timeout), handles
+ *  unsolicited result codes and drives SMS sends.  Nothing here
+ *  waits on the modem – init and SMS complete over later loops.
+ *
+ *  URCs:  +CREG: <stat>        network registration changes
+ *         +CMTI: "SM",<idx>    incoming SMS stored on the SIM
+ * ============================================================
+ */
+
+enum class GsmState : uint8_t {
+  BOOTING,       // waiting GSM_BOOT_DELAY_MS after power-up
+  INIT,          // init command sequence in flight, or waiting for +CREG
+  READY,         // SMS text mode configured and registered on a network
+  RETRY_WAIT     // init failed, retrying after GSM_RETRY_MS
+};
+
+struct GsmStats {
+  GsmState state;
+  bool     registered;      // +CREG stat 1 (home) or 5 (roaming)
+  uint32_t commands;
+  uint32_t timeouts;
+  uint32_t errors;          // ERROR / +CME / +CMS replies
+  uint32_t smsQueued;
+  uint32_t smsSent;
+  uint32_t smsFailed;       // gave up after GSM_SMS_RETRIES
+  uint32_t smsReceived;     // +CMTI
+  uint32_t linesDropped;    // RX line ring overflow
+};
+
+/** Start the UART and RX handler.  Returns immediately. */
 void gsmInit();
+
+/** Call every loop: consume modem lines, time out / start commands. */
+void gsmLoop();
+
+/**
+ * Queue an SMS to GSM_ALERT_NUMBER (truncated to 160 chars).
+ * Accepted while the modem is still initialising; sent once ready.
+ * @return false if the SMS queue is full
+ */
 bool gsmSendSMS(const char* msg);
+
 bool gsmIsReady();
+bool gsmIsRegistered();
+
+GsmStats gsmGetStats();
@@ -0,0 +1,109 @@
+#include "heap_guard.h"
+#include "config.h"
+#include "logger.h"
+#include <esp_heap_caps.h>
+
+/* ================= State ================= */
+
+static bool          armed          = false;
+static size_t        baseBlocks     = 0;
+static unsigned long lastCheckMs    = 0;
+static unsigned long lastReportMs   = 0;
+static unsigned long lastWarnMs     = 0;
+
+static HeapGuardStats stats = {};
+
+/* Written from whichever task failed the allocation */
+static volatile uint32_t failCount    = 0;
+static volatile uint32_t failLastSize = 0;
+
+/* Runs inside the allocator – no logging, no allocation */
+static void onAllocFailed(size_t size, uint32_t caps, const char* fn) {
+  failCount++;
+  failLastSize = size;
+}
+
+/* ================= Sampling ================= */
+
+static void sample(multi_heap_info_t& info) {
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+
+  stats.freeBytes    = info.total_free_bytes;
+  stats.minFreeBytes = info.minimum_free_bytes;
+  stats.largestBlock = info.largest_free_block;
+  stats.fragPct      = info.total_free_bytes
+    ? (uint8_t)(100 - (uint64_t)info.largest_free_block * 100 / info.total_free_bytes)
+    : 0;
+  if (stats.fragPct > stats.maxFragPct) stats.maxFragPct = stats.fragPct;
+
+  stats.allocFailures = failCount;
+  stats.lastFailSize  = failLastSize;
+}
+
+/* ================= API ================= */
+
+void heapGuardArm() {
+  heap_caps_register_failed_alloc_callback(onAllocFailed);
+
+  multi_heap_info_t info;
+  sample(info);
+  baseBlocks          = info.allocated_blocks;
+  stats.maxFragPct    = stats.fragPct;
+  stats.blockDelta    = 0;
+  stats.maxBlockDelta = 0;
+
+  armed        = true;
+  lastCheckMs  = millis();
+  lastReportMs = millis();
+
+  LOGI("HEAP", "Armed: %u blocks, free=%lu largest=%lu frag=%u%%",
+       (unsigned)baseBlocks, (unsigned long)stats.freeBytes,
+       (unsigned long)stats.largestBlock, stats.fragPct);
+}
+
+void heapGuardCheck() {
+  if (!armed) return;
+
+  unsigned long now = millis();
+  if (now - lastCheckMs < HEAP_GUARD_CHECK_MS) return;
+  lastCheckMs = now;
+
+  multi_heap_info_t info;
+  sample(info);
+
+  stats.blockDelta = (int32_t)info.allocated_blocks - (int32_t)baseBlocks;
+  if (stats.blockDelta > stats.maxBlockDelta) stats.maxBlockDelta = stats.blockDelta;
+
+  if (stats.blockDelta > HEAP_GUARD_BLOCK_SLACK) {
+    stats.violations++;
+#if HEAP_GUARD_STRICT
+    LOGE("HEAP", "Steady-state allocation: +%ld blocks since arm",
+         (long)stats.blockDelta);
+    logFlush();
+    abort();
+#else
+    if (now - lastWarnMs >= HEAP_GUARD_REPORT_MS) {
+      lastWarnMs = now;
+      LOGW("HEAP", "Steady-state allocation: +%ld blocks since arm (free=%lu)",
+           (long)stats.blockDelta, (unsigned long)stats.freeBytes);
+    }
+#endif
+  }
+
+  if (now - lastReportMs >= HEAP_GUARD_REPORT_MS) {
+    lastReportMs = now;
+    LOGI("HEAP", "free=%lu min=%lu largest=%lu frag=%u%% (max %u%%) "
+         "blocks%+ld fails=%lu",
+         (unsigned long)stats.freeBytes, (unsigned long)stats.minFreeBytes,
+         (unsigned long)stats.largestBlock, stats.fragPct, stats.maxFragPct,
+         (long)stats.blockDelta, (unsigned long)stats.allocFailures);
+  }
+}
+
+HeapGuardStats heapGuardGetStats() {
+  if (armed) {
+    multi_heap_info_t info;
+    sample(info);
+  }
+  return stats;
+}
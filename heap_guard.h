@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Steady-State Heap Guard
+ *  After setup() the firmware is meant to run without net heap
+ *  growth: module buffers are static, messages are built with
+ *  snprintf into fixed arrays.  Library internals (HTTPClient,
+ *  TLS) still allocate per request, but give it all back before
+ *  the loop ends.
+ *
+ *  heapGuardArm() snapshots the allocated-block count once init
+ *  is done; heapGuardCheck() compares against it at the end of
+ *  each loop.  Growth beyond HEAP_GUARD_BLOCK_SLACK is a leak or
+ *  a new steady-state allocation and is reported (or aborts the
+ *  firmware with HEAP_GUARD_STRICT).  Also tracks the free-heap
+ *  low-water mark, fragmentation and failed allocations.
+ *
+ *  Console 'h' prints the current numbers.
+ * ============================================================
+ */
+
+struct HeapGuardStats {
+  uint32_t freeBytes;
+  uint32_t minFreeBytes;      // low-water since boot
+  uint32_t largestBlock;
+  uint8_t  fragPct;           // 100 * (1 - largest / free)
+  uint8_t  maxFragPct;        // worst since arm
+  int32_t  blockDelta;        // allocated blocks vs. the armed baseline
+  int32_t  maxBlockDelta;
+  uint32_t violations;        // checks that exceeded the slack
+  uint32_t allocFailures;     // malloc returned NULL (any context)
+  uint32_t lastFailSize;
+};
+
+/** Call once at the end of setup(). Installs the failed-alloc hook. */
+void heapGuardArm();
+
+/** Call at the end of every loop(); samples every HEAP_GUARD_CHECK_MS. */
+void heapGuardCheck();
+
+HeapGuardStats heapGuardGetStats();
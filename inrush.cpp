@@ -0,0 +1,353 @@
+#include "inrush.h"
+#include "config.h"
+#include "logger.h"
+#include "fault_manager.h"
+#include "actuator.h"
+#if ENABLE_PRECHARGE
+  #include "precharge.h"
+#endif
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <math.h>
+#include <string.h>
+
+#if ENABLE_INRUSH_CAPTURE && !ENABLE_ADAPTIVE_SAMPLING
+  #error "ENABLE_INRUSH_CAPTURE needs ENABLE_ADAPTIVE_SAMPLING (burst-rate samples)"
+#endif
+
+#define CAP_MAX  (INRUSH_WINDOW_MS * SAMPLE_BURST_HZ / 1000 + 16)
+
+/* A pre-charged start has no DC-link spike left – only the motor's
+   own.  Its envelope and baseline are kept apart from one learned
+   on bare starts, so switching pre-charge on starts a fresh one
+   rather than shrinking the old one start by start.              */
+#if ENABLE_PRECHARGE
+  #define INRUSH_NVS  "inrush_pc"
+#else
+  #define INRUSH_NVS  "inrush"
+#endif
+
+/* ================= State ================= */
+
+enum CapState : uint8_t { CAP_IDLE = 0, CAP_RUNNING, CAP_DONE, CAP_TRIPPED, CAP_ABORTED };
+
+/* Written by the sampler task only while CAP_RUNNING, read by the
+   loop only after it left CAP_RUNNING.  Transitions under capLock. */
+static volatile CapState state = CAP_IDLE;
+static portMUX_TYPE      capLock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct {
+  int64_t      t0Us;
+  int64_t      prevUs;
+  float        prevA;
+  float        peakA;
+  uint32_t     peakUs;       // after relay ON
+  double       i2t;
+  float        minV;
+  uint16_t     n;
+  uint8_t      over;         // consecutive samples above the curve
+  InrushResult result;
+  uint32_t     atMs;
+  float        startV;
+#if ENABLE_PRECHARGE
+  uint32_t     preDone;      // pre-charge completions at relay ON
+#endif
+} cap;
+
+static float    capI[CAP_MAX];
+static uint32_t capT[CAP_MAX];   // µs after relay ON
+
+/* Limits for the running capture – fixed at inrushStart() */
+static struct {
+  float peakA;
+  float timeToPeakMs;
+  float tauMs;
+  float i2t;
+} lim;
+
+static bool           initialized = false;
+static float          preV        = 0.0f;   // EMA of pack voltage while no capture runs
+static InrushEnvelope learned     = {};
+static InrushEnvelope baseline    = {};
+static InrushStats    stats       = {};
+
+static InrushMetrics  hist[INRUSH_HISTORY];
+static uint8_t        histHead  = 0;
+static uint8_t        histCount = 0;
+
+static Preferences prefs;
+
+static bool envelopeValid() { return learned.starts >= INRUSH_LEARN_STARTS; }
+
+/* ================= NVS ================= */
+
+static void saveEnvelope() {
+  prefs.begin(INRUSH_NVS, false);
+  prefs.putBytes("env",  &learned,  sizeof(learned));
+  prefs.putBytes("base", &baseline, sizeof(baseline));
+  prefs.end();
+}
+
+/* ================= Envelope ================= */
+
+static void setLimits() {
+  if (envelopeValid()) {
+    lim.peakA        = learned.peakA        * INRUSH_PEAK_MARGIN;
+    lim.timeToPeakMs = learned.timeToPeakMs * INRUSH_TAU_MARGIN;
+    lim.tauMs        = learned.tauMs        * INRUSH_TAU_MARGIN;
+    lim.i2t          = learned.i2t          * INRUSH_I2T_MARGIN;
+  } else {
+    lim.peakA        = INRUSH_DEFAULT_PEAK_A;
+    lim.timeToPeakMs = INRUSH_DEFAULT_TPEAK_MS;
+    lim.tauMs        = INRUSH_DEFAULT_TAU_MS;
+    lim.i2t          = INRUSH_DEFAULT_I2T;
+  }
+  /* A heavier start than usual may still run at the rated current
+     for the whole window – that is the over-current check's job. */
+  const float ratedI2t = MAX_DISCHARGE_CURRENT * MAX_DISCHARGE_CURRENT *
+                         (INRUSH_WINDOW_MS / 1000.0f);
+  if (lim.i2t   < ratedI2t)              lim.i2t   = ratedI2t;
+  if (lim.peakA > INRUSH_HARD_LIMIT_A)   lim.peakA = INRUSH_HARD_LIMIT_A;
+  if (lim.tauMs < 1.0f)                  lim.tauMs = 1.0f;
+}
+
+/* Decay curve: flat to the time-to-peak, then exponential down to the rating */
+static float envelopeAt(float tMs) {
+  float e = lim.peakA;
+  if (tMs > lim.timeToPeakMs) e *= expf(-(tMs - lim.timeToPeakMs) / lim.tauMs);
+  return e > MAX_DISCHARGE_CURRENT ? e : MAX_DISCHARGE_CURRENT;
+}
+
+static void learn(const InrushMetrics& m) {
+  /* Plain mean until the envelope is valid, then a slow EMA that
+     follows the motor as it ages.                                */
+  float a = envelopeValid() ? INRUSH_LEARN_ALPHA : 1.0f / (learned.starts + 1);
+  learned.peakA        += a * (m.peakA        - learned.peakA);
+  learned.timeToPeakMs += a * (m.timeToPeakMs - learned.timeToPeakMs);
+  learned.i2t          += a * (m.i2t          - learned.i2t);
+  learned.tauMs        += a * (m.tauMs        - learned.tauMs);
+  learned.steadyA      += a * (m.steadyA      - learned.steadyA);
+  learned.starts++;
+
+  if (learned.starts == INRUSH_LEARN_STARTS) {
+    baseline = learned;
+    LOGI("INRUSH", "Envelope learned: peak %.1fA @%.0fms  tau %.0fms  I2t %.1fA2s",
+         learned.peakA, learned.timeToPeakMs, learned.tauMs, learned.i2t);
+  }
+  saveEnvelope();
+}
+
+/* ================= Analysis (loop) ================= */
+
+static void analyse(InrushMetrics& m) {
+  m.atMs         = cap.atMs;
+  m.peakA        = cap.peakA;
+  m.timeToPeakMs = cap.peakUs / 1000.0f;
+  m.i2t          = (float)cap.i2t;
+  m.startV       = cap.startV;
+  m.sagV         = cap.n ? cap.startV - cap.minV : 0.0f;
+  m.samples      = cap.n;
+  m.result       = cap.result;
+
+  /* Steady state: mean of the last quarter of the window */
+  const uint32_t tailUs = INRUSH_WINDOW_MS * 750UL;
+  float    sum = 0.0f;
+  uint16_t cnt = 0;
+  for (uint16_t k = 0; k < cap.n; k++)
+    if (capT[k] >= tailUs) { sum += capI[k]; cnt++; }
+  m.steadyA = cnt ? sum / cnt : (cap.n ? capI[cap.n - 1] : 0.0f);
+
+  /* τ: first sample after the peak at or below steady + (peak − steady)/e */
+  float thr = m.steadyA + (m.peakA - m.steadyA) * 0.36788f;
+  m.tauMs   = 0.0f;
+  for (uint16_t k = 0; k < cap.n; k++) {
+    if (capT[k] <= cap.peakUs) continue;
+    if (capI[k] <= thr) { m.tauMs = (capT[k] - cap.peakUs) / 1000.0f; break; }
+  }
+  if (m.tauMs == 0.0f && cap.n)      // never decayed inside the window
+    m.tauMs = (capT[cap.n - 1] - cap.peakUs) / 1000.0f;
+}
+
+static void finishCapture() {
+  InrushMetrics m;
+  analyse(m);
+  if (m.result == INRUSH_OK && m.peakA < INRUSH_MIN_PEAK_A) m.result = INRUSH_NO_LOAD;
+
+  portENTER_CRITICAL(&capLock);
+  state = CAP_IDLE;
+  portEXIT_CRITICAL(&capLock);
+
+  hist[histHead] = m;
+  histHead = (histHead + 1) % INRUSH_HISTORY;
+  if (histCount < INRUSH_HISTORY) histCount++;
+  stats.captures++;
+
+  switch (m.result) {
+    case INRUSH_OK:
+#if ENABLE_PRECHARGE
+      /* Learn only from a start whose sequence reached CLOSED: checked
+         against the envelope all the same, but a start that was not
+         pre-charged must not pull the pre-charged shape around       */
+      if (prechargeGetStats().completed == cap.preDone) {
+        stats.notPrecharged++;
+        LOGD("INRUSH", "Start not pre-charged (peak %.1fA) – not learned", m.peakA);
+        break;
+      }
+#endif
+      learn(m);
+      LOGI("INRUSH", "Start: peak %.1fA @%.0fms  tau %.0fms  I2t %.1fA2s  run %.1fA  sag %.2fV",
+           m.peakA, m.timeToPeakMs, m.tauMs, m.i2t, m.steadyA, m.sagV);
+      break;
+    case INRUSH_NO_LOAD:
+      stats.noLoad++;
+      LOGD("INRUSH", "Start without load (peak %.2fA)", m.peakA);
+      break;
+    case INRUSH_ABORTED:
+      stats.aborted++;
+      LOGD("INRUSH", "Capture aborted after %u samples", m.samples);
+      break;
+    default:
+      stats.trips++;
+      LOGE("INRUSH", "TRIP %s: peak %.1fA @%.0fms  I2t %.1fA2s (limits %.1fA / %.1fA2s)",
+           inrushResultName(m.result), m.peakA, m.timeToPeakMs, m.i2t, lim.peakA, lim.i2t);
+      triggerExternalFault(FAULT_MOTOR_INRUSH, "MOTOR INRUSH");
+      actuatorRequest(ACT_MOTOR, ACT_SRC_INRUSH, ACT_NONE);   // the fault holds it now
+      break;
+  }
+}
+
+/* ================= API ================= */
+
+void inrushInit() {
+  prefs.begin(INRUSH_NVS, true);
+  if (prefs.getBytesLength("env") == sizeof(learned))
+    prefs.getBytes("env", &learned, sizeof(learned));
+  if (prefs.getBytesLength("base") == sizeof(baseline))
+    prefs.getBytes("base", &baseline, sizeof(baseline));
+  prefs.end();
+  initialized = true;
+
+  if (envelopeValid())
+    LOGI("INRUSH", "Envelope: peak %.1fA  tau %.0fms  I2t %.1fA2s  (%lu starts)",
+         learned.peakA, learned.tauMs, learned.i2t, (unsigned long)learned.starts);
+  else
+    LOGI("INRUSH", "Learning – %lu/%u starts, default envelope",
+         (unsigned long)learned.starts, INRUSH_LEARN_STARTS);
+}
+
+void inrushStart() {
+  if (!initialized || state == CAP_RUNNING) return;   // boot enable: no sampler yet
+  if (state != CAP_IDLE) finishCapture();
+
+  setLimits();
+  memset(&cap, 0, sizeof(cap));
+  cap.atMs   = millis();
+  cap.startV = preV;
+  cap.minV   = preV;
+  cap.result = INRUSH_OK;
+  cap.t0Us   = esp_timer_get_time();
+#if ENABLE_PRECHARGE
+  cap.preDone = prechargeGetStats().completed;
+#endif
+
+  portENTER_CRITICAL(&capLock);
+  state = CAP_RUNNING;
+  portEXIT_CRITICAL(&capLock);
+}
+
+void inrushAbort() {
+  portENTER_CRITICAL(&capLock);
+  if (state == CAP_RUNNING) {
+    cap.result = INRUSH_ABORTED;
+    state      = CAP_ABORTED;
+  }
+  portEXIT_CRITICAL(&capLock);
+}
+
+bool inrushFeed(float current, float voltage, int64_t nowUs) {
+  if (state != CAP_RUNNING) {
+    preV = preV > 0.0f ? preV + 0.2f * (voltage - preV) : voltage;
+    return false;
+  }
+
+  float    a  = fabsf(current);
+  uint32_t t  = (uint32_t)(nowUs - cap.t0Us);
+  float    dt = (cap.n ? nowUs - cap.prevUs : nowUs - cap.t0Us) * 1e-6f;
+  cap.i2t += 0.5f * (a * a + cap.prevA * cap.prevA) * dt;   // from 0 A at relay ON
+  cap.prevA  = a;
+  cap.prevUs = nowUs;
+
+  if (cap.n < CAP_MAX) {
+    capI[cap.n] = a;
+    capT[cap.n] = t;
+    cap.n++;
+  }
+  if (a > cap.peakA) { cap.peakA = a; cap.peakUs = t; }
+  if (voltage < cap.minV) cap.minV = voltage;
+
+  InrushResult trip = INRUSH_OK;
+  if (a > INRUSH_HARD_LIMIT_A)                       trip = INRUSH_TRIP_HARD;
+  else if (a > envelopeAt(t / 1000.0f)) {
+    if (++cap.over >= INRUSH_TRIP_SAMPLES)           trip = INRUSH_TRIP_ENVELOPE;
+  } else                                             cap.over = 0;
+  if (trip == INRUSH_OK && cap.i2t > lim.i2t)        trip = INRUSH_TRIP_I2T;
+
+  CapState next = CAP_RUNNING;
+  if (trip != INRUSH_OK) {
+    actuatorForceOff(ACT_MOTOR);                      // now – the loop latches the fault
+    cap.result = trip;
+    next       = CAP_TRIPPED;
+  } else if (t >= INRUSH_WINDOW_MS * 1000UL) {
+    next       = CAP_DONE;
+  }
+
+  if (next != CAP_RUNNING) {
+    portENTER_CRITICAL(&capLock);
+    if (state == CAP_RUNNING) state = next;
+    portEXIT_CRITICAL(&capLock);
+    return false;
+  }
+  return true;
+}
+
+void inrushService() {
+  CapState s = state;
+  if (s == CAP_DONE || s == CAP_TRIPPED || s == CAP_ABORTED) finishCapture();
+}
+
+bool  inrushActive()       { return state == CAP_RUNNING; }
+float inrushStartVoltage() { return state == CAP_RUNNING ? cap.startV : preV; }
+
+InrushStats inrushGetStats() {
+  InrushStats s   = stats;
+  s.learned       = learned;
+  s.baseline      = baseline;
+  s.envelopeValid = envelopeValid();
+  s.history       = histCount;
+  return s;
+}
+
+bool inrushGetHistory(uint8_t idx, InrushMetrics* out) {
+  if (idx >= histCount || !out) return false;
+  *out = hist[(histHead + INRUSH_HISTORY - 1 - idx) % INRUSH_HISTORY];
+  return true;
+}
+
+void inrushResetEnvelope() {
+  memset(&learned,  0, sizeof(learned));
+  memset(&baseline, 0, sizeof(baseline));
+  saveEnvelope();
+  LOGW("INRUSH", "Envelope reset – learning from the next %u starts", INRUSH_LEARN_STARTS);
+}
+
+const char* inrushResultName(InrushResult r) {
+  switch (r) {
+    case INRUSH_OK:            return "OK";
+    case INRUSH_NO_LOAD:       return "NO-LOAD";
+    case INRUSH_ABORTED:       return "ABORTED";
+    case INRUSH_TRIP_HARD:     return "HARD-LIMIT";
+    case INRUSH_TRIP_ENVELOPE: return "ENVELOPE";
+    case INRUSH_TRIP_I2T:      return "I2T";
+    default:                   return "?";
+  }
+}
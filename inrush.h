@@ -0,0 +1,117 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Motor Inrush Capture
+ *  Every motor relay ON edge is captured for INRUSH_WINDOW_MS at
+ *  the sampler's burst rate.  Each sample is checked, in the
+ *  sampler task, against an envelope learned from earlier starts:
+ *
+ *    peak   |I| ≤ learned peak × INRUSH_PEAK_MARGIN
+ *    decay  after the learned time-to-peak the limit falls as
+ *           exp(-t / (τ × INRUSH_TAU_MARGIN)) down to
+ *           MAX_DISCHARGE_CURRENT
+ *    I²t    running ∫I²dt ≤ learned I²t × INRUSH_I2T_MARGIN
+ *
+ *  Leaving the envelope opens the motor relay from the sampler
+ *  task straight away (actuatorForceOff); inrushService() latches
+ *  FAULT_MOTOR_INRUSH on the next loop pass.  Until
+ *  INRUSH_LEARN_STARTS starts have been seen the INRUSH_DEFAULT_*
+ *  envelope applies.
+ *
+ *  Protection is not blanked: the loop keeps evaluating faults
+ *  during a capture and only judges under-voltage on the pack
+ *  voltage from before the relay closed (the sag is the inrush).
+ *
+ *  Per-start metrics (peak, time to peak, I²t, τ, steady current,
+ *  voltage sag) are kept for motor health trending; the envelope
+ *  and a baseline frozen when learning completes live in NVS.
+ *
+ *  With ENABLE_PRECHARGE the main relay closes onto a charged
+ *  bus and only the motor's own start current is left.  Such
+ *  starts get an envelope and baseline of their own (NVS
+ *  "inrush_pc"), learned only from starts whose pre-charge
+ *  sequence completed.
+ * ============================================================
+ */
+
+enum InrushResult : uint8_t {
+  INRUSH_OK = 0,             // inside the envelope – learned from
+  INRUSH_NO_LOAD,            // peak below INRUSH_MIN_PEAK_A – not learned
+  INRUSH_ABORTED,            // relay opened during the window
+  INRUSH_TRIP_HARD,          // one sample above INRUSH_HARD_LIMIT_A
+  INRUSH_TRIP_ENVELOPE,      // INRUSH_TRIP_SAMPLES above the decay curve
+  INRUSH_TRIP_I2T            // energy above the learned I²t
+};
+
+/** One motor start. */
+struct InrushMetrics {
+  uint32_t atMs;             // millis() at relay ON
+  float    peakA;
+  float    timeToPeakMs;
+  float    i2t;              // A²s over the window
+  float    tauMs;            // peak → 1/e of (peak − steady)
+  float    steadyA;          // mean of the last quarter of the window
+  float    startV;           // pack voltage before the relay closed
+  float    sagV;             // startV − lowest sample in the window
+  uint16_t samples;
+  InrushResult result;
+};
+
+/** Learned shape: running mean of accepted starts. */
+struct InrushEnvelope {
+  float    peakA;
+  float    timeToPeakMs;
+  float    i2t;
+  float    tauMs;
+  float    steadyA;
+  uint32_t starts;           // accepted starts behind the mean
+};
+
+struct InrushStats {
+  InrushEnvelope learned;
+  InrushEnvelope baseline;   // frozen at INRUSH_LEARN_STARTS – trend reference
+  bool           envelopeValid;
+  uint32_t       captures;
+  uint32_t       trips;
+  uint32_t       noLoad;
+  uint32_t       aborted;
+  uint32_t       notPrecharged;  // OK, but the pre-charge sequence did not complete – not learned
+  uint8_t        history;    // entries available to inrushGetHistory()
+};
+
+/** Load the envelope from NVS.  Call before samplerInit(). */
+void inrushInit();
+
+/** Motor relay just closed (actuator).  Ignored while a capture runs. */
+void inrushStart();
+
+/** Motor relay opened by something else during the window. */
+void inrushAbort();
+
+/**
+ * Sampler task, every sample.  Checks the envelope and may open
+ * the motor relay.
+ * @return true while a capture is running (hold the burst rate)
+ */
+bool inrushFeed(float current, float voltage, int64_t nowUs);
+
+/** Main loop, before fault evaluation: latch a trip, analyse a finished capture. */
+void inrushService();
+
+/** A capture is running. */
+bool inrushActive();
+
+/** Pack voltage before the relay closed – for the UV check during a capture. */
+float inrushStartVoltage();
+
+InrushStats inrushGetStats();
+
+/** @param idx 0 = newest start  @return false past the end */
+bool inrushGetHistory(uint8_t idx, InrushMetrics* out);
+
+/** Forget the learned envelope (new motor): back to the defaults. */
+void inrushResetEnvelope();
+
+const char* inrushResultName(InrushResult r);
@@ -3,6 +3,11 @@
 #include <hd44780ioClass/hd44780_I2Cexp.h>
 #include "lcd.h"
 #include "config.h"
+#include "logger.h"
+#include "bus_lock.h"
+#if ENABLE_RANGE_ESTIMATOR
+  #include "range.h"
+#endif
 #include <string.h>
 #include <math.h>
 
@@ -15,6 +20,12 @@ static uint8_t       screenIndex  = 0;
 #define LCD_UPDATE_MS    500
 #define LCD_ROTATION_MS  3000
 
+#if ENABLE_RANGE_ESTIMATOR
+  #define LCD_SCREENS    4
+#else
+  #define LCD_SCREENS    3
+#endif
+
 /* SOC thresholds for battery status labels */
 #define SOC_LOW_THRESHOLD       20.0f
 #define SOC_CRITICAL_THRESHOLD  10.0f
@@ -91,6 +102,15 @@ static const char* getStatusLine(float i, float soc, bool fanOn) {
   return "NORMAL";
 }
 
+/* One line per hold of the shared Wire bus: the sampler reads the
+   INA219 on it and waits out at most this (≈2–3 ms at 400 kHz) */
+static void showLine(uint8_t row, const char* text) {
+  busLock(BUS_I2C);
+  lcd.setCursor(0, row);
+  lcd.print(text);
+  busUnlock(BUS_I2C);
+}
+
 /* ═══════════════════════════════════════════
    INIT
    ═══════════════════════════════════════════ */
@@ -98,14 +118,14 @@ static const char* getStatusLine(float i, float soc, bool fanOn) {
 void lcdInit() {
   int rc = lcd.begin(16, 2);
   if (rc) {
-    Serial.printf("[LCD] Init failed (rc=%d)\n", rc);
+    LOGE("LCD", "Init failed (rc=%d)", rc);
     return;
   }
   lcd.backlight();
   lcd.clear();
-  lcd.setCursor(0, 0); lcd.print("BMS STARTING... ");
-  lcd.setCursor(0, 1); lcd.print("PLEASE WAIT...  ");
-  Serial.println("[LCD] Initialized");
+  showLine(0, "BMS STARTING... ");
+  showLine(1, "PLEASE WAIT...  ");
+  LOGI("LCD", "Initialized");
 }
 
 /* ═══════════════════════════════════════════
@@ -125,6 +145,10 @@ void lcdInit() {
        Line 1 : RUL: XXXX Months
        Line 2 : FAN: ON / OFF
 
+     Screen 3  – Range (ENABLE_RANGE_ESTIMATOR)
+       Line 1 : RNG: XXX km
+       Line 2 : XX-XXX km XX.X     (bounds, Wh/km)
+
    Fault override (any fault latched):
        Line 1 : !! FAULT !!
        Line 2 : FAULT: <SHORT CODE>
@@ -148,14 +172,14 @@ void lcdUpdate(float v, float i, float t,
   if (fault) {
     snprintf(line1, sizeof(line1), "!! FAULT !!     ");
     snprintf(line2, sizeof(line2), "FAULT: %-9s", shortFaultCode(faultMsg));
-    lcd.setCursor(0, 0); lcd.print(line1);
-    lcd.setCursor(0, 1); lcd.print(line2);
+    showLine(0, line1);
+    showLine(1, line2);
     return;
   }
 
   /* ── Rotate screens every LCD_ROTATION_MS ── */
   if (now - lastRotation > LCD_ROTATION_MS) {
-    screenIndex  = (screenIndex + 1) % 3;
+    screenIndex  = (screenIndex + 1) % LCD_SCREENS;
     lastRotation = now;
   }
 
@@ -182,8 +206,19 @@ void lcdUpdate(float v, float i, float t,
       snprintf(line1, sizeof(line1), "RUL:%4d Months ", rulMonths);
       snprintf(line2, sizeof(line2), "FAN: %-11s", fanOn ? "ON" : "OFF");
       break;
+
+#if ENABLE_RANGE_ESTIMATOR
+    /* ── Screen 3: Range / bounds + Wh/km ── */
+    case 3: {
+      RangeEstimate r = rangeGetEstimate();
+      snprintf(line1, sizeof(line1), "RNG: %4.0f km    ", r.rangeKm);
+      snprintf(line2, sizeof(line2), "%3.0f-%-4.0fkm%4.1f",
+               r.rangeLoKm, fminf(r.rangeHiKm, 9999.0f), r.whPerKm);
+      break;
+    }
+#endif
   }
 
-  lcd.setCursor(0, 0); lcd.print(line1);
-  lcd.setCursor(0, 1); lcd.print(line2);
+  showLine(0, line1);
+  showLine(1, line2);
 }
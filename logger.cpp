@@ -0,0 +1,137 @@
+#include "logger.h"
+#include <atomic>
+#include <stdarg.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+/* ================= Ring ================= */
+
+#define LOG_SLOTS           64     // power of two
+#define LOG_TEXT_LEN       112     // bytes of message per record
+#define LOG_DRAIN_PERIOD_MS 20
+#define LOG_TASK_STACK    3072
+#define LOG_TASK_PRIORITY    1     // same as loop(); runs on the other core
+
+enum : uint8_t { SLOT_EMPTY = 0, SLOT_WRITING = 1, SLOT_READY = 2 };
+
+struct LogSlot {
+  std::atomic<uint8_t> state;
+  uint8_t              level;
+  const char*          tag;       // string literal – never copied
+  int64_t              timeUs;
+  char                 text[LOG_TEXT_LEN];
+};
+
+static LogSlot               slots[LOG_SLOTS];
+static std::atomic<uint32_t> head{0};       // next slot to reserve (producers)
+static std::atomic<uint32_t> tail{0};       // next slot to print  (consumer)
+static std::atomic<uint32_t> dropped{0};
+static std::atomic<uint32_t> written{0};
+static uint16_t              highWater    = 0;
+static uint32_t              droppedShown = 0;
+
+static SemaphoreHandle_t drainLock = nullptr;   // consumer side only
+static TaskHandle_t      drainTask = nullptr;
+
+static const char LEVEL_CHAR[] = { '-', 'E', 'W', 'I', 'D' };
+
+/* ================= Producer ================= */
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) {
+  /* Reserve a slot: CAS so a full ring never advances head */
+  uint32_t h = head.load(std::memory_order_relaxed);
+  do {
+    if (h - tail.load(std::memory_order_acquire) >= LOG_SLOTS) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  } while (!head.compare_exchange_weak(h, h + 1,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed));
+
+  LogSlot& s = slots[h & (LOG_SLOTS - 1)];
+  s.state.store(SLOT_WRITING, std::memory_order_relaxed);
+  s.timeUs = esp_timer_get_time();
+  s.level  = level;
+  s.tag    = tag;
+
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(s.text, sizeof(s.text), fmt, ap);
+  va_end(ap);
+
+  s.state.store(SLOT_READY, std::memory_order_release);
+  written.fetch_add(1, std::memory_order_relaxed);
+
+  uint16_t used = (uint16_t)(h + 1 - tail.load(std::memory_order_relaxed));
+  if (used > highWater) highWater = used;
+}
+
+/* ================= Consumer ================= */
+
+static void printSlot(const LogSlot& s) {
+  char line[LOG_TEXT_LEN + 40];
+  uint32_t sec  = (uint32_t)(s.timeUs / 1000000);
+  uint32_t usec = (uint32_t)(s.timeUs % 1000000);
+  int n = snprintf(line, sizeof(line), "%lu.%06lu %c [%s] %s\n",
+                   (unsigned long)sec, (unsigned long)usec,
+                   LEVEL_CHAR[s.level <= LOG_LEVEL_DEBUG ? s.level : 0],
+                   s.tag, s.text);
+  if (n > (int)sizeof(line) - 1) n = sizeof(line) - 1;
+  Serial.write((const uint8_t*)line, n);   // one write – never interleaves
+}
+
+static void drain() {
+  uint32_t t = tail.load(std::memory_order_relaxed);
+  while (t != head.load(std::memory_order_acquire)) {
+    LogSlot& s = slots[t & (LOG_SLOTS - 1)];
+    if (s.state.load(std::memory_order_acquire) != SLOT_READY)
+      break;   // producer still formatting – pick it up next pass
+
+    printSlot(s);
+    s.state.store(SLOT_EMPTY, std::memory_order_relaxed);
+    tail.store(++t, std::memory_order_release);
+  }
+
+  uint32_t d = dropped.load(std::memory_order_relaxed);
+  if (d != droppedShown) {
+    Serial.printf("[LOG] %lu records dropped (ring full)\n",
+                  (unsigned long)(d - droppedShown));
+    droppedShown = d;
+  }
+}
+
+static void drainTaskFn(void*) {
+  for (;;) {
+    if (xSemaphoreTake(drainLock, portMAX_DELAY) == pdTRUE) {
+      drain();
+      xSemaphoreGive(drainLock);
+    }
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+  }
+}
+
+/* ================= Public ================= */
+
+void logInit() {
+  if (drainTask) return;
+
+  drainLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(drainTaskFn, "log_drain", LOG_TASK_STACK,
+                          nullptr, LOG_TASK_PRIORITY, &drainTask, 0);
+}
+
+void logFlush() {
+  if (!drainLock) { drain(); return; }
+  if (xSemaphoreTake(drainLock, pdMS_TO_TICKS(100)) == pdTRUE) {
+    drain();
+    xSemaphoreGive(drainLock);
+  }
+  Serial.flush();
+}
+
+uint32_t logDroppedCount() { return dropped.load(std::memory_order_relaxed); }
+uint32_t logWrittenCount() { return written.load(std::memory_order_relaxed); }
+uint16_t logHighWater()    { return highWater; }
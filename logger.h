@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+/*
+ * ============================================================
+ *  Asynchronous Ring-Buffer Logger
+ *  LOGE/LOGW/LOGI/LOGD format into a fixed slot of a lock-free
+ *  multi-producer ring and return immediately; a low-priority
+ *  task drains the ring to Serial.  Levels above LOG_LEVEL compile
+ *  to nothing – arguments are not even evaluated.
+ *
+ *  Output:  <seconds.micros> <L> [TAG] message
+ *
+ *  Not for use from ISRs (vsnprintf).
+ * ============================================================
+ */
+
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+#ifndef LOG_LEVEL
+  #define LOG_LEVEL  LOG_LEVEL_INFO
+#endif
+
+/* ──────────────────────────────────────────────────────────
+   MACROS
+   ────────────────────────────────────────────────────────── */
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+  #define LOGE(tag, fmt, ...) logWrite(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOGE(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+  #define LOGW(tag, fmt, ...) logWrite(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOGW(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  #define LOGI(tag, fmt, ...) logWrite(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOGI(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOGD(tag, fmt, ...) logWrite(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOGD(tag, fmt, ...) do {} while (0)
+#endif
+
+/* ──────────────────────────────────────────────────────────
+   API
+   ────────────────────────────────────────────────────────── */
+
+/**
+ * Start the drain task.  Call first thing in setup(); records
+ * written before this are kept in the ring and printed once it runs.
+ */
+void logInit();
+
+/**
+ * Format one record into the ring.  Never blocks: if the ring is
+ * full the record is dropped and counted.  Use the LOGx macros.
+ */
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...)
+  __attribute__((format(printf, 3, 4)));
+
+/** Drain synchronously from the caller (before halt / restart). */
+void logFlush();
+
+uint32_t logDroppedCount();   // records lost to a full ring
+uint32_t logWrittenCount();   // records accepted
+uint16_t logHighWater();      // max slots ever in use
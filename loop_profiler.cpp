@@ -0,0 +1,142 @@
+#include "loop_profiler.h"
+#include "config.h"
+
+/* ================= Private ================= */
+
+static uint32_t histogram[STAGE_COUNT][PROFILER_BUCKETS];
+static uint32_t stageCount[STAGE_COUNT];
+static uint32_t stageMaxUs[STAGE_COUNT];
+
+static uint32_t cpuMHz          = 240;
+static uint32_t loopStartCycles = 0;
+static uint32_t markCycles      = 0;
+static uint32_t deadlineMisses  = 0;
+static uint32_t worstIntervalMs = 0;
+static uint32_t markCostCycles  = 0;   // measured at init
+static uint32_t lastIntervalMs  = 100;
+
+static const char* STAGE_NAMES[STAGE_COUNT] = {
+  "wifi", "sensing", "edge", "health", "protect",
+  "relays", "lcd", "serial", "cloud", "LOOP"
+};
+
+/* ================= Bucketing ================= */
+
+/*
+ * Log-linear buckets: values < 4 µs map 1:1, above that each power of
+ * two is split into PROFILER_SUB_BUCKETS equal slices.
+ */
+static uint16_t bucketFor(uint32_t us) {
+  if (us < PROFILER_SUB_BUCKETS) return (uint16_t)us;
+
+  uint32_t octave = 31 - __builtin_clz(us);
+  if (octave >= PROFILER_OCTAVES) return PROFILER_BUCKETS - 1;
+
+  uint32_t sub = (us >> (octave - 2)) & (PROFILER_SUB_BUCKETS - 1);
+  return (uint16_t)(octave * PROFILER_SUB_BUCKETS + sub);
+}
+
+/* Upper bound (µs) of a bucket – what percentiles report */
+static uint32_t bucketUpperUs(uint16_t b) {
+  if (b < PROFILER_SUB_BUCKETS) return b;
+  uint32_t octave = b / PROFILER_SUB_BUCKETS;
+  uint32_t sub    = b % PROFILER_SUB_BUCKETS;
+  return ((PROFILER_SUB_BUCKETS + sub + 1) << (octave - 2)) - 1;
+}
+
+static void recordCycles(LoopStage stage, uint32_t cycles) {
+  uint32_t us = cycles / cpuMHz;
+  histogram[stage][bucketFor(us)]++;
+  stageCount[stage]++;
+  if (us > stageMaxUs[stage]) stageMaxUs[stage] = us;
+}
+
+static uint32_t percentileUs(LoopStage stage, uint32_t permille) {
+  uint32_t n = stageCount[stage];
+  if (n == 0) return 0;
+
+  uint32_t target = (uint32_t)(((uint64_t)n * permille + 999) / 1000);
+  uint32_t seen   = 0;
+  for (uint16_t b = 0; b < PROFILER_BUCKETS; b++) {
+    seen += histogram[stage][b];
+    if (seen >= target) return min(bucketUpperUs(b), stageMaxUs[stage]);
+  }
+  return stageMaxUs[stage];
+}
+
+/* ================= Public ================= */
+
+void profilerInit() {
+  cpuMHz = ESP.getCpuFreqMHz();
+  if (cpuMHz == 0) cpuMHz = 240;
+
+  /* Measure what one mark costs so the overhead can be reported */
+  const int CALIB = 64;
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i = 0; i < CALIB; i++)
+    recordCycles(STAGE_LOOP_TOTAL, ESP.getCycleCount() - t0);
+  markCostCycles = (ESP.getCycleCount() - t0) / CALIB;
+
+  profilerReset();
+  Serial.printf("[PROF] Initialized (%lu MHz, %lu cycles/mark)\n",
+                (unsigned long)cpuMHz, (unsigned long)markCostCycles);
+}
+
+void profilerBeginLoop() {
+  loopStartCycles = ESP.getCycleCount();
+  markCycles      = loopStartCycles;
+}
+
+void profilerMark(LoopStage stage) {
+  uint32_t now = ESP.getCycleCount();
+  recordCycles(stage, now - markCycles);
+  markCycles = ESP.getCycleCount();   // exclude our own bookkeeping
+}
+
+void profilerEndLoop(unsigned long dtMs, unsigned long intervalMs) {
+  recordCycles(STAGE_LOOP_TOTAL, ESP.getCycleCount() - loopStartCycles);
+
+  lastIntervalMs = intervalMs;
+  if (dtMs > worstIntervalMs) worstIntervalMs = dtMs;
+  if (dtMs > intervalMs + PROFILER_DEADLINE_SLACK_MS) deadlineMisses++;
+}
+
+StageStats profilerGetStats(LoopStage stage) {
+  StageStats s;
+  s.count = stageCount[stage];
+  s.p50Us = percentileUs(stage, 500);
+  s.p99Us = percentileUs(stage, 990);
+  s.maxUs = stageMaxUs[stage];
+  return s;
+}
+
+uint32_t profilerDeadlineMisses()  { return deadlineMisses;  }
+uint32_t profilerWorstIntervalMs() { return worstIntervalMs; }
+
+void profilerReset() {
+  memset(histogram,  0, sizeof(histogram));
+  memset(stageCount, 0, sizeof(stageCount));
+  memset(stageMaxUs, 0, sizeof(stageMaxUs));
+  deadlineMisses  = 0;
+  worstIntervalMs = 0;
+}
+
+void profilerDump() {
+  Serial.println("===== LOOP PROFILE (us) =====");
+  Serial.println("stage      count      p50      p99      max");
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    StageStats st = profilerGetStats((LoopStage)s);
+    Serial.printf("%-8s %7lu %8lu %8lu %8lu\n", STAGE_NAMES[s],
+                  (unsigned long)st.count, (unsigned long)st.p50Us,
+                  (unsigned long)st.p99Us, (unsigned long)st.maxUs);
+  }
+
+  /* STAGE_COUNT marks per loop (every stage + the total) */
+  float overheadUs  = (float)(markCostCycles * STAGE_COUNT) / (float)cpuMHz;
+  float overheadPct = overheadUs / ((float)lastIntervalMs * 10.0f);
+  Serial.printf("Deadline misses: %lu  worst interval: %lu ms\n",
+                (unsigned long)deadlineMisses, (unsigned long)worstIntervalMs);
+  Serial.printf("Profiler overhead: %.1f us/loop (%.3f%%)\n",
+                overheadUs, overheadPct);
+  Serial.println("=============================\n");
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Loop Stage Profiler
+ *  Times each STEP of loop() with the CPU cycle counter and
+ *  keeps a fixed-bucket log-scale histogram per stage.
+ *  Cost per mark: one cycle-counter read + one bucket increment.
+ * ============================================================
+ */
+
+/* ──────────────────────────────────────────────────────────
+   STAGES  (match the STEP comments in BMS_Firmware.ino)
+   ────────────────────────────────────────────────────────── */
+
+typedef enum : uint8_t {
+  STAGE_WIFI = 0,      // wifiEnsure()
+  STAGE_SENSING,       // STEP 1 – ADC averaging, INA219, DHT
+  STAGE_EDGE,          // STEP 2 – edge analytics
+  STAGE_HEALTH,        // STEP 3 – SOC / SOH / RUL (+ NVS saves)
+  STAGE_PROTECTION,    // STEP 4 – faults, accelerometer I2C, alerts
+  STAGE_RELAYS,        // STEP 5 – relay control
+  STAGE_DISPLAY,       // STEP 6 – LCD I2C
+  STAGE_SERIAL,        // STEP 7 – serial telemetry
+  STAGE_CLOUD,         // STEP 8 – HTTP upload
+  STAGE_LOOP_TOTAL,    // whole loop body
+  STAGE_COUNT
+} LoopStage;
+
+/* 4 buckets per octave, 1 µs … ~134 s */
+#define PROFILER_SUB_BUCKETS  4
+#define PROFILER_OCTAVES      27
+#define PROFILER_BUCKETS      (PROFILER_SUB_BUCKETS * PROFILER_OCTAVES)
+
+/* A loop whose start-to-start time exceeds the cadence by more than this
+   counts as a deadline miss (1 ms of millis() jitter is normal). */
+#define PROFILER_DEADLINE_SLACK_MS  2UL
+
+struct StageStats {
+  uint32_t count;
+  uint32_t p50Us;     // bucket upper bound
+  uint32_t p99Us;     // bucket upper bound
+  uint32_t maxUs;     // exact
+};
+
+/* ──────────────────────────────────────────────────────────
+   API
+   ────────────────────────────────────────────────────────── */
+
+/** Call once in setup(). Caches the CPU clock for cycle → µs. */
+void profilerInit();
+
+/** Start of a loop body: resets the stage mark to now. */
+void profilerBeginLoop();
+
+/**
+ * Close the stage that started at the previous mark.
+ * Records cycles since the last mark (or profilerBeginLoop()).
+ */
+void profilerMark(LoopStage stage);
+
+/**
+ * End of a loop body: records STAGE_LOOP_TOTAL and checks the
+ * start-to-start interval against the cadence.
+ * @param dtMs       Elapsed since the previous loop start (ms)
+ * @param intervalMs Nominal loop cadence (ms)
+ */
+void profilerEndLoop(unsigned long dtMs, unsigned long intervalMs);
+
+StageStats profilerGetStats(LoopStage stage);
+uint32_t   profilerDeadlineMisses();
+uint32_t   profilerWorstIntervalMs();
+
+/** Zero all histograms and counters. */
+void profilerReset();
+
+/** Print a per-stage table (count / p50 / p99 / max) to Serial. */
+void profilerDump();
@@ -0,0 +1,594 @@
+#include "mqtt_client.h"
+#include "config.h"
+#include "logger.h"
+#include "fault_manager.h"
+#include "soc.h"
+#include "telemetry_stream.h"
+#include <NetworkClient.h>
+#include <NetworkClientSecure.h>
+#include <string.h>
+
+/* ================= Protocol ================= */
+
+#define MQTT_PKT_CONNECT     0x10
+#define MQTT_PKT_CONNACK     0x20
+#define MQTT_PKT_PUBLISH     0x30
+#define MQTT_PKT_PUBACK      0x40
+#define MQTT_PKT_SUBSCRIBE   0x82     // reserved flags 0b0010
+#define MQTT_PKT_SUBACK      0x90
+#define MQTT_PKT_PINGREQ     0xC0
+#define MQTT_PKT_PINGRESP    0xD0
+#define MQTT_PKT_DISCONNECT  0xE0
+#define MQTT_FLAG_DUP        0x08
+
+#define MQTT_MAX_PACKET          1200    // telemetry JSON row + topic + header
+#define MQTT_RX_BUF               512
+#define MQTT_RX_BUDGET           1024    // bytes parsed per mqttLoop()
+#define MQTT_CONNACK_TIMEOUT_MS  5000
+#define MQTT_BACKOFF_MIN_MS      2000
+#define MQTT_BACKOFF_MAX_MS     60000
+#define MQTT_STREAM_PERIOD_MS    (1000UL / MQTT_STREAM_HZ)
+
+/* ================= Private ================= */
+
+#if MQTT_USE_TLS
+static NetworkClientSecure net;
+#else
+static NetworkClient       net;
+#endif
+
+enum : uint8_t { MQTT_DOWN, MQTT_AWAIT_CONNACK, MQTT_UP };
+static uint8_t state = MQTT_DOWN;
+static bool    trusted = false;        // broker verified (CA) – commands may change state
+
+struct InflightSlot {
+  bool          used;
+  uint16_t      id;
+  uint32_t      sentUs;
+  unsigned long sentMs;
+  uint16_t      len;
+  uint8_t       pkt[MQTT_MAX_PACKET];   // kept for DUP resend
+};
+static InflightSlot inflight[MQTT_INFLIGHT_WINDOW];
+
+static char topicTelemetry[48];
+static char topicStream[48];
+static char topicStatus[48];
+static char topicCmd[48];
+static char topicAck[48];
+
+static uint8_t  txBuf[MQTT_MAX_PACKET];
+static uint16_t nextId = 1;
+
+static unsigned long lastAttemptMs = 0;
+static unsigned long backoffMs     = MQTT_BACKOFF_MIN_MS;
+static unsigned long connectMs     = 0;
+static unsigned long lastTxMs      = 0;
+static unsigned long lastRxMs      = 0;
+static unsigned long lastStreamMs  = 0;
+
+static MqttStats stats = {};
+static uint32_t  rateCount    = 0;
+static unsigned long rateStartMs = 0;
+static uint64_t  rttSumUs     = 0;     // since last mqttBenchmark() reset
+static uint32_t  rttSamples   = 0;
+
+/* ── Receive parser ── */
+enum : uint8_t { RX_HEADER, RX_LENGTH, RX_BODY };
+static uint8_t  rxPhase  = RX_HEADER;
+static uint8_t  rxHeader = 0;
+static uint32_t rxLen    = 0;
+static uint32_t rxMul    = 1;
+static uint32_t rxPos    = 0;
+static uint8_t  rxBuf[MQTT_RX_BUF];
+
+/* ================= Encoding ================= */
+
+static size_t putRemLen(uint8_t* p, uint32_t len) {
+  size_t n = 0;
+  do {
+    uint8_t b = len & 0x7F;
+    len >>= 7;
+    if (len) b |= 0x80;
+    p[n++] = b;
+  } while (len);
+  return n;
+}
+
+static size_t putStr(uint8_t* p, const char* s, size_t len) {
+  p[0] = (uint8_t)(len >> 8);
+  p[1] = (uint8_t)len;
+  memcpy(&p[2], s, len);
+  return len + 2;
+}
+
+static size_t putStr(uint8_t* p, const char* s) { return putStr(p, s, strlen(s)); }
+
+/** @return packet length, 0 if it does not fit in `cap` */
+static size_t buildPublish(uint8_t* out, size_t cap, const char* topic,
+                           const uint8_t* payload, size_t len,
+                           uint8_t qos, bool retain, uint16_t id) {
+  size_t topicLen = strlen(topic);
+  size_t rem      = 2 + topicLen + (qos ? 2 : 0) + len;
+  if (rem + 5 > cap) return 0;
+
+  size_t n = 0;
+  out[n++] = MQTT_PKT_PUBLISH | (qos << 1) | (retain ? 1 : 0);
+  n += putRemLen(&out[n], rem);
+  n += putStr(&out[n], topic, topicLen);
+  if (qos) {
+    out[n++] = (uint8_t)(id >> 8);
+    out[n++] = (uint8_t)id;
+  }
+  memcpy(&out[n], payload, len);
+  return n + len;
+}
+
+/* ================= Transport ================= */
+
+static void dropConnection(const char* why) {
+  if (state != MQTT_DOWN) {
+    LOGW("MQTT", "Disconnected: %s", why);
+    stats.disconnects++;
+  }
+  net.stop();
+  state   = MQTT_DOWN;
+  rxPhase = RX_HEADER;
+}
+
+static bool sendRaw(const uint8_t* p, size_t len) {
+  if (net.write(p, len) != len) {
+    dropConnection("write failed");
+    return false;
+  }
+  lastTxMs = millis();
+  return true;
+}
+
+static uint16_t takePacketId() {
+  uint16_t id = nextId++;
+  if (nextId == 0) nextId = 1;     // 0 is not a valid packet id
+  return id;
+}
+
+static void countPublish() {
+  stats.published++;
+  rateCount++;
+}
+
+static bool publishQos0(const char* topic, const uint8_t* payload, size_t len) {
+  if (state != MQTT_UP) return false;
+  size_t n = buildPublish(txBuf, sizeof(txBuf), topic, payload, len, 0, false, 0);
+  if (!n || !sendRaw(txBuf, n)) return false;
+  countPublish();
+  return true;
+}
+
+static bool publishQos1(const char* topic, const uint8_t* payload, size_t len,
+                        bool retain) {
+  if (state != MQTT_UP) return false;
+
+  InflightSlot* slot = nullptr;
+  for (InflightSlot& s : inflight)
+    if (!s.used) { slot = &s; break; }
+  if (!slot) { stats.windowFull++; return false; }
+
+  uint16_t id = takePacketId();
+  size_t   n  = buildPublish(slot->pkt, sizeof(slot->pkt), topic,
+                             payload, len, 1, retain, id);
+  if (!n) return false;
+
+  slot->used   = true;
+  slot->id     = id;
+  slot->len    = n;
+  slot->sentUs = micros();
+  slot->sentMs = millis();
+  countPublish();
+
+  sendRaw(slot->pkt, n);   // on failure the slot is resent after reconnect
+  return true;
+}
+
+static uint8_t inflightCount() {
+  uint8_t n = 0;
+  for (const InflightSlot& s : inflight) n += s.used;
+  return n;
+}
+
+/* ================= Session ================= */
+
+static void sendConnect() {
+  size_t rem = 10                                   // variable header
+             + 2 + strlen(DEVICE_ID)
+             + 2 + strlen(topicStatus) + 2 + 7;     // will: "offline"
+  uint8_t flags = 0x04 | 0x08 | 0x20;               // will, will QoS 1, will retain
+  if (MQTT_USER[0]) { flags |= 0x80; rem += 2 + strlen(MQTT_USER); }
+  if (MQTT_PASS[0]) { flags |= 0x40; rem += 2 + strlen(MQTT_PASS); }
+
+  size_t n = 0;
+  txBuf[n++] = MQTT_PKT_CONNECT;
+  n += putRemLen(&txBuf[n], rem);
+  n += putStr(&txBuf[n], "MQTT");
+  txBuf[n++] = 4;                                   // protocol level 3.1.1
+  txBuf[n++] = flags;                               // clean session = 0
+  txBuf[n++] = (uint8_t)(MQTT_KEEPALIVE_S >> 8);
+  txBuf[n++] = (uint8_t)MQTT_KEEPALIVE_S;
+  n += putStr(&txBuf[n], DEVICE_ID);
+  n += putStr(&txBuf[n], topicStatus);
+  n += putStr(&txBuf[n], "offline");
+  if (MQTT_USER[0]) n += putStr(&txBuf[n], MQTT_USER);
+  if (MQTT_PASS[0]) n += putStr(&txBuf[n], MQTT_PASS);
+
+  sendRaw(txBuf, n);
+}
+
+static void sendSubscribe(const char* topic, uint8_t qos) {
+  size_t   topicLen = strlen(topic);
+  uint16_t id       = takePacketId();
+  size_t   n        = 0;
+  txBuf[n++] = MQTT_PKT_SUBSCRIBE;
+  n += putRemLen(&txBuf[n], 2 + 2 + topicLen + 1);
+  txBuf[n++] = (uint8_t)(id >> 8);
+  txBuf[n++] = (uint8_t)id;
+  n += putStr(&txBuf[n], topic, topicLen);
+  txBuf[n++] = qos;
+  sendRaw(txBuf, n);
+}
+
+static void tryConnect() {
+  unsigned long now = millis();
+  if (now - lastAttemptMs < backoffMs) return;
+  lastAttemptMs = now;
+
+  if (!net.connect(MQTT_HOST, MQTT_PORT)) {
+    LOGW("MQTT", "Connect to %s:%u failed – retry in %lus",
+         MQTT_HOST, (unsigned)MQTT_PORT, backoffMs / 1000);
+    backoffMs = min(backoffMs * 2, (unsigned long)MQTT_BACKOFF_MAX_MS);
+    return;
+  }
+
+  rxPhase   = RX_HEADER;
+  lastRxMs  = millis();
+  connectMs = millis();
+  state     = MQTT_AWAIT_CONNACK;
+  sendConnect();
+}
+
+static void onConnack(uint8_t ackFlags, uint8_t rc) {
+  if (rc != 0) {
+    LOGE("MQTT", "Broker refused connection (rc=%u)", rc);
+    dropConnection("CONNACK refused");
+    backoffMs = MQTT_BACKOFF_MAX_MS;
+    return;
+  }
+
+  state     = MQTT_UP;
+  backoffMs = MQTT_BACKOFF_MIN_MS;
+  stats.connects++;
+  LOGI("MQTT", "Connected to %s (session %s, %lu ms)",
+       MQTT_HOST, (ackFlags & 0x01) ? "resumed" : "new",
+       millis() - connectMs);
+
+  /* Resend everything still waiting for PUBACK */
+  for (InflightSlot& s : inflight) {
+    if (!s.used) continue;
+    s.pkt[0] |= MQTT_FLAG_DUP;
+    s.sentUs  = micros();
+    s.sentMs  = millis();
+    stats.resent++;
+    if (!sendRaw(s.pkt, s.len)) return;
+  }
+
+  if (!(ackFlags & 0x01)) sendSubscribe(topicCmd, 1);
+  publishQos1(topicStatus, (const uint8_t*)"online", 6, true);
+}
+
+/* ================= Commands ================= */
+
+static void handleCommand(const uint8_t* payload, size_t len) {
+  char cmd[48];
+  if (len >= sizeof(cmd)) len = sizeof(cmd) - 1;
+  memcpy(cmd, payload, len);
+  cmd[len] = '\0';
+  while (len && (cmd[len - 1] == '\n' || cmd[len - 1] == '\r' || cmd[len - 1] == ' '))
+    cmd[--len] = '\0';
+
+  stats.commands++;
+  bool ok = true;
+
+  if (!trusted && strcmp(cmd, "ping") != 0) {
+    LOGE("MQTT", "Remote command '%s' refused – broker not verified", cmd);
+    char ack[80];
+    int n = snprintf(ack, sizeof(ack), "err %s (untrusted session)", cmd);
+    publishQos0(topicAck, (const uint8_t*)ack, (size_t)n);
+    return;
+  }
+
+  if (strcmp(cmd, "clear_faults") == 0) {
+    clearFaults();
+  } else if (strncmp(cmd, "reset_soc", 9) == 0 && (cmd[9] == '\0' || cmd[9] == ' ')) {
+    float pct = cmd[9] ? atof(&cmd[10]) : 100.0f;
+    if (pct < 0.0f || pct > 100.0f) ok = false;
+    else                            resetSOC(pct);
+  } else if (strcmp(cmd, "ping") != 0) {
+    ok = false;
+  }
+
+  LOGW("MQTT", "Remote command '%s' %s", cmd, ok ? "executed" : "rejected");
+
+  char ack[64];
+  int n = snprintf(ack, sizeof(ack), "%s %s", ok ? "ok" : "err", cmd);
+  publishQos0(topicAck, (const uint8_t*)ack, (size_t)n);
+}
+
+/* ================= Receive ================= */
+
+static void onPuback(uint16_t id) {
+  for (InflightSlot& s : inflight) {
+    if (!s.used || s.id != id) continue;
+    uint32_t rtt = micros() - s.sentUs;
+    s.used = false;
+    stats.acked++;
+
+    stats.rttAvgUs = stats.rttAvgUs ? (stats.rttAvgUs * 7 + rtt) / 8 : rtt;
+    if (rtt > stats.rttMaxUs)                       stats.rttMaxUs = rtt;
+    if (stats.rttMinUs == 0 || rtt < stats.rttMinUs) stats.rttMinUs = rtt;
+    rttSumUs += rtt;
+    rttSamples++;
+    return;
+  }
+}
+
+static void onPublish() {
+  if (rxLen < 2) return;
+  uint16_t topicLen = ((uint16_t)rxBuf[0] << 8) | rxBuf[1];
+  uint8_t  qos      = (rxHeader >> 1) & 0x03;
+  size_t   pos      = 2 + topicLen;
+  uint16_t id       = 0;
+  if (qos) {
+    if (pos + 2 > rxLen) return;
+    id   = ((uint16_t)rxBuf[pos] << 8) | rxBuf[pos + 1];
+    pos += 2;
+  }
+  if (pos > rxLen) return;
+
+  if (qos == 1) {
+    uint8_t ack[4] = { MQTT_PKT_PUBACK, 2, (uint8_t)(id >> 8), (uint8_t)id };
+    sendRaw(ack, sizeof(ack));
+  }
+
+  if (topicLen == strlen(topicCmd) &&
+      memcmp(&rxBuf[2], topicCmd, topicLen) == 0)
+    handleCommand(&rxBuf[pos], rxLen - pos);
+}
+
+static void dispatch() {
+  lastRxMs = millis();
+  switch (rxHeader & 0xF0) {
+    case MQTT_PKT_CONNACK:
+      if (state == MQTT_AWAIT_CONNACK && rxLen >= 2) onConnack(rxBuf[0], rxBuf[1]);
+      break;
+    case MQTT_PKT_PUBACK:
+      if (rxLen >= 2) onPuback(((uint16_t)rxBuf[0] << 8) | rxBuf[1]);
+      break;
+    case MQTT_PKT_SUBACK:
+      if (rxLen >= 3 && rxBuf[2] == 0x80) LOGE("MQTT", "Command subscription refused");
+      break;
+    case MQTT_PKT_PUBLISH:
+      onPublish();
+      break;
+    case MQTT_PKT_PINGRESP:
+    default:
+      break;
+  }
+}
+
+static void rxFeed(uint8_t b) {
+  switch (rxPhase) {
+    case RX_HEADER:
+      rxHeader = b;
+      rxLen    = 0;
+      rxMul    = 1;
+      rxPhase  = RX_LENGTH;
+      break;
+
+    case RX_LENGTH:
+      rxLen += (uint32_t)(b & 0x7F) * rxMul;
+      rxMul *= 128;
+      if (!(b & 0x80)) {
+        rxPos = 0;
+        if (rxLen == 0) { dispatch(); rxPhase = RX_HEADER; }
+        else            rxPhase = RX_BODY;
+      } else if (rxMul > 128UL * 128 * 128) {
+        dropConnection("malformed length");
+      }
+      break;
+
+    case RX_BODY:
+      if (rxPos < sizeof(rxBuf)) rxBuf[rxPos] = b;
+      if (++rxPos == rxLen) {
+        if (rxLen <= sizeof(rxBuf)) dispatch();
+        else LOGW("MQTT", "Dropped %lu-byte packet (rx buffer %u)",
+                  (unsigned long)rxLen, (unsigned)sizeof(rxBuf));
+        rxPhase = RX_HEADER;
+      }
+      break;
+  }
+}
+
+static void pumpRx() {
+  uint16_t budget = MQTT_RX_BUDGET;
+  while (budget-- && state != MQTT_DOWN && net.available() > 0) {
+    int b = net.read();
+    if (b < 0) break;
+    rxFeed((uint8_t)b);
+  }
+}
+
+/* ================= Public ================= */
+
+void mqttInit() {
+  snprintf(topicTelemetry, sizeof(topicTelemetry), "%s/%s/telemetry", MQTT_TOPIC_PREFIX, DEVICE_ID);
+  snprintf(topicStream,    sizeof(topicStream),    "%s/%s/stream",    MQTT_TOPIC_PREFIX, DEVICE_ID);
+  snprintf(topicStatus,    sizeof(topicStatus),    "%s/%s/status",    MQTT_TOPIC_PREFIX, DEVICE_ID);
+  snprintf(topicCmd,       sizeof(topicCmd),       "%s/%s/cmd",       MQTT_TOPIC_PREFIX, DEVICE_ID);
+  snprintf(topicAck,       sizeof(topicAck),       "%s/%s/cmd/ack",   MQTT_TOPIC_PREFIX, DEVICE_ID);
+
+#if MQTT_USE_TLS
+  if (MQTT_CA_CERT[0]) net.setCACert(MQTT_CA_CERT);
+  else                 net.setInsecure();
+  trusted = MQTT_CA_CERT[0] || MQTT_INSECURE_COMMANDS;
+#else
+  trusted = MQTT_INSECURE_COMMANDS;
+#endif
+  if (!trusted)
+    LOGE("MQTT", "%s – broker NOT verified, remote commands other than ping disabled",
+         MQTT_USE_TLS ? "No MQTT_CA_CERT" : "Plain TCP");
+  else if (!MQTT_USE_TLS || !MQTT_CA_CERT[0])
+    LOGE("MQTT", "MQTT_INSECURE_COMMANDS set – accepting commands from an unverified broker");
+  net.setTimeout(5000);
+
+  /* Force a first attempt as soon as WiFi is up */
+  lastAttemptMs = millis() - MQTT_BACKOFF_MIN_MS;
+  LOGI("MQTT", "Initialized (%s:%u, %s, window %u)",
+       MQTT_HOST, (unsigned)MQTT_PORT, MQTT_USE_TLS ? "TLS" : "plain",
+       (unsigned)MQTT_INFLIGHT_WINDOW);
+}
+
+void mqttLoop() {
+  unsigned long now = millis();
+
+  if (now - rateStartMs >= 1000) {
+    stats.pubPerSec = rateCount * 1000.0f / (float)(now - rateStartMs);
+    rateCount   = 0;
+    rateStartMs = now;
+  }
+
+  if (!wifiConnected()) {
+    if (state != MQTT_DOWN) dropConnection("WiFi lost");
+    return;
+  }
+
+  if (state == MQTT_DOWN) {
+    tryConnect();
+    return;
+  }
+
+  if (!net.connected()) {
+    dropConnection("socket closed");
+    return;
+  }
+
+  pumpRx();
+  if (state == MQTT_DOWN) return;
+
+  now = millis();
+  if (state == MQTT_AWAIT_CONNACK) {
+    if (now - connectMs > MQTT_CONNACK_TIMEOUT_MS) dropConnection("CONNACK timeout");
+    return;
+  }
+
+  /* A PUBACK this late means the session is dead */
+  for (const InflightSlot& s : inflight) {
+    if (s.used && now - s.sentMs > MQTT_ACK_TIMEOUT_MS) {
+      dropConnection("PUBACK timeout");
+      return;
+    }
+  }
+
+  if (now - lastRxMs > MQTT_KEEPALIVE_S * 1500UL) {
+    dropConnection("keep-alive timeout");
+    return;
+  }
+  if (now - lastTxMs > MQTT_KEEPALIVE_S * 500UL) {
+    uint8_t ping[2] = { MQTT_PKT_PINGREQ, 0 };
+    sendRaw(ping, sizeof(ping));
+  }
+}
+
+bool mqttConnected() { return state == MQTT_UP; }
+
+bool mqttPublishTelemetry(const TelemetrySnapshot& snap) {
+  if (state != MQTT_UP) return false;
+
+  char body[1024];
+  size_t len = formatTelemetryJson(snap, body, sizeof(body));
+  if (!len) return false;
+  return publishQos1(topicTelemetry, (const uint8_t*)body, len, false);
+}
+
+void mqttStreamUpdate(float packVoltage,
+                      const CurrentData& iData,
+                      float temperature,
+                      float soc,
+                      bool  fault) {
+  if (state != MQTT_UP) return;
+
+  unsigned long now = millis();
+  if (now - lastStreamMs < MQTT_STREAM_PERIOD_MS) return;
+  lastStreamMs = now;
+
+  TelemetryFrameV1 f;
+  telemetryBuildFrame(f, packVoltage, iData, temperature, soc, fault);
+  publishQos0(topicStream, (const uint8_t*)&f, sizeof(f));
+}
+
+void mqttBenchmark(uint16_t count) {
+  if (state != MQTT_UP) {
+    Serial.println("[MQTT] Not connected – benchmark skipped");
+    return;
+  }
+
+  char topic[56];
+  snprintf(topic, sizeof(topic), "%s/%s/bench", MQTT_TOPIC_PREFIX, DEVICE_ID);
+  uint8_t payload[64];
+  memset(payload, 'x', sizeof(payload));
+
+  /* Let earlier publishes settle so only burst PUBACKs are counted */
+  unsigned long deadline = millis() + 2000;
+  while (inflightCount() && state == MQTT_UP && (long)(millis() - deadline) < 0)
+    pumpRx();
+
+  /* QoS 1: pipelined up to the window, until every PUBACK is in */
+  rttSumUs   = 0;
+  rttSamples = 0;
+  uint32_t maxBefore = stats.rttMaxUs;
+  stats.rttMaxUs     = 0;
+
+  uint16_t sent = 0;
+  uint32_t t0   = micros();
+  deadline      = millis() + 10000;
+  while ((sent < count || inflightCount()) && state == MQTT_UP &&
+         (long)(millis() - deadline) < 0) {
+    if (sent < count && publishQos1(topic, payload, sizeof(payload), false)) sent++;
+    else pumpRx();
+  }
+  uint32_t us = micros() - t0;
+
+  Serial.printf("BENCH {\"name\":\"mqtt_qos1_burst\",\"msgs\":%u,\"acked\":%lu,"
+                "\"ms\":%.1f,\"msg_s\":%.1f,\"rtt_avg_us\":%lu,\"rtt_max_us\":%lu,"
+                "\"window\":%u,\"tls\":%s}\n",
+                sent, (unsigned long)rttSamples, us / 1000.0f,
+                rttSamples * 1e6f / (float)(us ? us : 1),
+                (unsigned long)(rttSamples ? rttSumUs / rttSamples : 0),
+                (unsigned long)stats.rttMaxUs, (unsigned)MQTT_INFLIGHT_WINDOW,
+                MQTT_USE_TLS ? "true" : "false");
+  if (maxBefore > stats.rttMaxUs) stats.rttMaxUs = maxBefore;
+
+  /* QoS 0: fire and forget, limited by the socket */
+  sent = 0;
+  t0   = micros();
+  for (uint16_t i = 0; i < count && state == MQTT_UP; i++)
+    if (publishQos0(topic, payload, sizeof(payload))) sent++;
+  us = micros() - t0;
+
+  Serial.printf("BENCH {\"name\":\"mqtt_qos0_burst\",\"msgs\":%u,\"ms\":%.1f,"
+                "\"msg_s\":%.1f,\"tls\":%s}\n",
+                sent, us / 1000.0f, sent * 1e6f / (float)(us ? us : 1),
+                MQTT_USE_TLS ? "true" : "false");
+}
+
+MqttStats mqttGetStats() {
+  stats.inflight = inflightCount();
+  return stats;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <Arduino.h>
+#include "current.h"
+#include "wifi_cloud.h"
+
+/*
+ * ============================================================
+ *  MQTT 3.1.1 Transport
+ *  One persistent (clean-session = 0) connection to the broker,
+ *  TLS or plain TCP.  Minimal client written for this firmware:
+ *  fixed buffers, no heap, never blocks the loop except for the
+ *  TCP/TLS connect itself.
+ *
+ *  Topics  (<p> = MQTT_TOPIC_PREFIX/DEVICE_ID)
+ *    <p>/telemetry   QoS 1  JSON row, same as the HTTP upload
+ *    <p>/stream      QoS 0  TelemetryFrameV1 (binary) at MQTT_STREAM_HZ
+ *    <p>/status      QoS 1  retained "online" / LWT "offline"
+ *    <p>/cmd         QoS 1  subscribed: "clear_faults", "reset_soc [pct]",
+ *                           "ping"
+ *    <p>/cmd/ack     QoS 0  "ok <cmd>" / "err <cmd>"
+ *
+ *  Only "ping" is honoured unless the broker is verified against
+ *  MQTT_CA_CERT (or MQTT_INSECURE_COMMANDS is set for a bench LAN).
+ *
+ *  QoS 1 publishes are pipelined: up to MQTT_INFLIGHT_WINDOW may be
+ *  awaiting PUBACK.  Unacked packets are kept and resent with DUP
+ *  after a reconnect; a PUBACK overdue by MQTT_ACK_TIMEOUT_MS drops
+ *  the connection.
+ *
+ *  Local test:  mosquitto -v  (MQTT_USE_TLS false, port 1883,
+ *                            MQTT_INSECURE_COMMANDS true)
+ *               mosquitto_sub -t 'bms/#' -v
+ *               mosquitto_pub -t bms/<id>/cmd -q 1 -m clear_faults
+ *  Console 'm' runs a publish-rate / PUBACK-latency burst.
+ * ============================================================
+ */
+
+struct MqttStats {
+  uint32_t connects;
+  uint32_t disconnects;
+  uint32_t published;       // all QoS
+  uint32_t acked;           // QoS 1 PUBACKs
+  uint32_t resent;          // DUP retransmissions
+  uint32_t windowFull;      // QoS 1 publishes refused (window full)
+  uint32_t commands;
+  uint8_t  inflight;
+  float    pubPerSec;       // over the last second
+  uint32_t rttAvgUs;        // PUBACK round trip, EWMA
+  uint32_t rttMinUs;
+  uint32_t rttMaxUs;
+};
+
+/** Call once after wifiInit(). */
+void mqttInit();
+
+/**
+ * Call every loop: connect / reconnect with backoff, read and
+ * dispatch incoming packets, keep-alive, ack timeouts.
+ */
+void mqttLoop();
+
+bool mqttConnected();
+
+/**
+ * Publish one telemetry row on <p>/telemetry at QoS 1.
+ * @return false if not connected or the in-flight window is full
+ */
+bool mqttPublishTelemetry(const TelemetrySnapshot& snap);
+
+/** Publish the binary state frame on <p>/stream (QoS 0), rate-limited. */
+void mqttStreamUpdate(float packVoltage,
+                      const CurrentData& iData,
+                      float temperature,
+                      float soc,
+                      bool  fault);
+
+/**
+ * Blocking burst: `count` QoS 1 publishes as fast as the window
+ * allows, then `count` QoS 0.  Prints one "BENCH {json}" line each.
+ */
+void mqttBenchmark(uint16_t count);
+
+MqttStats mqttGetStats();
@@ -1,4 +1,5 @@
 #include "nvs_logger.h"
+#include "logger.h"
 #include <Preferences.h>
 
 static Preferences prefs;
@@ -12,7 +13,7 @@ void storageInit() {
      same namespace via its own Preferences object. */
   prefs.begin("bms_nvs", false);
   prefs.end();
-  Serial.println("[NVS] Storage initialized");
+  LOGI("NVS", "Storage initialized");
 }
 
 /* ================= Fault Count ================= */
@@ -38,7 +39,7 @@ void incrementCycleCount() {
   unsigned long cycles = prefs.getULong("cycle_cnt", 0) + 1;
   prefs.putULong("cycle_cnt", cycles);
   prefs.end();
-  Serial.printf("[NVS] Cycle count = %lu\n", cycles);
+  LOGI("NVS", "Cycle count = %lu", cycles);
 }
 
 unsigned long getCycleCount() {
@@ -0,0 +1,353 @@
+#include "parking.h"
+#include "config.h"
+#include "logger.h"
+#include "system.h"
+#include "voltage.h"
+#include "current.h"
+#include "soc.h"
+#include "soh.h"
+#include "fault_manager.h"
+#include "wifi_manager.h"
+#include "telemetry_stream.h"   // crc16Ccitt
+#include "actuator.h"
+#include "temperature.h"
+#if ENABLE_IMPACT_DETECTION
+  #include "accelerometer.h"
+#endif
+#if ENABLE_GEOLOCATION
+  #include "gps.h"
+#endif
+#if ENABLE_SNAPSHOT
+  #include "snapshot.h"
+#endif
+#if ENABLE_TSDB
+  #include "tsdb.h"
+#endif
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <sys/time.h>
+
+#define PARK_MAGIC      0x4B524150UL   // "PARK"
+#define PARK_V_MARGIN   0.10f          // V band edge for the quick check
+
+#define RELAY_BIT_CHARGE  0x01
+#define RELAY_BIT_MOTOR   0x02
+#define RELAY_BIT_FAN     0x04
+
+static const uint8_t relayPins[] = {
+  CHARGE_RELAY_PIN, LOAD_MOTOR_RELAY_PIN, COOLING_FAN_RELAY_PIN, PRECHARGE_RELAY_PIN
+};
+
+/* ================= RTC Slow Memory ================= */
+
+/* Zeroed on power-on reset, kept through deep sleep.  The CRC
+   guards against a firmware update changing the layout.      */
+struct ParkRetention {
+  uint32_t magic;
+  float    remainingAh;
+  float    soh;
+  uint32_t highTempS;
+  uint32_t faultBitmap;
+  uint32_t faultCount;
+  uint8_t  faultSeverity;
+  uint8_t  relays;           // RELAY_BIT_*
+  uint16_t crc;
+};
+
+static RTC_DATA_ATTR ParkRetention rtcState;
+static RTC_DATA_ATTR ParkModeStats rtcStats[PARK_MODES];
+static RTC_DATA_ATTR bool          inEpisode    = false;   // parked, between wakes
+static RTC_DATA_ATTR int64_t       sleepStartUs = 0;
+static RTC_DATA_ATTR int64_t       wakeUs       = 0;
+static RTC_DATA_ATTR uint8_t       tempWakes    = 0;       // timer wakes since the last T read
+
+/* ================= RAM State ================= */
+
+static bool          resumed      = false;   // this boot continues a deep-sleep park
+static bool          lightParked  = false;
+static bool          requested    = false;
+static bool          restorePending = false; // light: wake → next loop pass
+static unsigned long idleSinceMs  = 0;
+
+static int64_t nowUs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static uint16_t retentionCrc() {
+  return crc16Ccitt((const uint8_t*)&rtcState, offsetof(ParkRetention, crc));
+}
+
+static bool retentionValid() {
+  return rtcState.magic == PARK_MAGIC && rtcState.crc == retentionCrc();
+}
+
+/* ================= Accounting ================= */
+
+static void noteSleep(ParkModeStats& m) {
+  if (inEpisode) m.awakeMs += (uint64_t)((nowUs() - wakeUs) / 1000);
+  m.sleeps++;
+  inEpisode = true;
+}
+
+static void noteWakeCurrent(ParkModeStats& m, float current) {
+  m.wakeCurrentSumA += fabsf(current);
+  m.wakeSamples++;
+}
+
+/* ================= Wake Sources ================= */
+
+static void armWakeSources() {
+  esp_sleep_enable_timer_wakeup((uint64_t)PARK_WAKE_INTERVAL_S * 1000000ULL);
+#if ENABLE_IMPACT_DETECTION
+  accelArmMotionWake(PARK_MOTION_G);
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)ACCEL_INT_PIN, 1);
+#endif
+}
+
+static void disarmWakeSources() {
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+#if ENABLE_IMPACT_DETECTION
+  accelDisarmMotionWake();
+#endif
+}
+
+/* ================= Deep Sleep ================= */
+
+[[noreturn]] static void deepSleep() {
+  ParkModeStats& m = rtcStats[PARK_MODE_DEEP];
+  noteSleep(m);
+  /* Nothing supervises the pack between wakes: charge, motor and
+     pre-charge open while asleep (rtcState.relays keeps what to
+     restore), fan as it was – then latch every output pad. */
+  actuatorPark();
+  for (uint8_t p : relayPins) gpio_hold_en((gpio_num_t)p);
+  gpio_deep_sleep_hold_en();
+  logFlush();
+  sleepStartUs = nowUs();
+  esp_deep_sleep_start();
+}
+
+static void enterDeep() {
+  FaultData f = getFaultData();
+  rtcState.magic         = PARK_MAGIC;
+  rtcState.remainingAh   = getRemainingAh();
+  rtcState.soh           = getSOH();
+  rtcState.highTempS     = getHighTempSeconds();
+  rtcState.faultBitmap   = getFaultBitmap();
+  rtcState.faultCount    = f.faultCount;
+  rtcState.faultSeverity = f.severity;
+  rtcState.relays        = (actuatorState(ACT_CHARGE) ? RELAY_BIT_CHARGE : 0) |
+                           (actuatorState(ACT_MOTOR)  ? RELAY_BIT_MOTOR  : 0) |
+                           (actuatorState(ACT_FAN)    ? RELAY_BIT_FAN    : 0);
+  rtcState.crc           = retentionCrc();
+  tempWakes              = 0;
+
+  /* Flash copies in case the supply is cut while asleep */
+#if ENABLE_SNAPSHOT
+  snapshotSave(SNAP_EXPLICIT);
+#endif
+#if ENABLE_TSDB
+  tsdbFlush();
+#endif
+
+  LOGI("PARK", "Deep sleep – SOC %.1f%%, faults 0x%04lX, wake every %us",
+       getSOC(), (unsigned long)rtcState.faultBitmap, PARK_WAKE_INTERVAL_S);
+  wifiSuspend();
+  armWakeSources();
+  deepSleep();
+}
+
+/* Timer wake: has anything changed that the loop has to act on?
+   A fault already latched for the same condition is not a change. */
+static bool quickCheckQuiet(float v, float i) {
+  bool uvNow = v <= MIN_VOLTAGE + PARK_V_MARGIN;
+  bool ovNow = v >= MAX_VOLTAGE - PARK_V_MARGIN;
+  bool uvLatched = rtcState.faultBitmap & (1UL << FAULT_UNDER_VOLTAGE);
+  bool ovLatched = rtcState.faultBitmap & (1UL << FAULT_OVER_VOLTAGE);
+
+  if (fabsf(i) >= PARK_IDLE_CURRENT_A) return false;
+  if (uvNow != uvLatched || ovNow != ovLatched) return false;
+  if (!(rtcState.relays & RELAY_BIT_CHARGE) && v <= CHARGE_START_V) return false;
+  return true;
+}
+
+/* Every PARK_TEMP_EVERY_WAKES timer wakes: is the pack warm enough
+   for the thermal loop to act (fan, derate, trip)?            */
+static bool quickCheckCool() {
+  if (++tempWakes < PARK_TEMP_EVERY_WAKES) return true;
+  tempWakes = 0;
+  initTemperature();
+  float t = readPackTemperature();
+  return t < FAN_ON_TEMP;
+}
+
+/* ================= Light Sleep ================= */
+
+static void enterLight() {
+  LOGI("PARK", "Light sleep – wake every %us", PARK_WAKE_INTERVAL_S);
+  logFlush();
+  wifiSuspend();
+  armWakeSources();
+  lightParked = true;
+}
+
+static void exitLight(const char* why) {
+  disarmWakeSources();
+  wifiResume();
+  lightParked = false;
+  inEpisode   = false;
+  LOGI("PARK", "Unparked (%s)", why);
+}
+
+static void lightSleep() {
+  ParkModeStats& m = rtcStats[PARK_MODE_LIGHT];
+  noteSleep(m);
+  logFlush();
+
+  int64_t t0 = nowUs();
+  esp_light_sleep_start();
+  wakeUs     = nowUs();
+  m.asleepMs += (uint64_t)((wakeUs - t0) / 1000);
+  restorePending = true;
+
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0) {
+    m.motionWakes++;
+    exitLight("motion");
+  } else {
+    m.timerWakes++;
+  }
+}
+
+/* ================= Idle Detection ================= */
+
+static bool vehicleIdle(float current) {
+  if (fabsf(current) >= PARK_IDLE_CURRENT_A) return false;
+#if ENABLE_GEOLOCATION
+  GPSData gps = getGPSData();
+  if (gps.valid && gps.speed >= PARK_MAX_SPEED_KMH) return false;
+#endif
+  return true;
+}
+
+/* ================= API ================= */
+
+bool parkingBoot() {
+  resumed = false;
+  if (esp_reset_reason() != ESP_RST_DEEPSLEEP || !inEpisode || !retentionValid()) {
+    inEpisode = false;
+    return false;
+  }
+  resumed = true;
+
+  /* Past the timer interval is ROM/bootloader time, counted awake */
+  ParkModeStats& m = rtcStats[PARK_MODE_DEEP];
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  int64_t slept = nowUs() - sleepStartUs;
+  int64_t timer = (int64_t)PARK_WAKE_INTERVAL_S * 1000000LL;
+  if (cause == ESP_SLEEP_WAKEUP_TIMER && slept > timer) slept = timer;
+  m.asleepMs += (uint64_t)(slept / 1000);
+  wakeUs      = sleepStartUs + slept;
+
+  if (cause != ESP_SLEEP_WAKEUP_TIMER) {
+    m.motionWakes++;
+    inEpisode = false;
+    LOGI("PARK", "Motion wake – resuming");
+    return true;
+  }
+
+  m.timerWakes++;
+  initVoltage();
+  initCurrent();
+  float v = readPackVoltage();
+  float i = readCurrent();
+  noteWakeCurrent(m, i);
+
+  if (quickCheckQuiet(v, i) && quickCheckCool()) {
+#if ENABLE_IMPACT_DETECTION
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)ACCEL_INT_PIN, 1);   // accel still armed
+#endif
+    esp_sleep_enable_timer_wakeup((uint64_t)PARK_WAKE_INTERVAL_S * 1000000ULL);
+    deepSleep();
+  }
+
+  inEpisode = false;
+  LOGI("PARK", "Timer wake: %.2fV %.2fA – resuming", v, i);
+  return true;
+}
+
+bool parkingRestore() {
+  if (!resumed) return false;
+
+  restoreSOC(rtcState.remainingAh);
+  restoreSOH(rtcState.soh, rtcState.highTempS);
+  restoreFaultState(rtcState.faultBitmap, rtcState.faultCount, rtcState.faultSeverity);
+  restoreRelayState(rtcState.relays & RELAY_BIT_CHARGE, rtcState.relays & RELAY_BIT_FAN,
+                    rtcState.relays & RELAY_BIT_MOTOR);
+  LOGI("PARK", "Restored from RTC: SOC %.1f%% SOH %.1f%%", getSOC(), rtcState.soh);
+  return true;
+}
+
+void parkingBootDone() {
+  if (!resumed) return;
+
+  /* Drive the latches to the restored state (motor and charge open
+     until the loop's first protection pass votes them closed), then
+     let go of the pads */
+  actuatorResync();
+  for (uint8_t p : relayPins) gpio_hold_dis((gpio_num_t)p);
+  gpio_deep_sleep_hold_dis();
+
+  rtcStats[PARK_MODE_DEEP].lastRestoreMs = millis();
+  LOGI("PARK", "Protecting %lu ms after wake", millis());
+}
+
+void parkingUpdate(float current) {
+  unsigned long now = millis();
+  ParkModeStats& m  = rtcStats[PARK_MODE];
+
+  if (restorePending) {
+    restorePending  = false;
+    m.lastRestoreMs = (uint32_t)((nowUs() - wakeUs) / 1000);
+  }
+
+  bool idle = vehicleIdle(current);
+
+  if (lightParked) {
+    noteWakeCurrent(m, current);
+    if (!idle) { exitLight("load"); idleSinceMs = now; return; }
+    lightSleep();
+    return;
+  }
+
+  if (!idle) { idleSinceMs = now; requested = false; return; }
+  if (!requested && now - idleSinceMs < PARK_IDLE_MS) return;
+  requested = false;
+
+  if (PARK_MODE == PARK_MODE_DEEP) enterDeep();   // does not return
+  enterLight();
+  lightSleep();
+}
+
+void parkingRequest() { requested = true; }
+
+ParkStats parkingGetStats() {
+  ParkStats s;
+  s.parked   = lightParked;
+  s.restored = resumed;
+  s.idleMs   = millis() - idleSinceMs;
+  memcpy(s.mode, rtcStats, sizeof(s.mode));
+  return s;
+}
+
+float parkingQuiescentMa(uint8_t mode) {
+  if (mode >= PARK_MODES) return 0.0f;
+  const ParkModeStats& m = rtcStats[mode];
+  uint64_t total = m.asleepMs + m.awakeMs;
+  if (total == 0) return 0.0f;
+
+  float sleepMa = mode == PARK_MODE_DEEP ? PARK_SLEEP_MA_DEEP : PARK_SLEEP_MA_LIGHT;
+  float wakeMa  = m.wakeSamples ? m.wakeCurrentSumA / m.wakeSamples * 1000.0f : 0.0f;
+  return ((float)m.asleepMs * sleepMa + (float)m.awakeMs * wakeMa) / (float)total;
+}
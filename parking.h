@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Parking Mode
+ *  After PARK_IDLE_MS with no pack current (charge or discharge)
+ *  and no GPS speed the BMS stops running the 10 Hz loop and sleeps:
+ *
+ *    PARK_MODE_LIGHT – radio off, esp_light_sleep between checks;
+ *                      RAM and the loop state survive, each wake
+ *                      runs one full loop pass.
+ *    PARK_MODE_DEEP  – esp_deep_sleep; SOC, SOH, the fault bitmap
+ *                      and counters live in RTC slow memory (not
+ *                      NVS).  Charge, motor and pre-charge relays
+ *                      are opened and the fan output held.  A timer wake does
+ *                      a V / I check (and T every
+ *                      PARK_TEMP_EVERY_WAKES) straight from setup()
+ *                      and goes back to sleep; anything out of
+ *                      range continues a full boot, and the relays
+ *                      close again after its first protection pass.
+ *
+ *  Wake sources: timer (PARK_WAKE_INTERVAL_S) for the periodic
+ *  check, MPU6050 wake-on-motion on ACCEL_INT_PIN (ext0).  Motion,
+ *  pack current or a voltage near a limit ends parking.
+ *
+ *  Per-mode statistics (console 'Z'): wakes, time asleep/awake,
+ *  pack current measured at each wake, and wake → protecting
+ *  latency.  Average quiescent current is the duty-cycle blend of
+ *  the measured awake draw and PARK_SLEEP_MA_* for the sleep phase.
+ * ============================================================
+ */
+
+#define PARK_MODES  3                // index by PARK_MODE_* (0 unused)
+
+struct ParkModeStats {
+  uint32_t sleeps;
+  uint32_t timerWakes;
+  uint32_t motionWakes;
+  uint64_t asleepMs;
+  uint64_t awakeMs;          // wake → next sleep
+  float    wakeCurrentSumA;  // |pack current| at each wake
+  uint32_t wakeSamples;
+  uint32_t lastRestoreMs;    // wake → protection running again
+};
+
+struct ParkStats {
+  bool          parked;      // light-sleep parking in progress
+  bool          restored;    // this boot came out of deep-sleep parking
+  uint32_t      idleMs;      // current idle streak
+  ParkModeStats mode[PARK_MODES];
+};
+
+/**
+ * First thing in setup(): on a deep-sleep timer wake, check the
+ * pack and sleep again if it is still parked (does not return).
+ * @return true if this boot resumes from parking (RTC state valid)
+ */
+bool parkingBoot();
+
+/**
+ * After initSOC / initSOH / snapshotInit: apply the RTC-held SOC,
+ * SOH, faults and relay state.
+ * @return true if resumed from parking (skip the boot alert)
+ */
+bool parkingRestore();
+
+/** End of setup(): release held relay outputs, log restore latency. */
+void parkingBootDone();
+
+/** Call at the end of every loop; may sleep. */
+void parkingUpdate(float current);
+
+/** Park on the next loop regardless of the idle timer (console). */
+void parkingRequest();
+
+ParkStats parkingGetStats();
+
+/** Duty-cycle weighted average draw of a mode, mA (0 if never used). */
+float parkingQuiescentMa(uint8_t mode);
@@ -0,0 +1,507 @@
+/* ═══════════════════════════════════════════════════════════════════════════
+   PLANT SIMULATOR – closed-loop bench model of the pack, charger and motor
+   ─────────────────────────────────────────────────────────────────────────
+   MODEL
+   ─────────────────────────────────────────────────────────────────────────
+   Pack     : NUM_CELLS series cells, each OCV(SOC) + R0 + one R1‖C1 pair,
+              with per-cell capacity / resistance / SOC spread.
+   Thermal  : single lumped mass, I²R + RC heating, convection to ambient
+              through R_th (lower when the fan relay is ON and fan healthy).
+   Charger  : CC/CV source, only connected through the charge relay.
+   Motor    : controller DC-link capacitor (SIM_BUS_CAP_UF) with a bleed
+              resistor, fed through the main motor relay or the pre-charge
+              relay + PRECHARGE_RESISTOR_OHM; the scenario drive current is
+              drawn from the bus only with the main relay closed.
+
+   TIME
+   ─────────────────────────────────────────────────────────────────────────
+   Slow states (SOC, RC voltages, temperature) run PLANT_SIM_TIME_SCALE
+   times faster than wall time so long drive / charge cycles finish on the
+   bench.  The bus is solved exactly per step in wall time because the
+   firmware's pre-charge, inrush and over-current timers are wall-time
+   based; the reported current is the step average (charge conserved).
+
+   HARNESS
+   ─────────────────────────────────────────────────────────────────────────
+   Relay GPIO levels are sampled on every step.  Each edge is counted;
+   edges that revert within PLANT_SIM_CHATTER_MS count as chatter.  When
+   the plant crosses a protection limit with the responsible relay closed,
+   the wall time until that relay opens is recorded as the response time.
+   As the main motor relay closes, the inrush it causes ((pack − bus) / R)
+   and the pre-charge time before it are recorded.
+   ═══════════════════════════════════════════════════════════════════════════ */
+
+#include "plant_sim.h"
+#include "config.h"
+#include <math.h>
+
+#if ENABLE_PLANT_SIM
+
+/* ═══════════════════════════════════════════
+   MODEL PARAMETERS
+   ═══════════════════════════════════════════ */
+
+#define SIM_CELL_R0_OHM        0.004f    // ohmic resistance per cell
+#define SIM_CELL_R1_OHM        0.002f    // polarisation resistance per cell
+#define SIM_CELL_TAU_S        30.0f      // R1‖C1 time constant
+
+#define SIM_THERMAL_MASS_J_K 1500.0f     // pack heat capacity
+#define SIM_RTH_NATURAL_K_W     1.5f     // fan off / failed
+#define SIM_RTH_FAN_K_W         0.4f     // fan running
+
+#define SIM_CHARGER_CC_A       10.0f
+#ifndef SIM_CHARGER_CV_V
+#define SIM_CHARGER_CV_V       CHARGE_CV_V   // set to what the BMS expects
+#endif
+
+#define SIM_BUS_CAP_UF       2200.0f     // controller DC-link
+#define SIM_BUS_BLEED_OHM    5000.0f     // bleed resistor across the link
+#define SIM_MAIN_R_OHM          0.05f    // main relay contacts + wiring + cap ESR
+
+#define SIM_MAX_SUBSTEP_S       1.0f     // integration step (plant seconds)
+
+/* Harness */
+#define PLANT_SIM_CHATTER_MS         2000UL   // edge reverted faster than this = chatter
+#define PLANT_SIM_RESPONSE_LIMIT_MS  5000UL   // violation still open after this = unanswered
+#define PLANT_SIM_REPORT_MS         30000UL   // periodic report cadence (wall)
+
+/* Per-cell manufacturing spread */
+static const float CELL_CAP_SCALE[] = { 1.00f, 0.97f, 1.02f, 0.99f };
+static const float CELL_R0_SCALE[]  = { 1.00f, 1.15f, 0.95f, 1.05f };
+static const float CELL_SOC_OFFS[]  = { 0.0f, -1.5f,  1.0f, -0.5f };
+
+/* OCV curve – same knee points as soc.cpp's voltage→SOC table */
+static const float OCV_SOC[] = {  0.0f,  5.0f, 15.0f, 30.0f, 50.0f, 65.0f, 80.0f, 90.0f, 97.0f, 100.0f };
+static const float OCV_V[]   = { 3.00f, 3.20f, 3.40f, 3.60f, 3.70f, 3.80f, 3.90f, 4.00f, 4.10f, 4.15f };
+#define OCV_POINTS 10
+
+/* ═══════════════════════════════════════════
+   SCENARIOS
+   ═══════════════════════════════════════════ */
+
+struct PlantSimScenario {
+  const char*          name;
+  float                initialSoc;
+  float                ambientC;
+  const PlantSimEvent* events;
+  uint8_t              eventCount;
+};
+
+/* 0 – drive cycle with an over-current excursion at the end */
+static const PlantSimEvent DRIVE_CYCLE[] = {
+  {   0, SIM_SET_DRIVE_CURRENT,  5.0f },
+  {  60, SIM_SET_DRIVE_CURRENT, 25.0f },
+  { 120, SIM_SET_DRIVE_CURRENT, 45.0f },
+  { 180, SIM_SET_DRIVE_CURRENT, 10.0f },
+  { 240, SIM_SET_DRIVE_CURRENT,  0.0f },
+  { 300, SIM_SET_DRIVE_CURRENT, 55.0f },
+  { 330, SIM_SET_DRIVE_CURRENT, 70.0f },   // over-current
+  { 390, SIM_SET_DRIVE_CURRENT,  5.0f },
+  { 600, SIM_END,                0.0f },
+};
+
+/* 1 – charger plugged into a low pack, CC → CV */
+static const PlantSimEvent CHARGER_CONNECT[] = {
+  {     0, SIM_SET_DRIVE_CURRENT, 0.0f },
+  {    30, SIM_CHARGER_CONNECT,   0.0f },
+  { 21600, SIM_CHARGER_DISCONNECT, 0.0f },   // 50 Ah at 10 A CC: ~4.5 h + taper
+  { 21660, SIM_END,               0.0f },
+};
+
+/* 2 – fan dies under sustained load on a hot day */
+static const PlantSimEvent FAN_FAILURE[] = {
+  {    0, SIM_SET_AMBIENT,       35.0f },
+  {    0, SIM_SET_DRIVE_CURRENT, 40.0f },
+  {   60, SIM_FAN_FAIL,           0.0f },
+  { 5400, SIM_SET_DRIVE_CURRENT,  0.0f },
+  { 5400, SIM_FAN_RESTORE,        0.0f },
+  { 7200, SIM_END,                0.0f },
+};
+
+/* 3 – controller bus leaks (20 Ω): pre-charge never converges and must fail */
+static const PlantSimEvent PRECHARGE_FAULT[] = {
+  {   0, SIM_BUS_LEAK,          20.0f },
+  {   0, SIM_SET_DRIVE_CURRENT,  5.0f },
+  { 120, SIM_END,                0.0f },
+};
+
+#define SCENARIO(name, soc, amb, ev) { name, soc, amb, ev, sizeof(ev) / sizeof(ev[0]) }
+
+static const PlantSimScenario SCENARIOS[] = {
+  SCENARIO("drive cycle",     80.0f, 25.0f, DRIVE_CYCLE),
+  SCENARIO("charger connect", 15.0f, 25.0f, CHARGER_CONNECT),
+  SCENARIO("fan failure",     90.0f, 35.0f, FAN_FAILURE),
+  SCENARIO("precharge fault", 70.0f, 25.0f, PRECHARGE_FAULT),
+};
+
+#define SCENARIO_COUNT (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+/* ═══════════════════════════════════════════
+   STATE
+   ═══════════════════════════════════════════ */
+
+struct SimCell {
+  float capAh;
+  float r0;
+  float soc;    // %
+  float vRC;    // polarisation voltage (V, + under discharge)
+};
+
+static bool                    initialized   = false;
+static const PlantSimScenario* scenario      = nullptr;
+static uint8_t                 nextEvent     = 0;
+static bool                    finished      = false;
+
+static SimCell       cells[NUM_CELLS];
+static float         plantTimeS     = 0.0f;
+static float         tempC          = 25.0f;
+static float         ambientC       = 25.0f;
+static float         driveA         = 0.0f;
+static float         packCurrent    = 0.0f;
+static float         packVoltage    = 0.0f;
+static bool          chargerPlugged = false;
+static bool          fanFailed      = false;
+static float         busV           = 0.0f;    // DC-link voltage
+static float         busLeakOhm     = 0.0f;    // scenario fault, 0 = none
+static unsigned long lastStepMs     = 0;
+static unsigned long lastReportMs   = 0;
+
+/* Harness */
+static const uint8_t RELAY_PINS[SIM_RELAY_COUNT] = {
+  CHARGE_RELAY_PIN, LOAD_MOTOR_RELAY_PIN, COOLING_FAN_RELAY_PIN, PRECHARGE_RELAY_PIN
+};
+static const char* RELAY_NAMES[SIM_RELAY_COUNT] = { "CHG", "MOTOR", "FAN", "PRE" };
+
+static bool          relayState[SIM_RELAY_COUNT];
+static unsigned long relayEdgeMs[SIM_RELAY_COUNT];
+
+enum { RELAY_CHG = 0, RELAY_MOTOR = 1, RELAY_FAN = 2, RELAY_PRE = 3 };
+
+struct Violation {
+  const char*   name;
+  uint8_t       relayMask;    // relays that must open in response
+  unsigned long onsetMs;      // 0 = not active
+  bool          reportedLate;
+};
+
+enum { V_OVER_TEMP = 0, V_OVER_VOLT, V_UNDER_VOLT, V_OC_DISCHARGE, V_OC_CHARGE, V_COUNT };
+
+static Violation violations[V_COUNT] = {
+  { "OVER TEMP",     (1 << RELAY_CHG) | (1 << RELAY_MOTOR), 0, false },
+  { "OVER VOLTAGE",  (1 << RELAY_CHG),                      0, false },
+  { "UNDER VOLTAGE", (1 << RELAY_MOTOR),                    0, false },
+  { "OC DISCHARGE",  (1 << RELAY_MOTOR),                    0, false },
+  { "OC CHARGE",     (1 << RELAY_CHG),                      0, false },
+};
+
+static PlantSimMetrics metrics;
+
+/* ═══════════════════════════════════════════
+   HELPERS
+   ═══════════════════════════════════════════ */
+
+static float clampf(float v, float lo, float hi) {
+  return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+static float ocvFromSoc(float soc) {
+  if (soc <= OCV_SOC[0])              return OCV_V[0];
+  if (soc >= OCV_SOC[OCV_POINTS - 1]) return OCV_V[OCV_POINTS - 1];
+
+  for (int i = 0; i < OCV_POINTS - 1; i++) {
+    if (soc < OCV_SOC[i + 1]) {
+      float t = (soc - OCV_SOC[i]) / (OCV_SOC[i + 1] - OCV_SOC[i]);
+      return OCV_V[i] + t * (OCV_V[i + 1] - OCV_V[i]);
+    }
+  }
+  return OCV_V[OCV_POINTS - 1];
+}
+
+static float terminalVoltage(float current) {
+  float v = 0.0f;
+  for (int c = 0; c < NUM_CELLS; c++)
+    v += ocvFromSoc(cells[c].soc) - cells[c].vRC - current * cells[c].r0;
+  return v;
+}
+
+static float packR0() {
+  float r = 0.0f;
+  for (int c = 0; c < NUM_CELLS; c++) r += cells[c].r0;
+  return r;
+}
+
+/* ═══════════════════════════════════════════
+   SCENARIO PLAYBACK
+   ═══════════════════════════════════════════ */
+
+static void applyEvent(const PlantSimEvent& e) {
+  switch (e.action) {
+    case SIM_SET_DRIVE_CURRENT:  driveA         = e.value; break;
+    case SIM_CHARGER_CONNECT:    chargerPlugged = true;    break;
+    case SIM_CHARGER_DISCONNECT: chargerPlugged = false;   break;
+    case SIM_FAN_FAIL:           fanFailed      = true;    break;
+    case SIM_FAN_RESTORE:        fanFailed      = false;   break;
+    case SIM_SET_AMBIENT:        ambientC       = e.value; break;
+    case SIM_BUS_LEAK:           busLeakOhm     = e.value; break;
+    case SIM_END:
+      finished = true;
+      Serial.printf("[SIM] Scenario '%s' finished\n", scenario->name);
+      plantSimReport();
+      break;
+  }
+  Serial.printf("[SIM] t=%lus action=%u value=%.1f\n",
+                (unsigned long)e.atSec, (unsigned)e.action, e.value);
+}
+
+static void runScenario() {
+  while (!finished && nextEvent < scenario->eventCount &&
+         scenario->events[nextEvent].atSec <= (uint32_t)plantTimeS) {
+    applyEvent(scenario->events[nextEvent]);
+    nextEvent++;
+  }
+}
+
+/* ═══════════════════════════════════════════
+   PLANT INTEGRATION
+   ═══════════════════════════════════════════ */
+
+/* Pack → (main relay | pre-charge relay + resistor) → DC-link ‖ bleed ‖ leak,
+   drive current drawn from the link with the main relay closed:
+     C·dVbus/dt = (Vp − Vbus)/R − Vbus·G − Idrive
+   linear in Vbus → exact exponential over the step.
+   @return pack current averaged over dtS (instantaneous for dtS = 0) */
+static float busStep(float dtS) {
+  float c    = SIM_BUS_CAP_UF * 1e-6f;
+  float g    = 1.0f / SIM_BUS_BLEED_OHM + (busLeakOhm > 0.0f ? 1.0f / busLeakOhm : 0.0f);
+  bool  main = relayState[RELAY_MOTOR];
+
+  if (!main && !relayState[RELAY_PRE]) {     // isolated: bleeds down
+    busV *= expf(-g / c * dtS);
+    return 0.0f;
+  }
+
+  float r     = packR0() + (main ? SIM_MAIN_R_OHM : PRECHARGE_RESISTOR_OHM);
+  float vOpen = terminalVoltage(0.0f);
+  float iLoad = main ? driveA : 0.0f;
+  float b     = (1.0f / r + g) / c;
+  float vInf  = (vOpen / r - iLoad) / c / b;
+
+  if (dtS <= 0.0f) return (vOpen - busV) / r;
+
+  float e    = expf(-b * dtS);
+  float vAvg = vInf + (busV - vInf) * (1.0f - e) / (b * dtS);
+  busV       = vInf + (busV - vInf) * e;
+  return (vOpen - vAvg) / r;
+}
+
+static float chargerCurrent() {
+  if (!chargerPlugged || !relayState[RELAY_CHG]) return 0.0f;
+
+  /* CV limit: current that puts the terminal exactly at SIM_CHARGER_CV_V */
+  float vOpen = terminalVoltage(0.0f);
+  float rSum  = 0.0f;
+  for (int c = 0; c < NUM_CELLS; c++) rSum += cells[c].r0;
+
+  float iCV = (SIM_CHARGER_CV_V - vOpen) / rSum;
+  return clampf(iCV, 0.0f, SIM_CHARGER_CC_A);
+}
+
+static void integrate(float dtS, float load) {
+  float current = load - chargerCurrent();   // + = discharge
+  float r1C1    = SIM_CELL_TAU_S;
+  float heatW   = 0.0f;
+
+  for (int c = 0; c < NUM_CELLS; c++) {
+    SimCell& cell = cells[c];
+    cell.soc -= current * dtS / 3600.0f / cell.capAh * 100.0f;
+    cell.soc  = clampf(cell.soc, 0.0f, 100.0f);
+    cell.vRC += dtS * (current * SIM_CELL_R1_OHM - cell.vRC) / r1C1;
+
+    heatW += current * current * cell.r0 +
+             cell.vRC * cell.vRC / SIM_CELL_R1_OHM;
+  }
+
+  bool  fanCooling = relayState[RELAY_FAN] && !fanFailed;
+  float rth        = fanCooling ? SIM_RTH_FAN_K_W : SIM_RTH_NATURAL_K_W;
+  tempC += dtS * (heatW - (tempC - ambientC) / rth) / SIM_THERMAL_MASS_J_K;
+}
+
+/* ═══════════════════════════════════════════
+   HARNESS
+   ═══════════════════════════════════════════ */
+
+static void sampleRelays(unsigned long now) {
+  for (int r = 0; r < SIM_RELAY_COUNT; r++) {
+    bool s = digitalRead(RELAY_PINS[r]) == HIGH;
+    if (s == relayState[r]) continue;
+
+    /* The pre-charge relay is meant to be closed for a fraction of a second */
+    metrics.relaySwitches[r]++;
+    if (r != RELAY_PRE && now - relayEdgeMs[r] < PLANT_SIM_CHATTER_MS)
+      metrics.relayChatter[r]++;
+
+    if (r == RELAY_MOTOR && s) {
+      float vOpen = terminalVoltage(0.0f);
+      metrics.lastCloseInrushA = (vOpen - busV) / (packR0() + SIM_MAIN_R_OHM);
+      metrics.lastCloseBusPct  = vOpen > 0.0f ? busV / vOpen * 100.0f : 0.0f;
+      metrics.lastPrechargeMs  = relayState[RELAY_PRE] ? now - relayEdgeMs[RELAY_PRE] : 0;
+      if (metrics.lastCloseInrushA > metrics.worstCloseInrushA)
+        metrics.worstCloseInrushA = metrics.lastCloseInrushA;
+      Serial.printf("[SIM] Main relay closed: bus %.0f%% inrush %.1fA pre-charge %lums\n",
+                    metrics.lastCloseBusPct, metrics.lastCloseInrushA,
+                    (unsigned long)metrics.lastPrechargeMs);
+    }
+
+    relayEdgeMs[r] = now;
+    relayState[r]  = s;
+  }
+}
+
+static bool relaysOpen(uint8_t mask) {
+  for (int r = 0; r < SIM_RELAY_COUNT; r++)
+    if ((mask & (1 << r)) && relayState[r]) return false;
+  return true;
+}
+
+static void trackViolation(Violation& v, bool present, unsigned long now) {
+  if (v.onsetMs == 0) {
+    /* Only a violation if the responsible relay is still closed */
+    if (present && !relaysOpen(v.relayMask)) {
+      v.onsetMs      = now;
+      v.reportedLate = false;
+    }
+    return;
+  }
+
+  if (relaysOpen(v.relayMask)) {
+    uint32_t resp = now - v.onsetMs;
+    metrics.protectionEvents++;
+    metrics.lastResponseMs = resp;
+    if (resp > metrics.worstResponseMs) metrics.worstResponseMs = resp;
+    Serial.printf("[SIM] %s answered in %lu ms\n", v.name, (unsigned long)resp);
+    v.onsetMs = 0;
+    return;
+  }
+
+  if (!present) { v.onsetMs = 0; return; }   // went away on its own
+
+  if (!v.reportedLate && now - v.onsetMs > PLANT_SIM_RESPONSE_LIMIT_MS) {
+    v.reportedLate = true;
+    metrics.unansweredViolations++;
+    Serial.printf("[SIM] %s NOT answered after %lu ms\n",
+                  v.name, PLANT_SIM_RESPONSE_LIMIT_MS);
+  }
+}
+
+static void checkProtection(unsigned long now) {
+  trackViolation(violations[V_OVER_TEMP],    tempC       >= MAX_CELL_TEMP,          now);
+  trackViolation(violations[V_OVER_VOLT],    packVoltage >= MAX_VOLTAGE,            now);
+  trackViolation(violations[V_UNDER_VOLT],   packVoltage <= MIN_VOLTAGE,            now);
+  trackViolation(violations[V_OC_DISCHARGE], packCurrent >  MAX_DISCHARGE_CURRENT,  now);
+  trackViolation(violations[V_OC_CHARGE],   -packCurrent >  MAX_CHARGE_CURRENT,     now);
+}
+
+/* ═══════════════════════════════════════════
+   PUBLIC
+   ═══════════════════════════════════════════ */
+
+void plantSimInit() {
+  uint8_t idx = (PLANT_SIM_SCENARIO < SCENARIO_COUNT) ? PLANT_SIM_SCENARIO : 0;
+  scenario    = &SCENARIOS[idx];
+  nextEvent   = 0;
+  finished    = false;
+
+  for (int c = 0; c < NUM_CELLS; c++) {
+    cells[c].capAh = CELL_CAPACITY_AH * CELL_CAP_SCALE[c % 4];
+    cells[c].r0    = SIM_CELL_R0_OHM  * CELL_R0_SCALE[c % 4];
+    cells[c].soc   = clampf(scenario->initialSoc + CELL_SOC_OFFS[c % 4], 0.0f, 100.0f);
+    cells[c].vRC   = 0.0f;
+  }
+
+  ambientC       = scenario->ambientC;
+  tempC          = ambientC;
+  driveA         = 0.0f;
+  chargerPlugged = false;
+  fanFailed      = false;
+  busV           = 0.0f;
+  busLeakOhm     = 0.0f;
+  plantTimeS     = 0.0f;
+  packCurrent    = 0.0f;
+  packVoltage    = terminalVoltage(0.0f);
+
+  memset(&metrics, 0, sizeof(metrics));
+  unsigned long now = millis();
+  for (int r = 0; r < SIM_RELAY_COUNT; r++) {
+    relayState[r]  = digitalRead(RELAY_PINS[r]) == HIGH;
+    relayEdgeMs[r] = now;
+  }
+  for (auto& v : violations) v.onsetMs = 0;
+
+  lastStepMs   = now;
+  lastReportMs = now;
+  initialized  = true;
+
+  Serial.printf("[SIM] PLANT SIMULATION ACTIVE – scenario '%s' x%.0f time\n",
+                scenario->name, PLANT_SIM_TIME_SCALE);
+  runScenario();
+}
+
+void plantSimStep() {
+  if (!initialized) plantSimInit();
+
+  unsigned long now = millis();
+  sampleRelays(now);
+
+  float dtWall = (float)(now - lastStepMs) / 1000.0f;
+  float dtS    = dtWall * PLANT_SIM_TIME_SCALE;
+  lastStepMs   = now;
+
+  float load = busStep(dtWall);
+  while (dtS > 0.0f) {
+    float h = fminf(dtS, SIM_MAX_SUBSTEP_S);
+    integrate(h, load);
+    plantTimeS += h;
+    dtS        -= h;
+  }
+  packCurrent = load - chargerCurrent();
+
+  packVoltage          = terminalVoltage(packCurrent);
+  metrics.plantTimeSec = (uint32_t)plantTimeS;
+
+  runScenario();
+  checkProtection(now);
+
+  if (!finished && now - lastReportMs >= PLANT_SIM_REPORT_MS) {
+    lastReportMs = now;
+    plantSimReport();
+  }
+}
+
+float plantSimPackVoltage() { plantSimStep(); return packVoltage; }
+float plantSimCurrent()     { plantSimStep(); return packCurrent; }
+float plantSimPower()       { return fabsf(packVoltage * packCurrent); }
+float plantSimTemperature() { plantSimStep(); return tempC; }
+
+PlantSimMetrics plantSimGetMetrics() { return metrics; }
+
+void plantSimReport() {
+  Serial.printf("===== PLANT SIM  '%s'  t=%lus =====\n",
+                scenario ? scenario->name : "-", (unsigned long)metrics.plantTimeSec);
+  Serial.printf("Plant    : V=%.2f I=%.2f T=%.1fC SOC[0]=%.1f%%\n",
+                packVoltage, packCurrent, tempC, cells[0].soc);
+  for (int r = 0; r < SIM_RELAY_COUNT; r++)
+    Serial.printf("Relay %-5s: switches=%lu chatter=%lu\n", RELAY_NAMES[r],
+                  (unsigned long)metrics.relaySwitches[r],
+                  (unsigned long)metrics.relayChatter[r]);
+  Serial.printf("Protect  : answered=%lu last=%lums worst=%lums unanswered=%lu\n",
+                (unsigned long)metrics.protectionEvents,
+                (unsigned long)metrics.lastResponseMs,
+                (unsigned long)metrics.worstResponseMs,
+                (unsigned long)metrics.unansweredViolations);
+  Serial.printf("Motor bus: close inrush last=%.1fA worst=%.1fA bus=%.0f%% pre-charge=%lums\n",
+                metrics.lastCloseInrushA, metrics.worstCloseInrushA,
+                metrics.lastCloseBusPct, (unsigned long)metrics.lastPrechargeMs);
+  Serial.println("==============================\n");
+}
+
+#endif  // ENABLE_PLANT_SIM
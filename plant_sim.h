@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Closed-loop Battery Plant Simulator
+ *  Replaces the V/I/T sensors with an equivalent-circuit pack
+ *  model that reacts to the relay GPIOs the firmware drives.
+ *  Compiled in only when ENABLE_PLANT_SIM is true – bench use only.
+ * ============================================================
+ */
+
+/* ──────────────────────────────────────────────────────────
+   SCENARIO ACTIONS
+   ────────────────────────────────────────────────────────── */
+
+typedef enum : uint8_t {
+  SIM_SET_DRIVE_CURRENT = 0,   // steady motor current demand (A)
+  SIM_CHARGER_CONNECT,         // plug in CC/CV charger
+  SIM_CHARGER_DISCONNECT,      // unplug charger
+  SIM_FAN_FAIL,                // fan stops cooling even if relay is ON
+  SIM_FAN_RESTORE,             // fan works again
+  SIM_SET_AMBIENT,             // ambient temperature (°C)
+  SIM_BUS_LEAK,                // leak across the motor bus (Ω, 0 = none)
+  SIM_END                      // scenario finished – print report
+} PlantSimAction;
+
+struct PlantSimEvent {
+  uint32_t       atSec;        // plant time (s) at which the action fires
+  PlantSimAction action;
+  float          value;
+};
+
+/* ──────────────────────────────────────────────────────────
+   HARNESS METRICS
+   ────────────────────────────────────────────────────────── */
+
+#define SIM_RELAY_COUNT  4     // charge, motor, fan, pre-charge
+
+struct PlantSimMetrics {
+  uint32_t plantTimeSec;                     // simulated time elapsed
+  uint32_t relaySwitches[SIM_RELAY_COUNT];   // every GPIO edge seen
+  uint32_t relayChatter[SIM_RELAY_COUNT];    // edges reverted within PLANT_SIM_CHATTER_MS
+  uint32_t protectionEvents;                 // limit violations that got a response
+  uint32_t lastResponseMs;                   // violation onset → relay open (wall ms)
+  uint32_t worstResponseMs;
+  uint32_t unansweredViolations;             // still open after PLANT_SIM_RESPONSE_LIMIT_MS
+  float    lastCloseInrushA;                 // bus inrush as the main motor relay closed
+  float    worstCloseInrushA;
+  float    lastCloseBusPct;                  // bus / pack at that moment
+  uint32_t lastPrechargeMs;                  // pre-charge relay → main relay (wall ms), 0 = none
+};
+
+/* ──────────────────────────────────────────────────────────
+   API
+   ────────────────────────────────────────────────────────── */
+
+/** Reset plant state and load the scenario selected by PLANT_SIM_SCENARIO. */
+void plantSimInit();
+
+/**
+ * Advance the plant to the current wall time (scaled by
+ * PLANT_SIM_TIME_SCALE) and sample the relay GPIOs.
+ * Safe to call any number of times per loop; the sensor getters call it.
+ */
+void plantSimStep();
+
+/* Simulated sensor outputs – same units and sign convention as the real drivers */
+float plantSimPackVoltage();   // terminal voltage (V)
+float plantSimCurrent();       // signed (+ = discharge, − = charge) (A)
+float plantSimPower();         // |V·I| (W)
+float plantSimTemperature();   // pack temperature (°C)
+
+PlantSimMetrics plantSimGetMetrics();
+
+/** Print protection response times and relay chatter counts to Serial. */
+void plantSimReport();
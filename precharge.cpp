@@ -0,0 +1,176 @@
+#include "precharge.h"
+#include "config.h"
+#include "logger.h"
+#include "actuator.h"
+#include "fault_manager.h"
+#include <math.h>
+
+/* ================= State ================= */
+
+static PrechargeState state    = PRE_IDLE;
+static uint32_t       startMs  = 0;
+static uint32_t       mainMs   = 0;
+static float          lastBusV = -1.0f;     // < 0: no read yet this sequence
+static uint8_t        okReads  = 0;
+static uint8_t        lowReads = 0;
+static float          baseA    = 0.0f;      // pack current just before the relay closed
+static float          idleA    = NAN;       // previous pass's current while waiting to close
+static uint32_t       waitMs   = 0;         // motor wanted since (0 = not waiting)
+static PrechargeStats stats    = {};
+
+/* ================= Helpers ================= */
+
+static void setRelay(bool on) {
+  actuatorRequest(ACT_PRECHARGE, ACT_SRC_CONTROL, on ? ACT_ON : ACT_OFF);
+}
+
+static void fail(const char* why, float busPct);
+
+/* The pre-charge relay closes at the end of this pass, so this pass's
+   current is everything else on the pack (fan, controller, charger)
+   and only the change from it flows through the resistor.  That holds
+   while the other loads are steady: wait for two passes that agree,
+   and fail after PRECHARGE_BASE_WAIT_MS without them.            */
+static void begin(float current, uint32_t now) {
+  if (!waitMs) waitMs = now ? now : 1;
+  bool steady = !isnan(idleA) && fabsf(current - idleA) <= PRECHARGE_BASE_STEADY_A;
+  idleA = current;
+  if (!steady) {
+    if (now - waitMs < PRECHARGE_BASE_WAIT_MS) return;
+    stats.refused++;
+    startMs = waitMs;
+    waitMs  = 0;
+    idleA   = NAN;
+    fail("pack current not steady before close", 0.0f);
+    return;
+  }
+  waitMs = 0;
+  idleA  = NAN;
+  setRelay(true);
+  state          = PRE_CHARGING;
+  startMs        = now;
+  lastBusV       = -1.0f;
+  okReads        = 0;
+  lowReads       = 0;
+  baseA          = current;
+  stats.lastPeakA = 0.0f;
+  stats.sequences++;
+  LOGI("PRECHG", "Pre-charge relay closed (baseline %.2fA)", baseA);
+}
+
+static void abortSequence() {
+  setRelay(false);
+  state = PRE_IDLE;
+  stats.aborted++;
+  LOGI("PRECHG", "Aborted – motor no longer wanted");
+}
+
+static void fail(const char* why, float busPct) {
+  setRelay(false);
+  state = PRE_FAILED;
+  stats.failures++;
+  LOGE("PRECHG", "FAILED: %s (bus %.0f%% after %lu ms, peak %.2fA)",
+       why, busPct, (unsigned long)(millis() - startMs), stats.lastPeakA);
+  triggerExternalFault(FAULT_PRECHARGE_FAILURE, "PRECHARGE FAILED");
+}
+
+/* ================= Sequence ================= */
+
+static void charging(float packV, float current, uint32_t now) {
+  /* Bus behind the resistor: pack minus the drop the current makes across it */
+  current    -= baseA;
+  float vBus  = packV - current * PRECHARGE_RESISTOR_OHM;
+  float pct   = packV > 0.0f ? vBus / packV * 100.0f : 0.0f;
+  bool  still = lastBusV >= 0.0f && fabsf(vBus - lastBusV) < PRECHARGE_SETTLE_V;
+  lastBusV    = vBus;
+  if (current > stats.lastPeakA) stats.lastPeakA = current;
+
+  if (current > PRECHARGE_BYPASS_FACTOR * packV / PRECHARGE_RESISTOR_OHM) {
+    fail("current above V/R – resistor bypassed", pct);
+    return;
+  }
+
+  if (pct >= PRECHARGE_DONE_PCT || (still && pct >= PRECHARGE_MIN_PCT)) {
+    lowReads = 0;
+    if (++okReads >= PRECHARGE_SETTLE_READS) {
+      state            = PRE_READY;
+      stats.lastMs     = now - startMs;
+      stats.lastBusPct = pct;
+      if (stats.lastMs > stats.worstMs) stats.worstMs = stats.lastMs;
+      LOGI("PRECHG", "Bus at %.0f%% after %lu ms – closing main",
+           pct, (unsigned long)stats.lastMs);
+    }
+    return;
+  }
+  okReads = 0;
+
+  if (still) {
+    if (++lowReads >= PRECHARGE_SETTLE_READS) fail("bus stuck – leak or short", pct);
+    return;
+  }
+  lowReads = 0;
+
+  if (now - startMs >= PRECHARGE_TIMEOUT_MS) fail("timeout", pct);
+}
+
+void prechargeUpdate(float packVoltage, float current) {
+  bool     want   = actuatorWanted(ACT_MOTOR);
+  bool     mainOn = actuatorState(ACT_MOTOR);
+  uint32_t now    = millis();
+
+  switch (state) {
+    case PRE_IDLE:
+      if (mainOn)    state = PRE_CLOSED;       // already closed, not by a sequence
+      else if (want) begin(current, now);
+      else           { waitMs = 0; idleA = NAN; }
+      break;
+
+    case PRE_CHARGING:
+      if (!want) abortSequence();
+      else       charging(packVoltage, current, now);
+      break;
+
+    case PRE_READY:
+      if (!want)   { abortSequence(); break; }
+      if (!mainOn) break;
+      state  = PRE_OVERLAP;
+      mainMs = actuatorChangedAt(ACT_MOTOR);   // closed at the end of the last pass
+      /* fall through */
+
+    case PRE_OVERLAP:
+      if (!mainOn || now - mainMs >= PRECHARGE_OVERLAP_MS) {
+        setRelay(false);
+        state = mainOn ? PRE_CLOSED : PRE_IDLE;
+        if (mainOn) stats.completed++;
+      }
+      break;
+
+    case PRE_CLOSED:
+      if (!mainOn) state = PRE_IDLE;
+      break;
+
+    case PRE_FAILED:
+      if (!isFaultActive(FAULT_PRECHARGE_FAILURE)) state = PRE_IDLE;   // cleared by hand
+      break;
+  }
+}
+
+bool prechargeReady() { return state == PRE_READY; }
+
+PrechargeStats prechargeGetStats() {
+  PrechargeStats s = stats;
+  s.state = state;
+  return s;
+}
+
+const char* prechargeStateName(PrechargeState s) {
+  switch (s) {
+    case PRE_IDLE:     return "IDLE";
+    case PRE_CHARGING: return "CHARGING";
+    case PRE_READY:    return "READY";
+    case PRE_OVERLAP:  return "OVERLAP";
+    case PRE_CLOSED:   return "CLOSED";
+    case PRE_FAILED:   return "FAILED";
+    default:           return "?";
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Motor Bus Pre-charge
+ *  The main motor relay never closes onto an empty controller
+ *  bus.  When the motor is wanted:
+ *
+ *    CHARGING  pre-charge relay closes; the DC-link charges
+ *              through PRECHARGE_RESISTOR_OHM
+ *    READY     bus converged – the actuator closes the main relay
+ *    OVERLAP   both closed for PRECHARGE_OVERLAP_MS
+ *    CLOSED    pre-charge relay open, motor on the main relay
+ *
+ *  The bus is not sensed: it is pack − I·R across the resistor,
+ *  I being the INA219 current less the baseline that flowed
+ *  just before the relay closed (fan, controller, charger).  The
+ *  relay closes once two passes agree on that baseline.
+ *  Converged means at PRECHARGE_DONE_PCT of the pack, or no
+ *  longer rising and above PRECHARGE_MIN_PCT (controller
+ *  quiescent draw).  Fault paths latch FAULT_PRECHARGE_FAILURE
+ *  and open the pre-charge relay:
+ *
+ *    unsteady       no steady baseline in PRECHARGE_BASE_WAIT_MS
+ *    timeout        not converged in PRECHARGE_TIMEOUT_MS
+ *    bus stuck      settled below PRECHARGE_MIN_PCT (leak / short)
+ *    bypassed       current above the resistor's V/R – main relay
+ *                   welded or resistor shorted
+ *
+ *  An open resistor or a dead pre-charge relay reads as an
+ *  instantly charged bus (no current) and is not detectable
+ *  without a bus voltage sense.
+ * ============================================================
+ */
+
+enum PrechargeState : uint8_t {
+  PRE_IDLE = 0,
+  PRE_CHARGING,
+  PRE_READY,
+  PRE_OVERLAP,
+  PRE_CLOSED,
+  PRE_FAILED
+};
+
+struct PrechargeStats {
+  PrechargeState state;
+  uint32_t sequences;        // pre-charge relay closes
+  uint32_t completed;        // reached CLOSED
+  uint32_t aborted;          // motor no longer wanted mid-sequence
+  uint32_t failures;
+  uint32_t refused;          // failed before closing: baseline never steady
+  uint32_t lastMs;           // close → converged
+  uint32_t worstMs;
+  float    lastBusPct;       // bus / pack when released to the main relay
+  float    lastPeakA;        // largest current through the resistor
+};
+
+/**
+ * Main loop, after the relay controllers and before actuatorApply():
+ * advance the sequence from this pass's pack voltage and current.
+ */
+void prechargeUpdate(float packVoltage, float current);
+
+/** Actuator: the main motor relay may close now. */
+bool prechargeReady();
+
+PrechargeStats prechargeGetStats();
+
+const char* prechargeStateName(PrechargeState s);
@@ -0,0 +1,115 @@
+#include "range.h"
+#include "config.h"
+#include "logger.h"
+#include "soc.h"
+#include "soh.h"
+#include <Preferences.h>
+#include <math.h>
+
+#define RANGE_BUCKET_M     100.0f
+#define RANGE_BUCKETS      10          // last km
+#define RANGE_MIN_KM       1.0f        // trip / lifetime horizon needs this much
+#define RANGE_SAVE_KM      1.0f
+#define RANGE_PACK_V       (NOMINAL_CELL_VOLTAGE * NUM_CELLS)
+
+/* Blend weights: last km, trip, lifetime */
+#define RANGE_W_LAST_KM    0.5f
+#define RANGE_W_TRIP       0.3f
+#define RANGE_W_LIFETIME   0.2f
+
+/* ================= State ================= */
+
+static Preferences prefs;
+
+static float   bucketWh[RANGE_BUCKETS];
+static uint8_t bucketIdx   = 0;
+static uint8_t bucketsUsed = 0;
+static float   curWh       = 0.0f;     // open bucket
+static float   curM        = 0.0f;
+
+static float   tripWh = 0.0f, tripM = 0.0f;
+static double  lifeWh = 0.0, lifeM = 0.0;   // lifetime: float would round the 100 m buckets
+static double  savedLifeM = 0.0;
+
+static void saveLifetime() {
+  prefs.begin("range", false);
+  prefs.putDouble("wh64", lifeWh);
+  prefs.putDouble("m64",  lifeM);
+  prefs.end();
+  savedLifeM = lifeM;
+}
+
+static void closeBucket() {
+  bucketWh[bucketIdx] = curWh;
+  bucketIdx = (bucketIdx + 1) % RANGE_BUCKETS;
+  if (bucketsUsed < RANGE_BUCKETS) bucketsUsed++;
+
+  tripWh += curWh;  tripM += curM;
+  lifeWh += curWh;  lifeM += curM;
+  curWh = 0.0f;
+  curM  = 0.0f;
+
+  if (lifeM - savedLifeM >= RANGE_SAVE_KM * 1000.0f) saveLifetime();
+}
+
+/* ================= API ================= */
+
+void rangeInit() {
+  prefs.begin("range", true);
+  /* Totals saved as float by earlier firmware are carried over */
+  lifeWh = prefs.isKey("wh64") ? prefs.getDouble("wh64", 0.0) : prefs.getFloat("wh", 0.0f);
+  lifeM  = prefs.isKey("m64")  ? prefs.getDouble("m64",  0.0) : prefs.getFloat("m",  0.0f);
+  prefs.end();
+  savedLifeM = lifeM;
+  LOGI("RANGE", "Lifetime %.1f km, %.1f Wh/km", lifeM / 1000.0f,
+       lifeM > 0.0f ? lifeWh / (lifeM / 1000.0f) : 0.0f);
+}
+
+void rangeUpdate(float powerW, float speedKmh, unsigned long dtMs) {
+  /* Parked draw is not a driving cost */
+  if (speedKmh < RANGE_MIN_SPEED_KMH) return;
+
+  curWh += powerW * (float)dtMs * (1.0f / 3600000.0f);
+  curM  += speedKmh * (float)dtMs * (1.0f / 3600.0f);
+  if (curM >= RANGE_BUCKET_M) closeBucket();
+}
+
+RangeEstimate rangeGetEstimate() {
+  RangeEstimate e = {};
+
+  float lastWh = 0.0f;
+  for (uint8_t i = 0; i < bucketsUsed; i++) lastWh += bucketWh[i];
+  if (bucketsUsed == RANGE_BUCKETS)
+    e.whPerKmLastKm = lastWh / (RANGE_BUCKETS * RANGE_BUCKET_M / 1000.0f);
+
+  e.tripKm     = (tripM + curM) / 1000.0f;
+  e.lifetimeKm = (lifeM + curM) / 1000.0f;
+  if (tripM >= RANGE_MIN_KM * 1000.0f) e.whPerKmTrip     = tripWh / (tripM / 1000.0f);
+  if (lifeM >= RANGE_MIN_KM * 1000.0f) e.whPerKmLifetime = lifeWh / (lifeM / 1000.0f);
+
+  /* Blend whatever horizons have data; spread = best / worst of them */
+  const float h[3] = { e.whPerKmLastKm, e.whPerKmTrip, e.whPerKmLifetime };
+  const float w[3] = { RANGE_W_LAST_KM, RANGE_W_TRIP, RANGE_W_LIFETIME };
+  float sum = 0.0f, wsum = 0.0f, lo = INFINITY, hi = 0.0f;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (h[i] <= 0.0f) continue;
+    float v = fmaxf(h[i], RANGE_MIN_WH_PER_KM);   // downhill regen ≠ infinite range
+    sum  += w[i] * v;
+    wsum += w[i];
+    lo = fminf(lo, v);
+    hi = fmaxf(hi, v);
+  }
+  if (wsum > 0.0f) {
+    e.whPerKm = sum / wsum;
+  } else {
+    e.whPerKm = RANGE_DEFAULT_WH_PER_KM;
+    lo = RANGE_DEFAULT_WH_PER_KM * 0.7f;
+    hi = RANGE_DEFAULT_WH_PER_KM * 1.3f;
+  }
+
+  e.remainingWh = getRemainingAh() * (getSOH() / 100.0f) * RANGE_PACK_V;
+  e.rangeKm     = e.remainingWh / e.whPerKm;
+  e.rangeLoKm   = e.remainingWh * (1.0f - RANGE_ENERGY_UNCERT) / hi;
+  e.rangeHiKm   = e.remainingWh * (1.0f + RANGE_ENERGY_UNCERT) / lo;
+  return e;
+}
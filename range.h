@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Energy Efficiency & Range Estimator
+ *  Integrates pack power against GPS distance while moving and
+ *  keeps Wh/km over three horizons:
+ *    • last km   – ring of RANGE_BUCKETS × RANGE_BUCKET_M buckets
+ *    • trip      – since boot
+ *    • lifetime  – persisted in NVS
+ *  Usable energy = remaining Ah × SOH × nominal pack voltage.
+ *  The central range uses a recency-weighted blend of the
+ *  horizons; the bounds use the best / worst horizon and the
+ *  SOC uncertainty (RANGE_ENERGY_UNCERT).
+ *
+ *  rangeUpdate() is two multiply-adds per loop; buckets close
+ *  every RANGE_BUCKET_M of travel.
+ * ============================================================
+ */
+
+struct RangeEstimate {
+  float whPerKm;            // blended, used for rangeKm
+  float whPerKmLastKm;      // 0 = horizon not filled yet
+  float whPerKmTrip;
+  float whPerKmLifetime;
+  float remainingWh;        // usable energy left
+  float rangeKm;
+  float rangeLoKm;
+  float rangeHiKm;
+  float tripKm;
+  float lifetimeKm;
+};
+
+/** Load lifetime totals from NVS. */
+void rangeInit();
+
+/**
+ * Call every loop.
+ * @param powerW    pack power, + = discharge
+ * @param speedKmh  ground speed (0 without a fix)
+ */
+void rangeUpdate(float powerW, float speedKmh, unsigned long dtMs);
+
+RangeEstimate rangeGetEstimate();
@@ -0,0 +1,147 @@
+#include "rollup.h"
+#include "config.h"
+#include "logger.h"
+#if ENABLE_TSDB
+  #include "tsdb.h"
+#endif
+
+#define ROLLUP_LEVELS  3
+
+/* ================= State ================= */
+
+struct RollupLevel {
+  uint32_t      span;        // s
+  RollupBucket* ring;
+  uint16_t      size;
+  uint16_t      head;        // next slot
+  uint16_t      used;
+  RollupBucket  open;
+};
+
+static RollupBucket secRing[ROLLUP_SEC_BUCKETS];
+static RollupBucket minRing[ROLLUP_MIN_BUCKETS];
+static RollupBucket hourRing[ROLLUP_HOUR_BUCKETS];
+
+static RollupLevel levels[ROLLUP_LEVELS] = {
+  { 1,    secRing,  ROLLUP_SEC_BUCKETS,  0, 0, {} },
+  { 60,   minRing,  ROLLUP_MIN_BUCKETS,  0, 0, {} },
+  { 3600, hourRing, ROLLUP_HOUR_BUCKETS, 0, 0, {} },
+};
+
+/* ================= Bucket Helpers ================= */
+
+static void clearBucket(RollupBucket& b, uint32_t t, uint32_t span) {
+  b.t     = t;
+  b.span  = span;
+  b.count  = 0;
+  b.weight = 0.0;
+  for (uint8_t c = 0; c < ROLLUP_CHANNELS; c++) {
+    b.ch[c].min   = INFINITY;
+    b.ch[c].max   = -INFINITY;
+    b.ch[c].sum   = 0.0;
+    b.ch[c].sumSq = 0.0;
+  }
+}
+
+static void mergeBucket(RollupBucket& dst, const RollupBucket& src) {
+  dst.count  += src.count;
+  dst.weight += src.weight;
+  for (uint8_t c = 0; c < ROLLUP_CHANNELS; c++) {
+    dst.ch[c].min    = fminf(dst.ch[c].min, src.ch[c].min);
+    dst.ch[c].max    = fmaxf(dst.ch[c].max, src.ch[c].max);
+    dst.ch[c].sum   += src.ch[c].sum;
+    dst.ch[c].sumSq += src.ch[c].sumSq;
+  }
+}
+
+/* Close level k's open bucket if `t` is past it – pushing it to the
+   ring and folding it into level k+1 – then open the bucket for t. */
+static void rollTo(uint8_t k, uint32_t t) {
+  RollupLevel& L = levels[k];
+  uint32_t start = t - t % L.span;
+  if (L.open.count && L.open.t == start) return;
+
+  if (L.open.count) {
+    L.ring[L.head] = L.open;
+    L.head = (L.head + 1) % L.size;
+    if (L.used < L.size) L.used++;
+
+    if (k + 1 < ROLLUP_LEVELS) {
+      rollTo(k + 1, L.open.t);
+      mergeBucket(levels[k + 1].open, L.open);
+    }
+  }
+  clearBucket(L.open, start, L.span);
+}
+
+/* ================= API ================= */
+
+uint32_t rollupNow() {
+#if ENABLE_TSDB
+  return tsdbNow();
+#else
+  return millis() / 1000;
+#endif
+}
+
+void rollupInit() {
+  uint32_t now = rollupNow();
+  for (uint8_t k = 0; k < ROLLUP_LEVELS; k++) {
+    levels[k].head = 0;
+    levels[k].used = 0;
+    clearBucket(levels[k].open, now - now % levels[k].span, levels[k].span);
+  }
+  LOGI("ROLLUP", "Initialized – %u×1s %u×1min %u×1h buckets, %u B",
+       ROLLUP_SEC_BUCKETS, ROLLUP_MIN_BUCKETS, ROLLUP_HOUR_BUCKETS,
+       (unsigned)(sizeof(secRing) + sizeof(minRing) + sizeof(hourRing)));
+}
+
+void rollupUpdate(float packVoltage, float current, float temperature, float soc, float powerW,
+                  unsigned long dtMs) {
+  rollTo(0, rollupNow());
+
+  const float v[ROLLUP_CHANNELS] = { packVoltage, current, temperature, soc, powerW };
+  double w = dtMs * 0.001;
+  RollupBucket& b = levels[0].open;
+  b.count++;
+  b.weight += w;
+  for (uint8_t c = 0; c < ROLLUP_CHANNELS; c++) {
+    b.ch[c].min    = fminf(b.ch[c].min, v[c]);
+    b.ch[c].max    = fmaxf(b.ch[c].max, v[c]);
+    b.ch[c].sum   += v[c] * w;
+    b.ch[c].sumSq += (double)v[c] * v[c] * w;
+  }
+}
+
+/* Fold one source bucket into the output bins */
+static bool binBucket(const RollupBucket& b, uint32_t from, uint32_t to, uint32_t res,
+                      RollupBucket* out, uint16_t& n, uint16_t maxOut) {
+  if (b.count == 0 || b.t + b.span <= from || b.t > to) return true;
+
+  uint32_t bin = b.t - b.t % res;
+  if (n == 0 || out[n - 1].t != bin) {
+    if (n == maxOut) return false;
+    clearBucket(out[n++], bin, res);
+  }
+  mergeBucket(out[n - 1], b);
+  return true;
+}
+
+uint16_t rollupQuery(uint32_t from, uint32_t to, uint32_t resolutionS,
+                     RollupBucket* out, uint16_t maxOut) {
+  uint8_t k = 0;
+  while (k + 1 < ROLLUP_LEVELS && levels[k + 1].span <= resolutionS) k++;
+  const RollupLevel& L = levels[k];
+  uint32_t res = resolutionS > L.span ? resolutionS - resolutionS % L.span : L.span;
+
+  /* Ring oldest → newest, then the open buckets from coarse to fine:
+     each finer open bucket starts at or after the coarser one.      */
+  uint16_t n = 0;
+  for (uint16_t i = 0; i < L.used; i++) {
+    const RollupBucket& b = L.ring[(L.head + L.size - L.used + i) % L.size];
+    if (!binBucket(b, from, to, res, out, n, maxOut)) return n;
+  }
+  for (int8_t j = k; j >= 0; j--)
+    if (!binBucket(levels[j].open, from, to, res, out, n, maxOut)) return n;
+  return n;
+}
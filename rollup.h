@@ -0,0 +1,76 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Multi-resolution Rollups  (1 s / 1 min / 1 h)
+ *  Every loop sample is folded into the open 1 s bucket,
+ *  weighted by its loop dt (the loop decimates while idle); a
+ *  closed bucket is pushed to its level's ring and merged into
+ *  the next coarser open bucket.  Each bucket keeps count, min,
+ *  max, weighted sum and sum of squares per channel, so the
+ *  time-weighted mean and std-dev
+ *  of any span come from a handful of merges instead of a scan
+ *  of raw history.
+ *
+ *  Ring sizes are compile-time (ROLLUP_*_BUCKETS in config.h);
+ *  memory is fixed at ~144 B per bucket.
+ *
+ *  Bucket times are tsdbNow() seconds with ENABLE_TSDB (wall
+ *  clock once SNTP has run), seconds of uptime otherwise.
+ * ============================================================
+ */
+
+enum RollupChannel : uint8_t {
+  ROLLUP_VOLTAGE = 0,        // pack V
+  ROLLUP_CURRENT,            // A, + = discharge
+  ROLLUP_TEMP,               // °C
+  ROLLUP_SOC,                // %
+  ROLLUP_POWER,              // W
+  ROLLUP_CHANNELS
+};
+
+struct RollupStat {
+  float  min;
+  float  max;
+  double sum;                // Σ x·dt – double: 1 h of 100 ms samples
+  double sumSq;              //  Σ x²·dt  would swamp a float's mantissa
+};
+
+struct RollupBucket {
+  uint32_t   t;              // start, s
+  uint32_t   span;           // width, s
+  uint32_t   count;          // loop samples
+  double     weight;         // Σ dt, s
+  RollupStat ch[ROLLUP_CHANNELS];
+};
+
+inline float rollupMean(const RollupBucket& b, RollupChannel c) {
+  return b.weight > 0.0 ? (float)(b.ch[c].sum / b.weight) : 0.0f;
+}
+
+inline float rollupStdDev(const RollupBucket& b, RollupChannel c) {
+  if (b.count < 2 || b.weight <= 0.0) return 0.0f;
+  double m   = b.ch[c].sum / b.weight;
+  double var = b.ch[c].sumSq / b.weight - m * m;
+  return var > 0.0 ? (float)sqrt(var) : 0.0f;
+}
+
+void rollupInit();
+
+/** Call every loop; dtMs is the time this sample stands for. */
+void rollupUpdate(float packVoltage, float current, float temperature, float soc, float powerW,
+                  unsigned long dtMs);
+
+/**
+ * Buckets covering [from, to], oldest first, merged from the
+ * coarsest level whose span fits `resolutionS` (which is rounded
+ * down to a multiple of that span).  The newest bucket includes
+ * the still-open finer buckets, so it is current to the second.
+ * @return buckets written to `out`
+ */
+uint16_t rollupQuery(uint32_t from, uint32_t to, uint32_t resolutionS,
+                     RollupBucket* out, uint16_t maxOut);
+
+/** Current rollup timestamp (s). */
+uint32_t rollupNow();
@@ -2,6 +2,7 @@
 #include "soh.h"
 #include "nvs_logger.h"
 #include "config.h"
+#include "logger.h"
 
 /* ================= Private ================= */
 
@@ -35,7 +36,7 @@ void initRUL() {
   rulPercentage = soh;
 
   initialized  = true;
-  Serial.printf("[RUL] Initialized: %d cycles remaining\n", rulCycles);
+  LOGI("RUL", "Initialized: %d cycles remaining", rulCycles);
 }
 
 void updateRUL(float packVoltage, float temperature,
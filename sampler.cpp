@@ -0,0 +1,229 @@
+#include "sampler.h"
+#include "config.h"
+#include "logger.h"
+#include "current.h"
+#include "voltage.h"
+#include "bus_lock.h"
+#if ENABLE_INRUSH_CAPTURE
+  #include "inrush.h"
+#endif
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#define SAMPLER_TASK_STACK     3072
+#define SAMPLER_TASK_PRIORITY  2      // above loop() (1), same core: preempts it
+#define SAMPLER_TASK_CORE      1
+
+/* ================= State ================= */
+
+static TaskHandle_t samplerTask = nullptr;
+static TaskHandle_t loopTask    = nullptr;
+static portMUX_TYPE winLock     = portMUX_INITIALIZER_UNLOCKED;
+
+/* Window accumulators – shared with samplerTake(), under winLock */
+static double   accChargeAs   = 0.0;
+static double   accEnergyWs   = 0.0;
+static int64_t  accStartUs    = 0;
+static uint32_t accSamples    = 0;
+static float    accPeakA      = 0.0f;
+static float    lastI         = 0.0f;
+static float    lastV         = 0.0f;
+
+/* Sampler task only */
+static int64_t  prevUs        = 0;
+static float    refI          = 0.0f;    // dI/dt baseline
+static int64_t  refUs         = 0;
+static uint32_t lastActiveMs  = 0;
+static uint32_t burstSamples  = 0;
+static float    burstPeakA    = 0.0f;
+static uint32_t restSinceMs   = 0;       // burst capped: none until REST_MS (0 = not)
+static bool     holdBurst     = false;   // inrush capture running – never capped
+
+static volatile uint32_t   lastTriggerMs = 0;
+static volatile SampleRate rate          = SAMPLE_RATE_NORMAL;
+static uint32_t            rateSinceMs   = 0;
+
+static SamplerStats stats = {};
+
+static TickType_t periodTicks(SampleRate r) {
+  uint32_t hz = r == SAMPLE_RATE_BURST  ? SAMPLE_BURST_HZ :
+                r == SAMPLE_RATE_NORMAL ? SAMPLE_NORMAL_HZ : SAMPLE_IDLE_HZ;
+  TickType_t t = pdMS_TO_TICKS(1000 / hz);
+  return t ? t : 1;
+}
+
+/* ================= Rate Control ================= */
+
+static void setRate(SampleRate r, uint32_t nowMs) {
+  if (r == rate) return;
+  stats.timeInRateMs[rate] += nowMs - rateSinceMs;
+  rateSinceMs = nowMs;
+
+  if (rate == SAMPLE_RATE_BURST) {
+    stats.lastBurstPeakA   = burstPeakA;
+    stats.lastBurstSamples = burstSamples;
+    LOGD("SAMPLE", "Burst end: %lu samples, peak %.2fA",
+         (unsigned long)burstSamples, burstPeakA);
+  }
+  if (r == SAMPLE_RATE_BURST) {
+    stats.bursts++;
+    burstPeakA       = 0.0f;
+    burstSamples     = 0;
+  }
+  /* Leaving IDLE: the loop may be in a 1 s wait */
+  if (rate == SAMPLE_RATE_IDLE && loopTask) xTaskNotifyGive(loopTask);
+  rate = r;
+}
+
+static void updateRate(float i, int64_t nowUs) {
+  uint32_t nowMs = (uint32_t)(nowUs / 1000);
+
+  if (nowUs - refUs >= 1000000LL / SAMPLE_NORMAL_HZ) {
+    float didt = (i - refI) / ((nowUs - refUs) * 1e-6f);
+    if (fabsf(didt) > stats.maxDidt) stats.maxDidt = fabsf(didt);
+    if (refUs && fabsf(didt) >= SAMPLE_DIDT_A_PER_S) {
+      stats.triggers[SAMPLE_TRIG_DIDT]++;
+      lastTriggerMs = nowMs;
+    }
+    refI  = i;
+    refUs = nowUs;
+  }
+
+  if (fabsf(i) >= SAMPLE_IDLE_CURRENT_A) lastActiveMs = nowMs;
+
+  /* Duty cap: a trigger storm (noisy dI/dt, a vibrating accelerometer)
+     must not hold the task at 1 kHz on loop()'s core indefinitely */
+  if (rate == SAMPLE_RATE_BURST && !holdBurst && nowMs - rateSinceMs >= SAMPLE_BURST_MAX_MS) {
+    stats.burstCaps++;
+    restSinceMs = nowMs ? nowMs : 1;
+    LOGD("SAMPLE", "Burst capped after %lu ms", (unsigned long)SAMPLE_BURST_MAX_MS);
+  }
+  if (restSinceMs && nowMs - restSinceMs >= SAMPLE_BURST_REST_MS) restSinceMs = 0;
+
+  bool burst = lastTriggerMs && nowMs - lastTriggerMs < SAMPLE_BURST_MS &&
+               (!restSinceMs || holdBurst);
+
+  SampleRate r;
+  if (burst)                                                     r = SAMPLE_RATE_BURST;
+  else if (nowMs - lastActiveMs < SAMPLE_IDLE_AFTER_MS)          r = SAMPLE_RATE_NORMAL;
+  else                                                           r = SAMPLE_RATE_IDLE;
+  setRate(r, nowMs);
+}
+
+/* ================= Sampling ================= */
+
+static void sampleOnce() {
+  float   i   = readCurrent();
+  float   v   = readPackVoltageFast();
+  int64_t now = esp_timer_get_time();
+
+  portENTER_CRITICAL(&winLock);
+  if (prevUs) {
+    double dtS = (now - prevUs) * 1e-6;
+    accChargeAs += 0.5 * (i + lastI) * dtS;
+    accEnergyWs += 0.5 * (v * fabsf(i) + lastV * fabsf(lastI)) * dtS;
+  }
+  if (fabsf(i) > fabsf(accPeakA)) accPeakA = i;
+  accSamples++;
+  lastI = i;
+  lastV = v;
+  portEXIT_CRITICAL(&winLock);
+
+  prevUs = now;
+  stats.samples++;
+#if ENABLE_INRUSH_CAPTURE
+  /* Motor start being captured: hold the burst rate to the end of it */
+  holdBurst = inrushFeed(i, v, now);
+  if (holdBurst) lastTriggerMs = (uint32_t)(now / 1000);
+#endif
+  if (rate == SAMPLE_RATE_BURST) {
+    burstSamples++;
+    if (fabsf(i) > burstPeakA) burstPeakA = fabsf(i);
+  }
+  updateRate(i, now);
+}
+
+static void samplerTaskFn(void*) {
+  TickType_t due = xTaskGetTickCount();
+  for (;;) {
+    sampleOnce();
+
+    due += periodTicks(rate);
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(due - now) > 0) {
+      if (ulTaskNotifyTake(pdTRUE, due - now)) due = xTaskGetTickCount();   // trigger: sample now
+    } else if ((int32_t)(now - due) > 0) {
+      stats.overruns++;
+      due = now;                        // behind – don't try to catch up
+    }
+  }
+}
+
+/* ================= API ================= */
+
+void samplerInit() {
+  loopTask     = xTaskGetCurrentTaskHandle();
+  uint32_t now = millis();
+  lastActiveMs = now;
+  rateSinceMs  = now;
+  accStartUs   = esp_timer_get_time();
+  busLockInit();       // Wire / ADC shared with loop() from here on
+
+  xTaskCreatePinnedToCore(samplerTaskFn, "sampler", SAMPLER_TASK_STACK,
+                          nullptr, SAMPLER_TASK_PRIORITY, &samplerTask, SAMPLER_TASK_CORE);
+  LOGI("SAMPLE", "Started – %u / %u / %u Hz (burst / normal / idle)",
+       SAMPLE_BURST_HZ, SAMPLE_NORMAL_HZ, SAMPLE_IDLE_HZ);
+}
+
+SamplerWindow samplerTake() {
+  SamplerWindow w;
+  int64_t now = esp_timer_get_time();
+
+  portENTER_CRITICAL(&winLock);
+  int64_t span  = now - accStartUs;
+  w.current     = lastI;
+  w.voltage     = lastV;
+  w.samples     = accSamples;
+  w.peakCurrent = accSamples ? accPeakA : lastI;
+  /* No sample in this window (phase slip at the idle rate): hold the last */
+  w.avgCurrent  = span > 0 && accSamples ? (float)(accChargeAs / (span * 1e-6)) : lastI;
+  w.avgPowerW   = span > 0 && accSamples ? (float)(accEnergyWs / (span * 1e-6)) : lastV * fabsf(lastI);
+  accChargeAs   = 0.0;
+  accEnergyWs   = 0.0;
+  accSamples    = 0;
+  accPeakA      = 0.0f;
+  accStartUs    = now;
+  portEXIT_CRITICAL(&winLock);
+
+  w.spanUs = (uint32_t)span;
+  return w;
+}
+
+void samplerTrigger(SampleTrigger source) {
+  if (source < SAMPLE_TRIG_COUNT) stats.triggers[source]++;
+  lastTriggerMs = millis();
+  if (samplerTask) xTaskNotifyGive(samplerTask);
+}
+
+bool samplerIdle() { return rate == SAMPLE_RATE_IDLE; }
+
+void samplerWait(unsigned long ms) {
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+SamplerStats samplerGetStats() {
+  SamplerStats s = stats;
+  s.rate = rate;
+  s.timeInRateMs[rate] += millis() - rateSinceMs;
+  return s;
+}
+
+const char* sampleRateName(SampleRate r) {
+  switch (r) {
+    case SAMPLE_RATE_IDLE:   return "IDLE";
+    case SAMPLE_RATE_NORMAL: return "NORMAL";
+    case SAMPLE_RATE_BURST:  return "BURST";
+    default:                 return "?";
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Adaptive Multi-rate V / I Sampler
+ *  A task of its own reads the INA219 current and one ADC
+ *  conversion of pack voltage at a rate that follows the pack:
+ *
+ *    BURST   SAMPLE_BURST_HZ   for SAMPLE_BURST_MS after a trigger:
+ *                              relay edge, |dI/dt| above threshold,
+ *                              accelerometer event
+ *    NORMAL  SAMPLE_NORMAL_HZ  while current flows
+ *    IDLE    SAMPLE_IDLE_HZ    after SAMPLE_IDLE_AFTER_MS below
+ *                              SAMPLE_IDLE_CURRENT_A
+ *
+ *  Every sample is integrated (trapezoid, esp_timer µs) into
+ *  charge and energy, so the main loop gets exact As / Ws for
+ *  its window whatever the rate – the loop itself decimates to
+ *  LOOP_IDLE_INTERVAL_MS (BMS_Firmware.ino) while idle.
+ *
+ *  dI/dt is taken over at least one NORMAL period so it means
+ *  the same at every rate (INA219 noise over 1 ms would
+ *  otherwise keep a burst going forever).
+ *
+ *  Wire (INA219) and the pack ADC are shared with loop() – LCD,
+ *  MPU6050, readPackVoltage() – under bus_lock.h; a sample
+ *  waits out at most one loop-side access and counts as an
+ *  overrun if that made it late.
+ *
+ *  Loop latency: the task runs above loop() on its core.  One
+ *  sample is ≈0.25 ms (INA219 calibration write + current read
+ *  at 400 kHz, one conversion), so a burst takes ≈25 % of the
+ *  core and a loop pass stretches by about a third; NORMAL
+ *  costs ≈2.5 %.  A burst running SAMPLE_BURST_MAX_MS is cut to
+ *  NORMAL for SAMPLE_BURST_REST_MS, so bursts never take more
+ *  than half of any stretch of time – except an inrush capture,
+ *  which always runs to its end.
+ * ============================================================
+ */
+
+enum SampleRate : uint8_t {
+  SAMPLE_RATE_IDLE = 0,
+  SAMPLE_RATE_NORMAL,
+  SAMPLE_RATE_BURST,
+  SAMPLE_RATE_COUNT
+};
+
+enum SampleTrigger : uint8_t {
+  SAMPLE_TRIG_RELAY = 0,     // relay output changed
+  SAMPLE_TRIG_DIDT,          // current slew
+  SAMPLE_TRIG_ACCEL,         // free fall / impact / shock
+  SAMPLE_TRIG_MANUAL,        // console
+  SAMPLE_TRIG_COUNT
+};
+
+/** One main-loop window, returned by samplerTake(). */
+struct SamplerWindow {
+  float    current;          // newest sample, A (+ = discharge)
+  float    voltage;          // newest single conversion, V
+  float    avgCurrent;       // charge / time, A
+  float    avgPowerW;        // energy / time, W
+  float    peakCurrent;      // largest |I| in the window, signed
+  uint32_t samples;
+  uint32_t spanUs;
+};
+
+struct SamplerStats {
+  SampleRate rate;
+  uint32_t   samples;
+  uint32_t   overruns;       // sample later than its period
+  uint32_t   bursts;
+  uint32_t   burstCaps;      // bursts cut at SAMPLE_BURST_MAX_MS
+  uint32_t   triggers[SAMPLE_TRIG_COUNT];
+  uint64_t   timeInRateMs[SAMPLE_RATE_COUNT];
+  float      maxDidt;        // A/s, since boot
+  float      lastBurstPeakA; // |I| peak of the last finished burst
+  uint32_t   lastBurstSamples;
+};
+
+/** Start the sampler task.  Call at the end of setup(). */
+void samplerInit();
+
+/** Main loop: this window's integrals and newest sample; starts the next. */
+SamplerWindow samplerTake();
+
+/** Start (or extend) a burst now.  Task context only. */
+void samplerTrigger(SampleTrigger source);
+
+/** At the idle rate – the main loop decimates too. */
+bool samplerIdle();
+
+/** Main-loop wait; returns early when the sampler leaves IDLE. */
+void samplerWait(unsigned long ms);
+
+SamplerStats samplerGetStats();
+
+const char* sampleRateName(SampleRate r);
@@ -0,0 +1,272 @@
+#include "snapshot.h"
+#include "config.h"
+#include "logger.h"
+#include "soc.h"
+#include "soh.h"
+#include "telemetry_stream.h"   // crc16Ccitt
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#if SNAPSHOT_ON_BROWNOUT
+  #include <esp_private/brownout.h>
+  #include <esp_private/rtc_ctrl.h>
+  #include <hal/brownout_hal.h>
+  #include <soc/rtc_cntl_reg.h>
+#endif
+
+#define SNAP_SECTOR_SIZE    4096
+#define SNAP_RECORD_SIZE    32
+#define SNAP_SLOTS          (SNAP_SECTOR_SIZE / SNAP_RECORD_SIZE)
+#define SNAP_MAGIC          0x4E53     // "SN"
+#define SNAP_VERSION        1
+#define SNAP_PART_SUBTYPE   0x42       // partitions.csv: data, 0x42, "snapshot"
+#define SNAP_NVS_FALLBACK_MS  120000UL // no partition: old NVS cadence
+
+#define SNAP_TASK_STACK     2048
+#define SNAP_TASK_PRIORITY  (configMAX_PRIORITIES - 1)
+
+#ifndef CONFIG_ESP_BROWNOUT_DET_LVL
+  #define CONFIG_ESP_BROWNOUT_DET_LVL 0
+#endif
+
+/* ================= Record ================= */
+
+struct SnapRecord {
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  reason;           // SnapshotReason
+  uint32_t seq;
+  float    remainingAh;      // Coulomb counter – SOC follows from it
+  float    soc;              // informational
+  float    soh;
+  uint32_t highTempS;
+  uint32_t uptimeS;
+  uint16_t reserved;
+  uint16_t crc;              // over everything above
+};
+static_assert(sizeof(SnapRecord) == SNAP_RECORD_SIZE, "SnapRecord layout");
+
+static uint16_t recordCrc(const SnapRecord& r) {
+  return crc16Ccitt((const uint8_t*)&r, offsetof(SnapRecord, crc));
+}
+
+static bool recordBlank(const SnapRecord& r) {
+  const uint8_t* p = (const uint8_t*)&r;
+  for (size_t i = 0; i < sizeof(r); i++)
+    if (p[i] != 0xFF) return false;
+  return true;
+}
+
+static bool recordValid(const SnapRecord& r) {
+  return r.magic == SNAP_MAGIC && r.version == SNAP_VERSION && r.crc == recordCrc(r);
+}
+
+/* ================= State ================= */
+
+static const esp_partition_t* part = nullptr;
+
+static SemaphoreHandle_t writeLock    = nullptr;
+static TaskHandle_t      brownoutTask = nullptr;
+
+static uint8_t       activeSector = 0;
+static uint16_t      nextSlot     = 0;
+static int8_t        eraseSector  = -1;    // full sector waiting to be erased
+static unsigned long lastWriteMs  = 0;
+
+static SnapshotStats stats = {};
+
+static size_t slotOffset(uint8_t sector, uint16_t slot) {
+  return (size_t)sector * SNAP_SECTOR_SIZE + (size_t)slot * SNAP_RECORD_SIZE;
+}
+
+static bool eraseSectorNow(uint8_t sector) {
+  if (esp_partition_erase_range(part, (size_t)sector * SNAP_SECTOR_SIZE, SNAP_SECTOR_SIZE) != ESP_OK) {
+    stats.flashErrors++;
+    return false;
+  }
+  stats.erases++;
+  return true;
+}
+
+/* Caller holds writeLock.  The first record of a new sector is
+   written before the old one is erased, so a valid copy always
+   exists somewhere.                                            */
+static void writeRecord(SnapshotReason reason) {
+  if (nextSlot >= SNAP_SLOTS) {
+    eraseSector  = activeSector;
+    activeSector ^= 1;
+    nextSlot     = 0;
+  }
+
+  SnapRecord r;
+  r.magic       = SNAP_MAGIC;
+  r.version     = SNAP_VERSION;
+  r.reason      = reason;
+  r.seq         = stats.seq + 1;
+  r.remainingAh = getRemainingAh();
+  r.soc         = getSOC();
+  r.soh         = getSOH();
+  r.highTempS   = getHighTempSeconds();
+  r.uptimeS     = millis() / 1000;
+  r.reserved    = 0xFFFF;
+  r.crc         = recordCrc(r);
+
+  if (esp_partition_write(part, slotOffset(activeSector, nextSlot++), &r, sizeof(r)) != ESP_OK) {
+    stats.flashErrors++;
+    return;
+  }
+  stats.seq = r.seq;
+  stats.writes++;
+}
+
+/* ================= Brownout Hook ================= */
+
+#if SNAPSHOT_ON_BROWNOUT
+static void IRAM_ATTR onBrownout(void*) {
+  brownout_hal_intr_clear();
+  brownout_hal_intr_enable(false);          // one shot – the chip resets next
+
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(brownoutTask, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void brownoutTaskFn(void*) {
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  snapshotSave(SNAP_BROWNOUT);
+  ESP.restart();                             // what the default handler does
+}
+
+/* Replace the default brownout handler (immediate reset) with an
+   interrupt that gets one snapshot out first.                    */
+static void armBrownoutHook() {
+  xTaskCreatePinnedToCore(brownoutTaskFn, "snap_bod", SNAP_TASK_STACK,
+                          nullptr, SNAP_TASK_PRIORITY, &brownoutTask, 0);
+  esp_brownout_disable();
+
+  brownout_hal_config_t cfg = {};
+  cfg.threshold     = CONFIG_ESP_BROWNOUT_DET_LVL;
+  cfg.enabled       = true;
+  cfg.reset_enabled = false;
+  cfg.rf_power_down = true;                  // shed the radio's load first
+  brownout_hal_config(&cfg);
+
+  /* IRAM: the handler must run while flash cache is off (a write in progress) */
+  rtc_isr_register(onBrownout, nullptr, RTC_CNTL_BROWN_OUT_INT_ENA_M, RTC_INTR_FLAG_IRAM);
+  brownout_hal_intr_clear();
+  brownout_hal_intr_enable(true);
+}
+#endif
+
+/* ================= API ================= */
+
+void snapshotInit() {
+  writeLock = xSemaphoreCreateMutex();
+
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                  (esp_partition_subtype_t)SNAP_PART_SUBTYPE, "snapshot");
+  if (!part || part->size < 2 * SNAP_SECTOR_SIZE) {
+    LOGW("SNAPSHOT", "No 'snapshot' partition – SOC/SOH saved to NVS every %lus",
+         SNAP_NVS_FALLBACK_MS / 1000);
+    part = nullptr;
+    return;
+  }
+  stats.flashReady = true;
+
+  /* Newest valid record across both sectors */
+  SnapRecord newest;
+  bool     found     = false;
+  uint8_t  newSector = 0;
+  uint16_t newSlot   = 0;
+  bool     used[2]   = { false, false };
+  for (uint8_t s = 0; s < 2; s++) {
+    for (uint16_t i = 0; i < SNAP_SLOTS; i++) {
+      SnapRecord r;
+      if (esp_partition_read(part, slotOffset(s, i), &r, sizeof(r)) != ESP_OK) {
+        stats.flashErrors++;
+        continue;
+      }
+      if (recordBlank(r)) continue;
+      used[s] = true;
+      if (!recordValid(r)) { stats.badRecords++; continue; }
+      if (!found || r.seq > newest.seq) {
+        newest    = r;
+        newSector = s;
+        newSlot   = i;
+        found     = true;
+      }
+    }
+  }
+
+  if (found) {
+    /* Append after the newest record, past any torn write */
+    activeSector = newSector;
+    nextSlot     = newSlot + 1;
+    SnapRecord r;
+    while (nextSlot < SNAP_SLOTS &&
+           esp_partition_read(part, slotOffset(activeSector, nextSlot), &r, sizeof(r)) == ESP_OK &&
+           !recordBlank(r))
+      nextSlot++;
+    if (used[activeSector ^ 1]) eraseSectorNow(activeSector ^ 1);
+
+    restoreSOC(newest.remainingAh);
+    restoreSOH(newest.soh, newest.highTempS);
+    stats.restored       = true;
+    stats.seq            = newest.seq;
+    stats.lastBootReason = newest.reason;
+    LOGI("SNAPSHOT", "Restored #%lu (%s, up %lus): SOC %.1f%% SOH %.1f%%",
+         (unsigned long)newest.seq,
+         newest.reason == SNAP_BROWNOUT ? "brownout" :
+         newest.reason == SNAP_EXPLICIT ? "explicit" : "periodic",
+         (unsigned long)newest.uptimeS, getSOC(), newest.soh);
+  } else {
+    if (used[0]) eraseSectorNow(0);
+    if (used[1]) eraseSectorNow(1);
+    activeSector = 0;
+    nextSlot     = 0;
+    LOGI("SNAPSHOT", "No snapshot – keeping NVS values");
+  }
+  if (stats.badRecords)
+    LOGW("SNAPSHOT", "%lu torn/corrupt records skipped", (unsigned long)stats.badRecords);
+
+  lastWriteMs = millis();
+#if SNAPSHOT_ON_BROWNOUT
+  armBrownoutHook();
+#endif
+}
+
+void snapshotSave(SnapshotReason reason) {
+  if (!part || !writeLock) return;
+  if (xSemaphoreTake(writeLock, pdMS_TO_TICKS(100)) != pdTRUE) return;
+  writeRecord(reason);
+  xSemaphoreGive(writeLock);
+}
+
+void snapshotService() {
+  unsigned long now = millis();
+
+  if (!part) {
+    if (now - lastWriteMs >= SNAP_NVS_FALLBACK_MS) {
+      lastWriteMs = now;
+      saveSOC();
+      saveSOH();
+    }
+    return;
+  }
+
+  if (now - lastWriteMs >= SNAPSHOT_INTERVAL_MS) {
+    lastWriteMs = now;
+    snapshotSave(SNAP_PERIODIC);
+  }
+
+  /* ~45 ms sector erase, off the write path and outside the lock:
+     the full sector is no longer the one being appended to.      */
+  if (eraseSector >= 0) {
+    uint8_t s   = (uint8_t)eraseSector;
+    eraseSector = -1;
+    eraseSectorNow(s);
+  }
+}
+
+SnapshotStats snapshotGetStats() { return stats; }
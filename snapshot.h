@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  Power-loss-safe State Snapshot
+ *  SOC (as the Coulomb-counted Ah), SOH and the high-temperature
+ *  counter are saved together as one 32-byte, CRC-protected
+ *  record – never one without the other.
+ *
+ *  Records are appended to the "snapshot" flash partition
+ *  (partitions.csv), two 4 KB sectors used A/B: when one fills,
+ *  the next record goes to the other (pre-erased) sector, and
+ *  only then is the full one erased.  A write is a single
+ *  32-byte program into erased flash – no erase, no NVS
+ *  bookkeeping – so it fits in the supply's hold-up time.
+ *
+ *  Written every SNAPSHOT_INTERVAL_MS from the loop and, with
+ *  SNAPSHOT_ON_BROWNOUT, from a top-priority task woken by the
+ *  brownout detector interrupt (which then resets the chip, as
+ *  the default brownout handler would).
+ *
+ *  Boot: the newest valid record (highest sequence, good CRC)
+ *  overrides the values soc.cpp / soh.cpp loaded from NVS.
+ * ============================================================
+ */
+
+enum SnapshotReason : uint8_t {
+  SNAP_PERIODIC = 0,
+  SNAP_EXPLICIT,             // saveSOC() / saveSOH()
+  SNAP_BROWNOUT,
+};
+
+struct SnapshotStats {
+  bool     flashReady;
+  bool     restored;         // boot values came from a snapshot
+  uint32_t seq;              // newest record written / restored
+  uint32_t writes;
+  uint32_t erases;
+  uint32_t badRecords;       // torn / corrupt records skipped at boot
+  uint32_t flashErrors;
+  uint8_t  lastBootReason;   // SnapshotReason of the restored record
+};
+
+/**
+ * Find the partition, restore the newest record, arm the brownout
+ * hook.  Call after initSOC() / initSOH().
+ */
+void snapshotInit();
+
+/** Periodic write + deferred sector erase – call every loop. */
+void snapshotService();
+
+/** Write a record now (also used by saveSOC() / saveSOH()). */
+void snapshotSave(SnapshotReason reason);
+
+SnapshotStats snapshotGetStats();
@@ -1,7 +1,11 @@
 #include "soc.h"
 #include "config.h"
+#include "logger.h"
 #include <Preferences.h>
 #include <math.h>
+#if ENABLE_SNAPSHOT
+  #include "snapshot.h"
+#endif
 
 /* ================= Private ================= */
 
@@ -60,10 +64,10 @@ void initSOC(float capacityAh, float initialVoltage) {
 
   if (saved >= 0.0f && saved <= 100.0f) {
     soc = saved;
-    Serial.printf("[SOC] Loaded from NVS: %.1f%%\n", soc);
+    LOGI("SOC", "Loaded from NVS: %.1f%%", soc);
   } else {
     soc = voltageToSOC_3S(initialVoltage);
-    Serial.printf("[SOC] Estimated from OCV: %.1f%%\n", soc);
+    LOGI("SOC", "Estimated from OCV: %.1f%%", soc);
   }
 
   remainingAh  = ratedCapAh * (soc / 100.0f);
@@ -99,11 +103,13 @@ void updateSOC(float currentA, unsigned long dtMs) {
   remainingAh  = fmaxf(0.0f, fminf(remainingAh, ratedCapAh));
   soc          = (remainingAh / ratedCapAh) * 100.0f;
 
+#if !ENABLE_SNAPSHOT   // otherwise saved with SOH in snapshot.cpp
   static unsigned long lastSaveMs = 0;
   if (millis() - lastSaveMs > SOC_SAVE_INTERVAL_MS) {
     saveSOC();
     lastSaveMs = millis();
   }
+#endif
 }
 
 void correctSOCFromVoltage(float packVoltage) {
@@ -119,6 +125,10 @@ void correctSOCFromVoltage(float packVoltage) {
   correctionDue = false;
 }
 
+float estimateSOCFromVoltage(float packVoltage) {
+  return voltageToSOC_3S(packVoltage);
+}
+
 float getSOC()         { return soc;         }
 float getRemainingAh() { return remainingAh; }
 
@@ -126,7 +136,10 @@ void saveSOC() {
   prefs.begin("bms_soc", false);
   prefs.putFloat("soc", soc);
   prefs.end();
-  Serial.printf("[SOC] Saved: %.1f%%\n", soc);
+#if ENABLE_SNAPSHOT
+  snapshotSave(SNAP_EXPLICIT);   // else the older snapshot wins at boot
+#endif
+  LOGD("SOC", "Saved: %.1f%%", soc);
 }
 
 void loadSOC() {
@@ -136,6 +149,11 @@ void loadSOC() {
   remainingAh = ratedCapAh * (soc / 100.0f);
 }
 
+void restoreSOC(float savedAh) {
+  remainingAh = fmaxf(0.0f, fminf(savedAh, ratedCapAh));
+  soc         = (remainingAh / ratedCapAh) * 100.0f;
+}
+
 void resetSOC(float percent) {
   soc         = percent;
   remainingAh = ratedCapAh * (soc / 100.0f);
@@ -24,6 +24,12 @@ void updateSOC(float currentA, unsigned long dtMs);
  */
 void correctSOCFromVoltage(float packVoltage);
 
+/**
+ * Open-circuit voltage → SOC lookup for the 3S pack (no state change).
+ * Same table used for boot estimation and idle correction.
+ */
+float estimateSOCFromVoltage(float packVoltage);
+
 /** Returns SOC in percent [0.0 – 100.0] */
 float getSOC();
 
@@ -34,3 +40,6 @@ float getRemainingAh();
 void saveSOC();
 void loadSOC();
 void resetSOC(float percent = 100.0);
+
+/** Set the Coulomb counter from a snapshot (no save). */
+void restoreSOC(float remainingAh);
@@ -1,7 +1,11 @@
 #include "soh.h"
 #include "config.h"
+#include "logger.h"
 #include "nvs_logger.h"
 #include <Preferences.h>
+#if ENABLE_SNAPSHOT
+  #include "snapshot.h"
+#endif
 
 /* ================= Private ================= */
 
@@ -47,7 +51,7 @@ void initSOH() {
   lastUpdateTime = millis();
   initialized    = true;
 
-  Serial.printf("[SOH] Initialized: %.1f%%\n", soh);
+  LOGI("SOH", "Initialized: %.1f%%", soh);
 }
 
 float getSOH() { return soh; }
@@ -79,12 +83,14 @@ void updateSOH(float current, float temperature, bool fault) {
   soh            = clamp(soh, SOH_MIN_THRESHOLD, 100.0f);
   lastUpdateTime = now;
 
+#if !ENABLE_SNAPSHOT   // otherwise saved with SOC in snapshot.cpp
   if (now - lastSaveTime > SOH_SAVE_INTERVAL_MS) saveSOH();
+#endif
 }
 
 void degradeSOH() {
   soh = clamp(soh - SOH_DEGRADE_PER_FAULT, SOH_MIN_THRESHOLD, 100.0f);
-  Serial.printf("[SOH] Fault degradation → %.1f%%\n", soh);
+  LOGI("SOH", "Fault degradation → %.1f%%", soh);
 }
 
 void degradeSOHByTemperature(float temperature, unsigned long durationMs) {
@@ -96,7 +102,7 @@ void degradeSOHByTemperature(float temperature, unsigned long durationMs) {
 void degradeSOHByCycle(float cycleDepth) {
   float degrade = SOH_DEGRADE_PER_CYCLE * cycleDegradeFactor(cycleDepth);
   soh           = clamp(soh - degrade, SOH_MIN_THRESHOLD, 100.0f);
-  Serial.printf("[SOH] Cycle degrade (%.0f%% DoD) → %.1f%%\n", cycleDepth, soh);
+  LOGI("SOH", "Cycle degrade (%.0f%% DoD) → %.1f%%", cycleDepth, soh);
 }
 
 float calculateSOHFromCapacity(float measured, float nominal) {
@@ -117,6 +123,9 @@ void saveSOH() {
   prefs.putULong("hightemp_s", totalHighTempSeconds);
   prefs.end();
   lastSaveTime = millis();
+#if ENABLE_SNAPSHOT
+  snapshotSave(SNAP_EXPLICIT);
+#endif
 }
 
 void loadSOH() {
@@ -126,6 +135,13 @@ void loadSOH() {
   prefs.end();
 }
 
+void restoreSOH(float savedSoh, unsigned long highTempSeconds) {
+  soh                  = clamp(savedSoh, SOH_MIN_THRESHOLD, 100.0f);
+  totalHighTempSeconds = highTempSeconds;
+}
+
+unsigned long getHighTempSeconds() { return totalHighTempSeconds; }
+
 void resetSOH() {
   soh                  = 100.0f;
   totalHighTempSeconds = 0;
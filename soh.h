@@ -32,3 +32,7 @@ bool needsReplacement();
 void saveSOH();
 void loadSOH();
 void resetSOH();
+
+/** Set SOH and the high-temperature counter from a snapshot (no save). */
+void restoreSOH(float soh, unsigned long highTempSeconds);
+unsigned long getHighTempSeconds();
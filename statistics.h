@@ -14,7 +14,7 @@
    STATISTICS RECORD
    ────────────────────────────────────────────────────────── */
 
-#define FAULT_TYPE_COUNT  14   // must match FaultType enum size
+#define FAULT_TYPE_COUNT  16   // must match FaultType enum size
 
 struct BmsStatistics {
 
@@ -1,5 +1,6 @@
 #include "system.h"
 #include "config.h"
+#include "logger.h"
 #include "fault_manager.h"
 #include "soh.h"
 #include "rul.h"
@@ -9,15 +10,65 @@
 #include "telegram.h"
 #include "nvs_logger.h"
 #include "lcd.h"
+#include "loop_profiler.h"
+#include "telemetry_stream.h"
+#include "actuator.h"
 
 #if ENABLE_GEOLOCATION
   #include "gps.h"
+  #include "geofence.h"
+#endif
+#if ENABLE_GEOLOCATION && ENABLE_HARDWARE_GPS && GPS_TRACK_ENABLED
+  #include "gps_track.h"
+#endif
+#if ENABLE_RANGE_ESTIMATOR
+  #include "range.h"
+#endif
+#if ENABLE_BLACKBOX
+  #include "blackbox.h"
+#endif
+#if ENABLE_TSDB
+  #include "tsdb.h"
+#endif
+#if ENABLE_ROLLUPS
+  #include "rollup.h"
+#endif
+#if ENABLE_SNAPSHOT
+  #include "snapshot.h"
+#endif
+#if ENABLE_PARKING
+  #include "parking.h"
+#endif
+#if ENABLE_ADAPTIVE_SAMPLING
+  #include "sampler.h"
+  #include "bus_lock.h"
+#endif
+#if ENABLE_INRUSH_CAPTURE
+  #include "inrush.h"
+#endif
+#if ENABLE_PRECHARGE
+  #include "precharge.h"
+#endif
+#if ENABLE_CHARGE_CONTROL
+  #include "charge.h"
 #endif
 
 #if ENABLE_IMPACT_DETECTION
   #include "accelerometer.h"
 #endif
 
+#if ENABLE_OFFLINE_QUEUE
+  #include "telemetry_queue.h"
+#endif
+
+#if ENABLE_MQTT
+  #include "mqtt_client.h"
+#endif
+
+#if ENABLE_HEAP_GUARD
+  #include "heap_guard.h"
+#endif
+
 /* ═══════════════════════════════════════════
    GLOBAL SYSTEM STATE
    ═══════════════════════════════════════════ */
@@ -30,6 +81,25 @@ bool isChargingActive() { return chargingActive; }
 bool isFanActive()      { return fanActive;      }
 bool isThermalTripped() { return thermalTripped; }
 
+/* Parking resume: restore the control state instead of re-arming (and
+   re-alerting).  The fan was held through deep sleep; motor and charge
+   were opened for it, so they are only voted closed here and close on
+   the loop's first actuatorApply(), after evaluateSystemFaults() – the
+   motor through pre-charge again.                                   */
+void restoreRelayState(bool chargeArmed, bool fanOn, bool motorOn) {
+  chargingActive = chargeArmed;
+  fanActive      = fanOn;
+#if ENABLE_CHARGE_CONTROL
+  chargeRestore(chargeArmed);
+#endif
+  actuatorAssume(ACT_CHARGE, false);
+  actuatorAssume(ACT_FAN,    fanOn);
+  actuatorAssume(ACT_MOTOR,  false);
+  actuatorRequest(ACT_CHARGE, ACT_SRC_CONTROL, chargeArmed ? ACT_ON : ACT_OFF);
+  actuatorRequest(ACT_FAN,    ACT_SRC_CONTROL, fanOn       ? ACT_ON : ACT_OFF);
+  actuatorRequest(ACT_MOTOR,  ACT_SRC_CONTROL, motorOn     ? ACT_ON : ACT_OFF);
+}
+
 /* ═══════════════════════════════════════════
    INTERNAL ALERT HELPER
    Sends the same message via both Telegram and GSM SMS.
@@ -41,9 +111,9 @@ bool isThermalTripped() { return thermalTripped; }
 static void sendAlert(const char* telegramMsg, const char* smsShort,
                       bool forceSend = false) {
   if (forceSend)
-    sendTelegramForced(String(telegramMsg));
+    sendTelegramForced(telegramMsg);
   else
-    sendTelegramAlert(String(telegramMsg));
+    sendTelegramAlert(telegramMsg);
   gsmSendSMS(smsShort);
 }
 
@@ -82,25 +152,45 @@ void printSystemBanner() {
 
 void initializeAllSystems(float initialPackVoltage) {
 
-  pinMode(CHARGE_RELAY_PIN,      OUTPUT);
-  pinMode(LOAD_MOTOR_RELAY_PIN,  OUTPUT);
-  pinMode(COOLING_FAN_RELAY_PIN, OUTPUT);
-
   /* ALL relays OFF during init.
      Motor relay is enabled AFTER all subsystems are ready to prevent
      relay coil inrush from browning out the 3.3V rail mid-init. */
-  digitalWrite(CHARGE_RELAY_PIN,      LOW);
-  digitalWrite(LOAD_MOTOR_RELAY_PIN,  LOW);
-  digitalWrite(COOLING_FAN_RELAY_PIN, LOW);
+  actuatorInit();
 
   initFaultManager();
   storageInit();
+#if ENABLE_BLACKBOX
+  blackboxInit();
+#endif
+#if ENABLE_TSDB
+  tsdbInit();
+#endif
+#if ENABLE_ROLLUPS
+  rollupInit();   // after tsdbInit – bucket times come from tsdbNow()
+#endif
+#if ENABLE_OFFLINE_QUEUE
+  telemetryQueueInit();
+#endif
 
   initSOC(CELL_CAPACITY_AH, initialPackVoltage);
   initSOH();
+#if ENABLE_SNAPSHOT
+  snapshotInit();   // newest snapshot overrides the NVS values just loaded
+#endif
+#if ENABLE_PARKING
+  bool fromPark = parkingRestore();   // RTC state is newer than any snapshot
+#else
+  bool fromPark = false;
+#endif
   initRUL();
+#if ENABLE_RANGE_ESTIMATOR
+  rangeInit();
+#endif
 
   wifiInit();
+#if ENABLE_MQTT
+  mqttInit();
+#endif
   gsmInit();
   telegramInit();
 
@@ -110,19 +200,35 @@ void initializeAllSystems(float initialPackVoltage) {
 
 #if ENABLE_GEOLOCATION
   initGPS();
+#if GEOFENCE_ENABLED
+  geofenceInit();
+#endif
 #endif
 
 #if ENABLE_IMPACT_DETECTION
   initAccelerometer();
 #endif
 
-  Serial.println("[SYS] All systems initialized");
+  LOGI("SYS", "All systems initialized");
 
   /* Enable motor relay now that 3.3V rail is stable and all init is done.
-     200 ms delay lets capacitors on the relay driver fully charge first. */
+     200 ms delay lets capacitors on the relay driver fully charge first;
+     with pre-charge the loop sequences the bus before the main relay.
+     Resuming from parking the relays are already voted and the boot
+     alert was sent when the device first started. */
+  if (fromPark) {
+    LOGI("SYS", "Resumed from parking – relays close on first pass, no boot alert");
+    return;
+  }
+#if ENABLE_PRECHARGE
+  actuatorRequest(ACT_MOTOR, ACT_SRC_CONTROL, ACT_ON);
+  LOGI("MOTOR", "Relay requested – pre-charging bus");
+#else
   delay(200);
-  digitalWrite(LOAD_MOTOR_RELAY_PIN, HIGH);
-  Serial.println("[MOTOR] Relay enabled after init");
+  actuatorRequest(ACT_MOTOR, ACT_SRC_CONTROL, ACT_ON);
+  actuatorApply();
+  LOGI("MOTOR", "Relay enabled after init");
+#endif
 
   /* ── Startup alert ── */
   char bootMsg[160];
@@ -140,7 +246,7 @@ void initializeAllSystems(float initialPackVoltage) {
 void performSystemDiagnostics() {
   Serial.println("--- SYSTEM DIAGNOSTICS ---");
   Serial.printf("WiFi : %s\n", wifiConnected() ? "Connected" : "NOT connected");
-  Serial.printf("GSM  : %s\n", gsmIsReady()    ? "Ready"     : "NOT ready");
+  Serial.printf("GSM  : %s\n", gsmIsReady()    ? "Ready"     : "Initialising");
 #if ENABLE_GEOLOCATION
   Serial.printf("GPS  : %s\n", gpsHealthy()    ? "Fix OK"    : "No fix");
 #endif
@@ -179,21 +285,53 @@ void updateSystemHealth(float currentA,
 
 void checkExternalEvents() {
 
-  static unsigned long lastGeofenceAlertMs = 0;
   static unsigned long lastFreeFallAlertMs = 0;
   static unsigned long lastImpactAlertMs   = 0;
   static unsigned long lastShockAlertMs    = 0;
 
   /* Separate cooldowns per event type */
-  static const unsigned long GEOFENCE_COOLDOWN_MS  = 60000UL;  // 60 s
   static const unsigned long FREEFALL_COOLDOWN_MS  = 30000UL;  // 30 s
   static const unsigned long IMPACT_COOLDOWN_MS    = 10000UL;  // 10 s (serious – shorter)
   static const unsigned long SHOCK_COOLDOWN_MS     = 10000UL;  // 10 s
 
+  /* ── Geofence (hysteresis inside geofenceUpdate) ── */
+#if ENABLE_GEOLOCATION && GEOFENCE_ENABLED
+  static unsigned long lastGeofenceAlertMs = 0;
+  static const unsigned long GEOFENCE_COOLDOWN_MS = 60000UL;   // 60 s
+
+  if (hasGPSFix()) {
+    GPSData g = getGPSData();
+    if (geofenceUpdate(g.latitude, g.longitude, g.accuracy)) {
+      GeofenceStatus gf = geofenceGetStatus();
+      if (gf.violation) {
+        /* Alert only: a position fix is not grounds to cut the motor */
+        if (millis() - lastGeofenceAlertMs >= GEOFENCE_COOLDOWN_MS) {
+          lastGeofenceAlertMs = millis();
+
+          char msg[200];
+          snprintf(msg, sizeof(msg),
+                   "BMS ALERT [%s]\nGEOFENCE VIOLATION\n%s %s",
+                   DEVICE_ID, gf.zone >= 0 ? "Entered" : "Left", gf.zoneName);
+          appendGPSLocation(msg, sizeof(msg));
+
+          sendAlert(msg, "BMS: GEOFENCE VIOLATION");
+        }
+        LOGW("GEOFENCE", "Violation – %s %s", gf.zone >= 0 ? "entered" : "left",
+             gf.zoneName);
+      } else {
+        LOGI("GEOFENCE", "Back inside permitted area");
+      }
+    }
+  }
+#endif
 
   /* ── Accelerometer ── */
 #if ENABLE_IMPACT_DETECTION
   AccelData accel = readAccelerometer();
+#if ENABLE_ADAPTIVE_SAMPLING
+  if (accel.freeFallDetected || accel.impactDetected || accel.shockDetected)
+    samplerTrigger(SAMPLE_TRIG_ACCEL);
+#endif
 
   /* 1. FREE FALL */
   if (accel.freeFallDetected) {
@@ -207,7 +345,7 @@ void checkExternalEvents() {
       appendGPSLocation(msg, sizeof(msg));
 
       sendAlert(msg, "BMS: FREE FALL DETECTED");
-      Serial.printf("[ACCEL ALERT] Free fall  mag=%.2fg\n", accel.magnitude);
+      LOGW("ACCEL", "Free fall  mag=%.2fg", accel.magnitude);
     }
   }
 
@@ -225,8 +363,8 @@ void checkExternalEvents() {
       appendGPSLocation(msg, sizeof(msg));
 
       sendAlert(msg, "BMS: IMPACT DETECTED");
-      Serial.printf("[ACCEL ALERT] Impact  mag=%.2fg  total=%u\n",
-                    accel.magnitude, (unsigned int)accel.impactCount);
+      LOGW("ACCEL", "Impact  mag=%.2fg  total=%u",
+           accel.magnitude, (unsigned int)accel.impactCount);
     }
   }
 
@@ -244,8 +382,8 @@ void checkExternalEvents() {
       appendGPSLocation(msg, sizeof(msg));
 
       sendAlert(msg, "BMS: SHOCK DETECTED");
-      Serial.printf("[ACCEL ALERT] Shock  mag=%.2fg  total=%u\n",
-                    accel.magnitude, (unsigned int)accel.shockCount);
+      LOGW("ACCEL", "Shock  mag=%.2fg  total=%u",
+           accel.magnitude, (unsigned int)accel.shockCount);
     }
   }
 #endif
@@ -256,17 +394,95 @@ void checkExternalEvents() {
    ─────────────────────────────────────────────
    Alerts sent on:
      - Charging STARTED  (charger connected + current flowing in)
-     - Charging COMPLETE (pack reached CHARGE_STOP_V)
+     - Charging COMPLETE (C/20 taper with ENABLE_CHARGE_CONTROL,
+                          else pack reached CHARGE_STOP_V)
      - Charging STOPPED  by fault or thermal trip
+   With ENABLE_CHARGE_CONTROL also on CV entry (ETA to full),
+   a CV timeout and a temperature derate pause.
    ═══════════════════════════════════════════ */
 
-void controlCharging(float packVoltage, bool fault) {
+#if ENABLE_CHARGE_CONTROL
+void controlCharging(float packVoltage, float currentA, float temperature, bool fault) {
+
+  /* Fault interlock is a safety vote: no minimum on-time delays it */
+  actuatorRequest(ACT_CHARGE, ACT_SRC_FAULT, fault ? ACT_OFF : ACT_NONE);
+
+  ChargeEvent ev = chargeUpdate(packVoltage, currentA, temperature, fault || thermalTripped);
+  chargingActive = chargeRelayWanted();
+  actuatorRequest(ACT_CHARGE, ACT_SRC_CONTROL, chargingActive ? ACT_ON : ACT_OFF);
+  if (ev == CHG_EV_NONE) return;
+
+  ChargeStatus cs = chargeGetStatus();
+  char msg[160];
+
+  switch (ev) {
+    case CHG_EV_ARMED:
+      snprintf(msg, sizeof(msg),
+               "BMS INFO [%s]\nBATTERY READY TO CHARGE\nYou can now connect your charger\nVoltage: %.2fV  SOC: %.1f%%",
+               DEVICE_ID, packVoltage, getSOC());
+      sendAlert(msg, "BMS: YOU CAN CONNECT CHARGER", true);
+      LOGI("CHG", "Charge relay ON – ready alert sent");
+      break;
+
+    case CHG_EV_CV:
+      snprintf(msg, sizeof(msg),
+               "BMS INFO [%s]\nCHARGING – CV PHASE\nCurrent: %.2fA  Voltage: %.2fV  SOC: %.1f%%\nFull in ~%.0f min",
+               DEVICE_ID, cs.chargeA, cs.packV, getSOC(), cs.etaMin);
+      sendAlert(msg, "BMS: CHARGING CV PHASE", true);
+      break;
+
+    case CHG_EV_COMPLETE:
+    case CHG_EV_CV_TIMEOUT:
+      incrementCycleCount();
+      snprintf(msg, sizeof(msg),
+               "BMS INFO [%s]\nCHARGING COMPLETE%s\n%.2f Ah in %lu min\nVoltage: %.2fV  SOC: %.1f%%  Cycles: %lu",
+               DEVICE_ID, ev == CHG_EV_CV_TIMEOUT ? " (CV timeout)" : "",
+               cs.sessionAh, (unsigned long)(cs.sessionMs / 60000UL),
+               packVoltage, getSOC(), getCycleCount());
+      sendAlert(msg, "BMS: CHARGING COMPLETE", true);
+      LOGI("CHG", "Charge relay OFF – charging complete – alert sent");
+      break;
+
+    case CHG_EV_DERATED:
+      snprintf(msg, sizeof(msg),
+               "BMS ALERT [%s]\nCHARGING PAUSED\nCharger %.1fA above %.1fA allowed at %.1fC\nRetrying every %lus",
+               DEVICE_ID, cs.chargeA, cs.limitA, temperature,
+               (unsigned long)(CHARGE_DERATE_RETRY_MS / 1000UL));
+      sendAlert(msg, "BMS: CHARGING PAUSED", true);
+      break;
+
+    case CHG_EV_STOPPED: {
+      const char* reason = fault ? "fault" : "high temperature";
+      snprintf(msg, sizeof(msg),
+               "BMS ALERT [%s]\nCHARGING STOPPED\nReason: %s\nVoltage: %.2fV",
+               DEVICE_ID, reason, packVoltage);
+      sendAlert(msg, "BMS: CHARGING STOPPED", true);
+      LOGI("CHG", "Stopped by %s → relay OFF", reason);
+      break;
+    }
+
+    case CHG_EV_CEILING:
+      snprintf(msg, sizeof(msg),
+               "BMS ALERT [%s]\nCHARGING STOPPED\nPack %.2fV above %.2fV ceiling – check charger setpoint\nSOC: %.1f%%",
+               DEVICE_ID, cs.packV, CHARGE_CEILING_V, getSOC());
+      sendAlert(msg, "BMS: CHARGER ABOVE CEILING", true);
+      break;
+
+    default:
+      break;
+  }
+}
+#else
+void controlCharging(float packVoltage, float currentA, float temperature, bool fault) {
+
+  /* Fault interlock is a safety vote: no minimum on-time delays it */
+  actuatorRequest(ACT_CHARGE, ACT_SRC_FAULT, fault ? ACT_OFF : ACT_NONE);
 
   /* Fault OR thermal trip → immediately cut charge relay */
   if (fault || thermalTripped) {
     if (chargingActive) {
       chargingActive = false;
-      digitalWrite(CHARGE_RELAY_PIN, LOW);
+      actuatorRequest(ACT_CHARGE, ACT_SRC_CONTROL, ACT_OFF);
 
       const char* reason = fault ? "fault" : "high temperature";
       char msg[160];
@@ -275,7 +491,7 @@ void controlCharging(float packVoltage, bool fault) {
                DEVICE_ID, reason, packVoltage);
       sendAlert(msg, "BMS: CHARGING STOPPED", true);
 
-      Serial.printf("[CHG] Stopped by %s → relay OFF\n", reason);
+      LOGI("CHG", "Stopped by %s → relay OFF", reason);
     }
     return;
   }
@@ -283,7 +499,7 @@ void controlCharging(float packVoltage, bool fault) {
   /* Start charging – relay ready alert */
   if (!chargingActive && packVoltage <= CHARGE_START_V) {
     chargingActive = true;
-    digitalWrite(CHARGE_RELAY_PIN, HIGH);
+    actuatorRequest(ACT_CHARGE, ACT_SRC_CONTROL, ACT_ON);
 
     char msg[160];
     snprintf(msg, sizeof(msg),
@@ -291,13 +507,13 @@ void controlCharging(float packVoltage, bool fault) {
              DEVICE_ID, packVoltage, getSOC());
     sendAlert(msg, "BMS: YOU CAN CONNECT CHARGER", true);
 
-    Serial.println("[CHG] Charge relay ON – ready alert sent");
+    LOGI("CHG", "Charge relay ON – ready alert sent");
   }
 
   /* Charging complete */
   if (chargingActive && packVoltage >= CHARGE_STOP_V) {
     chargingActive = false;
-    digitalWrite(CHARGE_RELAY_PIN, LOW);
+    actuatorRequest(ACT_CHARGE, ACT_SRC_CONTROL, ACT_OFF);
     incrementCycleCount();
 
     char msg[160];
@@ -306,9 +522,10 @@ void controlCharging(float packVoltage, bool fault) {
              DEVICE_ID, packVoltage, getSOC(), getCycleCount());
     sendAlert(msg, "BMS: CHARGING COMPLETE", true);
 
-    Serial.println("[CHG] Charge relay OFF – charging complete – alert sent");
+    LOGI("CHG", "Charge relay OFF – charging complete – alert sent");
   }
 }
+#endif
 
 /* ═══════════════════════════════════════════
    CHARGING CURRENT MONITOR
@@ -331,13 +548,20 @@ void monitorChargingCurrent(float currentA, float packVoltage) {
     wasChargingCurrent = true;
 
     char msg[160];
-    snprintf(msg, sizeof(msg),
+    int  n = snprintf(msg, sizeof(msg),
              "BMS INFO [%s]\nCHARGING IN PROGRESS\nCurrent: %.2fA  Voltage: %.2fV  SOC: %.1f%%",
              DEVICE_ID, fabsf(currentA), packVoltage, getSOC());
+#if ENABLE_CHARGE_CONTROL
+    float eta = chargeGetStatus().etaMin;
+    if (eta >= 0.0f && n > 0 && (size_t)n < sizeof(msg))
+      snprintf(msg + n, sizeof(msg) - n, "\nFull in ~%.0f min", eta);
+#else
+    (void)n;
+#endif
     sendAlert(msg, "BMS: CHARGING IN PROGRESS", true);
 
-    Serial.printf("[CHG] Current flowing IN (%.2fA) – in-progress alert sent\n",
-                  fabsf(currentA));
+    LOGI("CHG", "Current flowing IN (%.2fA) – in-progress alert sent",
+         fabsf(currentA));
   }
 
   /* Current stopped flowing INTO battery */
@@ -350,7 +574,7 @@ void monitorChargingCurrent(float currentA, float packVoltage) {
              DEVICE_ID, packVoltage, getSOC());
     sendAlert(msg, "BMS: CHARGING CURRENT STOPPED", true);
 
-    Serial.printf("[CHG] Current no longer flowing in – stopped alert sent\n");
+    LOGI("CHG", "Current no longer flowing in – stopped alert sent");
   }
 }
 
@@ -361,18 +585,26 @@ void monitorChargingCurrent(float currentA, float packVoltage) {
 
 #define MOTOR_CHARGE_CURRENT_THRESHOLD  -0.2f
 
-/* Timestamp of last motor-ON transition – used for inrush blanking */
-static unsigned long motorOnTimeMs = 0;
-
 /* How long to blank fault/sensor evaluation after motor energises.
    Motor inrush typically lasts < 200 ms; 500 ms gives plenty of margin. */
 #define MOTOR_START_BLANK_MS  500UL
 
+/* With inrush capture there is no blanking: true while the start is
+   being captured and checked against the envelope (flags only).
+   With pre-charge the main relay closes onto a charged bus: never.  */
 bool isMotorStartBlanking() {
-  return (motorOnTimeMs > 0 &&
-          (millis() - motorOnTimeMs) < MOTOR_START_BLANK_MS);
+#if ENABLE_INRUSH_CAPTURE
+  return inrushActive();
+#elif ENABLE_PRECHARGE
+  return false;
+#else
+  return actuatorState(ACT_MOTOR) &&
+         (millis() - actuatorChangedAt(ACT_MOTOR)) < MOTOR_START_BLANK_MS;
+#endif
 }
 
+/* The control vote only – a latched fault, the thermal trip and an
+   inrush trip hold the relay open through their own votes.         */
 void controlMotorRelay(bool fault, float currentA) {
 
   bool actuallyCharging = (currentA < MOTOR_CHARGE_CURRENT_THRESHOLD);
@@ -380,21 +612,14 @@ void controlMotorRelay(bool fault, float currentA) {
 
   static bool lastState = true;
   if (allow != lastState) {
-    digitalWrite(LOAD_MOTOR_RELAY_PIN, allow ? HIGH : LOW);
-
-    if (allow) {
-      /* Motor just turned ON – start blanking window */
-      motorOnTimeMs = millis();
-      Serial.println("[MOTOR] ON – inrush blanking started");
-    } else {
-      motorOnTimeMs = 0;
-      Serial.printf("[MOTOR] OFF  (fault=%d trip=%d current=%.2fA)\n",
-                    (int)fault, (int)thermalTripped, currentA);
-    }
+    if (allow)
+      LOGI("MOTOR", "ON requested");
+    else
+      LOGI("MOTOR", "OFF  (fault=%d trip=%d current=%.2fA)",
+           (int)fault, (int)thermalTripped, currentA);
     lastState = allow;
-  } else {
-    digitalWrite(LOAD_MOTOR_RELAY_PIN, allow ? HIGH : LOW);
   }
+  actuatorRequest(ACT_MOTOR, ACT_SRC_CONTROL, allow ? ACT_ON : ACT_OFF);
 }
 
 /* ═══════════════════════════════════════════
@@ -415,8 +640,8 @@ void controlThermalManagement(float temperature, bool fault) {
   if (!thermalTripped && temperature >= THERMAL_TRIP_TEMP) {
     thermalTripped = true;
 
-    digitalWrite(CHARGE_RELAY_PIN,     LOW);
-    digitalWrite(LOAD_MOTOR_RELAY_PIN, LOW);
+    actuatorRequest(ACT_CHARGE, ACT_SRC_THERMAL, ACT_OFF);
+    actuatorRequest(ACT_MOTOR,  ACT_SRC_THERMAL, ACT_OFF);
     if (chargingActive) chargingActive = false;
 
     char msg[160];
@@ -425,12 +650,14 @@ void controlThermalManagement(float temperature, bool fault) {
              DEVICE_ID, temperature);
     sendAlert(msg, "BMS: THERMAL PROTECTION ON", true);
 
-    Serial.printf("[THERMAL] TRIP at %.1fC – both relays OFF – alert sent\n", temperature);
+    LOGW("THERMAL", "TRIP at %.1fC – both relays OFF – alert sent", temperature);
   }
 
   /* ── THERMAL CLEAR ── */
   if (thermalTripped && temperature < THERMAL_CLEAR_TEMP) {
     thermalTripped = false;
+    actuatorRequest(ACT_CHARGE, ACT_SRC_THERMAL, ACT_NONE);
+    actuatorRequest(ACT_MOTOR,  ACT_SRC_THERMAL, ACT_NONE);
 
     char msg[160];
     snprintf(msg, sizeof(msg),
@@ -438,7 +665,7 @@ void controlThermalManagement(float temperature, bool fault) {
              DEVICE_ID, temperature);
     sendAlert(msg, "BMS: THERMAL PROTECTION OFF", true);
 
-    Serial.printf("[THERMAL] CLEARED at %.1fC – relays unlocked – alert sent\n", temperature);
+    LOGI("THERMAL", "CLEARED at %.1fC – relays unlocked – alert sent", temperature);
   }
 
   /* ── FAN ── */
@@ -449,13 +676,13 @@ void controlThermalManagement(float temperature, bool fault) {
 
   if (shouldBeOn && !fanActive) {
     fanActive = true;
-    digitalWrite(COOLING_FAN_RELAY_PIN, HIGH);
-    Serial.printf("[FAN] ON  (T=%.1fC fault=%d trip=%d)\n",
-                  temperature, (int)fault, (int)thermalTripped);
+    actuatorRequest(ACT_FAN, ACT_SRC_CONTROL, ACT_ON);
+    LOGI("FAN", "ON  (T=%.1fC fault=%d trip=%d)",
+         temperature, (int)fault, (int)thermalTripped);
   } else if (!shouldBeOn && fanActive) {
     fanActive = false;
-    digitalWrite(COOLING_FAN_RELAY_PIN, LOW);
-    Serial.printf("[FAN] OFF (T=%.1fC)\n", temperature);
+    actuatorRequest(ACT_FAN, ACT_SRC_CONTROL, ACT_OFF);
+    LOGI("FAN", "OFF (T=%.1fC)", temperature);
   }
 }
 
@@ -528,7 +755,412 @@ void uploadSystemData(float packVoltage,
     impacts, shocks,
     chargingActive,
     fanActive,
-    (bool)digitalRead(CHARGE_RELAY_PIN),
-    (bool)digitalRead(LOAD_MOTOR_RELAY_PIN)
+    actuatorState(ACT_CHARGE),
+    actuatorState(ACT_MOTOR)
   );
 }
+
+#if ENABLE_BLACKBOX
+void recordBlackbox(float packVoltage,
+                    const CurrentData& iData,
+                    float temperature,
+                    float soc) {
+  BlackboxSample s;
+  s.tMs       = millis();
+  s.packMv    = (uint16_t)lroundf(packVoltage * 1000.0f);
+  s.currentCa = (int16_t)constrain(lroundf(iData.current * 100.0f), -32768L, 32767L);
+  s.tempDc    = (int16_t)lroundf(temperature * 10.0f);
+#if ENABLE_IMPACT_DETECTION
+  AccelData a = getAccelData();
+  s.accelMg[0] = (int16_t)lroundf(a.accelX * 1000.0f);
+  s.accelMg[1] = (int16_t)lroundf(a.accelY * 1000.0f);
+  s.accelMg[2] = (int16_t)lroundf(a.accelZ * 1000.0f);
+#else
+  s.accelMg[0] = s.accelMg[1] = s.accelMg[2] = 0;
+#endif
+  s.faultBits = (uint16_t)getFaultBitmap();
+  s.socPct    = (uint8_t)lroundf(soc);
+
+  uint8_t flags = 0;
+  if (actuatorState(ACT_CHARGE))         flags |= BB_FLAG_CHARGE_RELAY;
+  if (actuatorState(ACT_MOTOR))          flags |= BB_FLAG_MOTOR_RELAY;
+  if (actuatorState(ACT_FAN))            flags |= BB_FLAG_FAN;
+  if (chargingActive)                    flags |= BB_FLAG_CHARGING;
+  if (isMotorStartBlanking())            flags |= BB_FLAG_BLANKING;
+  s.flags = flags;
+
+  blackboxRecord(s);
+}
+#endif
+
+#if ENABLE_TSDB
+struct HistoryAgg {
+  uint32_t n;
+  float    mn[TSDB_SERIES], mx[TSDB_SERIES];
+  double   sum[TSDB_SERIES];
+};
+
+static bool aggregateHistory(const TsdbSample& s, void* ctx) {
+  HistoryAgg& a = *(HistoryAgg*)ctx;
+  a.n++;
+  for (uint8_t k = 0; k < TSDB_SERIES; k++) {
+    a.mn[k]   = fminf(a.mn[k], s.v[k]);
+    a.mx[k]   = fmaxf(a.mx[k], s.v[k]);
+    a.sum[k] += s.v[k];
+  }
+  return true;
+}
+#endif
+
+/* ═══════════════════════════════════════════
+   SERIAL CONSOLE
+   Single-character commands, never blocks the loop.
+   ═══════════════════════════════════════════ */
+
+void handleSerialCommands() {
+  while (Serial.available()) {
+    char c = (char)Serial.read();
+    switch (c) {
+      case 'p': profilerDump();  break;
+      case 'r': profilerReset(); Serial.println("[PROF] Reset"); break;
+      case 'b':
+        telemetryStreamEnable(!telemetryStreamEnabled());
+        Serial.printf("[TSTREAM] Binary stream %s (sent=%lu dropped=%lu)\n",
+                      telemetryStreamEnabled() ? "ON" : "OFF",
+                      (unsigned long)telemetryStreamFramesSent(),
+                      (unsigned long)telemetryStreamFramesDropped());
+        break;
+      case 't':
+        telemetryTextEnable(!telemetryTextEnabled());
+        Serial.printf("[TSTREAM] Text telemetry %s\n",
+                      telemetryTextEnabled() ? "ON" : "OFF");
+        break;
+      case 'l':
+        Serial.printf("[LOG] written=%lu dropped=%lu high-water=%u\n",
+                      (unsigned long)logWrittenCount(),
+                      (unsigned long)logDroppedCount(),
+                      (unsigned)logHighWater());
+        break;
+      case 'w': {
+        WifiStats w = wifiGetStats();
+        Serial.printf("[WIFI] %s attempts=%lu connects=%lu (fast %lu) fails=%lu drops=%lu "
+                      "reason=%u connect last/min/avg/max=%lu/%lu/%lu/%lu ms "
+                      "up=%lus total=%lus\n",
+                      w.state == WifiState::UP ? "UP" :
+                      w.state == WifiState::CONNECTING ? "CONNECTING" :
+                      w.state == WifiState::OFF ? "OFF" : "BACKOFF",
+                      (unsigned long)w.attempts, (unsigned long)w.connects,
+                      (unsigned long)w.fastConnects, (unsigned long)w.failures,
+                      (unsigned long)w.disconnects, w.lastReason,
+                      (unsigned long)w.lastConnectMs, (unsigned long)w.minConnectMs,
+                      (unsigned long)w.avgConnectMs, (unsigned long)w.maxConnectMs,
+                      (unsigned long)(w.upSinceMs / 1000), (unsigned long)w.totalUpS);
+        break;
+      }
+#if ENABLE_GEOLOCATION
+      case 'G': {
+        GeoStats g = gpsGetGeoStats();
+        Serial.printf("[GEO] scans=%lu scan-fail=%lu lookups=%lu cache-hits=%lu (%.0f%%) "
+                      "http=%lu http-fail=%lu avoided=%lu\n",
+                      (unsigned long)g.scans, (unsigned long)g.scanFailures,
+                      (unsigned long)g.lookups, (unsigned long)g.cacheHits,
+                      g.lookups ? 100.0f * g.cacheHits / g.lookups : 0.0f,
+                      (unsigned long)g.httpCalls, (unsigned long)g.httpFailures,
+                      (unsigned long)g.cacheHits);
+        break;
+      }
+#endif
+#if ENABLE_GEOLOCATION && GEOFENCE_ENABLED
+      case 'f': {
+        GeofenceStatus f = geofenceGetStatus();
+        Serial.printf("[GEOFENCE] %s zones=%u inside=%u candidates=%u checks=%lu "
+                      "haversine=%lu coarse=%lu transitions=%lu\n",
+                      f.violation ? "VIOLATION" : "OK",
+                      f.zones, f.zonesInside, f.lastCandidates,
+                      (unsigned long)f.checks, (unsigned long)f.haversineFallbacks,
+                      (unsigned long)f.coarseSkips, (unsigned long)f.transitions);
+        break;
+      }
+#endif
+#if ENABLE_GEOLOCATION && ENABLE_HARDWARE_GPS && GPS_TRACK_ENABLED
+      case 'o': {
+        TripStats o = gpsTrackGetStats();
+        NmeaStats n = gpsGetNmeaStats();
+        Serial.printf("[ODO] trip=%.2fkm total=%.1fkm max=%.1fkm/h avg=%.1fkm/h moving=%lus "
+                      "fixes=%lu rejected=%lu resets=%lu\n",
+                      o.tripM / 1000.0f, o.totalM / 1000.0f,
+                      o.maxSpeedMps * 3.6f, o.avgMovingMps * 3.6f,
+                      (unsigned long)o.movingS, (unsigned long)o.fixes,
+                      (unsigned long)o.rejected, (unsigned long)o.resets);
+        Serial.printf("[NMEA] sentences=%lu ring-drops=%lu too-long=%lu uart-overruns=%lu "
+                      "checksum-fail=%lu\n",
+                      (unsigned long)n.sentences, (unsigned long)n.ringDrops,
+                      (unsigned long)n.tooLong, (unsigned long)n.uartOverruns,
+                      (unsigned long)n.checksumFail);
+        break;
+      }
+      case 'O': gpsTrackResetTrip(); Serial.println("[ODO] trip reset"); break;
+#endif
+#if ENABLE_BLACKBOX
+      case 'x': {
+        BlackboxStats bb = blackboxGetStats();
+        Serial.printf("[BLACKBOX] samples=%lu triggers=%lu suppressed=%lu flushes=%lu "
+                      "flash-errors=%lu%s\n",
+                      (unsigned long)bb.samples, (unsigned long)bb.triggers,
+                      (unsigned long)bb.suppressed, (unsigned long)bb.flushes,
+                      (unsigned long)bb.flashErrors, bb.capturing ? " (capturing)" : "");
+        blackboxList();
+        break;
+      }
+      case 'X': blackboxDumpLatest(); break;
+#endif
+#if ENABLE_TSDB
+      case 'y': {
+        TsdbStats ts = tsdbGetStats();
+        float bitsPer = ts.samples ? (float)ts.bits / ts.samples : 0.0f;
+        Serial.printf("[TSDB] %u/%u blocks  t=%lu..%lu  samples=%lu  %.1f bits/sample "
+                      "(%.1fx vs 20 B raw)  flushes=%lu flash-errors=%lu\n",
+                      ts.blocksUsed, ts.blocks,
+                      (unsigned long)ts.oldestT, (unsigned long)ts.newestT,
+                      (unsigned long)ts.samples, bitsPer,
+                      bitsPer > 0.0f ? 160.0f / bitsPer : 0.0f,
+                      (unsigned long)ts.flushes, (unsigned long)ts.flashErrors);
+        break;
+      }
+      case 'Y': {
+        HistoryAgg a = { 0, { INFINITY, INFINITY, INFINITY, INFINITY },
+                         { -INFINITY, -INFINITY, -INFINITY, -INFINITY }, { 0, 0, 0, 0 } };
+        uint32_t now = tsdbNow();
+        tsdbQuery(now - 3600, now, aggregateHistory, &a);
+        if (a.n == 0) { Serial.println("[TSDB] no samples in the last hour"); break; }
+        static const char* const names[TSDB_SERIES] = { "pack V", "current A", "temp C", "SOC %" };
+        Serial.printf("[TSDB] last hour, %lu samples (min / avg / max)\n", (unsigned long)a.n);
+        for (uint8_t k = 0; k < TSDB_SERIES; k++)
+          Serial.printf("  %-10s %8.3f %8.3f %8.3f\n", names[k],
+                        a.mn[k], a.sum[k] / a.n, a.mx[k]);
+        break;
+      }
+#endif
+#if ENABLE_SNAPSHOT
+      case 's': {
+        SnapshotStats sn = snapshotGetStats();
+        Serial.printf("[SNAPSHOT] seq=%lu writes=%lu erases=%lu bad=%lu flash-errors=%lu "
+                      "restored=%s%s\n",
+                      (unsigned long)sn.seq, (unsigned long)sn.writes, (unsigned long)sn.erases,
+                      (unsigned long)sn.badRecords, (unsigned long)sn.flashErrors,
+                      sn.restored ? "yes" : "no",
+                      sn.restored && sn.lastBootReason == SNAP_BROWNOUT ? " (brownout)" : "");
+        break;
+      }
+#endif
+#if ENABLE_ADAPTIVE_SAMPLING
+      case 'a': {
+        SamplerStats ss = samplerGetStats();
+        Serial.printf("[SAMPLE] rate=%s samples=%lu overruns=%lu bursts=%lu (capped %lu) "
+                      "trig relay/didt/accel/manual=%lu/%lu/%lu/%lu\n",
+                      sampleRateName(ss.rate), (unsigned long)ss.samples,
+                      (unsigned long)ss.overruns, (unsigned long)ss.bursts,
+                      (unsigned long)ss.burstCaps,
+                      (unsigned long)ss.triggers[SAMPLE_TRIG_RELAY],
+                      (unsigned long)ss.triggers[SAMPLE_TRIG_DIDT],
+                      (unsigned long)ss.triggers[SAMPLE_TRIG_ACCEL],
+                      (unsigned long)ss.triggers[SAMPLE_TRIG_MANUAL]);
+        Serial.printf("  time idle/normal/burst=%lu/%lu/%lu s  max dI/dt=%.1f A/s  "
+                      "last burst %lu samples peak %.2fA\n",
+                      (unsigned long)(ss.timeInRateMs[SAMPLE_RATE_IDLE] / 1000),
+                      (unsigned long)(ss.timeInRateMs[SAMPLE_RATE_NORMAL] / 1000),
+                      (unsigned long)(ss.timeInRateMs[SAMPLE_RATE_BURST] / 1000),
+                      ss.maxDidt, (unsigned long)ss.lastBurstSamples, ss.lastBurstPeakA);
+        BusLockStats bl = busLockGetStats();
+        Serial.printf("  bus waits i2c/adc=%lu/%lu  longest %lu/%lu us\n",
+                      (unsigned long)bl.contended[BUS_I2C], (unsigned long)bl.contended[BUS_ADC],
+                      (unsigned long)bl.maxWaitUs[BUS_I2C], (unsigned long)bl.maxWaitUs[BUS_ADC]);
+        break;
+      }
+      case 'A':
+        Serial.println("[SAMPLE] burst");
+        samplerTrigger(SAMPLE_TRIG_MANUAL);
+        break;
+#endif
+#if ENABLE_CHARGE_CONTROL
+      case 'c': {
+        ChargeStatus cs = chargeGetStatus();
+        Serial.printf("[CHG] %s for %lus  %.2fV %.2fA (limit %.1fA, plateau %.1fA)  "
+                      "ETA %.0f min  tau %.1f min | session %.2fAh %lumin | completed=%lu derates=%lu ceiling=%lu\n",
+                      chargePhaseName(cs.phase), (unsigned long)(cs.phaseMs / 1000),
+                      cs.packV, cs.chargeA, cs.limitA, cs.plateauA, cs.etaMin, cs.tauMin,
+                      cs.sessionAh, (unsigned long)(cs.sessionMs / 60000UL),
+                      (unsigned long)cs.completed, (unsigned long)cs.derates,
+                      (unsigned long)cs.ceilingStops);
+        break;
+      }
+#endif
+      case 'k':
+        for (uint8_t r = 0; r < ACT_RELAYS; r++) {
+          RelayStats rs = actuatorGetStats((ActRelay)r);
+          Serial.printf("[RELAY] %-6s %-3s by %-7s ops=%lu lifetime=%lu skipped=%lu deferred=%lu "
+                        "on=%lus last=%lus ago\n",
+                        actRelayName((ActRelay)r), rs.on ? "ON" : "OFF", actSourceName(rs.owner),
+                        (unsigned long)rs.ops, (unsigned long)rs.lifetimeOps,
+                        (unsigned long)rs.skipped, (unsigned long)rs.deferred,
+                        (unsigned long)(rs.onMs / 1000),
+                        rs.lastChangeMs ? (unsigned long)((millis() - rs.lastChangeMs) / 1000) : 0UL);
+        }
+#if ENABLE_PRECHARGE
+        {
+          PrechargeStats ps = prechargeGetStats();
+          Serial.printf("[PRECHG] %s sequences=%lu completed=%lu aborted=%lu failures=%lu refused=%lu "
+                        "last=%lums (bus %.0f%%, peak %.2fA) worst=%lums\n",
+                        prechargeStateName(ps.state), (unsigned long)ps.sequences,
+                        (unsigned long)ps.completed, (unsigned long)ps.aborted,
+                        (unsigned long)ps.failures, (unsigned long)ps.refused,
+                        (unsigned long)ps.lastMs,
+                        ps.lastBusPct, ps.lastPeakA, (unsigned long)ps.worstMs);
+        }
+#endif
+        break;
+#if ENABLE_INRUSH_CAPTURE
+      case 'i': {
+        InrushStats is = inrushGetStats();
+        const InrushEnvelope& l = is.learned;
+        const InrushEnvelope& b = is.baseline;
+        Serial.printf("[INRUSH] captures=%lu trips=%lu no-load=%lu aborted=%lu not-prechg=%lu envelope=%s (%lu starts)\n",
+                      (unsigned long)is.captures, (unsigned long)is.trips,
+                      (unsigned long)is.noLoad, (unsigned long)is.aborted,
+                      (unsigned long)is.notPrecharged,
+                      is.envelopeValid ? "learned" : "default", (unsigned long)l.starts);
+        Serial.printf("  learned peak=%.1fA @%.0fms tau=%.0fms I2t=%.1fA2s run=%.1fA\n",
+                      l.peakA, l.timeToPeakMs, l.tauMs, l.i2t, l.steadyA);
+        if (b.starts && b.peakA > 0.0f && b.tauMs > 0.0f && b.i2t > 0.0f)
+          Serial.printf("  vs baseline  peak %+.0f%%  tau %+.0f%%  I2t %+.0f%%\n",
+                        (l.peakA / b.peakA - 1.0f) * 100.0f,
+                        (l.tauMs / b.tauMs - 1.0f) * 100.0f,
+                        (l.i2t   / b.i2t   - 1.0f) * 100.0f);
+        InrushMetrics m;
+        for (uint8_t k = 0; inrushGetHistory(k, &m); k++)
+          Serial.printf("  -%lus %-10s peak=%.1fA @%.0fms tau=%.0fms I2t=%.1f run=%.1fA sag=%.2fV n=%u\n",
+                        (unsigned long)((millis() - m.atMs) / 1000), inrushResultName(m.result),
+                        m.peakA, m.timeToPeakMs, m.tauMs, m.i2t, m.steadyA, m.sagV, m.samples);
+        break;
+      }
+      case 'I':
+        inrushResetEnvelope();
+        Serial.println("[INRUSH] envelope reset");
+        break;
+#endif
+#if ENABLE_PARKING
+      case 'z':
+        Serial.println("[PARK] parking on next loop");
+        parkingRequest();
+        break;
+      case 'Z': {
+        ParkStats ps = parkingGetStats();
+        Serial.printf("[PARK] mode=%s idle=%lus resumed=%s\n",
+                      PARK_MODE == PARK_MODE_DEEP ? "deep" : "light",
+                      (unsigned long)(ps.idleMs / 1000), ps.restored ? "yes" : "no");
+        for (uint8_t k = PARK_MODE_LIGHT; k <= PARK_MODE_DEEP; k++) {
+          const ParkModeStats& m = ps.mode[k];
+          Serial.printf("  %-5s sleeps=%lu timer=%lu motion=%lu asleep=%lus awake=%lus "
+                        "wake-I=%.1fmA restore=%lums avg=%.2fmA\n",
+                        k == PARK_MODE_DEEP ? "deep" : "light",
+                        (unsigned long)m.sleeps, (unsigned long)m.timerWakes,
+                        (unsigned long)m.motionWakes,
+                        (unsigned long)(m.asleepMs / 1000), (unsigned long)(m.awakeMs / 1000),
+                        m.wakeSamples ? m.wakeCurrentSumA / m.wakeSamples * 1000.0f : 0.0f,
+                        (unsigned long)m.lastRestoreMs, parkingQuiescentMa(k));
+        }
+        break;
+      }
+#endif
+#if ENABLE_ROLLUPS
+      case 'H': {
+        static RollupBucket rows[12];
+        uint32_t now = rollupNow();
+        uint16_t n   = rollupQuery(now - 3599, now, 300, rows, 12);
+        Serial.println("[ROLLUP] last hour, 5 min buckets: age  V avg/min/max  A avg/max  C max  SOC  W avg");
+        for (uint16_t i = 0; i < n; i++) {
+          const RollupBucket& b = rows[i];
+          Serial.printf("  -%4lus  %6.3f %6.3f %6.3f  %6.2f %6.2f  %5.1f  %5.1f  %6.1f\n",
+                        (unsigned long)(now - b.t),
+                        rollupMean(b, ROLLUP_VOLTAGE), b.ch[ROLLUP_VOLTAGE].min, b.ch[ROLLUP_VOLTAGE].max,
+                        rollupMean(b, ROLLUP_CURRENT), b.ch[ROLLUP_CURRENT].max,
+                        b.ch[ROLLUP_TEMP].max, rollupMean(b, ROLLUP_SOC), rollupMean(b, ROLLUP_POWER));
+        }
+        break;
+      }
+#endif
+#if ENABLE_RANGE_ESTIMATOR
+      case 'e': {
+        RangeEstimate r = rangeGetEstimate();
+        Serial.printf("[RANGE] %.1f km (%.1f–%.1f) at %.1f Wh/km, %.0f Wh usable | "
+                      "Wh/km last-km=%.1f trip=%.1f lifetime=%.1f | trip=%.2fkm life=%.1fkm\n",
+                      r.rangeKm, r.rangeLoKm, r.rangeHiKm, r.whPerKm, r.remainingWh,
+                      r.whPerKmLastKm, r.whPerKmTrip, r.whPerKmLifetime,
+                      r.tripKm, r.lifetimeKm);
+        break;
+      }
+#endif
+      case 'g': {
+        GsmStats g = gsmGetStats();
+        Serial.printf("[GSM] %s %s cmds=%lu timeouts=%lu errors=%lu "
+                      "sms queued/sent/failed=%lu/%lu/%lu rx=%lu dropped-lines=%lu\n",
+                      g.state == GsmState::READY ? "READY" : "NOT-READY",
+                      g.registered ? "REG" : "NO-REG",
+                      (unsigned long)g.commands, (unsigned long)g.timeouts,
+                      (unsigned long)g.errors, (unsigned long)g.smsQueued,
+                      (unsigned long)g.smsSent, (unsigned long)g.smsFailed,
+                      (unsigned long)g.smsReceived, (unsigned long)g.linesDropped);
+        break;
+      }
+#if ENABLE_OFFLINE_QUEUE
+      case 'q': {
+        TelemetryQueueStats q = telemetryQueueGetStats();
+        Serial.printf("[TQ] depth=%lu/%lu enq=%lu replayed=%lu lost=%lu "
+                      "failed=%lu rate=%.1f rec/s %.0f B/s\n",
+                      (unsigned long)q.depth, (unsigned long)q.capacity,
+                      (unsigned long)q.enqueued, (unsigned long)q.replayed,
+                      (unsigned long)q.overwritten, (unsigned long)q.failedBatches,
+                      q.replayRecPerSec, q.replayBytesPerSec);
+        break;
+      }
+#endif
+#if ENABLE_MQTT
+      case 'm': {
+        MqttStats m = mqttGetStats();
+        Serial.printf("[MQTT] %s pub=%lu acked=%lu inflight=%u resent=%lu "
+                      "full=%lu cmds=%lu rate=%.1f/s rtt avg/min/max=%lu/%lu/%lu us\n",
+                      mqttConnected() ? "UP" : "DOWN",
+                      (unsigned long)m.published, (unsigned long)m.acked,
+                      (unsigned)m.inflight, (unsigned long)m.resent,
+                      (unsigned long)m.windowFull, (unsigned long)m.commands,
+                      m.pubPerSec, (unsigned long)m.rttAvgUs,
+                      (unsigned long)m.rttMinUs, (unsigned long)m.rttMaxUs);
+        break;
+      }
+      case 'M': mqttBenchmark(200); break;
+#endif
+#if ENABLE_HEAP_GUARD
+      case 'h': {
+        HeapGuardStats h = heapGuardGetStats();
+        Serial.printf("[HEAP] free=%lu min=%lu largest=%lu frag=%u%% (max %u%%) "
+                      "blocks%+ld (max %+ld) violations=%lu fails=%lu last=%luB\n",
+                      (unsigned long)h.freeBytes, (unsigned long)h.minFreeBytes,
+                      (unsigned long)h.largestBlock, h.fragPct, h.maxFragPct,
+                      (long)h.blockDelta, (long)h.maxBlockDelta,
+                      (unsigned long)h.violations, (unsigned long)h.allocFailures,
+                      (unsigned long)h.lastFailSize);
+        break;
+      }
+#endif
+      case '?':
+        Serial.println("Commands: p=profile r=reset-profile b=binary-stream "
+                       "t=text-telemetry l=log-stats w=wifi g=gsm G=geo f=geofence o=odometer O=trip-reset e=range "
+                       "x=blackbox X=blackbox-dump y=history Y=history-hour H=rollups s=snapshot "
+                       "z=park Z=park-stats a=sampler A=burst i=inrush I=inrush-reset k=relays c=charge "
+                       "q=offline-queue "
+                       "m=mqtt-stats M=mqtt-bench h=heap ?=help");
+        break;
+      default: break;   // ignore CR/LF and unknown keys
+    }
+  }
+}
@@ -31,10 +31,14 @@ void checkExternalEvents();
 
 /**
  * controlCharging – manages charge relay with motor interlock.
+ * With ENABLE_CHARGE_CONTROL the CC/CV phase machine (charge.h)
+ * decides; otherwise bang-bang at CHARGE_START_V / CHARGE_STOP_V.
  * @param packVoltage  Current pack voltage
+ * @param currentA     Signed current (+ = discharge, − = charge)
+ * @param temperature  Pack temperature (derating)
  * @param fault        True = immediately disable charging
  */
-void controlCharging(float packVoltage, bool fault);
+void controlCharging(float packVoltage, float currentA, float temperature, bool fault);
 
 /**
  * controlMotorRelay – motor ON only when not faulted AND current is NOT
@@ -71,6 +75,16 @@ void uploadSystemData(float packVoltage,
                       float soc,
                       bool  fault);
 
+/**
+ * recordBlackbox – call every loop (ENABLE_BLACKBOX).
+ * Packs the loop's readings, accel and relay state into one
+ * black-box sample.
+ */
+void recordBlackbox(float packVoltage,
+                    const CurrentData& iData,
+                    float temperature,
+                    float soc);
+
 /**
  * monitorChargingCurrent – call every loop with live current.
  * Sends alerts based purely on actual current flow:
@@ -79,7 +93,19 @@ void uploadSystemData(float packVoltage,
  */
 void monitorChargingCurrent(float currentA, float packVoltage);
 
+/**
+ * handleSerialCommands – call every loop.
+ * Non-blocking single-character console on the USB serial port:
+ *   p  loop profiler report      r  reset profiler
+ *   b  binary stream on/off      t  text telemetry on/off
+ *   ?  help
+ */
+void handleSerialCommands();
+
 /* ── Accessors ── */
 bool isChargingActive();
 bool isFanActive();
 bool isThermalTripped();
+
+/** Charge-armed / fan / motor state carried across deep sleep (parking.cpp). */
+void restoreRelayState(bool chargeArmed, bool fanOn, bool motorOn);
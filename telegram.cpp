@@ -1,6 +1,7 @@
 #include "telegram.h"
 #include "config.h"
-#include <WiFi.h>
+#include "logger.h"
+#include "wifi_manager.h"
 #include <HTTPClient.h>
 #include <NetworkClientSecure.h>   // ESP32 core 3.x (replaces WiFiClientSecure)
 
@@ -9,6 +10,30 @@ static unsigned long lastTelegramTime = 0;
 static bool          neverSent        = true;  // first message always bypasses cooldown
 
 #define TELEGRAM_COOLDOWN_MS  30000UL   // 30 s minimum between messages
+#define TELEGRAM_MAX_PAYLOAD  1024       // escaped message + JSON wrapper
+#define TELEGRAM_HOLD_SLOTS   4          // messages held through an outage
+#define TELEGRAM_RETRY_MS     5000UL     // first retry after a failed POST …
+#define TELEGRAM_RETRY_MAX_MS 300000UL   // … doubling up to this
+
+/* Built once – no per-send String concatenation */
+static char sendUrl[128];
+static char payload[TELEGRAM_MAX_PAYLOAD];
+
+/* Messages not delivered yet – raised while the link was down, or whose
+   POST failed – oldest first.  The head is only popped after a 2xx.
+   A full queue gives up its oldest non-critical entry, so a fault latch
+   is never pushed out by a geofence or shock repeat. */
+struct HeldMessage {
+  char text[384];
+  bool critical;                         // from sendTelegramForced()
+};
+static HeldMessage held[TELEGRAM_HOLD_SLOTS];
+static uint8_t     heldHead  = 0;
+static uint8_t     heldCount = 0;
+static unsigned long retryAtMs    = 0;     // no POST of the head before this
+static unsigned long retryDelayMs = 0;     // 0 = last POST succeeded
+
+enum SendResult : uint8_t { SEND_OK, SEND_RETRY, SEND_REJECTED };
 
 /* ═══════════════════════════════════════════
    INIT
@@ -18,7 +43,7 @@ void telegramInit() {
   if (initialized) return;
 
   if (!TELEGRAM_BOT_TOKEN[0] || !TELEGRAM_CHAT_ID[0]) {
-    Serial.println("[TELEGRAM] ERROR: Token or Chat ID missing in config.h");
+    LOGE("TELEGRAM", "ERROR: Token or Chat ID missing in config.h");
     return;
   }
 
@@ -27,40 +52,83 @@ void telegramInit() {
   lastTelegramTime = 0;
   neverSent        = true;
 
+  snprintf(sendUrl, sizeof(sendUrl),
+           "https://api.telegram.org/bot%s/sendMessage", TELEGRAM_BOT_TOKEN);
+
   initialized = true;
-  Serial.println("[TELEGRAM] Ready");
+  LOGI("TELEGRAM", "Ready");
 }
 
 /* ═══════════════════════════════════════════
-   INTERNAL SEND  (shared by both public functions)
+   JSON ESCAPE
    ═══════════════════════════════════════════ */
 
-static bool doSend(const String& message) {
-  /* Wait up to 5 s for WiFi (handles messages sent right after boot) */
-  unsigned long wifiWait = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - wifiWait < 5000) {
-    delay(200);
+size_t telegramEscapeJson(const char* in, char* out, size_t outSize) {
+  if (!outSize) return 0;
+  size_t o = 0;
+  for (; *in; in++) {
+    char c = *in;
+    if (c == '\r') continue;
+    const char* esc = (c == '\\') ? "\\\\"
+                    : (c == '"')  ? "\\\""
+                    : (c == '\n') ? "\\n" : nullptr;
+    size_t need = esc ? 2 : 1;
+    if (o + need >= outSize) break;          // truncate, never split an escape
+    if (esc) { out[o++] = esc[0]; out[o++] = esc[1]; }
+    else     { out[o++] = c; }
   }
+  out[o] = '\0';
+  return o;
+}
 
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("[TELEGRAM] WiFi not connected – skipped");
-    return false;
+/* ═══════════════════════════════════════════
+   INTERNAL SEND  (shared by both public functions)
+   ═══════════════════════════════════════════ */
+
+static void hold(const char* message, bool critical) {
+  if (heldCount == TELEGRAM_HOLD_SLOTS) {
+    /* Evict the oldest non-critical entry; only a critical message may
+       displace a critical one (the oldest). */
+    uint8_t victim = TELEGRAM_HOLD_SLOTS;
+    for (uint8_t i = 0; i < heldCount && victim == TELEGRAM_HOLD_SLOTS; i++)
+      if (!held[(heldHead + i) % TELEGRAM_HOLD_SLOTS].critical) victim = i;
+    if (victim == TELEGRAM_HOLD_SLOTS) {
+      if (!critical) {
+        LOGW("TELEGRAM", "Hold queue full of critical alerts – dropped");
+        return;
+      }
+      victim = 0;
+    }
+    LOGW("TELEGRAM", "Hold queue full – dropped: %.40s",
+         held[(heldHead + victim) % TELEGRAM_HOLD_SLOTS].text);
+    for (uint8_t i = victim; i + 1 < heldCount; i++)
+      held[(heldHead + i) % TELEGRAM_HOLD_SLOTS] = held[(heldHead + i + 1) % TELEGRAM_HOLD_SLOTS];
+    heldCount--;
   }
 
-  String url = String("https://api.telegram.org/bot") +
-               TELEGRAM_BOT_TOKEN + "/sendMessage";
+  HeldMessage& m = held[(heldHead + heldCount) % TELEGRAM_HOLD_SLOTS];
+  strncpy(m.text, message, sizeof(m.text) - 1);
+  m.text[sizeof(m.text) - 1] = '\0';
+  m.critical = critical;
+  heldCount++;
+  LOGI("TELEGRAM", "Held for retry (%u queued)", heldCount);
+}
 
-  /* Escape characters that break JSON */
-  String escaped = message;
-  escaped.replace("\\", "\\\\");
-  escaped.replace("\"", "\\\"");
-  escaped.replace("\n", "\\n");
-  escaped.replace("\r", "");
+static void backoff() {
+  retryDelayMs = retryDelayMs ? min(retryDelayMs * 2, TELEGRAM_RETRY_MAX_MS) : TELEGRAM_RETRY_MS;
+  retryAtMs    = millis() + retryDelayMs;
+}
 
+/* One blocking HTTPS POST.  4xx other than 429 is the API refusing this
+   message (bad chat id, too long) – retrying it would only wedge the queue. */
+static SendResult post(const char* message) {
   /* Plain text – NO parse_mode (avoids Markdown/HTML rejection) */
-  String payload =
-    "{\"chat_id\":\"" + String(TELEGRAM_CHAT_ID) + "\","
-    "\"text\":\""    + escaped + "\"}";
+  int n = snprintf(payload, sizeof(payload),
+                   "{\"chat_id\":\"%s\",\"text\":\"", TELEGRAM_CHAT_ID);
+  size_t len = (size_t)n;
+  len += telegramEscapeJson(message, &payload[len], sizeof(payload) - len - 2);
+  payload[len++] = '"';
+  payload[len++] = '}';
 
   NetworkClientSecure client;
   client.setInsecure();
@@ -69,49 +137,73 @@ static bool doSend(const String& message) {
   HTTPClient http;
   http.setTimeout(8000);
 
-  if (!http.begin(client, url)) {
-    Serial.println("[TELEGRAM] http.begin failed");
-    return false;
+  if (!http.begin(client, sendUrl)) {
+    LOGE("TELEGRAM", "http.begin failed");
+    return SEND_RETRY;
   }
 
   http.addHeader("Content-Type", "application/json");
 
-  int    code     = http.POST(payload);
-  String response = http.getString();
-  http.end();
+  int code = http.POST((uint8_t*)payload, len);
 
   if (code >= 200 && code < 300) {
+    http.end();
     lastTelegramTime = millis();
     neverSent        = false;
-    Serial.println("[TELEGRAM] Alert sent OK");
-    return true;
+    retryDelayMs     = 0;
+    LOGI("TELEGRAM", "Alert sent OK");
+    return SEND_OK;
   }
 
-  Serial.printf("[TELEGRAM] Failed  HTTP=%d  body=%s\n", code, response.c_str());
-  return false;
+  /* Error body (first bytes only) into a stack buffer, not a String */
+  char   response[96] = "";
+  Stream* body        = (code > 0) ? http.getStreamPtr() : nullptr;
+  if (body) {
+    size_t got = body->readBytes(response, sizeof(response) - 1);
+    response[got] = '\0';
+  }
+  http.end();
+
+  LOGE("TELEGRAM", "Failed  HTTP=%d  body=%s", code, response);
+  return (code >= 400 && code < 500 && code != 429) ? SEND_REJECTED : SEND_RETRY;
+}
+
+static bool doSend(const char* message, bool critical) {
+  /* No waiting: with the link down, or older messages still queued
+     (they go first), hold it for telegramService()                 */
+  if (!wifiConnected() || heldCount) {
+    hold(message, critical);
+    return false;
+  }
+  SendResult r = post(message);
+  if (r == SEND_RETRY) {
+    hold(message, critical);
+    backoff();
+  }
+  return r == SEND_OK;
 }
 
 /* ═══════════════════════════════════════════
    PUBLIC – NORMAL SEND  (respects cooldown)
    ═══════════════════════════════════════════ */
 
-bool sendTelegramAlert(const String& message) {
+bool sendTelegramAlert(const char* message) {
   if (!initialized) telegramInit();
   if (!initialized) return false;
 
   /* First message ever: always send regardless of cooldown */
   if (neverSent) {
-    Serial.println("[TELEGRAM] First message – bypassing cooldown");
-    return doSend(message);
+    LOGD("TELEGRAM", "First message – bypassing cooldown");
+    return doSend(message, false);
   }
 
   if ((millis() - lastTelegramTime) < TELEGRAM_COOLDOWN_MS) {
-    Serial.printf("[TELEGRAM] Cooldown (%lus left) – skipped\n",
-                  (TELEGRAM_COOLDOWN_MS - (millis() - lastTelegramTime)) / 1000);
+    LOGD("TELEGRAM", "Cooldown (%lus left) – skipped",
+         (TELEGRAM_COOLDOWN_MS - (millis() - lastTelegramTime)) / 1000);
     return false;
   }
 
-  return doSend(message);
+  return doSend(message, false);
 }
 
 /* ═══════════════════════════════════════════
@@ -120,10 +212,27 @@ bool sendTelegramAlert(const String& message) {
      boot alert, fault latch, thermal trip, charging start/stop
    ═══════════════════════════════════════════ */
 
-bool sendTelegramForced(const String& message) {
+bool sendTelegramForced(const char* message) {
   if (!initialized) telegramInit();
   if (!initialized) return false;
 
-  Serial.println("[TELEGRAM] Forced send – ignoring cooldown");
-  return doSend(message);
+  LOGD("TELEGRAM", "Forced send – ignoring cooldown");
+  return doSend(message, true);
+}
+
+/* ═══════════════════════════════════════════
+   PUBLIC – SERVICE  (held messages on link-up)
+   ═══════════════════════════════════════════ */
+
+void telegramService() {
+  if (!heldCount || !wifiConnected()) return;
+  if ((long)(millis() - retryAtMs) < 0) return;
+
+  /* One per call: each send is a blocking HTTPS POST.  The head stays
+     queued until the API accepted it.                                */
+  SendResult r = post(held[heldHead].text);
+  if (r == SEND_RETRY) { backoff(); return; }
+  if (r == SEND_REJECTED) LOGW("TELEGRAM", "Rejected – dropped: %.40s", held[heldHead].text);
+  heldHead  = (heldHead + 1) % TELEGRAM_HOLD_SLOTS;
+  heldCount--;
 }
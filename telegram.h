@@ -5,16 +5,34 @@
 /** Call once in setup() before any send calls. */
 void telegramInit();
 
+/**
+ * Escape a message for embedding in a JSON string literal
+ * (backslash, quote, newline; CR dropped) into a caller buffer.
+ * Truncates to fit; the result is always NUL-terminated.
+ * @return Escaped length
+ */
+size_t telegramEscapeJson(const char* message, char* out, size_t outSize);
+
 /**
  * Send alert – respects 30 s cooldown.
  * Use for repeating conditions (geofence, shock, free fall).
  * The very first call ever always goes through regardless of cooldown.
  */
-bool sendTelegramAlert(const String& message);
+bool sendTelegramAlert(const char* message);
 
 /**
  * Send alert – BYPASSES cooldown entirely.
  * Use for critical one-time events that must never be dropped:
  *   boot, fault latch, charging start/stop, thermal trip/clear.
  */
-bool sendTelegramForced(const String& message);
+bool sendTelegramForced(const char* message);
+
+/**
+ * Call every loop.  Sends attempted while WiFi was down, or whose
+ * POST failed (TLS / HTTP error), are held (up to 4, oldest first;
+ * a full queue drops its oldest non-forced message) and go out here
+ * one per call, retried with a doubling backoff (5 s … 5 min).  A
+ * message leaves the queue on a 2xx, or when the API rejects it
+ * outright (4xx other than 429).
+ */
+void telegramService();
@@ -0,0 +1,190 @@
+#include "telemetry_codec.h"
+#include "config.h"
+#include <math.h>
+#include <string.h>
+
+/* ================= CBOR Writer ================= */
+
+#define CBOR_MAJOR_UINT   0x00
+#define CBOR_MAJOR_NINT   0x20
+#define CBOR_MAJOR_TEXT   0x60
+#define CBOR_MAJOR_ARRAY  0x80
+#define CBOR_NULL         0xF6
+#define CBOR_BREAK        0xFF
+#define CBOR_INDEF        0x1F
+
+bool cborFlush(CborWriter& w) {
+  if (w.staged && w.ok) {
+    if (w.sink(w.ctx, w.stage, w.staged) != w.staged) w.ok = false;
+  }
+  w.staged = 0;
+  return w.ok;
+}
+
+static void put(CborWriter& w, const uint8_t* data, size_t len) {
+  w.total += len;
+  while (len) {
+    if (w.staged == sizeof(w.stage)) cborFlush(w);
+    size_t n = sizeof(w.stage) - w.staged;
+    if (n > len) n = len;
+    memcpy(&w.stage[w.staged], data, n);
+    w.staged += n;
+    data     += n;
+    len      -= n;
+  }
+}
+
+static void putHead(CborWriter& w, uint8_t major, uint64_t v) {
+  uint8_t b[9];
+  size_t  n;
+  if (v < 24) {
+    b[0] = major | (uint8_t)v;                                 n = 1;
+  } else if (v <= 0xFF) {
+    b[0] = major | 24;  b[1] = (uint8_t)v;                     n = 2;
+  } else if (v <= 0xFFFF) {
+    b[0] = major | 25;  b[1] = v >> 8;  b[2] = (uint8_t)v;     n = 3;
+  } else if (v <= 0xFFFFFFFFULL) {
+    b[0] = major | 26;
+    for (int i = 0; i < 4; i++) b[1 + i] = (uint8_t)(v >> (24 - 8 * i));
+    n = 5;
+  } else {
+    b[0] = major | 27;
+    for (int i = 0; i < 8; i++) b[1 + i] = (uint8_t)(v >> (56 - 8 * i));
+    n = 9;
+  }
+  put(w, b, n);
+}
+
+void cborBegin(CborWriter& w, CborSink sink, void* ctx) {
+  w.sink   = sink;
+  w.ctx    = ctx;
+  w.staged = 0;
+  w.total  = 0;
+  w.ok     = true;
+}
+
+void cborUint(CborWriter& w, uint64_t v) { putHead(w, CBOR_MAJOR_UINT, v); }
+
+void cborInt(CborWriter& w, int64_t v) {
+  if (v >= 0) putHead(w, CBOR_MAJOR_UINT, (uint64_t)v);
+  else        putHead(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - v));
+}
+
+void cborText(CborWriter& w, const char* s) {
+  size_t len = strlen(s);
+  putHead(w, CBOR_MAJOR_TEXT, len);
+  put(w, (const uint8_t*)s, len);
+}
+
+void cborNull(CborWriter& w)                  { uint8_t b = CBOR_NULL;  put(w, &b, 1); }
+void cborArray(CborWriter& w, uint32_t count) { putHead(w, CBOR_MAJOR_ARRAY, count); }
+void cborArrayIndef(CborWriter& w)            { uint8_t b = CBOR_MAJOR_ARRAY | CBOR_INDEF; put(w, &b, 1); }
+void cborBreak(CborWriter& w)                 { uint8_t b = CBOR_BREAK; put(w, &b, 1); }
+
+/* ================= Sinks ================= */
+
+size_t cborSinkBuffer(void* ctx, const uint8_t* data, size_t len) {
+  CborBufferSink* s = (CborBufferSink*)ctx;
+  if (s->len + len > s->cap) return 0;
+  memcpy(&s->buf[s->len], data, len);
+  s->len += len;
+  return len;
+}
+
+size_t cborSinkPrint(void* ctx, const uint8_t* data, size_t len) {
+  return ((Print*)ctx)->write(data, len);
+}
+
+size_t cborSinkCount(void*, const uint8_t*, size_t len) {
+  return len;
+}
+
+/* ================= Quantisation ================= */
+
+static int64_t q(float v, float scale) {
+  return lroundf(v * scale);
+}
+
+static void quantise(const TelemetrySnapshot& s, int64_t* v) {
+  v[TCODEC_FIELD_UPTIME_MS]    = s.uptimeMs;
+  v[TCODEC_FIELD_PACK_MV]      = q(s.packVoltage, 1000.0f);
+  v[TCODEC_FIELD_CURRENT_CA]   = q(s.current,      100.0f);
+  v[TCODEC_FIELD_POWER_DW]     = q(s.power,         10.0f);
+  v[TCODEC_FIELD_TEMP_DC]      = q(s.tempPack,      10.0f);
+  v[TCODEC_FIELD_SOC_CENTI]    = q(s.soc,          100.0f);
+  v[TCODEC_FIELD_SOH_CENTI]    = q(s.soh,          100.0f);
+  v[TCODEC_FIELD_RUL_CYCLES]   = s.rulCycles;
+  v[TCODEC_FIELD_LAT_E6]       = llround((double)s.latitude  * 1e6);
+  v[TCODEC_FIELD_LON_E6]       = llround((double)s.longitude * 1e6);
+  v[TCODEC_FIELD_IMPACTS]      = s.impactCount;
+  v[TCODEC_FIELD_SHOCKS]       = s.shockCount;
+  v[TCODEC_FIELD_CONN_QUALITY] = s.connectionQuality;
+
+  int64_t flags = 0;
+  if (s.fault)          flags |= TCODEC_FLAG_FAULT;
+  if (s.chargingActive) flags |= TCODEC_FLAG_CHARGING;
+  if (s.fanActive)      flags |= TCODEC_FLAG_FAN;
+  if (s.chargerRelay)   flags |= TCODEC_FLAG_CHARGE_RELAY;
+  if (s.motorRelay)     flags |= TCODEC_FLAG_MOTOR_RELAY;
+  v[TCODEC_FIELD_FLAGS]        = flags;
+
+  v[TCODEC_FIELD_LOOP_P50_US]  = s.loopP50Us;
+  v[TCODEC_FIELD_LOOP_P99_US]  = s.loopP99Us;
+  v[TCODEC_FIELD_LOOP_MAX_US]  = s.loopMaxUs;
+  v[TCODEC_FIELD_LOOP_MISS]    = s.loopDeadlineMiss;
+  v[TCODEC_FIELD_WH_PER_KM_DC] = q(s.whPerKm,       10.0f);
+  v[TCODEC_FIELD_RANGE_HM]     = q(s.rangeKm,       10.0f);
+  v[TCODEC_FIELD_RANGE_LO_HM]  = q(s.rangeLoKm,     10.0f);
+  v[TCODEC_FIELD_RANGE_HI_HM]  = q(s.rangeHiKm,     10.0f);
+  v[TCODEC_FIELD_CHARGE_PHASE] = s.chargePhase;
+  v[TCODEC_FIELD_CHARGE_ETA_MIN] = s.chargeEtaMin < 0.0f ? -1 : q(s.chargeEtaMin, 1.0f);
+}
+
+/* ================= Batch Encoder ================= */
+
+void telemetryEncodeBegin(TelemetryEncoder& enc, CborWriter& w) {
+  enc.w        = &w;
+  enc.sinceKey = 0;
+  enc.samples  = 0;
+  enc.prevMsg[0] = '\0';
+
+  cborArrayIndef(w);
+  cborArray(w, 4);
+  cborText(w, "bms-tlm");
+  cborUint(w, TCODEC_SCHEMA_VERSION);
+  cborText(w, DEVICE_ID);
+  cborUint(w, TCODEC_FIELD_COUNT);
+}
+
+void telemetryEncodeSample(TelemetryEncoder& enc, const TelemetrySnapshot& s) {
+  CborWriter& w = *enc.w;
+
+  int64_t v[TCODEC_FIELD_COUNT];
+  quantise(s, v);
+
+  bool key = (enc.samples == 0) || (enc.sinceKey >= TCODEC_KEYFRAME_INTERVAL);
+
+  cborArray(w, TCODEC_FIELD_COUNT + 2);
+  cborUint(w, key ? 0 : 1);
+
+  for (uint8_t i = 0; i < TCODEC_FIELD_COUNT; i++) {
+    cborInt(w, key ? v[i] : v[i] - enc.prev[i]);
+    enc.prev[i] = v[i];
+  }
+
+  if (key || strncmp(s.faultMessage, enc.prevMsg, sizeof(enc.prevMsg)) != 0) {
+    strncpy(enc.prevMsg, s.faultMessage, sizeof(enc.prevMsg) - 1);
+    enc.prevMsg[sizeof(enc.prevMsg) - 1] = '\0';
+    cborText(w, enc.prevMsg);
+  } else {
+    cborNull(w);
+  }
+
+  enc.sinceKey = key ? 1 : enc.sinceKey + 1;
+  enc.samples++;
+}
+
+bool telemetryEncodeEnd(TelemetryEncoder& enc) {
+  cborBreak(*enc.w);
+  return cborFlush(*enc.w);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <Arduino.h>
+#include "wifi_cloud.h"
+
+/*
+ * ============================================================
+ *  Compact Telemetry Codec  (CBOR, delta + varint)
+ *  Alternative to the snprintf JSON row for batched uploads.
+ *  Each sample is quantised to integers; the first sample of a
+ *  batch (and every TCODEC_KEYFRAME_INTERVAL-th) is absolute, the
+ *  rest are differences to the previous sample.  CBOR integers are
+ *  varints, so a slowly changing field costs one byte.
+ *
+ *  Batch (RFC 8949):
+ *    [_  ["bms-tlm", version, device_id, field_count],
+ *        [0, v0 … v23, msg],        0 = keyframe, values absolute
+ *        [1, d0 … d23, msg|null],   1 = delta, msg null if unchanged
+ *        …  ]                       indefinite-length outer array
+ *
+ *  Field order / scaling: TCODEC_FIELD_* below.
+ *  Reference decoder: tools/telemetry_cbor_decode.py
+ *
+ *  The writer never allocates: bytes go through a 64-byte staging
+ *  buffer to a sink (RAM buffer, Print/socket, byte counter).
+ * ============================================================
+ */
+
+#define TCODEC_SCHEMA_VERSION     3
+#define TCODEC_KEYFRAME_INTERVAL  32
+#define TCODEC_MAX_SAMPLE_BYTES   290   // worst case: every field 9 bytes + 63-char msg
+
+/* Quantised fields, in wire order */
+enum : uint8_t {
+  TCODEC_FIELD_UPTIME_MS = 0,
+  TCODEC_FIELD_PACK_MV,          // 1 mV
+  TCODEC_FIELD_CURRENT_CA,       // 0.01 A, + = discharge
+  TCODEC_FIELD_POWER_DW,         // 0.1 W
+  TCODEC_FIELD_TEMP_DC,          // 0.1 °C
+  TCODEC_FIELD_SOC_CENTI,        // 0.01 %
+  TCODEC_FIELD_SOH_CENTI,        // 0.01 %
+  TCODEC_FIELD_RUL_CYCLES,
+  TCODEC_FIELD_LAT_E6,           // 1e-6 deg
+  TCODEC_FIELD_LON_E6,           // 1e-6 deg
+  TCODEC_FIELD_IMPACTS,
+  TCODEC_FIELD_SHOCKS,
+  TCODEC_FIELD_CONN_QUALITY,
+  TCODEC_FIELD_FLAGS,            // TCODEC_FLAG_*
+  TCODEC_FIELD_LOOP_P50_US,
+  TCODEC_FIELD_LOOP_P99_US,
+  TCODEC_FIELD_LOOP_MAX_US,
+  TCODEC_FIELD_LOOP_MISS,
+  TCODEC_FIELD_WH_PER_KM_DC,     // 0.1 Wh/km       (v2)
+  TCODEC_FIELD_RANGE_HM,         // 0.1 km
+  TCODEC_FIELD_RANGE_LO_HM,      // 0.1 km
+  TCODEC_FIELD_RANGE_HI_HM,      // 0.1 km
+  TCODEC_FIELD_CHARGE_PHASE,     // ChargePhase     (v3)
+  TCODEC_FIELD_CHARGE_ETA_MIN,   // 1 min, -1 = unknown
+  TCODEC_FIELD_COUNT
+};
+
+#define TCODEC_FLAG_FAULT         (1u << 0)
+#define TCODEC_FLAG_CHARGING      (1u << 1)
+#define TCODEC_FLAG_FAN           (1u << 2)
+#define TCODEC_FLAG_CHARGE_RELAY  (1u << 3)
+#define TCODEC_FLAG_MOTOR_RELAY   (1u << 4)
+
+/* ──────────────────────────────────────────────────────────
+   STREAMING CBOR WRITER
+   ────────────────────────────────────────────────────────── */
+
+/** Sink: consume `len` bytes, return how many were accepted. */
+typedef size_t (*CborSink)(void* ctx, const uint8_t* data, size_t len);
+
+struct CborWriter {
+  CborSink sink;
+  void*    ctx;
+  uint8_t  stage[64];
+  uint8_t  staged;
+  size_t   total;      // bytes emitted so far (incl. staged)
+  bool     ok;         // false once the sink refused bytes
+};
+
+void cborBegin(CborWriter& w, CborSink sink, void* ctx);
+void cborUint(CborWriter& w, uint64_t v);
+void cborInt(CborWriter& w, int64_t v);
+void cborText(CborWriter& w, const char* s);
+void cborNull(CborWriter& w);
+void cborArray(CborWriter& w, uint32_t count);
+void cborArrayIndef(CborWriter& w);
+void cborBreak(CborWriter& w);
+/** Push staged bytes to the sink. @return w.ok */
+bool cborFlush(CborWriter& w);
+
+/* Ready-made sinks */
+struct CborBufferSink {
+  uint8_t* buf;
+  size_t   cap;
+  size_t   len;
+};
+size_t cborSinkBuffer(void* ctx, const uint8_t* data, size_t len);  // ctx = CborBufferSink*
+size_t cborSinkPrint(void* ctx, const uint8_t* data, size_t len);   // ctx = Print* (socket, Serial)
+size_t cborSinkCount(void* ctx, const uint8_t* data, size_t len);   // ctx = nullptr, sizing pass
+
+/* ──────────────────────────────────────────────────────────
+   TELEMETRY BATCH ENCODER
+   ────────────────────────────────────────────────────────── */
+
+struct TelemetryEncoder {
+  CborWriter* w;
+  int64_t     prev[TCODEC_FIELD_COUNT];
+  char        prevMsg[64];
+  uint16_t    sinceKey;
+  uint16_t    samples;
+};
+
+/** Open a batch: writes the outer array and header. */
+void telemetryEncodeBegin(TelemetryEncoder& enc, CborWriter& w);
+
+/** Append one sample (keyframe or delta). */
+void telemetryEncodeSample(TelemetryEncoder& enc, const TelemetrySnapshot& s);
+
+/** Close the batch and flush.  @return false if the sink overflowed. */
+bool telemetryEncodeEnd(TelemetryEncoder& enc);
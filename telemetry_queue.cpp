@@ -0,0 +1,305 @@
+#include "telemetry_queue.h"
+#include "config.h"
+#include "logger.h"
+#include "telemetry_stream.h"   // crc16Ccitt
+#include <esp_partition.h>
+
+#if TQ_REPLAY_CBOR
+  #include "telemetry_codec.h"
+  #define TQ_BATCH_MAX  TQ_BATCH_RECORDS_CBOR
+#else
+  #define TQ_BATCH_MAX  TQ_BATCH_RECORDS
+#endif
+
+/* ================= Flash Format ================= */
+
+#define TQ_SECTOR_SIZE    4096
+#define TQ_PART_SUBTYPE   0x43       // partitions.csv: data, 0x43, "tlmq"
+#define TQ_RECORD_MAGIC   0x54513035UL   // "TQ05" – bump when TelemetrySnapshot changes
+#define TQ_UNACKED        0xFFFF         // ackMark as written; programmed to 0 in place on ack
+
+struct TQ_Record {
+  uint32_t          magic;
+  uint32_t          seq;
+  TelemetrySnapshot snap;
+  uint16_t          crc;               // over magic + seq + snap
+  uint16_t          ackMark;           // outside the CRC: written after the record
+};
+
+#define TQ_PER_SECTOR   (TQ_SECTOR_SIZE / sizeof(TQ_Record))   // records never straddle sectors
+
+/* ================= Private ================= */
+
+static const esp_partition_t* part = nullptr;
+static uint32_t sectors   = 0;
+static uint32_t slots     = 0;         // sectors * TQ_PER_SECTOR
+
+static uint32_t headSlot  = 0;         // next slot to write
+static uint32_t tailSlot  = 0;         // oldest unacknowledged
+static uint32_t headSeq   = 0;         // sequence of the next record
+static int32_t  eraseNext = -1;        // sector to erase before the head reaches it
+
+static TelemetryQueueStats stats = {};
+
+static unsigned long lastReplayMs   = 0;
+static unsigned long replayDelayMs  = TQ_REPLAY_INTERVAL_MS;
+
+static char batchBuf[TQ_BATCH_BUF_SIZE];
+
+static uint16_t recordCrc(const TQ_Record& r) {
+  return crc16Ccitt((const uint8_t*)&r, offsetof(TQ_Record, crc));
+}
+
+static size_t slotOffset(uint32_t slot) {
+  return (size_t)(slot / TQ_PER_SECTOR) * TQ_SECTOR_SIZE +
+         (size_t)(slot % TQ_PER_SECTOR) * sizeof(TQ_Record);
+}
+
+static uint32_t nextSlot(uint32_t slot) { return (slot + 1) % slots; }
+static uint32_t used()                  { return (headSlot + slots - tailSlot) % slots; }
+
+static bool readRecord(uint32_t slot, TQ_Record& r) {
+  return esp_partition_read(part, slotOffset(slot), &r, sizeof(r)) == ESP_OK &&
+         r.magic == TQ_RECORD_MAGIC && r.crc == recordCrc(r);
+}
+
+static bool slotBlank(uint32_t slot) {
+  uint32_t w[4];
+  if (esp_partition_read(part, slotOffset(slot), w, sizeof(w)) != ESP_OK) return false;
+  for (uint32_t v : w) if (v != 0xFFFFFFFFUL) return false;
+  return true;
+}
+
+/* ================= Sectors ================= */
+
+/* The sector after the head's is kept erased, so a push is a single
+   program and never waits on an erase.  Anything still unacknowledged
+   there is the oldest data – it is dropped and counted.             */
+static void scheduleErase(uint32_t headSector) {
+  uint32_t s = (headSector + 1) % sectors;
+  if (tailSlot / TQ_PER_SECTOR == s && used()) {
+    uint32_t lost = TQ_PER_SECTOR - tailSlot % TQ_PER_SECTOR;
+    stats.overwritten += min(lost, used());
+    tailSlot = ((s + 1) % sectors) * TQ_PER_SECTOR;
+    LOGW("TQ", "Queue full – oldest %lu records dropped", (unsigned long)lost);
+  }
+  eraseNext = (int32_t)s;
+}
+
+static void eraseNow() {
+  if (eraseNext < 0) return;
+  if (esp_partition_erase_range(part, (size_t)eraseNext * TQ_SECTOR_SIZE, TQ_SECTOR_SIZE) != ESP_OK)
+    LOGE("TQ", "Sector %ld erase failed", (long)eraseNext);
+  eraseNext = -1;
+}
+
+/* ================= Init ================= */
+
+void telemetryQueueInit() {
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                  (esp_partition_subtype_t)TQ_PART_SUBTYPE, "tlmq");
+  sectors = part ? part->size / TQ_SECTOR_SIZE : 0;
+  if (sectors < 3) {
+    LOGE("TQ", "No 'tlmq' partition – offline queue disabled");
+    part = nullptr;
+    return;
+  }
+  slots          = sectors * TQ_PER_SECTOR;
+  stats.capacity = slots - TQ_PER_SECTOR;       // one sector is always the erased spare
+
+  /* Newest record → head.  Records are written to consecutive slots in
+     sequence order, so the tail is the lowest sequence past the newest
+     acknowledgement still on flash.                                   */
+  bool     any = false, acked = false;
+  uint32_t newestSeq = 0, newestSlot = 0, ackSeq = 0;
+  TQ_Record r;
+  for (uint32_t i = 0; i < slots; i++) {
+    if (!readRecord(i, r)) continue;
+    if (!any || (int32_t)(r.seq - newestSeq) > 0) { newestSeq = r.seq; newestSlot = i; }
+    if (r.ackMark != TQ_UNACKED && (!acked || (int32_t)(r.seq - ackSeq) > 0)) {
+      ackSeq = r.seq;
+      acked  = true;
+    }
+    any = true;
+  }
+
+  headSlot = tailSlot = 0;
+  if (any) {
+    headSeq  = newestSeq + 1;
+    headSlot = nextSlot(newestSlot);
+    tailSlot = headSlot;
+    uint32_t tailSeq = headSeq;
+    for (uint32_t i = 0; i < slots; i++) {
+      if (!readRecord(i, r)) continue;
+      if (acked && (int32_t)(r.seq - ackSeq) <= 0) continue;
+      if ((int32_t)(r.seq - tailSeq) < 0) { tailSeq = r.seq; tailSlot = i; }
+    }
+    /* Past a torn write: a slot is only ever programmed erased */
+    while (headSlot % TQ_PER_SECTOR && !slotBlank(headSlot)) headSlot = nextSlot(headSlot);
+  }
+
+  /* On a sector boundary the head's sector is the spare – make sure an
+     interrupted pre-erase did not leave it dirty. */
+  if (headSlot % TQ_PER_SECTOR == 0) {
+    eraseNext = (int32_t)(headSlot / TQ_PER_SECTOR);
+    eraseNow();
+  }
+  scheduleErase(headSlot / TQ_PER_SECTOR);
+  eraseNow();
+
+  stats.depth = used();
+  LOGI("TQ", "Initialized: %lu queued (cap %lu, %u B/record)",
+       (unsigned long)stats.depth, (unsigned long)stats.capacity,
+       (unsigned)sizeof(TQ_Record));
+}
+
+/* ================= Push ================= */
+
+bool telemetryQueuePush(const TelemetrySnapshot& snap) {
+  if (!part) return false;
+
+  if (headSlot % TQ_PER_SECTOR == 0) {
+    eraseNow();                                 // service() did not get to it
+    scheduleErase(headSlot / TQ_PER_SECTOR);
+  }
+
+  TQ_Record r;
+  memset(&r, 0xFF, sizeof(r));         // padding stays erased
+  r.magic   = TQ_RECORD_MAGIC;
+  r.seq     = headSeq;
+  r.snap    = snap;
+  r.crc     = recordCrc(r);
+  r.ackMark = TQ_UNACKED;
+
+  if (esp_partition_write(part, slotOffset(headSlot), &r, sizeof(r)) != ESP_OK) {
+    LOGE("TQ", "Record write failed (seq %lu)", (unsigned long)headSeq);
+    return false;
+  }
+  headSlot = nextSlot(headSlot);
+  headSeq++;
+  stats.enqueued++;
+  stats.depth = used();
+  LOGD("TQ", "Queued seq %lu (depth %lu)",
+       (unsigned long)r.seq, (unsigned long)stats.depth);
+  return true;
+}
+
+/* ================= Replay ================= */
+
+void telemetryQueueService() {
+  if (!part) return;
+  eraseNow();                                   // ~45 ms, off the push path
+
+  if (headSlot == tailSlot) return;
+  if (!wifiConnected())     return;
+
+  unsigned long now = millis();
+  if (now - lastReplayMs < replayDelayMs) return;
+
+  /* Live sample first: stay clear of the upload slot */
+  if (now - getLastUploadTime() > CLOUD_UPLOAD_INTERVAL_MS - TQ_LIVE_GUARD_MS) return;
+
+  lastReplayMs = now;
+
+  /* Build the batch from the oldest unacknowledged records */
+  size_t   len      = 0;
+  uint32_t count    = 0;
+  uint32_t slot     = tailSlot;
+  int32_t  lastSlot = -1;                       // last record in the batch
+
+#if TQ_REPLAY_CBOR
+  CborBufferSink   sink = { (uint8_t*)batchBuf, sizeof(batchBuf), 0 };
+  CborWriter       w;
+  TelemetryEncoder enc;
+  cborBegin(w, cborSinkBuffer, &sink);
+  telemetryEncodeBegin(enc, w);
+#else
+  batchBuf[len++] = '[';
+#endif
+
+  TQ_Record r;
+  while (slot != headSlot && count < TQ_BATCH_MAX) {
+    if (!readRecord(slot, r)) {
+      /* Torn / corrupt slot – skip it rather than wedge the queue */
+      LOGW("TQ", "Bad record in slot %lu – skipped", (unsigned long)slot);
+      slot = nextSlot(slot);
+      if (count == 0) tailSlot = slot;
+      continue;
+    }
+#if TQ_REPLAY_CBOR
+    if (sizeof(batchBuf) - w.total < TCODEC_MAX_SAMPLE_BYTES + 1) break;   // + break byte
+    telemetryEncodeSample(enc, r.snap);
+#else
+    size_t sep  = count ? 1 : 0;                     // leading ','
+    size_t room = sizeof(batchBuf) - len - sep - 1;  // keep 1 for ']'
+    size_t n    = formatTelemetryJson(r.snap, &batchBuf[len + sep], room);
+    if (n == 0) {
+      if (count) break;                              // batch full
+      LOGE("TQ", "Record seq %lu does not format – skipped", (unsigned long)r.seq);
+      slot = tailSlot = nextSlot(slot);
+      continue;
+    }
+    if (count) batchBuf[len++] = ',';
+    len += n;
+#endif
+    lastSlot = (int32_t)slot;
+    count++;
+    slot = nextSlot(slot);
+  }
+
+  if (count == 0) {
+    stats.depth = used();
+    return;
+  }
+
+#if TQ_REPLAY_CBOR
+  if (!telemetryEncodeEnd(enc)) {
+    LOGE("TQ", "CBOR batch overflow");
+    return;
+  }
+  len = sink.len;
+#else
+  batchBuf[len++] = ']';
+#endif
+
+  unsigned long t0 = millis();
+#if TQ_REPLAY_CBOR
+  int code = cloudPostCbor((const uint8_t*)batchBuf, len);
+#else
+  int code = cloudPostJson(batchBuf, len);
+#endif
+  float dtS = (millis() - t0) / 1000.0f;
+
+  if (code >= 200 && code < 300) {
+    /* One 2-byte program marks everything up to here acknowledged */
+    uint16_t mark = 0;
+    esp_partition_write(part, slotOffset((uint32_t)lastSlot) + offsetof(TQ_Record, ackMark),
+                        &mark, sizeof(mark));
+    tailSlot        = nextSlot((uint32_t)lastSlot);
+    stats.replayed += count;
+    stats.depth     = used();
+    replayDelayMs   = TQ_REPLAY_INTERVAL_MS;
+
+    if (dtS > 0.0f) {
+      float recRate  = count / dtS;
+      float byteRate = len   / dtS;
+      stats.replayRecPerSec   = stats.replayRecPerSec   == 0.0f ? recRate
+                              : 0.8f * stats.replayRecPerSec   + 0.2f * recRate;
+      stats.replayBytesPerSec = stats.replayBytesPerSec == 0.0f ? byteRate
+                              : 0.8f * stats.replayBytesPerSec + 0.2f * byteRate;
+    }
+    LOGI("TQ", "Replayed %lu records (%u B, %lu ms) – %lu left",
+         (unsigned long)count, (unsigned)len, (unsigned long)(millis() - t0),
+         (unsigned long)stats.depth);
+  } else {
+    stats.failedBatches++;
+    replayDelayMs = min(replayDelayMs * 2, (unsigned long)TQ_REPLAY_MAX_BACKOFF_MS);
+    LOGW("TQ", "Replay failed (HTTP %d) – retry in %lus",
+         code, replayDelayMs / 1000);
+  }
+}
+
+/* ================= Status ================= */
+
+uint32_t            telemetryQueueDepth()    { return part ? used() : 0; }
+TelemetryQueueStats telemetryQueueGetStats() { return stats; }
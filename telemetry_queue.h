@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include "wifi_cloud.h"
+
+/*
+ * ============================================================
+ *  Offline Telemetry Queue  (store-and-forward)
+ *  Cloud samples that cannot be uploaded (WiFi down, HTTP error)
+ *  are appended to a record ring on the raw "tlmq" partition.  Once
+ *  the link is back, the backlog is replayed oldest-first as JSON
+ *  array (or CBOR) batches, paced so live uploads and alerts keep
+ *  priority.
+ *
+ *  Layout: 4 KB sectors of fixed-size TQ_Records, each with its
+ *  sequence number and a CRC.  A push is one program into erased
+ *  flash – no read-modify-write, no filesystem.  The sector ahead
+ *  of the head is kept erased (from telemetryQueueService) and is
+ *  where the oldest records are dropped when the ring is full.
+ *  An acknowledged batch is marked by clearing a 16-bit field in
+ *  its last record in place, so acks cost no erase either.
+ *
+ *  On boot one scan finds the newest record (head) and the newest
+ *  acknowledgement (tail); torn slots fail their CRC and are skipped.
+ * ============================================================
+ */
+
+struct TelemetryQueueStats {
+  uint32_t depth;            // records waiting for ack
+  uint32_t capacity;
+  uint32_t enqueued;         // since boot
+  uint32_t replayed;         // acknowledged by the cloud since boot
+  uint32_t overwritten;      // oldest records lost to a full queue
+  uint32_t failedBatches;
+  float    replayRecPerSec;  // EWMA over batch POSTs
+  float    replayBytesPerSec;
+};
+
+/** Find the partition and recover head / tail.  Call after storageInit(). */
+void telemetryQueueInit();
+
+/**
+ * Append one sample.  When the queue is full the oldest sector of
+ * records is dropped and counted.
+ * @return false if the partition is missing or the write failed
+ */
+bool telemetryQueuePush(const TelemetrySnapshot& snap);
+
+/**
+ * Call every loop.  Sends at most one batch per TQ_REPLAY_INTERVAL_MS
+ * (backing off after failures) and only while WiFi is up and no live
+ * upload is about to fall due.
+ */
+void telemetryQueueService();
+
+uint32_t            telemetryQueueDepth();
+TelemetryQueueStats telemetryQueueGetStats();
@@ -0,0 +1,159 @@
+#include "telemetry_stream.h"
+#include "config.h"
+#include "system.h"
+#include "fault_manager.h"
+#include "actuator.h"
+#include "soh.h"
+#include "rul.h"
+#include "wifi_cloud.h"
+
+/* ================= Private ================= */
+
+static bool          streamOn      = ENABLE_BINARY_TELEMETRY;
+static bool          textOn        = !ENABLE_BINARY_TELEMETRY;
+static uint16_t      seq           = 0;
+static uint32_t      framesSent    = 0;
+static uint32_t      framesDropped = 0;
+static unsigned long lastFrameMs   = 0;
+
+#define TSTREAM_MAX_PAYLOAD  64
+#define TSTREAM_PERIOD_MS    (1000UL / TELEMETRY_STREAM_HZ)
+
+/* ================= Helpers ================= */
+
+static int16_t clampI16(float v) {
+  if (v >  32767.0f) return  32767;
+  if (v < -32768.0f) return -32768;
+  return (int16_t)lroundf(v);
+}
+
+static uint16_t clampU16(float v) {
+  if (v > 65535.0f) return 65535;
+  if (v < 0.0f)     return 0;
+  return (uint16_t)lroundf(v);
+}
+
+/* ================= Framing ================= */
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (uint8_t b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+  size_t  codeIdx = 0;
+  size_t  o       = 1;
+  uint8_t code    = 1;
+
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] == 0) {
+      out[codeIdx] = code;
+      codeIdx      = o++;
+      code         = 1;
+    } else {
+      out[o++] = in[i];
+      if (++code == 0xFF) {
+        out[codeIdx] = code;
+        codeIdx      = o++;
+        code         = 1;
+      }
+    }
+  }
+  out[codeIdx] = code;
+  return o;
+}
+
+bool telemetryStreamSend(uint8_t type, const void* payload, size_t len) {
+  if (!streamOn || len > TSTREAM_MAX_PAYLOAD) return false;
+
+  /* raw = type | seq(2) | payload | crc(2) */
+  uint8_t raw[TSTREAM_MAX_PAYLOAD + 5];
+  raw[0] = type;
+  raw[1] = (uint8_t)(seq & 0xFF);
+  raw[2] = (uint8_t)(seq >> 8);
+  memcpy(&raw[3], payload, len);
+  uint16_t crc = crc16Ccitt(raw, len + 3);
+  raw[len + 3] = (uint8_t)(crc & 0xFF);
+  raw[len + 4] = (uint8_t)(crc >> 8);
+
+  /* Leading delimiter isolates any text the logger wrote in between */
+  uint8_t frame[sizeof(raw) + sizeof(raw) / 254 + 3];
+  frame[0]   = 0x00;
+  size_t n   = cobsEncode(raw, len + 5, &frame[1]) + 1;
+  frame[n++] = 0x00;
+
+  /* Never block the loop on the UART – drop instead */
+  if ((size_t)Serial.availableForWrite() < n) {
+    framesDropped++;
+    return false;
+  }
+
+  Serial.write(frame, n);
+  seq++;
+  framesSent++;
+  return true;
+}
+
+/* ================= Telemetry Frame ================= */
+
+void telemetryBuildFrame(TelemetryFrameV1& f,
+                         float packVoltage,
+                         const CurrentData& iData,
+                         float temperature,
+                         float soc,
+                         bool  fault) {
+  uint16_t flags = 0;
+  if (fault)                                flags |= TSTREAM_FLAG_FAULT;
+  if (isChargingActive())                   flags |= TSTREAM_FLAG_CHARGING;
+  if (isFanActive())                        flags |= TSTREAM_FLAG_FAN;
+  if (isThermalTripped())                   flags |= TSTREAM_FLAG_THERMAL_TRIP;
+  if (isMotorStartBlanking())               flags |= TSTREAM_FLAG_BLANKING;
+  if (actuatorState(ACT_CHARGE))            flags |= TSTREAM_FLAG_CHARGE_RELAY;
+  if (actuatorState(ACT_MOTOR))             flags |= TSTREAM_FLAG_MOTOR_RELAY;
+  if (getEdgeAnalytics().anomalyDetected)   flags |= TSTREAM_FLAG_ANOMALY;
+  if (wifiConnected())                      flags |= TSTREAM_FLAG_WIFI;
+  if (iData.overCurrent)                    flags |= TSTREAM_FLAG_OVERCURRENT;
+
+  f.uptimeMs         = millis();
+  f.packMilliVolts   = clampU16(packVoltage * 1000.0f);
+  f.currentCentiAmps = clampI16(iData.current * 100.0f);
+  f.powerDeciWatts   = clampU16(iData.powerWatts * 10.0f);
+  f.tempDeciC        = clampI16(temperature * 10.0f);
+  f.socCenti         = clampU16(soc * 100.0f);
+  f.sohCenti         = clampU16(getSOH() * 100.0f);
+  f.rulCycles        = clampU16((float)estimateRUL());
+  f.faultBitmap      = getFaultBitmap();
+  f.flags            = flags;
+  f.anomalyScore     = getEdgeAnalytics().anomalyScore;
+  f.faultSeverity    = getFaultSeverity();
+}
+
+void telemetryStreamUpdate(float packVoltage,
+                           const CurrentData& iData,
+                           float temperature,
+                           float soc,
+                           bool  fault) {
+  if (!streamOn) return;
+
+  unsigned long now = millis();
+  if (now - lastFrameMs < TSTREAM_PERIOD_MS) return;
+  lastFrameMs = now;
+
+  TelemetryFrameV1 f;
+  telemetryBuildFrame(f, packVoltage, iData, temperature, soc, fault);
+  telemetryStreamSend(TSTREAM_TYPE_TELEMETRY_V1, &f, sizeof(f));
+}
+
+/* ================= Switches / Counters ================= */
+
+void telemetryStreamEnable(bool on) { streamOn = on;   }
+bool telemetryStreamEnabled()       { return streamOn; }
+void telemetryTextEnable(bool on)   { textOn = on;     }
+bool telemetryTextEnabled()         { return textOn;   }
+
+uint32_t telemetryStreamFramesSent()    { return framesSent;    }
+uint32_t telemetryStreamFramesDropped() { return framesDropped; }
@@ -0,0 +1,98 @@
+#pragma once
+#include <Arduino.h>
+#include "current.h"
+
+/*
+ * ============================================================
+ *  Binary Serial Telemetry Stream
+ *  Full BMS state as compact COBS-framed, CRC-16 protected
+ *  records on the USB/UART0 serial port.  Frames are queued into
+ *  the UART driver's TX ring buffer (interrupt driven) and dropped
+ *  – never blocked on – when the buffer is full.
+ *
+ *  Wire format:  0x00 | COBS( type | seq | payload | crc16 ) | 0x00
+ *    type    : uint8   (TSTREAM_TYPE_*)
+ *    seq     : uint16  little-endian, wraps
+ *    payload : packed struct, little-endian
+ *    crc16   : CRC-16/CCITT-FALSE over type..payload
+ *
+ *  Decoder: tools/telemetry_decode.py → CSV / Parquet.
+ * ============================================================
+ */
+
+#define TSTREAM_TYPE_TELEMETRY_V1  0x01
+
+/* Status flag bits in TelemetryFrameV1::flags */
+#define TSTREAM_FLAG_FAULT          (1u << 0)
+#define TSTREAM_FLAG_CHARGING       (1u << 1)
+#define TSTREAM_FLAG_FAN            (1u << 2)
+#define TSTREAM_FLAG_THERMAL_TRIP   (1u << 3)
+#define TSTREAM_FLAG_BLANKING       (1u << 4)
+#define TSTREAM_FLAG_CHARGE_RELAY   (1u << 5)
+#define TSTREAM_FLAG_MOTOR_RELAY    (1u << 6)
+#define TSTREAM_FLAG_ANOMALY        (1u << 7)
+#define TSTREAM_FLAG_WIFI           (1u << 8)
+#define TSTREAM_FLAG_OVERCURRENT    (1u << 9)
+
+struct __attribute__((packed)) TelemetryFrameV1 {
+  uint32_t uptimeMs;
+  uint16_t packMilliVolts;
+  int16_t  currentCentiAmps;   // 0.01 A, + = discharge
+  uint16_t powerDeciWatts;     // 0.1 W
+  int16_t  tempDeciC;          // 0.1 °C
+  uint16_t socCenti;           // 0.01 %
+  uint16_t sohCenti;           // 0.01 %
+  uint16_t rulCycles;
+  uint32_t faultBitmap;        // 1 << FaultType
+  uint16_t flags;              // TSTREAM_FLAG_*
+  uint8_t  anomalyScore;
+  uint8_t  faultSeverity;
+};
+
+/* ──────────────────────────────────────────────────────────
+   API
+   ────────────────────────────────────────────────────────── */
+
+/**
+ * Call every loop after the relay stage.  Emits one frame if the
+ * stream is on and TELEMETRY_STREAM_HZ allows it; the effective rate
+ * is capped by the loop cadence.
+ */
+void telemetryStreamUpdate(float packVoltage,
+                           const CurrentData& iData,
+                           float temperature,
+                           float soc,
+                           bool  fault);
+
+/** Fill a frame from the current state (also used by the MQTT stream). */
+void telemetryBuildFrame(TelemetryFrameV1& f,
+                         float packVoltage,
+                         const CurrentData& iData,
+                         float temperature,
+                         float soc,
+                         bool  fault);
+
+/**
+ * COBS-encode `len` bytes into `out` (needs len + len/254 + 1 bytes).
+ * @return encoded length (no delimiter)
+ */
+size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out);
+
+/** CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF). */
+uint16_t crc16Ccitt(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+/**
+ * Frame and queue an arbitrary payload of the given type.
+ * @return false if the frame was dropped (stream off / TX buffer full).
+ */
+bool telemetryStreamSend(uint8_t type, const void* payload, size_t len);
+
+/* Runtime switches (serial console 'b' / 't') */
+void telemetryStreamEnable(bool on);
+bool telemetryStreamEnabled();
+void telemetryTextEnable(bool on);
+bool telemetryTextEnabled();
+
+/* Counters */
+uint32_t telemetryStreamFramesSent();
+uint32_t telemetryStreamFramesDropped();
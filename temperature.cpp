@@ -1,7 +1,12 @@
 #include "temperature.h"
 #include "config.h"
+#include "logger.h"
 #include <DHT.h>
 
+#if ENABLE_PLANT_SIM
+  #include "plant_sim.h"
+#endif
+
 /* ================= Private ================= */
 
 static DHT           dhtPack(TEMP_PACK_PIN, DHT11);
@@ -17,10 +22,15 @@ void initTemperature() {
   if (initialized) return;
 
   dhtPack.begin();
-  delay(2000);   // DHT11 startup stabilization
+  if (esp_reset_reason() == ESP_RST_DEEPSLEEP) {
+    /* Sensor stayed powered through deep sleep (parking) – read now */
+    lastReadTime = millis() - DHT_MIN_INTERVAL_MS;
+  } else {
+    delay(2000);   // DHT11 startup stabilization
+  }
 
   initialized = true;
-  Serial.println("[TEMP] DHT11 initialized");
+  LOGI("TEMP", "DHT11 initialized");
 }
 
 /* ================= Read ================= */
@@ -28,6 +38,11 @@ void initTemperature() {
 float readPackTemperature() {
   if (!initialized) initTemperature();
 
+#if ENABLE_PLANT_SIM
+  lastTemp = plantSimTemperature();
+  return lastTemp;
+#endif
+
   if (millis() - lastReadTime < DHT_MIN_INTERVAL_MS)
     return lastTemp;
 
@@ -35,7 +50,7 @@ float readPackTemperature() {
 
   float t = dhtPack.readTemperature();
   if (isnan(t) || t < -20.0f || t > 85.0f) {
-    Serial.println("[TEMP] Invalid reading – using last value");
+    LOGW("TEMP", "Invalid reading – using last value");
     return lastTemp;
   }
 
@@ -0,0 +1,7 @@
+/* Host entry for the hot-path microbenchmarks (bench.cpp) */
+#include "bench.h"
+
+int main() {
+  runBenchmarks();
+  return 0;
+}
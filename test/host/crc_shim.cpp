@@ -0,0 +1,15 @@
+/*
+ * crc16Ccitt() for tests that link a storage module without
+ * telemetry_stream.o (which drags in the whole firmware).  Same
+ * polynomial and seed as telemetry_stream.cpp.
+ */
+#include "telemetry_stream.h"
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t len, uint16_t crc) {
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (uint8_t b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
@@ -0,0 +1,229 @@
+#include "host_arduino.h"
+#include "logger.h"
+#include <Preferences.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <map>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* ================= Globals the core provides ================= */
+
+HardwareSerial Serial(0);
+EspClass       ESP;
+TwoWire        Wire;
+WiFiClass      WiFi;
+
+bool hostVerbose          = getenv("HOST_VERBOSE") != nullptr;
+bool hostRestartRequested = false;
+int  hostChecks           = 0;
+int  hostFailures         = 0;
+
+/* ================= Clock ================= */
+
+static unsigned long long clockUs = 0;
+
+unsigned long millis()               { return (unsigned long)(clockUs / 1000ULL); }
+unsigned long micros()               { return (unsigned long)clockUs; }
+void delay(unsigned long ms)         { clockUs += ms * 1000ULL; }
+void delayMicroseconds(unsigned us)  { clockUs += us; }
+
+void hostSetMs(unsigned long ms)     { clockUs = ms * 1000ULL; }
+void hostAdvanceMs(unsigned long ms) { clockUs += ms * 1000ULL; }
+
+void EspClass::restart() { hostRestartRequested = true; }
+
+/* ================= Pins ================= */
+
+static int pinLevel[64];
+static int pinAnalog[64];
+
+void pinMode(uint8_t, uint8_t)            {}
+void digitalWrite(uint8_t pin, uint8_t v) { pinLevel[pin & 63] = v; }
+int  digitalRead(uint8_t pin)             { return pinLevel[pin & 63]; }
+int  analogRead(uint8_t pin)              { return pinAnalog[pin & 63]; }
+
+void hostSetAnalog(uint8_t pin, int v)    { pinAnalog[pin & 63] = v; }
+int  hostPinLevel(uint8_t pin)            { return pinLevel[pin & 63]; }
+
+/* ================= UARTs ================= */
+
+static HardwareSerial* uarts[3];
+
+HardwareSerial::HardwareSerial(int n) : uart(n) { if (n >= 0 && n < 3) uarts[n] = this; }
+HardwareSerial::~HardwareSerial()                { if (uart >= 0 && uart < 3) uarts[uart] = nullptr; }
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (uart == 0) fputc(c, stdout);           // console
+  else           hostTx.push_back((char)c);
+  return 1;
+}
+
+void HardwareSerial::hostInject(const char* bytes, size_t n) {
+  rx.insert(rx.end(), bytes, bytes + n);
+  if (rxCb) rxCb();                          // the driver's RX event
+}
+
+HardwareSerial* hostUart(int n) { return n >= 0 && n < 3 ? uarts[n] : nullptr; }
+
+/* ================= Preferences ================= */
+
+static std::map<std::string, std::vector<uint8_t>> nvs;
+
+bool Preferences::begin(const char* name, bool) { ns = name; return true; }
+
+size_t Preferences::putBytes(const char* key, const void* v, size_t n) {
+  nvs[ns + "/" + key].assign((const uint8_t*)v, (const uint8_t*)v + n);
+  return n;
+}
+
+size_t Preferences::getBytes(const char* key, void* v, size_t n) {
+  auto it = nvs.find(ns + "/" + key);
+  if (it == nvs.end() || it->second.size() > n) return 0;
+  memcpy(v, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = nvs.find(ns + "/" + key);
+  return it == nvs.end() ? 0 : it->second.size();
+}
+
+bool Preferences::isKey(const char* key)  { return nvs.count(ns + "/" + key) != 0; }
+bool Preferences::remove(const char* key) { return nvs.erase(ns + "/" + key) != 0; }
+
+bool Preferences::clear() {
+  for (auto it = nvs.begin(); it != nvs.end();)
+    it = it->first.compare(0, ns.size() + 1, ns + "/") == 0 ? nvs.erase(it) : std::next(it);
+  return true;
+}
+
+/* ================= Flash ================= */
+
+#define HOST_MAX_PARTITIONS  8
+
+struct HostFlashShared {                     // lives in shared memory
+  uint32_t cutBudget;                        // bytes left before power loss
+  bool     cutArmed;
+  uint32_t violations;
+  uint32_t erases;
+};
+
+static esp_partition_t  parts[HOST_MAX_PARTITIONS];
+static uint8_t*         partData[HOST_MAX_PARTITIONS];
+static int              partCount = 0;
+static HostFlashShared* flash     = nullptr;
+
+static void* sharedAlloc(size_t n) {
+  void* p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) { perror("mmap"); abort(); }
+  return p;
+}
+
+const esp_partition_t* hostAddPartition(const char* label, int subtype, uint32_t size) {
+  if (!flash) flash = (HostFlashShared*)sharedAlloc(sizeof(HostFlashShared));
+  if (partCount >= HOST_MAX_PARTITIONS) return nullptr;
+
+  esp_partition_t& p = parts[partCount];
+  p.type       = ESP_PARTITION_TYPE_DATA;
+  p.subtype    = subtype;
+  p.address    = 0x300000 + partCount * 0x100000;
+  p.size       = size;
+  p.erase_size = 4096;
+  strncpy(p.label, label, sizeof(p.label) - 1);
+
+  partData[partCount] = (uint8_t*)sharedAlloc(size);
+  memset(partData[partCount], 0xFF, size);
+  return &parts[partCount++];
+}
+
+static int partIndex(const esp_partition_t* p) {
+  for (int i = 0; i < partCount; i++) if (&parts[i] == p) return i;
+  return -1;
+}
+
+uint8_t* hostPartitionData(const esp_partition_t* p) {
+  int i = partIndex(p);
+  return i < 0 ? nullptr : partData[i];
+}
+
+void hostFlashPowerCut(uint32_t bytes) {
+  flash->cutBudget = bytes;
+  flash->cutArmed  = true;
+}
+
+uint32_t hostFlashViolations() { return flash ? flash->violations : 0; }
+uint32_t hostFlashErases()     { return flash ? flash->erases : 0; }
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label) {
+  for (int i = 0; i < partCount; i++)
+    if (parts[i].type == type && parts[i].subtype == subtype &&
+        (!label || strcmp(parts[i].label, label) == 0))
+      return &parts[i];
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t off, void* dst, size_t len) {
+  int i = partIndex(p);
+  if (i < 0 || off + len > p->size) return ESP_FAIL;
+  memcpy(dst, partData[i] + off, len);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t off, const void* src, size_t len) {
+  int i = partIndex(p);
+  if (i < 0 || off + len > p->size) return ESP_FAIL;
+  const uint8_t* s = (const uint8_t*)src;
+  for (size_t k = 0; k < len; k++) {
+    if (flash->cutArmed && flash->cutBudget-- == 0) {
+      flash->cutArmed = false;
+      fflush(stdout);
+      _exit(HOST_POWER_CUT_EXIT);
+    }
+    uint8_t& cell = partData[i][off + k];
+    if ((cell & s[k]) != s[k]) flash->violations++;
+    cell &= s[k];                            // NOR: program clears bits only
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t off, size_t len) {
+  int i = partIndex(p);
+  if (i < 0 || off % p->erase_size || len % p->erase_size || off + len > p->size) return ESP_FAIL;
+  memset(partData[i] + off, 0xFF, len);
+  flash->erases++;
+  return ESP_OK;
+}
+
+/* ================= Logger ================= */
+
+static uint32_t logCount = 0;
+
+void logInit()  {}
+void logFlush() { fflush(stderr); }
+
+void logWrite(uint8_t level, const char* tag, const char* fmt, ...) {
+  logCount++;
+  if (!hostVerbose) return;
+  static const char LEVELS[] = "-EWID";
+  va_list ap;
+  va_start(ap, fmt);
+  fprintf(stderr, "%8.3f %c [%s] ", millis() / 1000.0, LEVELS[level <= LOG_LEVEL_DEBUG ? level : 0], tag);
+  vfprintf(stderr, fmt, ap);
+  fputc('\n', stderr);
+  va_end(ap);
+}
+
+uint32_t logDroppedCount() { return 0; }
+uint32_t logWrittenCount() { return logCount; }
+uint16_t logHighWater()    { return 0; }
+
+/* ================= Results ================= */
+
+int hostReport(const char* suite) {
+  printf("%s: %d checks, %d failed\n", suite, hostChecks, hostFailures);
+  return hostFailures ? 1 : 0;
+}
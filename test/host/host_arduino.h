@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_partition.h>
+
+/*
+ * ============================================================
+ *  Host Test Harness
+ *  Controls for the shims in stubs/: the fake clock, pin levels,
+ *  the in-memory UARTs and RAM-backed NOR flash partitions, plus
+ *  the CHECK macros the host tests report with.
+ *
+ *  Flash behaves like the real part: erase sets 0xFF, a write can
+ *  only clear bits.  hostFlashPowerCut(n) lets n more bytes be
+ *  programmed and then "loses power": the write in progress is
+ *  left torn and the process exits, so a test that forks one
+ *  child per boot sees exactly what survives a real power cut.
+ * ============================================================
+ */
+
+/* ── Clock ── */
+void hostSetMs(unsigned long ms);
+void hostAdvanceMs(unsigned long ms);
+
+/* ── Pins ── */
+void hostSetAnalog(uint8_t pin, int value);
+int  hostPinLevel(uint8_t pin);
+
+/* ── UARTs ── */
+HardwareSerial* hostUart(int uart);   // nullptr if that UART was never constructed
+
+/* ── Flash ── */
+/** Add a RAM-backed partition.  Shared with forked children. */
+const esp_partition_t* hostAddPartition(const char* label, int subtype, uint32_t size);
+uint8_t*  hostPartitionData(const esp_partition_t* p);
+/** Program `bytes` more bytes, then cut power (_exit(HOST_POWER_CUT_EXIT)). */
+void      hostFlashPowerCut(uint32_t bytes);
+uint32_t  hostFlashViolations();      // writes that needed a 0 → 1 (programmed over unerased flash)
+uint32_t  hostFlashErases();
+
+#define HOST_POWER_CUT_EXIT  77
+
+/* ── Log ── */
+extern bool hostVerbose;              // LOGx lines to stderr (HOST_VERBOSE=1)
+extern bool hostRestartRequested;     // ESP.restart() was called
+
+/* ── Results ── */
+extern int hostChecks;
+extern int hostFailures;
+
+#define CHECK(cond)                                                             \
+  do {                                                                          \
+    hostChecks++;                                                               \
+    if (!(cond)) {                                                              \
+      hostFailures++;                                                           \
+      fprintf(stderr, "FAIL %s:%d  %s\n", __FILE__, __LINE__, #cond);           \
+    }                                                                           \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                   \
+  do {                                                                          \
+    hostChecks++;                                                               \
+    double _a = (a), _b = (b);                                                  \
+    if (fabs(_a - _b) > (tol)) {                                                \
+      hostFailures++;                                                           \
+      fprintf(stderr, "FAIL %s:%d  %s = %g, expected %g\n",                     \
+              __FILE__, __LINE__, #a, _a, _b);                                  \
+    }                                                                           \
+  } while (0)
+
+/** Print the summary line; use as the return value of main(). */
+int hostReport(const char* suite);
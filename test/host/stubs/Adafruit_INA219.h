@@ -0,0 +1,9 @@
+#pragma once
+class Adafruit_INA219 {
+ public:
+  bool  begin()                { return false; }
+  float getCurrent_mA()        { return 0.0f; }
+  float getPower_mW()          { return 0.0f; }
+  float getBusVoltage_V()      { return 0.0f; }
+  float getShuntVoltage_mV()   { return 0.0f; }
+};
@@ -0,0 +1,175 @@
+#pragma once
+/*
+ * Host shim for the Arduino-ESP32 core: just enough of the API for
+ * the firmware modules to compile and run on a PC.  Time is a fake
+ * clock the test drives (host_arduino.h); the UARTs are in-memory.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <deque>
+
+using std::min;
+using std::max;
+
+#define HIGH           1
+#define LOW            0
+#define INPUT          0
+#define OUTPUT         1
+#define INPUT_PULLUP   2
+#define RISING         1
+#define FALLING        2
+#define CHANGE         3
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define DRAM_ATTR
+#define SERIAL_8N1     0
+#define ADC_11db       3
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+typedef uint8_t byte;
+
+/* ── Time (host_arduino.cpp: fake clock) ── */
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/* ── GPIO / ADC (host_arduino.cpp: pin table) ── */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+int  analogRead(uint8_t pin);
+inline void analogSetPinAttenuation(uint8_t, int) {}
+inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+inline int  digitalPinToInterrupt(int pin) { return pin; }
+
+inline long random(long hi)          { return hi > 0 ? rand() % hi : 0; }
+inline long random(long lo, long hi) { return hi > lo ? lo + rand() % (hi - lo) : lo; }
+inline uint32_t esp_random()         { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+/* Setup / diagnostics only – the loop paths no longer use it */
+class String {
+ public:
+  String(const char* s = "") : str(s ? s : "") {}
+  const char* c_str() const { return str.c_str(); }
+  unsigned    length() const { return (unsigned)str.size(); }
+ private:
+  std::string str;
+};
+
+/* ── Print / Stream ── */
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    for (size_t i = 0; i < n; i++) write(buf[i]);
+    return n;
+  }
+  size_t write(const char* s)           { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s)           { return write(s); }
+  size_t print(char c)                  { return write((uint8_t)c); }
+  size_t print(int v)                   { return printf("%d", v); }
+  size_t print(float v, int d = 2)      { return printf("%.*f", d, v); }
+  size_t println(const char* s = "")    { return print(s) + print("\r\n"); }
+  size_t println(int v)                 { return print(v) + print("\r\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    return write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1));
+  }
+};
+
+class Stream : public Print {
+ public:
+  virtual int  available() { return 0; }
+  virtual int  read()      { return -1; }
+  virtual int  peek()      { return -1; }
+  void flush() {}
+  void setTimeout(unsigned long) {}
+  size_t readBytes(uint8_t* buf, size_t n) {
+    size_t i = 0;
+    for (int c; i < n && (c = read()) >= 0; i++) buf[i] = (uint8_t)c;
+    return i;
+  }
+  size_t readBytes(char* buf, size_t n) { return readBytes((uint8_t*)buf, n); }
+};
+
+/* ── UART: TX is captured, RX is fed by the test ── */
+enum hardwareSerial_error_t { UART_NO_ERROR, UART_BREAK_ERROR, UART_BUFFER_FULL_ERROR,
+                              UART_FIFO_OVF_ERROR, UART_FRAME_ERROR, UART_PARITY_ERROR };
+typedef std::function<void(void)>                   OnReceiveCb;
+typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(int uart = 0);
+  ~HardwareSerial();
+  void   begin(unsigned long, uint32_t = 0, int8_t = -1, int8_t = -1) {}
+  size_t setRxBufferSize(size_t n) { return n; }
+  size_t setTxBufferSize(size_t n) { return n; }
+  int    availableForWrite()       { return 4096; }
+  void   onReceive(OnReceiveCb cb, bool = false) { rxCb = cb; }
+  void   onReceiveError(OnReceiveErrorCb) {}
+  bool   setRxFIFOFull(uint8_t)  { return true; }
+  bool   setRxTimeout(uint8_t)   { return true; }
+  operator bool() const          { return true; }
+
+  using Print::write;
+  size_t write(uint8_t c) override;
+  int    available() override { return (int)rx.size(); }
+  int    read() override {
+    if (rx.empty()) return -1;
+    int c = (uint8_t)rx.front();
+    rx.pop_front();
+    return c;
+  }
+  int    peek() override { return rx.empty() ? -1 : (uint8_t)rx.front(); }
+
+  /* Test side */
+  void        hostInject(const char* bytes, size_t n);   // RX + onReceive event
+  std::string hostTx;                                    // everything written
+  int         uart;
+
+ private:
+  std::deque<char> rx;
+  OnReceiveCb      rxCb;
+};
+
+extern HardwareSerial Serial;
+
+/* ── Chip ── */
+class EspClass {
+ public:
+  uint32_t getFreeHeap()     { return 200000; }
+  uint32_t getMinFreeHeap()  { return 180000; }
+  uint32_t getMaxAllocHeap() { return 110000; }
+  uint32_t getHeapSize()     { return 300000; }
+  uint32_t getCycleCount()   { return (uint32_t)micros() * 240u; }
+  uint32_t getCpuFreqMHz()   { return 240; }
+  void     restart();
+};
+extern EspClass ESP;
+
+typedef enum { ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC,
+               ESP_RST_INT_WDT, ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP,
+               ESP_RST_BROWNOUT } esp_reset_reason_t;
+inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+#include "freertos/FreeRTOS.h"
@@ -0,0 +1,8 @@
+#pragma once
+#define DHT11 11
+class DHT {
+ public:
+  DHT(int, int) {}
+  void  begin() {}
+  float readTemperature() { return 25.0f; }
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+#include "NetworkClientSecure.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+
+/* Host tests script the reply: status POST returns, POSTs made */
+inline int      hostHttpCode  = HTTPC_ERROR_CONNECTION_REFUSED;
+inline unsigned hostHttpPosts = 0;
+
+class HTTPClient {
+ public:
+  bool    begin(const char*) { return true; }
+  bool    begin(NetworkClient&, const char*) { return true; }
+  void    setTimeout(uint16_t) {}
+  void    setReuse(bool) {}
+  void    addHeader(const char*, const char*) {}
+  int     POST(uint8_t*, size_t) { hostHttpPosts++; return hostHttpCode; }
+  int     POST(const char*)      { hostHttpPosts++; return hostHttpCode; }
+  void    end() {}
+  Stream* getStreamPtr() { return nullptr; }
+  int     getSize() { return -1; }
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+
+/* No network on the host: every connect fails */
+class Client : public Stream {
+ public:
+  virtual int  connect(const char*, uint16_t) { return 0; }
+  virtual bool connected() { return false; }
+  virtual void stop() {}
+  void setTimeout(uint32_t) {}
+  using Print::write;
+  size_t write(uint8_t) override { return 0; }
+  size_t write(const uint8_t*, size_t) override { return 0; }
+};
+class NetworkClient : public Client {};
+class NetworkClientSecure : public NetworkClient {
+ public:
+  void setInsecure() {}
+  void setCACert(const char*) {}
+  void setHandshakeTimeout(unsigned long) {}
+};
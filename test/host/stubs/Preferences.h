@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+/* NVS in memory (host_arduino.cpp): survives hostReboot(), not the process */
+class Preferences {
+ public:
+  bool          begin(const char* ns, bool readOnly = false);
+  void          end() {}
+  size_t        putBytes(const char* key, const void* v, size_t n);
+  size_t        getBytes(const char* key, void* v, size_t n);
+  size_t        getBytesLength(const char* key);
+  bool          isKey(const char* key);
+  bool          remove(const char* key);
+  bool          clear();
+
+  float         getFloat(const char* k, float d = 0)                 { return get(k, d); }
+  size_t        putFloat(const char* k, float v)                     { return putBytes(k, &v, sizeof(v)); }
+  double        getDouble(const char* k, double d = 0)               { return get(k, d); }
+  size_t        putDouble(const char* k, double v)                   { return putBytes(k, &v, sizeof(v)); }
+  unsigned long getULong(const char* k, unsigned long d = 0)         { return get(k, d); }
+  size_t        putULong(const char* k, unsigned long v)             { return putBytes(k, &v, sizeof(v)); }
+  uint32_t      getUInt(const char* k, uint32_t d = 0)               { return get(k, d); }
+  size_t        putUInt(const char* k, uint32_t v)                   { return putBytes(k, &v, sizeof(v)); }
+  uint8_t       getUChar(const char* k, uint8_t d = 0)               { return get(k, d); }
+  size_t        putUChar(const char* k, uint8_t v)                   { return putBytes(k, &v, sizeof(v)); }
+  bool          getBool(const char* k, bool d = false)               { return get(k, d); }
+  size_t        putBool(const char* k, bool v)                       { return putBytes(k, &v, sizeof(v)); }
+
+ private:
+  template <class T> T get(const char* k, T d) {
+    T v;
+    return getBytesLength(k) == sizeof(T) && getBytes(k, &v, sizeof(v)) == sizeof(v) ? v : d;
+  }
+  std::string ns;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+struct TinyGPSLocation { bool isValid() { return false; } bool isUpdated() { return false; } uint32_t age() { return 0xFFFFFFFF; } double lat() { return 0; } double lng() { return 0; } };
+struct TinyGPSAltitude { bool isValid() { return false; } double meters() { return 0; } };
+struct TinyGPSSpeed    { bool isValid() { return false; } bool isUpdated() { return false; } double kmph() { return 0; } double mps() { return 0; } };
+struct TinyGPSInteger  { bool isValid() { return false; } uint32_t value() { return 0; } };
+struct TinyGPSHDOP     { bool isValid() { return false; } double hdop() { return 0; } int32_t value() { return 0; } };
+struct TinyGPSCourse   { bool isValid() { return false; } double deg() { return 0; } };
+class TinyGPSPlus {
+ public:
+  bool encode(char) { return false; }
+  TinyGPSLocation location;
+  TinyGPSAltitude altitude;
+  TinyGPSSpeed    speed;
+  TinyGPSInteger  satellites;
+  TinyGPSHDOP     hdop;
+  TinyGPSCourse   course;
+  uint32_t charsProcessed()   { return 0; }
+  uint32_t sentencesWithFix() { return 0; }
+  uint32_t failedChecksum()   { return 0; }
+  uint32_t passedChecksum()   { return 0; }
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+
+#define WL_CONNECTED        3
+#define WL_DISCONNECTED     6
+#define WIFI_STA            1
+#define WIFI_OFF            0
+#define WIFI_SCAN_RUNNING   (-1)
+#define WIFI_SCAN_FAILED    (-2)
+
+typedef int wl_status_t;
+typedef int arduino_event_id_t;
+enum { ARDUINO_EVENT_WIFI_SCAN_DONE = 1, ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+       ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5, ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+       ARDUINO_EVENT_WIFI_STA_LOST_IP = 8 };
+struct wifi_event_sta_connected_t    { uint8_t ssid[32]; uint8_t ssid_len; uint8_t bssid[6]; uint8_t channel; };
+struct wifi_event_sta_disconnected_t { uint8_t reason; };
+union arduino_event_info_t {
+  wifi_event_sta_connected_t    wifi_sta_connected;
+  wifi_event_sta_disconnected_t wifi_sta_disconnected;
+};
+
+/* Radio off: no networks, never connects */
+class WiFiClass {
+ public:
+  wl_status_t status() { return WL_DISCONNECTED; }
+  void        mode(int) {}
+  void        setSleep(bool) {}
+  wl_status_t begin(const char*, const char*, int32_t = 0, const uint8_t* = nullptr, bool = true) { return WL_DISCONNECTED; }
+  bool        disconnect(bool = false, bool = false) { return true; }
+  int16_t     scanNetworks(bool = false, bool = false, bool = false, uint32_t = 300, uint8_t = 0) { return 0; }
+  int16_t     scanComplete() { return 0; }
+  void        scanDelete() {}
+  uint8_t*    BSSID(uint8_t) { static uint8_t b[6]; return b; }
+  int32_t     RSSI(uint8_t) { return -100; }
+  int32_t     RSSI() { return -100; }
+  int32_t     channel(uint8_t) { return 0; }
+  String      macAddress() { return String("00:00:00:00:00:00"); }
+  int         onEvent(std::function<void(arduino_event_id_t, arduino_event_info_t)>, arduino_event_id_t = 0) { return 0; }
+  bool        setAutoReconnect(bool) { return true; }
+  bool        persistent(bool) { return true; }
+};
+extern WiFiClass WiFi;
+
+inline void configTime(long, int, const char*, const char* = nullptr, const char* = nullptr) {}
@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+
+/* I2C: no devices on the host bus – reads return nothing */
+class TwoWire : public Stream {
+ public:
+  bool    begin(int = -1, int = -1, uint32_t = 0) { return true; }
+  void    setClock(uint32_t) {}
+  void    beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 2; }   // NACK on address
+  uint8_t requestFrom(uint8_t, uint8_t) { return 0; }
+  using Print::write;
+  size_t  write(uint8_t) override { return 1; }
+};
+extern TwoWire Wire;
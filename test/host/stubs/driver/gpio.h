@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+typedef int esp_err_t;
+typedef enum { GPIO_NUM_0 = 0, GPIO_NUM_MAX = 40 } gpio_num_t;
+typedef enum { GPIO_INTR_DISABLE, GPIO_INTR_LOW_LEVEL = 4, GPIO_INTR_HIGH_LEVEL = 5 } gpio_int_type_t;
+inline esp_err_t gpio_hold_en(gpio_num_t) { return 0; }
+inline esp_err_t gpio_hold_dis(gpio_num_t) { return 0; }
+inline void gpio_deep_sleep_hold_en() {}
+inline void gpio_deep_sleep_hold_dis() {}
+inline esp_err_t gpio_wakeup_enable(gpio_num_t, gpio_int_type_t) { return 0; }
+inline esp_err_t gpio_wakeup_disable(gpio_num_t) { return 0; }
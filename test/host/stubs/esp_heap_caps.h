@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/* No heap accounting on the host: constant figures */
+#define MALLOC_CAP_8BIT      0x4
+#define MALLOC_CAP_INTERNAL  0x800
+#define MALLOC_CAP_DEFAULT   0x1000
+
+typedef struct {
+  size_t total_free_bytes, total_allocated_bytes, largest_free_block, minimum_free_bytes,
+         allocated_blocks, free_blocks, total_blocks;
+} multi_heap_info_t;
+typedef void (*esp_alloc_failed_hook_t)(size_t, uint32_t, const char*);
+
+inline size_t heap_caps_get_free_size(uint32_t)          { return 200000; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t)  { return 200000; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 110000; }
+inline void   heap_caps_get_info(multi_heap_info_t* i, uint32_t) {
+  *i = {};
+  i->total_free_bytes = i->minimum_free_bytes = 200000;
+  i->largest_free_block = 110000;
+}
+inline int heap_caps_monitor_local_minimum_free_size_start() { return 0; }
+inline int heap_caps_monitor_local_minimum_free_size_stop()  { return 0; }
+inline int heap_caps_register_failed_alloc_callback(esp_alloc_failed_hook_t) { return 0; }
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/* Partitions are RAM-backed NOR flash (host_arduino.cpp, hostAddPartition) */
+typedef int esp_err_t;
+#define ESP_OK    0
+#define ESP_FAIL  (-1)
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0, ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t    type;
+  esp_partition_subtype_t subtype;
+  uint32_t                address;
+  uint32_t                size;
+  uint32_t                erase_size;
+  char                    label[17];
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t, esp_partition_subtype_t, const char* label);
+esp_err_t esp_partition_read(const esp_partition_t*, size_t off, void* dst, size_t len);
+esp_err_t esp_partition_write(const esp_partition_t*, size_t off, const void* src, size_t len);
+esp_err_t esp_partition_erase_range(const esp_partition_t*, size_t off, size_t len);
@@ -0,0 +1,3 @@
+#pragma once
+inline void esp_brownout_init() {}
+inline void esp_brownout_disable() {}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+typedef int esp_err_t;
+typedef void (*intr_handler_t)(void*);
+#define RTC_INTR_FLAG_IRAM  (1u << 0)
+inline uint32_t  hostRtcIsrFlags = 0;     // flags of the last registration
+inline esp_err_t rtc_isr_register(intr_handler_t, void*, uint32_t, uint32_t flags) {
+  hostRtcIsrFlags = flags;
+  return 0;
+}
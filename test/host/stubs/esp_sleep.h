@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "driver/gpio.h"
+typedef enum { ESP_SLEEP_WAKEUP_UNDEFINED, ESP_SLEEP_WAKEUP_ALL, ESP_SLEEP_WAKEUP_EXT0,
+               ESP_SLEEP_WAKEUP_EXT1, ESP_SLEEP_WAKEUP_TIMER } esp_sleep_wakeup_cause_t;
+inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t) { return 0; }
+inline esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t, int) { return 0; }
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return 0; }
+inline esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t) { return 0; }
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return ESP_SLEEP_WAKEUP_UNDEFINED; }
+inline esp_err_t esp_light_sleep_start() { return 0; }
+[[noreturn]] inline void esp_deep_sleep_start() { abort(); }
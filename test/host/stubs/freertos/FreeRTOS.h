@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+
+/* Single-threaded host: tasks are never started, locks always succeed */
+typedef void*    TaskHandle_t;
+typedef void*    QueueHandle_t;
+typedef void*    EventGroupHandle_t;
+typedef void*    SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t EventBits_t;
+
+#define pdMS_TO_TICKS(x)       (x)
+#define pdTRUE                 1
+#define pdFALSE                0
+#define pdPASS                 1
+#define portMAX_DELAY          0xFFFFFFFFu
+#define portTICK_PERIOD_MS     1
+#define configMAX_PRIORITIES   25
+
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED   { 0 }
+inline void portENTER_CRITICAL(portMUX_TYPE*)     {}
+inline void portEXIT_CRITICAL(portMUX_TYPE*)      {}
+inline void portENTER_CRITICAL_ISR(portMUX_TYPE*) {}
+inline void portEXIT_CRITICAL_ISR(portMUX_TYPE*)  {}
+#define portYIELD_FROM_ISR(x)  (void)(x)
+
+unsigned long millis();
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*,
+                                          UBaseType_t, TaskHandle_t* h, BaseType_t) {
+  if (h) *h = nullptr;
+  return pdPASS;
+}
+inline BaseType_t xTaskCreate(void (*)(void*), const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* h) {
+  if (h) *h = nullptr;
+  return pdPASS;
+}
+inline void         vTaskDelay(TickType_t) {}
+inline void         vTaskDelete(TaskHandle_t) {}
+inline TickType_t   xTaskGetTickCount() { return (TickType_t)millis(); }
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+inline uint32_t     ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline void         vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t* w) { if (w) *w = pdFALSE; }
+inline BaseType_t   xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+
+inline EventGroupHandle_t xEventGroupCreate() { static EventBits_t g; return &g; }
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t g, EventBits_t b)   { return *(EventBits_t*)g |= b; }
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t g, EventBits_t b) { EventBits_t o = *(EventBits_t*)g; *(EventBits_t*)g &= ~b; return o; }
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t g) { return *(EventBits_t*)g; }
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t g, EventBits_t, BaseType_t, BaseType_t, TickType_t) { return *(EventBits_t*)g; }
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int m; return &m; }
+inline BaseType_t        xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t        xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
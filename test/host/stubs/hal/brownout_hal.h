@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+typedef struct { int threshold; bool enabled; bool reset_enabled; bool flash_power_down; bool rf_power_down; } brownout_hal_config_t;
+inline void brownout_hal_config(const brownout_hal_config_t*) {}
+inline void brownout_hal_intr_enable(bool) {}
+inline void brownout_hal_intr_clear() {}
@@ -0,0 +1,3 @@
+#pragma once
+#include <hd44780.h>
+class hd44780_I2Cexp : public hd44780 {};
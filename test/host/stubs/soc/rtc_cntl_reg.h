@@ -0,0 +1,2 @@
+#pragma once
+#define RTC_CNTL_BROWN_OUT_INT_ENA_M (1u<<9)
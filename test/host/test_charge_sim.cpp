@@ -0,0 +1,98 @@
+/*
+ * CC/CV charge controller (charge.cpp) closed-loop against the plant
+ * simulator's "charger connect" scenario: a 15 % pack, charger plugged
+ * in at 30 s.  The loop is the firmware's: plant V / I / T in,
+ * chargeUpdate(), charge relay pin out.
+ *
+ * Built twice:
+ *   test_charge_sim      charger at CHARGE_CV_V – CC → CV → C/20,
+ *                        the ceiling never fires
+ *   test_charge_sim_420  charger at 4.20 V/cell – the relay opens at
+ *                        CHARGE_CEILING_V, one alert, no completion
+ */
+#include "host_arduino.h"
+#include "charge.h"
+#include "plant_sim.h"
+#include "config.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+#define STEP_MS      100UL
+#define LIMIT_STEPS  (21600UL * 1000UL / (unsigned long)PLANT_SIM_TIME_SCALE / STEP_MS)
+
+/* ── What charge.o reads from soc.cpp (ETA only) ── */
+
+float getSOC() { return 50.0f; }
+
+int main() {
+  uint32_t events[CHG_EV_CEILING + 1] = {};
+  float    maxV     = 0.0f;
+  bool     relayAfterCeiling = false;
+  uint32_t termAtMs = 0;                 // filtered current first at / below C/20
+  uint32_t doneAfterMs = 0;
+  unsigned long step;
+
+  /* The plant's [SIM] reports go to the console; keep them for HOST_VERBOSE */
+  fflush(stdout);
+  int console = dup(1);
+  if (!hostVerbose) dup2(open("/dev/null", O_WRONLY), 1);
+
+  hostSetMs(1000);
+  plantSimInit();
+
+  for (step = 0; step < LIMIT_STEPS; step++) {
+    hostAdvanceMs(STEP_MS);
+    float v = plantSimPackVoltage();
+    float i = plantSimCurrent();
+    float t = plantSimTemperature();
+    if (v > maxV) maxV = v;
+
+    ChargeEvent ev = chargeUpdate(v, i, t, false);
+    events[ev]++;
+    digitalWrite(CHARGE_RELAY_PIN, chargeRelayWanted() ? HIGH : LOW);
+
+    if (events[CHG_EV_CEILING] && ev != CHG_EV_CEILING && chargeRelayWanted())
+      relayAfterCeiling = true;
+    if (!termAtMs && chargeGetStatus().phase == CHG_CV &&
+        chargeGetStatus().chargeA <= CHARGE_TERM_C * CELL_CAPACITY_AH)
+      termAtMs = millis();
+    if (ev == CHG_EV_COMPLETE) { doneAfterMs = millis() - termAtMs; break; }
+  }
+
+  fflush(stdout);
+  dup2(console, 1);
+
+  /* Session Ah / τ are wall-time based; the plant runs PLANT_SIM_TIME_SCALE faster */
+  ChargeStatus    cs = chargeGetStatus();
+  float           ah = cs.sessionAh * PLANT_SIM_TIME_SCALE;
+  PlantSimMetrics pm = plantSimGetMetrics();
+
+  CHECK(events[CHG_EV_ARMED] == 1);
+  CHECK(events[CHG_EV_CV_TIMEOUT] == 0);
+  CHECK(events[CHG_EV_STOPPED] == 0);
+  CHECK(pm.unansweredViolations == 0);
+  CHECK(maxV < MAX_VOLTAGE);
+
+#ifndef EXPECT_CEILING
+  CHECK(events[CHG_EV_CV] == 1);
+  CHECK(events[CHG_EV_COMPLETE] == 1);
+  CHECK(termAtMs && doneAfterMs >= CHARGE_TERM_CONFIRM_MS);   // C/20 confirmed, not first touch
+  CHECK(events[CHG_EV_CEILING] == 0);
+  CHECK(cs.ceilingStops == 0);
+  CHECK(!relayAfterCeiling);
+  CHECK(maxV <= CHARGE_CV_V + 0.01f);
+  CHECK(ah > 0.75f * CELL_CAPACITY_AH);             // from 15 %, less the taper tail
+  printf("test_charge_sim: C/20 after %lu plant min, %.1f Ah, tau %.0f plant min, peak %.2fV\n",
+         (unsigned long)pm.plantTimeSec / 60, ah, cs.tauMin * PLANT_SIM_TIME_SCALE, maxV);
+  return hostReport("test_charge_sim");
+#else
+  CHECK(events[CHG_EV_COMPLETE] == 0 && !doneAfterMs);
+  CHECK(events[CHG_EV_CEILING] == 1);               // alerted once, however often it trips
+  CHECK(cs.ceilingStops >= 1);
+  CHECK(!relayAfterCeiling);                        // stays open: pack never sags to CHARGE_START_V
+  CHECK(maxV < CHARGE_CEILING_V + 0.1f);
+  printf("test_charge_sim_420: ceiling stop at %.2fV after %lu plant min, %.1f Ah\n",
+         maxV, (unsigned long)pm.plantTimeSec / 60, ah);
+  return hostReport("test_charge_sim_420");
+#endif
+}
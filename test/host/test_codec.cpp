@@ -0,0 +1,186 @@
+/*
+ * CBOR telemetry codec (telemetry_codec.cpp) round trip against the
+ * reference decoder.  Each case is encoded here and written to
+ * build/codec/<case>.cbor together with <case>.json – the rows the
+ * decoder must produce, in its units, plus the wire layout expected
+ * per record.  test_codec_roundtrip.py decodes the .cbor with
+ * tools/telemetry_cbor_decode.py and compares.
+ */
+#include "host_arduino.h"
+#include "telemetry_codec.h"
+#include "config.h"
+#include <sys/stat.h>
+
+#define OUT_DIR  "build/codec"
+
+static const char* PHASES[] = { "IDLE", "WAITING", "PRECOND", "CC", "CV", "MAINT", "DERATED" };
+
+static uint8_t buf[TQ_BATCH_BUF_SIZE];
+
+struct Case {
+  FILE*            json;
+  CborBufferSink   sink;
+  CborWriter       w;
+  TelemetryEncoder enc;
+  int              rows;
+};
+
+static void begin(Case& c, const char* name) {
+  char path[96];
+  snprintf(path, sizeof(path), OUT_DIR "/%s.json", name);
+  c.json = fopen(path, "w");
+  CHECK(c.json != nullptr);
+  fprintf(c.json, "{\"device_id\":\"%s\",\"rows\":[\n", DEVICE_ID);
+  c.sink = { buf, sizeof(buf), 0 };
+  c.rows = 0;
+  cborBegin(c.w, cborSinkBuffer, &c.sink);
+  telemetryEncodeBegin(c.enc, c.w);
+}
+
+/* Encode one sample and record what the decoder should return for it */
+static void add(Case& c, const TelemetrySnapshot& s, bool keyframe, bool msgNull) {
+  telemetryEncodeSample(c.enc, s);
+  CHECK(c.w.ok);
+
+  fprintf(c.json, "%s{\"_keyframe\":%s,\"_msg_null\":%s,",
+          c.rows++ ? ",\n" : "", keyframe ? "true" : "false", msgNull ? "true" : "false");
+  fprintf(c.json,
+          "\"device_uptime_ms\":%lu,\"pack_voltage\":%.6f,\"current\":%.6f,\"power\":%.6f,"
+          "\"temp_pack\":%.6f,\"soc\":%.6f,\"soh\":%.6f,\"rul_cycles\":%ld,"
+          "\"latitude\":%.7f,\"longitude\":%.7f,\"impact_count\":%lu,\"shock_count\":%lu,"
+          "\"connection_quality\":%u,\"loop_p50_us\":%lu,\"loop_p99_us\":%lu,"
+          "\"loop_max_us\":%lu,\"loop_deadline_miss\":%lu,\"wh_per_km\":%.6f,"
+          "\"range_km\":%.6f,\"range_lo_km\":%.6f,\"range_hi_km\":%.6f,"
+          "\"charge_phase\":\"%s\",\"charge_eta_min\":%.6f,",
+          (unsigned long)s.uptimeMs, s.packVoltage, s.current, s.power,
+          s.tempPack, s.soc, s.soh, (long)s.rulCycles,
+          (double)s.latitude, (double)s.longitude,
+          (unsigned long)s.impactCount, (unsigned long)s.shockCount,
+          s.connectionQuality, (unsigned long)s.loopP50Us, (unsigned long)s.loopP99Us,
+          (unsigned long)s.loopMaxUs, (unsigned long)s.loopDeadlineMiss, s.whPerKm,
+          s.rangeKm, s.rangeLoKm, s.rangeHiKm,
+          PHASES[s.chargePhase], s.chargeEtaMin < 0.0f ? -1.0f : s.chargeEtaMin);
+  fprintf(c.json,
+          "\"fault\":%s,\"fault_message\":\"%s\",\"is_charging\":%s,\"fan_on\":%s,"
+          "\"charger_relay_on\":%s,\"motor_load_on\":%s}",
+          s.fault ? "true" : "false", s.faultMessage, s.chargingActive ? "true" : "false",
+          s.fanActive ? "true" : "false", s.chargerRelay ? "true" : "false",
+          s.motorRelay ? "true" : "false");
+}
+
+static void end(Case& c, const char* name) {
+  CHECK(telemetryEncodeEnd(c.enc));
+  CHECK(c.w.total == c.sink.len);
+  fprintf(c.json, "\n]}\n");
+  fclose(c.json);
+
+  char path[96];
+  snprintf(path, sizeof(path), OUT_DIR "/%s.cbor", name);
+  FILE* f = fopen(path, "wb");
+  CHECK(f != nullptr);
+  if (!f) return;
+  fwrite(buf, 1, c.sink.len, f);
+  fclose(f);
+}
+
+static TelemetrySnapshot base() {
+  TelemetrySnapshot s;
+  memset(&s, 0, sizeof(s));
+  s.uptimeMs          = 123456789;
+  s.packVoltage       = 46.837f;
+  s.current           = -12.345f;            // charging
+  s.power             = -578.2f;
+  s.tempPack          = 31.4f;
+  s.soc               = 72.51f;
+  s.soh               = 96.07f;
+  s.rulCycles         = 812;
+  s.latitude          = -33.868820f;
+  s.longitude         = 151.209296f;
+  s.impactCount       = 3;
+  s.shockCount        = 17;
+  s.connectionQuality = 78;
+  s.chargingActive    = true;
+  s.chargerRelay      = true;
+  s.loopP50Us         = 1830;
+  s.loopP99Us         = 4120;
+  s.loopMaxUs         = 15870;
+  s.loopDeadlineMiss  = 2;
+  s.whPerKm           = 21.7f;
+  s.rangeKm           = 54.3f;
+  s.rangeLoKm         = 41.0f;
+  s.rangeHiKm         = 66.9f;
+  s.chargePhase       = 3;                   // CC
+  s.chargeEtaMin      = 47.0f;
+  return s;
+}
+
+int main() {
+  mkdir("build", 0755);
+  mkdir(OUT_DIR, 0755);
+
+  /* Keyframe: one absolute sample, every field and flag set */
+  {
+    Case c;
+    TelemetrySnapshot s = base();
+    s.fault      = true;
+    s.fanActive  = true;
+    s.motorRelay = true;
+    strcpy(s.faultMessage, "Overcurrent on discharge");
+    begin(c, "keyframe");
+    add(c, s, true, false);
+    end(c, "keyframe");
+  }
+
+  /* Deltas: values moving both ways across a keyframe boundary */
+  {
+    Case c;
+    TelemetrySnapshot s = base();
+    begin(c, "delta");
+    for (int i = 0; i < TCODEC_KEYFRAME_INTERVAL + 8; i++) {
+      bool key = i == 0 || i == TCODEC_KEYFRAME_INTERVAL;
+      add(c, s, key, !key);
+      s.uptimeMs     += 10000;
+      s.packVoltage  += (i & 1) ? -0.013f : 0.021f;
+      s.current       = -12.345f + 30.0f * sinf(i * 0.4f);
+      s.power         = s.packVoltage * s.current;
+      s.tempPack     += 0.1f;
+      s.soc          -= 0.07f;
+      s.latitude     += 0.000131f;
+      s.longitude    -= 0.000057f;
+      s.shockCount   += i % 3 == 0;
+      s.loopMaxUs     = 15000 + (i * 7919) % 9000;
+      s.rangeKm      -= 0.3f;
+      s.chargeEtaMin  = i < 20 ? 47.0f - i : -1.0f;
+      s.chargePhase   = i < 20 ? 3 : 4;
+      s.fanActive     = i % 5 == 0;
+    }
+    end(c, "delta");
+  }
+
+  /* Message only sent when it changes: null otherwise, "" clears it */
+  {
+    Case c;
+    TelemetrySnapshot s = base();
+    begin(c, "null_msg");
+    add(c, s, true, false);                            // "" on a keyframe
+    s.uptimeMs += 10000;
+    add(c, s, false, true);
+    strcpy(s.faultMessage, "Pack overtemperature");
+    s.fault = true;
+    s.uptimeMs += 10000;
+    add(c, s, false, false);
+    for (int i = 0; i < 3; i++) {
+      s.uptimeMs += 10000;
+      add(c, s, false, true);                          // decoder carries it forward
+    }
+    s.faultMessage[0] = '\0';
+    s.fault = false;
+    s.uptimeMs += 10000;
+    add(c, s, false, false);
+    s.uptimeMs += 10000;
+    add(c, s, false, true);
+    end(c, "null_msg");
+  }
+
+  return hostReport("test_codec");
+}
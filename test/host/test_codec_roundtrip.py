@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Second half of test_codec: decode every build/codec/<case>.cbor with
+tools/telemetry_cbor_decode.py and compare against <case>.json, the
+rows the C++ side expects.  Numbers must agree to half a quantisation
+step; everything else exactly.  Batches from older schema versions
+(fewer fields) must still decode.
+
+Usage: test_codec_roundtrip.py [dir]     (default build/codec)
+"""
+
+import glob
+import json
+import os
+import sys
+
+sys.dont_write_bytecode = True     # keep tools/ clean
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, "..", "..", "tools"))
+
+import telemetry_cbor_decode as dec  # noqa: E402
+
+TOL = {name: scale / 2 + 1e-6 for name, scale in dec.FIELDS}
+
+
+def check_case(cbor_path):
+    name = os.path.splitext(os.path.basename(cbor_path))[0]
+    data = open(cbor_path, "rb").read()
+    expected = json.load(open(os.path.splitext(cbor_path)[0] + ".json"))
+    fails = []
+
+    def fail(msg):
+        fails.append("%s: %s" % (name, msg))
+
+    device_id, rows = dec.decode_batch(data)
+    if device_id != expected["device_id"]:
+        fail("device_id %r" % device_id)
+    want = expected["rows"]
+    if len(rows) != len(want):
+        fail("%d rows, expected %d" % (len(rows), len(want)))
+
+    # Wire layout: keyframe / delta marker and null messages
+    records = dec._Reader(data).item()[1:]
+    for i, (rec, exp) in enumerate(zip(records, want)):
+        if (rec[0] == 0) != exp["_keyframe"]:
+            fail("row %d: kind %d" % (i, rec[0]))
+        if (rec[-1] is None) != exp["_msg_null"]:
+            fail("row %d: msg %r" % (i, rec[-1]))
+
+    for i, (row, exp) in enumerate(zip(rows, want)):
+        for key, v in exp.items():
+            if key.startswith("_"):
+                continue
+            got = row.get(key)
+            if isinstance(v, float) or (isinstance(v, int) and not isinstance(v, bool)):
+                ok = isinstance(got, (int, float)) and abs(got - v) <= TOL.get(key, 1e-6)
+            else:
+                ok = got == v
+            if not ok:
+                fail("row %d: %s = %r, expected %r" % (i, key, got, v))
+    return len(rows), fails
+
+
+def _cbor(v):
+    """Encoder for the subset a batch uses: ints, text, None, arrays."""
+    def head(major, n):
+        if n < 24:
+            return bytes([major | n])
+        for info, size in ((24, 1), (25, 2), (26, 4), (27, 8)):
+            if n < 1 << (8 * size):
+                return bytes([major | info]) + n.to_bytes(size, "big")
+    if v is None:
+        return b"\xf6"
+    if isinstance(v, int):
+        return head(0x00, v) if v >= 0 else head(0x20, -1 - v)
+    if isinstance(v, str):
+        b = v.encode()
+        return head(0x60, len(b)) + b
+    return head(0x80, len(v)) + b"".join(_cbor(x) for x in v)
+
+
+def check_older_versions():
+    fails = []
+    for version, count in sorted(dec.FIELD_COUNT.items()):
+        key = [0] + list(range(100, 100 + count)) + ["msg"]
+        delta = [1] + [1] * count + [None]
+        data = b"\x9f" + _cbor(["bms-tlm", version, "dev", count]) \
+            + _cbor(key) + _cbor(delta) + b"\xff"
+        try:
+            _, rows = dec.decode_batch(data)
+        except dec.CborError as e:
+            fails.append("v%d: %s" % (version, e))
+            continue
+        names = [n for n, _ in dec.FIELDS]
+        if len(rows) != 2 or rows[1]["device_uptime_ms"] != 101 \
+                or rows[1]["fault_message"] != "msg":
+            fails.append("v%d: rows %r" % (version, rows))
+        if any(n in rows[0] for n in names[count:]):
+            fails.append("v%d: fields past %d present" % (version, count))
+    return fails
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else "build/codec"
+    cases = sorted(glob.glob(os.path.join(out, "*.cbor")))
+    if not cases:
+        sys.exit("no cases in %s – run test_codec first" % out)
+
+    total_rows, fails = 0, []
+    for path in cases:
+        n, f = check_case(path)
+        total_rows += n
+        fails += f
+    fails += check_older_versions()
+    for f in fails:
+        print("FAIL " + f, file=sys.stderr)
+    print("test_codec_roundtrip: %d cases, %d rows, %d failed"
+          % (len(cases), total_rows, len(fails)))
+    sys.exit(1 if fails else 0)
+
+
+if __name__ == "__main__":
+    main()
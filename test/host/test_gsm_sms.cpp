@@ -0,0 +1,222 @@
+/*
+ * GSM modem driver (gsm_sms.cpp) against a scripted fake SIM800 on
+ * UART2: init and +CREG gating, SMS send through the '>' prompt,
+ * command timeouts and retries.  Each scenario runs in a forked
+ * child so the driver starts from cold statics.
+ */
+#include "host_arduino.h"
+#include "gsm_sms.h"
+#include "config.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* ── Fake modem ── */
+
+struct FakeModem {
+  bool        silent      = false;      // never answers anything
+  const char* cregReply   = "\r\n+CREG: 1,1\r\n\r\nOK\r\n";
+  int         cmgsErrors  = 0;          // next N sends answer +CMS ERROR
+  int         cmgsSilent  = 0;          // next N sends get no answer at all
+  int         creg        = 0;          // AT+CREG? queries seen
+  int         sends       = 0;          // Ctrl-Z received
+  int         escapes     = 0;          // ESC received
+  std::string lastPayload;
+
+  size_t      pos         = 0;          // consumed from hostTx
+  bool        inText      = false;
+  std::string line, text;
+};
+
+static FakeModem modem;
+
+static void reply(const char* s) { hostUart(2)->hostInject(s, strlen(s)); }
+
+static void modemCommand(const std::string& cmd) {
+  if (modem.silent) return;
+  if (cmd == "AT+CREG?") {
+    modem.creg++;
+    reply(modem.cregReply);
+  } else if (cmd.compare(0, 8, "AT+CMGS=") == 0) {
+    modem.inText = true;
+    modem.text.clear();
+    reply("\r\n> ");
+  } else {
+    reply("\r\nOK\r\n");
+  }
+}
+
+static void modemStep() {
+  std::string& tx = hostUart(2)->hostTx;
+  while (modem.pos < tx.size()) {
+    char c = tx[modem.pos++];
+    if (modem.inText) {
+      if (c == 27) {                                  // ESC: abort text entry
+        modem.inText = false;
+        modem.escapes++;
+      } else if (c == 26) {                           // Ctrl-Z: send
+        modem.inText      = false;
+        modem.lastPayload = modem.text;
+        modem.sends++;
+        if (modem.cmgsSilent)      modem.cmgsSilent--;
+        else if (modem.cmgsErrors) { modem.cmgsErrors--; reply("\r\n+CMS ERROR: 500\r\n"); }
+        else                       reply("\r\n+CMGS: 12\r\n\r\nOK\r\n");
+      } else {
+        modem.text += c;
+      }
+      continue;
+    }
+    if (c == 27) { modem.escapes++; continue; }       // ESC outside text mode: ignored
+    if (c == '\r') continue;
+    if (c == '\n') { modemCommand(modem.line); modem.line.clear(); continue; }
+    modem.line += c;
+  }
+}
+
+/* Run driver + modem for `ms` of fake time */
+static void run(unsigned long ms) {
+  for (unsigned long t = 0; t < ms; t += 10) {
+    hostAdvanceMs(10);
+    gsmLoop();
+    modemStep();
+  }
+}
+
+template <typename F>
+static int scenario(F body) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    hostSetMs(0);
+    gsmInit();
+    body();
+    _exit(hostFailures);
+  }
+  int st = 0;
+  waitpid(pid, &st, 0);
+  return WIFEXITED(st) ? WEXITSTATUS(st) : 255;
+}
+
+#define SCENARIO(...)                                               \
+  do {                                                              \
+    hostChecks++;                                                   \
+    hostFailures += scenario([&] { __VA_ARGS__ });                  \
+  } while (0)
+
+int main() {
+  /* Registered at the first query → READY */
+  SCENARIO(
+    CHECK(!gsmIsReady());
+    run(GSM_BOOT_DELAY_MS + 500);
+    CHECK(gsmIsReady());
+    CHECK(gsmIsRegistered());
+    CHECK(modem.creg == 1);
+    CHECK(gsmGetStats().errors == 0);
+  );
+
+  /* AT+CREG? → ERROR is a failed init, not READY */
+  SCENARIO(
+    modem.cregReply = "\r\nERROR\r\n";
+    run(GSM_BOOT_DELAY_MS + 500);
+    CHECK(!gsmIsReady());
+    CHECK(gsmGetStats().state == GsmState::RETRY_WAIT);
+    CHECK(gsmGetStats().errors == 1);
+
+    modem.cregReply = "\r\n+CREG: 1,1\r\n\r\nOK\r\n";
+    run(GSM_RETRY_MS + 500);
+    CHECK(gsmIsReady());
+  );
+
+  /* Searching (stat 2): READY only once the +CREG URC reports registered */
+  SCENARIO(
+    modem.cregReply = "\r\n+CREG: 1,2\r\n\r\nOK\r\n";
+    gsmSendSMS("queued before registration");
+    run(GSM_BOOT_DELAY_MS + 5000);
+    CHECK(!gsmIsReady());
+    CHECK(!gsmIsRegistered());
+    CHECK(gsmGetStats().state == GsmState::INIT);
+    CHECK(modem.sends == 0);
+
+    reply("\r\n+CREG: 5\r\n");                        // roaming
+    run(100);
+    CHECK(gsmIsReady());
+    run(1000);
+    CHECK(modem.sends == 1);
+    CHECK(gsmGetStats().smsSent == 1);
+
+    /* Network lost → SMS held until it comes back */
+    reply("\r\n+CREG: 0\r\n");
+    run(100);
+    CHECK(!gsmIsReady());
+    gsmSendSMS("held");
+    run(5000);
+    CHECK(modem.sends == 1);
+    reply("\r\n+CREG: 1\r\n");
+    run(1000);
+    CHECK(gsmIsReady());
+    CHECK(modem.sends == 2);
+  );
+
+  /* Never registers → re-init after GSM_REG_TIMEOUT_MS */
+  SCENARIO(
+    modem.cregReply = "\r\n+CREG: 1,0\r\n\r\nOK\r\n";
+    run(GSM_BOOT_DELAY_MS + 500);
+    CHECK(gsmGetStats().state == GsmState::INIT);
+    run(GSM_REG_TIMEOUT_MS);
+    CHECK(gsmGetStats().state == GsmState::RETRY_WAIT);
+    run(GSM_RETRY_MS + 500);
+    CHECK(modem.creg == 2);
+  );
+
+  /* SMS through the '>' prompt: payload then Ctrl-Z, +CMGS / OK */
+  SCENARIO(
+    run(GSM_BOOT_DELAY_MS + 500);
+    CHECK(gsmSendSMS("BMS FAULT: Overcurrent"));
+    run(1000);
+    CHECK(modem.sends == 1);
+    CHECK(modem.lastPayload == "BMS FAULT: Overcurrent");
+    CHECK(gsmGetStats().smsSent == 1);
+    CHECK(hostUart(2)->hostTx.find("AT+CMGS=\"" GSM_ALERT_NUMBER "\"") != std::string::npos);
+  );
+
+  /* CMGS timeout: ESC out of text mode, then a successful retry */
+  SCENARIO(
+    run(GSM_BOOT_DELAY_MS + 500);
+    modem.cmgsSilent = 1;
+    gsmSendSMS("retry me");
+    run(GSM_SMS_TIMEOUT_MS + 500);
+    CHECK(gsmGetStats().timeouts == 1);
+    CHECK(modem.escapes == 1);
+    run(1000);
+    CHECK(modem.sends == 2);
+    CHECK(gsmGetStats().smsSent == 1);
+    CHECK(gsmGetStats().smsFailed == 0);
+    CHECK(gsmIsReady());
+  );
+
+  /* +CMS ERROR on every try: dropped after GSM_SMS_RETRIES */
+  SCENARIO(
+    run(GSM_BOOT_DELAY_MS + 500);
+    modem.cmgsErrors = GSM_SMS_RETRIES;
+    gsmSendSMS("doomed");
+    gsmSendSMS("next");
+    run(3000);
+    CHECK(gsmGetStats().smsFailed == 1);
+    CHECK(gsmGetStats().smsSent == 1);
+    CHECK(modem.lastPayload == "next");
+    CHECK(modem.sends == GSM_SMS_RETRIES + 1);
+  );
+
+  /* Silent modem: AT times out, init retried */
+  SCENARIO(
+    modem.silent = true;
+    run(GSM_BOOT_DELAY_MS + 1500);
+    CHECK(gsmGetStats().timeouts == 1);
+    CHECK(gsmGetStats().state == GsmState::RETRY_WAIT);
+    modem.silent = false;
+    run(GSM_RETRY_MS + 500);
+    CHECK(gsmIsReady());
+  );
+
+  return hostReport("test_gsm_sms");
+}
@@ -0,0 +1,124 @@
+/*
+ * Motor bus pre-charge (precharge.cpp) against a 47 Ω / 2200 µF bus
+ * model with other loads on the pack: a steady fan load is subtracted
+ * as the baseline, a charger's small reverse current does not release
+ * the main relay early, and a load that never settles fails with
+ * FAULT_PRECHARGE_FAILURE after PRECHARGE_BASE_WAIT_MS instead of
+ * retrying silently.
+ */
+#include "host_arduino.h"
+#include "precharge.h"
+#include "actuator.h"
+#include "fault_manager.h"
+#include "config.h"
+#include <math.h>
+
+#define PACK_V     12.0f
+#define BUS_C_F    2200e-6f
+#define STEP_MS    100UL
+
+/* ── What precharge.o reads from actuator.cpp / fault_manager.cpp ── */
+
+static bool     motorWanted = true;
+static bool     motorOn     = false;
+static bool     preOn       = false;
+static uint32_t motorAtMs   = 0;
+static int      faults      = 0;
+static bool     faultActive = false;
+
+bool     actuatorWanted(ActRelay r)    { return r == ACT_MOTOR && motorWanted; }
+bool     actuatorState(ActRelay r)     { return r == ACT_MOTOR ? motorOn : preOn; }
+uint32_t actuatorChangedAt(ActRelay)   { return motorAtMs; }
+void     actuatorRequest(ActRelay r, ActSource, ActCmd cmd) {
+  if (r == ACT_PRECHARGE) preOn = cmd == ACT_ON;
+}
+bool isFaultActive(FaultType t) { return t == FAULT_PRECHARGE_FAILURE && faultActive; }
+void triggerExternalFault(FaultType t, const char*) {
+  if (t == FAULT_PRECHARGE_FAILURE) { faults++; faultActive = true; }
+}
+
+/* ── Plant: bus behind the resistor, other loads on the pack ── */
+
+static float busV = 0.0f;
+
+/** One loop pass; returns the pack current the INA219 would read (+ = discharge) */
+static float pass(float otherA) {
+  hostAdvanceMs(STEP_MS);
+  float iBus = 0.0f;
+  if (motorOn) {
+    busV = PACK_V;
+  } else if (preOn) {
+    /* Current read at the start of the pass, bus charges through the rest of it */
+    iBus  = (PACK_V - busV) / PRECHARGE_RESISTOR_OHM;
+    float tau = PRECHARGE_RESISTOR_OHM * BUS_C_F;
+    busV  = PACK_V - (PACK_V - busV) * expf(-(STEP_MS / 1000.0f) / tau);
+  }
+  return otherA + iBus;
+}
+
+/** Run until READY (the actuator closes main) or FAILED; bus % at release */
+static float runSequence(float (*load)(int)) {
+  float releasedPct = -1.0f;
+  for (int n = 0; n < 200; n++) {
+    float i = pass(load(n));
+    if (prechargeReady() && !motorOn) {
+      releasedPct = busV / PACK_V * 100.0f;
+      motorOn     = true;             // actuator closes main at the end of the pass
+      motorAtMs   = millis();
+    }
+    prechargeUpdate(PACK_V, i);
+    if (prechargeGetStats().state == PRE_CLOSED || prechargeGetStats().state == PRE_FAILED) break;
+  }
+  return releasedPct;
+}
+
+static void reset() {
+  motorOn = preOn = false;
+  busV    = 0.0f;
+  faultActive = false;
+  prechargeUpdate(PACK_V, 0.0f);      // CLOSED / FAILED → IDLE
+}
+
+static float fanLoad(int)     { return 1.5f; }                           // fan relay at ≥ FAN_ON_TEMP
+static float chargerLoad(int) { return -0.15f; }                         // charger trickle
+static float noisyLoad(int n) { return n % 2 ? 3.0f : 0.5f; }            // never steady
+
+int main() {
+  hostSetMs(1000);
+
+  /* Steady fan load: baseline subtracted, sequence completes */
+  float pct = runSequence(fanLoad);
+  PrechargeStats s = prechargeGetStats();
+  CHECK(s.state == PRE_CLOSED);
+  CHECK(faults == 0);
+  CHECK(pct >= PRECHARGE_DONE_PCT);
+  CHECK(s.completed == 1);
+
+  /* Charger trickle: only released once the bus really is charged */
+  motorWanted = false;
+  reset();
+  motorWanted = true;
+  pct = runSequence(chargerLoad);
+  s   = prechargeGetStats();
+  CHECK(s.state == PRE_CLOSED);
+  CHECK(pct >= PRECHARGE_DONE_PCT);
+  CHECK(s.lastBusPct <= 101.0f);
+
+  /* Load never settles: fault after the bounded wait, relay never closed */
+  motorWanted = false;
+  reset();
+  motorWanted = true;
+  uint32_t seqBefore = s.sequences;
+  uint32_t t0 = millis();
+  runSequence(noisyLoad);
+  s = prechargeGetStats();
+  CHECK(s.state == PRE_FAILED);
+  CHECK(faults == 1);
+  CHECK(s.refused == 1);
+  CHECK(s.sequences == seqBefore);
+  CHECK(!preOn);
+  CHECK(millis() - t0 >= PRECHARGE_BASE_WAIT_MS);
+  CHECK(millis() - t0 <= PRECHARGE_BASE_WAIT_MS + 2 * STEP_MS);
+
+  return hostReport("test_precharge");
+}
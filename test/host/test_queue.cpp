@@ -0,0 +1,180 @@
+/*
+ * Offline telemetry queue (telemetry_queue.cpp) on a RAM-backed
+ * "tlmq" partition: ack / replay order, recovery across reboots,
+ * overflow and a power cut in the middle of a push.  Each boot is a
+ * forked child so the module starts from cold statics while the
+ * flash (shared mmap) survives.
+ */
+#include "host_arduino.h"
+#include "telemetry_queue.h"
+#include "config.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define SECTORS  4
+
+/* ── What telemetry_queue.o needs from wifi_manager / wifi_cloud ── */
+
+static bool                  linkUp   = true;
+static int                   httpCode = 200;
+static std::vector<uint32_t> posted;           // uptimeMs of every replayed row
+
+bool          wifiConnected()     { return linkUp; }
+unsigned long getLastUploadTime() { return millis(); }
+
+size_t formatTelemetryJson(const TelemetrySnapshot& s, char* buf, size_t bufSize) {
+  int n = snprintf(buf, bufSize, "{\"t\":%lu}", (unsigned long)s.uptimeMs);
+  return n > 0 && (size_t)n < bufSize ? (size_t)n : 0;
+}
+
+int cloudPostJson(const char* body, size_t len) {
+  std::string b(body, len);
+  for (const char* p = b.c_str(); (p = strstr(p, "\"t\":")); p += 4)
+    posted.push_back(strtoul(p + 4, nullptr, 10));
+  return httpCode;
+}
+
+/* ── Helpers ── */
+
+static uint32_t nextT = 0;                     // uptimeMs of the next pushed sample
+
+static bool push() {
+  TelemetrySnapshot s;
+  memset(&s, 0, sizeof(s));
+  s.uptimeMs = nextT++;
+  return telemetryQueuePush(s);
+}
+
+/* Run the service until the queue is empty or nothing more is sent */
+static void drain() {
+  for (int i = 0; i < 1000 && telemetryQueueDepth(); i++) {
+    hostAdvanceMs(TQ_REPLAY_INTERVAL_MS);
+    size_t before = posted.size();
+    telemetryQueueService();
+    if (posted.size() == before && httpCode == 200) break;
+  }
+}
+
+/* Run one boot in a child; returns its exit status (failures, or HOST_POWER_CUT_EXIT) */
+template <typename F>
+static int boot(F body) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    hostSetMs(10000);
+    telemetryQueueInit();
+    body();
+    _exit(hostFailures);
+  }
+  int st = 0;
+  waitpid(pid, &st, 0);
+  return WIFEXITED(st) ? WEXITSTATUS(st) : 255;
+}
+
+#define BOOT(...)                                                   \
+  do {                                                              \
+    hostChecks++;                                                   \
+    hostFailures += boot([&] { __VA_ARGS__ });                      \
+  } while (0)
+
+int main() {
+  hostAddPartition("tlmq", 0x43, SECTORS * 4096);
+
+  uint32_t cap = 0;
+
+  /* 1. Push while offline, replay once back, in order */
+  BOOT(
+    linkUp = false;
+    for (int i = 0; i < 30; i++) CHECK(push());
+    CHECK(telemetryQueueDepth() == 30);
+    telemetryQueueService();
+    CHECK(posted.empty());
+
+    linkUp = true;
+    drain();
+    CHECK(telemetryQueueDepth() == 0);
+    CHECK(posted.size() == 30);
+    for (size_t i = 0; i < posted.size(); i++) CHECK(posted[i] == i);
+    CHECK(telemetryQueueGetStats().replayed == 30);
+
+    /* Left for the next boot */
+    nextT = 100;
+    for (int i = 0; i < 5; i++) CHECK(push());
+  );
+
+  /* 2. Reboot: only the unacknowledged five come back */
+  BOOT(
+    CHECK(telemetryQueueDepth() == 5);
+    drain();
+    CHECK(posted.size() == 5);
+    CHECK(!posted.empty() && posted.front() == 100 && posted.back() == 104);
+
+    /* A failed POST keeps the batch */
+    nextT = 200;
+    for (int i = 0; i < 3; i++) push();
+    httpCode = 500;
+    hostAdvanceMs(TQ_REPLAY_INTERVAL_MS);
+    telemetryQueueService();
+    CHECK(telemetryQueueDepth() == 3);
+    CHECK(telemetryQueueGetStats().failedBatches == 1);
+  );
+
+  /* 3. Those three survive the reboot; drain, then overflow while offline */
+  BOOT(
+    CHECK(telemetryQueueDepth() == 3);
+    drain();
+    CHECK(posted.size() == 3 && posted.front() == 200);
+
+    cap = telemetryQueueGetStats().capacity;
+    CHECK(cap > 0 && cap < 1000);
+
+    linkUp = false;
+    nextT = 1000;
+    uint32_t erases = hostFlashErases();
+    for (uint32_t i = 0; i < 2 * cap; i++) {
+      push();
+      CHECK(hostFlashErases() == erases);      // never erases in the push
+      telemetryQueueService();                 // erase happens here
+      erases = hostFlashErases();
+    }
+    TelemetryQueueStats st = telemetryQueueGetStats();
+    CHECK(st.depth <= cap);
+    CHECK(st.overwritten + st.depth == 2 * cap);
+    CHECK(st.overwritten > 0);
+  );
+
+  /* 4. The newest records survive, oldest first, nothing lost or repeated */
+  BOOT(
+    cap = telemetryQueueGetStats().capacity;
+    uint32_t depth = telemetryQueueDepth();
+    CHECK(depth > 0 && depth <= cap);
+    drain();
+    CHECK(posted.size() == depth);
+    for (size_t i = 1; i < posted.size(); i++) CHECK(posted[i] == posted[i - 1] + 1);
+    CHECK(!posted.empty() && posted.back() == 1000 + 2 * cap - 1);
+  );
+
+  /* 5. Power cut half-way through a record */
+  CHECK(boot([&] {
+    linkUp = false;
+    nextT = 5000;
+    for (int i = 0; i < 4; i++) push();
+    hostFlashPowerCut(40);
+    push();
+  }) == HOST_POWER_CUT_EXIT);
+
+  BOOT(
+    CHECK(telemetryQueueDepth() == 5);       // 4 + the torn slot, skipped on replay
+    nextT = 6000;
+    CHECK(push());
+    drain();
+    CHECK(posted.size() == 5 && posted[0] == 5000 && posted[3] == 5003 && posted[4] == 6000);
+  );
+
+  /* 6. Nothing was ever programmed over unerased flash */
+  CHECK(hostFlashViolations() == 0);
+
+  return hostReport("test_queue");
+}
@@ -0,0 +1,139 @@
+/*
+ * State snapshot (snapshot.cpp) across 40 reboots on a RAM-backed
+ * "snapshot" partition.  Each boot is a forked child: it checks what
+ * was restored, writes a random number of records (wrapping the A/B
+ * sectors now and then) and most of the time loses power part-way
+ * through a record.  The restored value must always be the last
+ * record that was completely written, and no write may ever land on
+ * unerased flash.
+ */
+#include "host_arduino.h"
+#include "snapshot.h"
+#include "config.h"
+#include <esp_private/rtc_ctrl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BOOTS         40
+#define SNAP_SIZE     (2 * 4096)
+
+/* ── What snapshot.o reads from / restores into soc.cpp and soh.cpp ── */
+
+static float         ah        = 0.0f;
+static float         restoredAh = -1.0f;
+static float         restoredSoh = -1.0f;
+static unsigned long restoredHot = 0;
+
+float         getRemainingAh()     { return ah; }
+float         getSOC()             { return ah; }
+float         getSOH()             { return 90.0f + ah / 1000.0f; }
+unsigned long getHighTempSeconds() { return (unsigned long)ah; }
+void          restoreSOC(float remainingAh)             { restoredAh = remainingAh; }
+void          restoreSOH(float soh, unsigned long hotS) { restoredSoh = soh; restoredHot = hotS; }
+void          saveSOC() {}
+void          saveSOH() {}
+
+/* ── Survives the children ── */
+
+struct Shared {
+  float    lastDone;        // value of the last snapshotSave() that returned
+  float    inFlight;        // value being written when power went
+  bool     any;             // at least one record completed
+  uint32_t seq;             // stats.seq after the last completed write
+  int      failures;
+  int      cuts;
+  int      wraps;           // boots that crossed into the other sector
+};
+
+static Shared* sh;
+
+static void bootOnce(int boot) {
+  hostSetMs(1000);
+  snapshotInit();
+
+  /* ── What came back ── */
+  SnapshotStats st = snapshotGetStats();
+  CHECK(st.flashReady);
+  CHECK(hostRtcIsrFlags & RTC_INTR_FLAG_IRAM);     // brownout ISR registered as IRAM
+  if (!sh->any) {
+    CHECK(!st.restored);
+  } else {
+    CHECK(st.restored);
+    bool exact = restoredAh == sh->lastDone;
+    /* A cut after the last byte that differs from erased flash leaves a
+       complete record behind – equally valid. */
+    bool torn  = restoredAh == sh->inFlight;
+    CHECK(exact || torn);
+    if (!(exact || torn))
+      fprintf(stderr, "  boot %d: restored %.0f, last complete %.0f, in flight %.0f\n",
+              boot, restoredAh, sh->lastDone, sh->inFlight);
+    CHECK(restoredSoh == 90.0f + restoredAh / 1000.0f);
+    CHECK(restoredHot == (unsigned long)restoredAh);
+    if (torn && !exact) { sh->lastDone = restoredAh; sh->seq = st.seq; }
+    CHECK(st.seq == sh->seq);
+  }
+  sh->failures += hostFailures;
+  hostFailures  = 0;
+
+  /* ── This boot's writes ── */
+  int  writes = 1 + rand() % 160;
+  bool cut    = rand() % 4 != 0;
+  if (cut) hostFlashPowerCut((uint32_t)(rand() % (writes * 32)));
+
+  uint32_t erases = hostFlashErases();
+  for (int i = 0; i < writes; i++) {
+    ah           = (float)(boot * 1000 + i + 1);
+    sh->inFlight = ah;
+    snapshotSave(SNAP_PERIODIC);
+    sh->lastDone = ah;
+    sh->any      = true;
+    sh->seq      = snapshotGetStats().seq;
+    hostAdvanceMs(100);
+    snapshotService();                              // deferred sector erase
+  }
+  if (hostFlashErases() != erases) sh->wraps++;
+}
+
+int main() {
+  sh = (Shared*)mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  memset(sh, 0, sizeof(*sh));
+  hostAddPartition("snapshot", 0x42, SNAP_SIZE);
+  srand(0x5A17);
+
+  for (int boot = 0; boot < BOOTS; boot++) {
+    int seed = rand();
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+      srand(seed);
+      bootOnce(boot);
+      sh->failures += hostFailures;
+      _exit(0);
+    }
+    int st = 0;
+    waitpid(pid, &st, 0);
+    hostChecks++;
+    if (!WIFEXITED(st)) hostFailures++;
+    else if (WEXITSTATUS(st) == HOST_POWER_CUT_EXIT) sh->cuts++;
+  }
+
+  /* One more boot to check the state the last one left */
+  pid_t pid = fork();
+  if (pid == 0) {
+    snapshotInit();
+    sh->failures += restoredAh == sh->lastDone || restoredAh == sh->inFlight ? 0 : 1;
+    _exit(0);
+  }
+  waitpid(pid, nullptr, 0);
+
+  hostFailures += sh->failures;
+  CHECK(sh->cuts > BOOTS / 2);
+  CHECK(sh->wraps > 0);
+  CHECK(hostFlashViolations() == 0);
+  printf("test_snapshot: %d boots, %d power cuts, %d sector wraps\n",
+         BOOTS, sh->cuts, sh->wraps);
+  return hostReport("test_snapshot");
+}
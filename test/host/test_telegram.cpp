@@ -0,0 +1,75 @@
+/*
+ * Telegram delivery queue (telegram.cpp): a POST that fails with WiFi
+ * up keeps the message at the head and retries it with a doubling
+ * backoff; it only leaves the queue on a 2xx, or when the API rejects
+ * it outright (4xx).  Later sends queue behind it, in order.
+ */
+#include "host_arduino.h"
+#include "telegram.h"
+#include <HTTPClient.h>
+
+/* ── What telegram.o reads from wifi_manager.cpp ── */
+
+static bool linkUp = true;
+bool wifiConnected() { return linkUp; }
+
+/** Service passes over `ms`, one per 100 ms; returns the POSTs made */
+static unsigned service(uint32_t ms) {
+  unsigned before = hostHttpPosts;
+  for (uint32_t t = 0; t < ms; t += 100) {
+    hostAdvanceMs(100);
+    telegramService();
+  }
+  return hostHttpPosts - before;
+}
+
+int main() {
+  hostSetMs(1000);
+  telegramInit();
+
+  /* TLS failure with the link up: held, not lost */
+  hostHttpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+  CHECK(!sendTelegramForced("fault latch"));
+  CHECK(hostHttpPosts == 1);
+
+  /* Later sends queue behind it rather than jumping ahead */
+  CHECK(!sendTelegramForced("thermal trip"));
+  CHECK(hostHttpPosts == 1);
+
+  /* Backoff: nothing before 5 s, then 5 s, 10 s, 20 s … */
+  CHECK(service(4900) == 0);
+  CHECK(service(200) == 1);
+  CHECK(service(9800) == 0);
+  CHECK(service(300) == 1);
+  CHECK(service(19600) == 0);
+  CHECK(service(300) == 1);
+
+  /* Link down: no attempts at all */
+  linkUp = false;
+  CHECK(service(60000) == 0);
+  linkUp = true;
+
+  /* 2xx: the head goes, the next one follows on the next pass */
+  hostHttpCode = 200;
+  CHECK(service(100) == 1);
+  CHECK(service(100) == 1);
+  CHECK(service(10000) == 0);              // queue empty
+
+  /* Sent directly again once the queue is empty */
+  CHECK(sendTelegramForced("charging start"));
+
+  /* Permanent rejection is dropped, not retried forever */
+  hostHttpCode = 400;
+  CHECK(!sendTelegramForced("too long"));
+  CHECK(service(600000) == 0);
+
+  /* 429 is throttling: held and retried */
+  hostHttpCode = 429;
+  unsigned before = hostHttpPosts;
+  CHECK(!sendTelegramForced("charging stop"));
+  hostHttpCode = 200;
+  CHECK(service(5100) == 1);
+  CHECK(hostHttpPosts - before == 2);
+
+  return hostReport("test_telegram");
+}
@@ -0,0 +1,102 @@
+/*
+ * History block codec (tsdb.cpp): a day of 1 Hz pack history – load
+ * cycle, sensor noise, motor starts, a reboot gap – and a block of
+ * random full-scale values are encoded into TSDB_DATA_BYTES blocks
+ * the way the store fills them and must decode bit-exact.  The day's
+ * blocks give the retention of the 768 KB "tsdb" partition.
+ */
+#include "host_arduino.h"
+#include "tsdb.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define DATA_BYTES   (4096 - 160)          // TSDB_DATA_BYTES
+#define PART_BLOCKS  (0xC0000 / 4096)      // partitions.csv "tsdb"
+#define DAY_S        86400UL
+
+static uint8_t  block[DATA_BYTES];
+static TsdbSample ref[DATA_BYTES * 8];     // ≥ 1 bit a sample
+static uint16_t refN = 0;
+static uint32_t mismatches = 0;
+
+static float noise(float span) { return ((float)rand() / RAND_MAX - 0.5f) * span; }
+
+static TsdbSample daySample(uint32_t i) {
+  TsdbSample s;
+  float load = 4.0f + 3.0f * sinf(i * (2.0f * (float)M_PI / 600.0f));
+  if (i % 300 < 2) load += 40.0f;          // motor start every 5 min
+  s.t    = 1700000000UL + i + (i >= DAY_S / 2 ? 3600 : 0);   // reboot gap mid-day
+  s.v[0] = 12.40f - 0.05f * load + noise(0.004f);
+  s.v[1] = load + noise(0.10f);
+  s.v[2] = 28.0f + (i % 3600) * 0.0005f + noise(0.05f);
+  s.v[3] = 80.0f - (i % 3600) * 0.0015f;
+  tsdbQuantise(s);
+  return s;
+}
+
+static TsdbSample wildSample(uint32_t i) {
+  TsdbSample s;
+  s.t = 1700000000UL + i * (1 + rand() % 5000);
+  for (uint8_t k = 0; k < TSDB_SERIES; k++) s.v[k] = noise(2000.0f);
+  tsdbQuantise(s);
+  return s;
+}
+
+/* Decode the block just filled and compare with what went in */
+static void verifyBlock() {
+  TsdbDecoder d;
+  TsdbSample  s;
+  uint16_t    n = 0;
+  tsdbDecBegin(d, block, sizeof(block), refN);
+  while (tsdbDecNext(d, s)) {
+    bool same = s.t == ref[n].t;
+    for (uint8_t k = 0; k < TSDB_SERIES; k++) same = same && s.v[k] == ref[n].v[k];
+    if (!same) mismatches++;
+    n++;
+  }
+  if (n != refN) mismatches++;
+}
+
+/** Encode `total` samples block by block; @return blocks used */
+static uint32_t run(TsdbSample (*gen)(uint32_t), uint32_t total) {
+  TsdbEncoder e;
+  uint32_t    blocks = 0;
+  refN = 0;
+  for (uint32_t i = 0; i < total; i++) {
+    TsdbSample s = gen(i);
+    if (!refN) {
+      memset(block, 0xFF, sizeof(block));
+      tsdbEncBegin(e, block, sizeof(block));
+      blocks++;
+    }
+    if (!tsdbEncAppend(e, s)) {            // full: check it, start the next
+      verifyBlock();
+      memset(block, 0xFF, sizeof(block));
+      tsdbEncBegin(e, block, sizeof(block));
+      blocks++;
+      refN = 0;
+      tsdbEncAppend(e, s);
+    }
+    ref[refN++] = s;
+  }
+  verifyBlock();
+  return blocks;
+}
+
+int main() {
+  srand(42);
+
+  uint32_t dayBlocks = run(daySample, DAY_S);
+  CHECK(mismatches == 0);
+  float days = (float)PART_BLOCKS / dayBlocks;
+  CHECK(days >= 5.0f);
+
+  mismatches = 0;
+  uint32_t wildBlocks = run(wildSample, 2000);
+  CHECK(mismatches == 0);
+  CHECK(wildBlocks > 1);                   // escapes fill blocks, never overflow them
+
+  printf("test_tsdb: %lu blocks a day at 1 Hz – %.1f days in %u blocks\n",
+         (unsigned long)dayBlocks, days, (unsigned)PART_BLOCKS);
+  return hostReport("test_tsdb");
+}
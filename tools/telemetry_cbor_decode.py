@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+Reference decoder for CBOR telemetry batches (telemetry_codec.cpp).
+
+Batch:
+  [_ ["bms-tlm", version, device_id, field_count],
+     [0, v0 .. vN-1, msg],         keyframe – absolute values
+     [1, d0 .. dN-1, msg | null],  delta    – added to previous sample
+     ... ]
+
+Emits one dict per sample with the same keys/units as the JSON row
+(formatTelemetryJson), so the ingest side can insert it unchanged.
+
+Usage:
+  telemetry_cbor_decode.py batch.cbor            # JSON lines to stdout
+  cat batch.cbor | telemetry_cbor_decode.py -
+
+Pure Python, no dependencies.  Import decode_batch() from an ingest
+handler to turn a request body into rows.
+"""
+
+import json
+import struct
+import sys
+
+SCHEMA_VERSION = 3
+
+# Must match TCODEC_FIELD_* in telemetry_codec.h: (name, scale).
+# Fields are only ever appended; a version-N batch carries the first
+# FIELD_COUNT[N] of them.
+FIELDS = [
+    ("device_uptime_ms",   1),
+    ("pack_voltage",       1e-3),
+    ("current",            1e-2),
+    ("power",              1e-1),
+    ("temp_pack",          1e-1),
+    ("soc",                1e-2),
+    ("soh",                1e-2),
+    ("rul_cycles",         1),
+    ("latitude",           1e-6),
+    ("longitude",          1e-6),
+    ("impact_count",       1),
+    ("shock_count",        1),
+    ("connection_quality", 1),
+    ("flags",              1),
+    ("loop_p50_us",        1),
+    ("loop_p99_us",        1),
+    ("loop_max_us",        1),
+    ("loop_deadline_miss", 1),
+    ("wh_per_km",          1e-1),   # v2
+    ("range_km",           1e-1),
+    ("range_lo_km",        1e-1),
+    ("range_hi_km",        1e-1),
+    ("charge_phase",       1),      # v3
+    ("charge_eta_min",     1),
+]
+
+FIELD_COUNT = {1: 18, 2: 22, 3: 24}
+assert FIELD_COUNT[SCHEMA_VERSION] == len(FIELDS)
+
+# Must match ChargePhase in charge.h / chargePhaseName()
+CHARGE_PHASES = ["IDLE", "WAITING", "PRECOND", "CC", "CV", "MAINT", "DERATED"]
+
+FLAG_FAULT, FLAG_CHARGING, FLAG_FAN, FLAG_CHARGE_RELAY, FLAG_MOTOR_RELAY = (
+    1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4)
+
+_BREAK = object()
+
+
+class CborError(ValueError):
+    pass
+
+
+class _Reader:
+    """Minimal CBOR reader: the subset the firmware writes."""
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def _take(self, n):
+        if self.pos + n > len(self.data):
+            raise CborError("truncated")
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def _arg(self, info):
+        if info < 24:
+            return info
+        sizes = {24: ">B", 25: ">H", 26: ">I", 27: ">Q"}
+        if info not in sizes:
+            raise CborError("bad additional info %d" % info)
+        fmt = sizes[info]
+        return struct.unpack(fmt, self._take(struct.calcsize(fmt)))[0]
+
+    def item(self):
+        ib = self._take(1)[0]
+        major, info = ib >> 5, ib & 0x1F
+        if ib == 0xFF:
+            return _BREAK
+        if major == 0:
+            return self._arg(info)
+        if major == 1:
+            return -1 - self._arg(info)
+        if major == 3:
+            return self._take(self._arg(info)).decode("utf-8", "replace")
+        if major == 4:
+            if info == 31:
+                out = []
+                while True:
+                    v = self.item()
+                    if v is _BREAK:
+                        return out
+                    out.append(v)
+            return [self.item() for _ in range(self._arg(info))]
+        if ib == 0xF6:
+            return None
+        if ib == 0xF4:
+            return False
+        if ib == 0xF5:
+            return True
+        raise CborError("unsupported item 0x%02x" % ib)
+
+
+def decode_batch(data):
+    """Return (device_id, [row dict, ...]) for one CBOR batch."""
+    batch = _Reader(data).item()
+    if not isinstance(batch, list) or not batch:
+        raise CborError("not a batch")
+
+    header = batch[0]
+    if len(header) < 4 or header[0] != "bms-tlm":
+        raise CborError("bad header")
+    _, version, device_id, field_count = header[:4]
+    if version not in FIELD_COUNT or field_count != FIELD_COUNT[version]:
+        raise CborError("unsupported schema v%s (%s fields)" % (version, field_count))
+    fields = FIELDS[:field_count]
+
+    rows, prev, msg = [], None, ""
+    for rec in batch[1:]:
+        kind, values, rec_msg = rec[0], rec[1:1 + field_count], rec[1 + field_count]
+        if kind == 0:
+            cur = list(values)
+        elif kind == 1:
+            if prev is None:
+                raise CborError("delta before keyframe")
+            cur = [p + d for p, d in zip(prev, values)]
+        else:
+            raise CborError("unknown record kind %s" % kind)
+        if rec_msg is not None:
+            msg = rec_msg
+        prev = cur
+        rows.append(_row(device_id, fields, cur, msg))
+    return device_id, rows
+
+
+def _row(device_id, fields, values, msg):
+    """Row dict; fields newer than the batch's version are left out."""
+    row = {"device_id": device_id}
+    for (name, scale), v in zip(fields, values):
+        row[name] = v if scale == 1 else round(v * scale, 6)
+    flags = row.pop("flags")
+    row["fault"] = bool(flags & FLAG_FAULT)
+    row["fault_message"] = msg
+    row["is_charging"] = bool(flags & FLAG_CHARGING)
+    row["is_discharging"] = not row["is_charging"]
+    row["charger_relay_on"] = bool(flags & FLAG_CHARGE_RELAY)
+    row["motor_load_on"] = bool(flags & FLAG_MOTOR_RELAY)
+    row["fan_on"] = bool(flags & FLAG_FAN)
+    row["cooling_active"] = row["fan_on"]
+    if "charge_phase" in row:
+        phase = row["charge_phase"]
+        row["charge_phase"] = CHARGE_PHASES[phase] if 0 <= phase < len(CHARGE_PHASES) else "?"
+    return row
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    src = sys.argv[1]
+    data = sys.stdin.buffer.read() if src == "-" else open(src, "rb").read()
+    _, rows = decode_batch(data)
+    for row in rows:
+        print(json.dumps(row))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Decode the BMS binary serial telemetry stream (telemetry_stream.cpp).
+
+Wire format:  0x00 | COBS( type | seq | payload | crc16 ) | 0x00
+Text log lines interleaved on the same port are skipped.
+
+Usage:
+  telemetry_decode.py capture.bin  -o telemetry.csv
+  telemetry_decode.py /dev/ttyUSB0 -o telemetry.parquet --baud 115200
+
+Parquet output needs pandas + pyarrow; CSV needs nothing extra.
+Reading a serial port needs pyserial.
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+TYPE_TELEMETRY_V1 = 0x01
+
+# Must match TelemetryFrameV1 in telemetry_stream.h (packed, little-endian)
+V1_STRUCT = struct.Struct("<IHhHhHHHIHBB")
+V1_FIELDS = [
+    "uptime_ms", "pack_voltage", "current", "power", "temp_pack",
+    "soc", "soh", "rul_cycles", "fault_bitmap", "flags",
+    "anomaly_score", "fault_severity",
+]
+V1_SCALE = {
+    "pack_voltage": 0.001, "current": 0.01, "power": 0.1,
+    "temp_pack": 0.1, "soc": 0.01, "soh": 0.01,
+}
+
+FLAG_NAMES = [
+    "fault", "charging", "fan", "thermal_trip", "blanking",
+    "charge_relay", "motor_relay", "anomaly", "wifi", "overcurrent",
+]
+
+COLUMNS = ["seq"] + V1_FIELDS + FLAG_NAMES
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self):
+        self.buf = bytearray()
+        self.frames = 0
+        self.bad_crc = 0
+        self.skipped = 0
+
+    def feed(self, chunk):
+        """Yield decoded rows for every complete frame in chunk."""
+        self.buf += chunk
+        while True:
+            end = self.buf.find(b"\x00")
+            if end < 0:
+                return
+            packet, self.buf = bytes(self.buf[:end]), self.buf[end + 1:]
+            if not packet:
+                continue
+            row = self._decode(packet)
+            if row is not None:
+                yield row
+
+    def _decode(self, packet):
+        raw = cobs_decode(packet)
+        if raw is None or len(raw) < 5:
+            self.skipped += 1          # text log line or partial frame
+            return None
+        body, crc = raw[:-2], struct.unpack("<H", raw[-2:])[0]
+        if crc16_ccitt(body) != crc:
+            self.bad_crc += 1
+            return None
+        ftype, seq = body[0], struct.unpack("<H", body[1:3])[0]
+        payload = body[3:]
+        if ftype != TYPE_TELEMETRY_V1 or len(payload) != V1_STRUCT.size:
+            self.skipped += 1
+            return None
+
+        self.frames += 1
+        row = {"seq": seq}
+        for name, value in zip(V1_FIELDS, V1_STRUCT.unpack(payload)):
+            row[name] = round(value * V1_SCALE[name], 3) if name in V1_SCALE else value
+        for bit, name in enumerate(FLAG_NAMES):
+            row[name] = int(bool(row["flags"] & (1 << bit)))
+        return row
+
+
+def open_source(path, baud):
+    if os.path.isfile(path):
+        return open(path, "rb")
+    try:
+        import serial  # pyserial
+    except ImportError:
+        sys.exit("pyserial is required to read from a serial port")
+    return serial.Serial(path, baud, timeout=1)
+
+
+def write_rows(rows, out_path):
+    if out_path.endswith(".parquet"):
+        try:
+            import pandas as pd
+        except ImportError:
+            sys.exit("pandas + pyarrow are required for Parquet output")
+        pd.DataFrame(rows, columns=COLUMNS).to_parquet(out_path, index=False)
+        return
+    with open(out_path, "w", newline="") as f:
+        w = csv.DictWriter(f, fieldnames=COLUMNS)
+        w.writeheader()
+        w.writerows(rows)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="capture file or serial port")
+    ap.add_argument("-o", "--output", default="telemetry.csv",
+                    help=".csv or .parquet (default telemetry.csv)")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    dec, rows = Decoder(), []
+    is_file = os.path.isfile(args.source)
+    src = open_source(args.source, args.baud)
+    try:
+        while True:
+            chunk = src.read(4096)
+            if not chunk:
+                if is_file:
+                    break
+                continue            # serial timeout – keep listening
+            rows.extend(dec.feed(chunk))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        src.close()
+
+    write_rows(rows, args.output)
+    print(f"{dec.frames} frames -> {args.output}  "
+          f"(bad crc {dec.bad_crc}, skipped {dec.skipped})", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,515 @@
+#include "tsdb.h"
+#include "config.h"
+#include "logger.h"
+#include "telemetry_stream.h"   // crc16Ccitt
+#include <esp_partition.h>
+#include <time.h>
+
+#define TSDB_BLOCK_SIZE     4096       // one flash sector
+#define TSDB_HDR_SIZE       160
+#define TSDB_DATA_BYTES     (TSDB_BLOCK_SIZE - TSDB_HDR_SIZE)
+#define TSDB_COMMITS        64         // a block lasts ≈40 min at 1 Hz: one flush a minute fits
+#define TSDB_MAGIC          0x32425354UL   // "TSB2" – Rice-coded values
+#define TSDB_PART_SUBTYPE   0x41       // partitions.csv: data, 0x41, "tsdb"
+#define TSDB_WALL_CLOCK_MIN 1700000000UL   // time() above this = SNTP has run
+
+/* Rice code of a zig-zagged change u: (u >> k) ones, a zero, the k
+   low bits.  From TSDB_RICE_ESCAPE ones on, the 32-bit value follows
+   raw instead (a jump, e.g. a relay closing).                        */
+#define TSDB_RICE_ESCAPE     16
+#define TSDB_RICE_MAX_K      20
+#define TSDB_MEAN_INIT       (4 << 4)  // k = 2 until the series has shown its noise
+
+/* Worst case: '1111' + 32-bit timestamp, 4 × (escape + 32) */
+#define TSDB_MAX_SAMPLE_BITS  (4 + 32 + TSDB_SERIES * (TSDB_RICE_ESCAPE + 32))
+
+/* Storage step per series = 1 / scale (powers of two) */
+static const float TSDB_SCALE[TSDB_SERIES] = { 1024.0f, 128.0f, 16.0f, 128.0f };
+
+/* ═══════════════════════════════════════════
+   BIT I/O  (MSB first)
+   ═══════════════════════════════════════════ */
+
+static void putBits(TsdbEncoder& e, uint32_t v, uint8_t n) {
+  while (n) {
+    uint8_t room  = 8 - (e.bitPos & 7);
+    uint8_t take  = n < room ? n : room;
+    uint8_t shift = room - take;
+    uint8_t mask  = (uint8_t)(((1u << take) - 1) << shift);
+    uint8_t bits  = (uint8_t)((v >> (n - take)) << shift) & mask;
+    uint8_t& b    = e.buf[e.bitPos >> 3];
+    b = (b & ~mask) | bits;
+    e.bitPos += take;
+    n        -= take;
+  }
+}
+
+static uint32_t getBits(TsdbDecoder& d, uint8_t n) {
+  uint32_t v = 0;
+  while (n) {
+    uint8_t room  = 8 - (d.bitPos & 7);
+    uint8_t take  = n < room ? n : room;
+    uint8_t shift = room - take;
+    v = (v << take) | ((d.buf[d.bitPos >> 3] >> shift) & ((1u << take) - 1));
+    d.bitPos += take;
+    n        -= take;
+  }
+  return v;
+}
+
+static int32_t  toSteps(uint8_t k, float v)     { return (int32_t)lroundf(v * TSDB_SCALE[k]); }
+static float    fromSteps(uint8_t k, int32_t q)  { return (float)q / TSDB_SCALE[k]; }
+
+/* ═══════════════════════════════════════════
+   BLOCK CODEC
+   ═══════════════════════════════════════════ */
+
+void tsdbQuantise(TsdbSample& s) {
+  for (uint8_t k = 0; k < TSDB_SERIES; k++)
+    s.v[k] = roundf(s.v[k] * TSDB_SCALE[k]) / TSDB_SCALE[k];
+}
+
+void tsdbEncBegin(TsdbEncoder& e, uint8_t* buf, size_t len) {
+  e.buf     = buf;
+  e.capBits = len * 8;
+  e.bitPos  = 0;
+  memset(&e.p, 0, sizeof(e.p));
+}
+
+/* Rice parameter from the running mean of u: k = ⌊log2 mean⌋ */
+static uint8_t riceK(int32_t mean) {
+  uint8_t k = 0;
+  while (k < TSDB_RICE_MAX_K && (16 << (k + 1)) <= mean) k++;
+  return k;
+}
+
+/* Same integer update on both sides – the decoder tracks k exactly */
+static void updateMean(int32_t& mean, uint32_t u) {
+  int32_t x = (int32_t)(u < 0xFFFF ? u : 0xFFFF) << 4;
+  mean += (x - mean) / 8;
+}
+
+static void putValue(TsdbEncoder& e, uint8_t k, int32_t q) {
+  int32_t  d = (int32_t)((uint32_t)q - (uint32_t)e.p.q[k]);
+  uint32_t u = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);     // zig-zag: 0, -1, 1, -2 …
+  uint8_t  r = riceK(e.p.mean[k]);
+  uint32_t n = u >> r;
+
+  if (n < TSDB_RICE_ESCAPE) {
+    putBits(e, ((1u << n) - 1) << 1, n + 1);
+    if (r) putBits(e, u & ((1u << r) - 1), r);
+  } else {
+    putBits(e, (1u << TSDB_RICE_ESCAPE) - 1, TSDB_RICE_ESCAPE);
+    putBits(e, u, 32);
+  }
+  updateMean(e.p.mean[k], u);
+  e.p.q[k] = q;
+}
+
+bool tsdbEncAppend(TsdbEncoder& e, const TsdbSample& s) {
+  if (e.bitPos + TSDB_MAX_SAMPLE_BITS > e.capBits) return false;
+
+  if (e.p.count == 0) {
+    putBits(e, s.t, 32);
+    for (uint8_t k = 0; k < TSDB_SERIES; k++) {
+      e.p.q[k]    = toSteps(k, s.v[k]);
+      e.p.mean[k] = TSDB_MEAN_INIT;
+      putBits(e, (uint32_t)e.p.q[k], 32);
+    }
+  } else {
+    int32_t delta = (int32_t)(s.t - e.p.t);
+    int32_t dod   = delta - e.p.delta;
+    e.p.delta     = delta;
+    if (dod == 0)                         putBits(e, 0, 1);
+    else if (dod >= -64   && dod < 64)    { putBits(e, 0b10,   2); putBits(e, (uint32_t)dod & 0x7F,  7); }
+    else if (dod >= -256  && dod < 256)   { putBits(e, 0b110,  3); putBits(e, (uint32_t)dod & 0x1FF, 9); }
+    else if (dod >= -2048 && dod < 2048)  { putBits(e, 0b1110, 4); putBits(e, (uint32_t)dod & 0xFFF, 12); }
+    else                                  { putBits(e, 0b1111, 4); putBits(e, (uint32_t)dod, 32); }
+    for (uint8_t k = 0; k < TSDB_SERIES; k++) putValue(e, k, toSteps(k, s.v[k]));
+  }
+  e.p.t = s.t;
+  e.p.count++;
+  return true;
+}
+
+void tsdbDecBegin(TsdbDecoder& d, const uint8_t* buf, size_t len, uint16_t count) {
+  d.buf       = buf;
+  d.capBits   = len * 8;
+  d.bitPos    = 0;
+  d.remaining = count;
+  memset(&d.p, 0, sizeof(d.p));
+}
+
+static int32_t signExtend(uint32_t v, uint8_t n) {
+  return (int32_t)(v << (32 - n)) >> (32 - n);
+}
+
+bool tsdbDecNext(TsdbDecoder& d, TsdbSample& s) {
+  if (d.remaining == 0 || d.bitPos >= d.capBits) return false;
+  d.remaining--;
+
+  if (d.p.count == 0) {
+    d.p.t = getBits(d, 32);
+    for (uint8_t k = 0; k < TSDB_SERIES; k++) {
+      d.p.q[k]    = (int32_t)getBits(d, 32);
+      d.p.mean[k] = TSDB_MEAN_INIT;
+    }
+  } else {
+    int32_t dod;
+    if      (getBits(d, 1) == 0) dod = 0;
+    else if (getBits(d, 1) == 0) dod = signExtend(getBits(d, 7),  7);
+    else if (getBits(d, 1) == 0) dod = signExtend(getBits(d, 9),  9);
+    else if (getBits(d, 1) == 0) dod = signExtend(getBits(d, 12), 12);
+    else                         dod = (int32_t)getBits(d, 32);
+    d.p.delta += dod;
+    d.p.t     += d.p.delta;
+
+    for (uint8_t k = 0; k < TSDB_SERIES; k++) {
+      uint8_t  r = riceK(d.p.mean[k]);
+      uint32_t n = 0;
+      while (n < TSDB_RICE_ESCAPE && getBits(d, 1)) n++;
+      uint32_t u = n < TSDB_RICE_ESCAPE ? (n << r) | (r ? getBits(d, r) : 0) : getBits(d, 32);
+      int32_t  delta = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+      d.p.q[k] = (int32_t)((uint32_t)d.p.q[k] + (uint32_t)delta);
+      updateMean(d.p.mean[k], u);
+    }
+  }
+  d.p.count++;
+
+  s.t = d.p.t;
+  for (uint8_t k = 0; k < TSDB_SERIES; k++) s.v[k] = fromSteps(k, d.p.q[k]);
+  return true;
+}
+
+/* ═══════════════════════════════════════════
+   FLASH FORMAT
+   ═══════════════════════════════════════════ */
+
+struct TsdbHeader {
+  /* written when the block is opened */
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t tFirst;
+  uint32_t openCrc;                  // crc16 over the three above
+  /* written when sealed (0xFF until then) */
+  uint32_t tLast;
+  uint16_t count;
+  uint16_t sealCrc;                  // crc16 over tLast + count
+  /* sample count after each flush, 0xFFFF = unused */
+  uint16_t commits[TSDB_COMMITS];
+  uint8_t  reserved[8];
+};
+static_assert(sizeof(TsdbHeader) == TSDB_HDR_SIZE, "TsdbHeader layout");
+
+static uint16_t openCrc(const TsdbHeader& h) {
+  return crc16Ccitt((const uint8_t*)&h, offsetof(TsdbHeader, openCrc));
+}
+static uint16_t sealCrc(const TsdbHeader& h) {
+  return crc16Ccitt((const uint8_t*)&h.tLast, sizeof(h.tLast) + sizeof(h.count));
+}
+static bool headerOpen(const TsdbHeader& h) {
+  return h.magic == TSDB_MAGIC && h.openCrc == openCrc(h);
+}
+static bool headerSealed(const TsdbHeader& h) {
+  return h.count != 0xFFFF && h.sealCrc == sealCrc(h);
+}
+static uint16_t lastCommit(const TsdbHeader& h) {
+  uint16_t c = 0;
+  for (uint8_t i = 0; i < TSDB_COMMITS && h.commits[i] != 0xFFFF; i++) c = h.commits[i];
+  return c;
+}
+
+/* ═══════════════════════════════════════════
+   STORE STATE
+   ═══════════════════════════════════════════ */
+
+static const esp_partition_t* part = nullptr;
+
+static bool        haveBlocks = false;   // newestSeq valid
+static uint32_t    newestSeq  = 0;
+static bool        curOpen    = false;   // newestSeq is being appended to
+static uint8_t     curBuf[TSDB_DATA_BYTES];
+static TsdbEncoder enc;
+static uint32_t    flushedBytes = 0;     // bytes of curBuf already in flash (excl. partial)
+static uint8_t     commitsUsed  = 0;
+static uint16_t    committed    = 0;     // sample count of the last commit
+static uint32_t    curFirstT    = 0;
+
+static uint8_t     readBuf[TSDB_DATA_BYTES];   // query / resume scratch
+
+static uint32_t    lastT     = 0;        // newest sample, monotonic
+static uint32_t    clockBase = 0;        // device clock = clockBase + uptime s
+
+static float         acc[TSDB_SERIES];
+static uint16_t      accN       = 0;
+static unsigned long windowMs   = 0;
+static unsigned long lastFlushMs = 0;
+
+static TsdbStats stats = {};
+
+static size_t blockBase(uint32_t seq) {
+  return (size_t)(seq % stats.blocks) * TSDB_BLOCK_SIZE;
+}
+
+static bool readHeader(uint32_t seq, TsdbHeader& h) {
+  return esp_partition_read(part, blockBase(seq), &h, sizeof(h)) == ESP_OK &&
+         headerOpen(h) && h.seq == seq;
+}
+
+static bool flashWrite(size_t off, const void* data, size_t len) {
+  if (esp_partition_write(part, off, data, len) == ESP_OK) return true;
+  stats.flashErrors++;
+  return false;
+}
+
+/* ═══════════════════════════════════════════
+   BLOCK LIFECYCLE
+   ═══════════════════════════════════════════ */
+
+/* Data bytes up to the encoder position, then the commit count.
+   The trailing partial byte is re-written next time: NOR flash
+   only clears bits and the unused bits are still 1.             */
+static void flushBlock() {
+  if (!curOpen || commitsUsed >= TSDB_COMMITS || enc.p.count == committed) return;
+
+  size_t end = (enc.bitPos + 7) / 8;
+  size_t base = blockBase(newestSeq);
+  if (end > flushedBytes &&
+      !flashWrite(base + TSDB_HDR_SIZE + flushedBytes, &curBuf[flushedBytes], end - flushedBytes))
+    return;
+  flushedBytes = enc.bitPos / 8;
+
+  uint16_t count = enc.p.count;
+  if (!flashWrite(base + offsetof(TsdbHeader, commits) + commitsUsed * 2, &count, 2)) return;
+  committed = count;
+  commitsUsed++;
+  stats.flushes++;
+}
+
+static void sealBlock() {
+  if (!curOpen) return;
+  flushBlock();
+
+  TsdbHeader h;
+  h.tLast   = enc.p.t;
+  h.count   = enc.p.count;
+  h.sealCrc = sealCrc(h);
+  flashWrite(blockBase(newestSeq) + offsetof(TsdbHeader, tLast), &h.tLast, 8);
+  curOpen = false;
+}
+
+static bool openBlock(uint32_t t) {
+  uint32_t seq = haveBlocks ? newestSeq + 1 : 0;
+  size_t base  = blockBase(seq);
+
+  TsdbHeader old;
+  bool recycled = esp_partition_read(part, base, &old, sizeof(old)) == ESP_OK && headerOpen(old);
+
+  if (esp_partition_erase_range(part, base, TSDB_BLOCK_SIZE) != ESP_OK) {
+    stats.flashErrors++;
+    return false;
+  }
+  TsdbHeader h;
+  h.magic   = TSDB_MAGIC;
+  h.seq     = seq;
+  h.tFirst  = t;
+  h.openCrc = openCrc(h);
+  if (!flashWrite(base, &h, offsetof(TsdbHeader, tLast))) return false;
+
+  if (!recycled) stats.blocksUsed++;
+  newestSeq    = seq;
+  haveBlocks   = true;
+  curOpen      = true;
+  curFirstT    = t;
+  flushedBytes = 0;
+  commitsUsed  = 0;
+  committed    = 0;
+  memset(curBuf, 0xFF, sizeof(curBuf));
+  tsdbEncBegin(enc, curBuf, sizeof(curBuf));
+  return true;
+}
+
+/* Rebuild the encoder from an unsealed block's committed samples.
+   Anything written past the last commit (power lost mid-flush)
+   cannot be overwritten, so such a block is sealed instead.      */
+static void resumeBlock(const TsdbHeader& h) {
+  uint16_t count = lastCommit(h);
+  if (esp_partition_read(part, blockBase(h.seq) + TSDB_HDR_SIZE, curBuf, sizeof(curBuf)) != ESP_OK) {
+    stats.flashErrors++;
+    return;
+  }
+
+  TsdbDecoder d;
+  TsdbSample  s;
+  tsdbDecBegin(d, curBuf, sizeof(curBuf), count);
+  while (tsdbDecNext(d, s)) {}
+
+  bool clean = (d.bitPos & 7) == 0 ||
+               (uint8_t)(curBuf[d.bitPos >> 3] | (0xFF << (8 - (d.bitPos & 7)))) == 0xFF;
+  for (size_t i = (d.bitPos + 7) / 8; clean && i < sizeof(curBuf); i++)
+    clean = curBuf[i] == 0xFF;
+
+  curOpen      = true;
+  curFirstT    = h.tFirst;
+  enc.buf      = curBuf;
+  enc.capBits  = sizeof(curBuf) * 8;
+  enc.bitPos   = d.bitPos;
+  enc.p        = d.p;
+  flushedBytes = d.bitPos / 8;
+  committed    = count;
+  commitsUsed  = 0;
+  while (commitsUsed < TSDB_COMMITS && h.commits[commitsUsed] != 0xFFFF) commitsUsed++;
+  if (count) lastT = d.p.t;
+
+  if (!clean || commitsUsed == TSDB_COMMITS) {
+    LOGW("TSDB", "Block %lu sealed at %u samples", (unsigned long)h.seq, count);
+    sealBlock();
+  }
+}
+
+/* ═══════════════════════════════════════════
+   API
+   ═══════════════════════════════════════════ */
+
+uint32_t tsdbNow() {
+  uint32_t wall = (uint32_t)time(nullptr);
+  uint32_t t    = wall >= TSDB_WALL_CLOCK_MIN ? wall : clockBase + millis() / 1000;
+  return t > lastT ? t : lastT;
+}
+
+void tsdbInit() {
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                  (esp_partition_subtype_t)TSDB_PART_SUBTYPE, "tsdb");
+  if (!part || part->size < 2 * TSDB_BLOCK_SIZE) {
+    LOGW("TSDB", "No 'tsdb' partition – history disabled");
+    part = nullptr;
+    return;
+  }
+  stats.flashReady = true;
+  stats.blocks     = part->size / TSDB_BLOCK_SIZE;
+
+  TsdbHeader newest;
+  for (uint16_t i = 0; i < stats.blocks; i++) {
+    TsdbHeader h;
+    if (esp_partition_read(part, (size_t)i * TSDB_BLOCK_SIZE, &h, sizeof(h)) != ESP_OK ||
+        !headerOpen(h) || h.seq % stats.blocks != i)
+      continue;
+    stats.blocksUsed++;
+    if (!haveBlocks || h.seq > newestSeq) {
+      newestSeq  = h.seq;
+      newest     = h;
+      haveBlocks = true;
+    }
+  }
+
+  if (haveBlocks) {
+    if (headerSealed(newest)) lastT = newest.tLast;
+    else                      resumeBlock(newest);
+  }
+  clockBase = lastT + 1;
+  windowMs  = lastFlushMs = millis();
+
+  LOGI("TSDB", "Initialized – %u/%u blocks, newest t=%lu%s",
+       stats.blocksUsed, stats.blocks, (unsigned long)lastT, curOpen ? " (resumed)" : "");
+}
+
+void tsdbUpdate(float packVoltage, float current, float temperature, float soc) {
+  if (!part) return;
+
+  acc[0] += packVoltage;
+  acc[1] += current;
+  acc[2] += temperature;
+  acc[3] += soc;
+  accN++;
+
+  unsigned long now = millis();
+  if (now - windowMs >= TSDB_INTERVAL_MS) {
+    windowMs = now;
+
+    TsdbSample s;
+    s.t = tsdbNow();
+    for (uint8_t k = 0; k < TSDB_SERIES; k++) {
+      s.v[k] = acc[k] / accN;
+      acc[k] = 0.0f;
+    }
+    accN = 0;
+    tsdbQuantise(s);
+
+    if (!curOpen && !openBlock(s.t)) return;
+    uint32_t before = enc.bitPos;
+    if (!tsdbEncAppend(enc, s)) {
+      sealBlock();
+      if (!openBlock(s.t)) return;
+      before = 0;
+      tsdbEncAppend(enc, s);
+    }
+    lastT = s.t;
+    stats.samples++;
+    stats.bits += enc.bitPos - before;
+  }
+
+  if (now - lastFlushMs >= TSDB_FLUSH_MS) {
+    lastFlushMs = now;
+    flushBlock();
+    if (commitsUsed == TSDB_COMMITS) sealBlock();
+  }
+}
+
+void tsdbFlush() {
+  if (!part) return;
+  lastFlushMs = millis();
+  flushBlock();
+  if (commitsUsed == TSDB_COMMITS) sealBlock();
+}
+
+uint32_t tsdbQuery(uint32_t from, uint32_t to, TsdbVisitor fn, void* ctx) {
+  if (!part || !haveBlocks) return 0;
+
+  uint32_t visited = 0;
+  uint32_t span    = newestSeq + 1 < stats.blocks ? newestSeq + 1 : stats.blocks;
+  for (uint32_t seq = newestSeq + 1 - span; seq <= newestSeq; seq++) {
+    const uint8_t* data;
+    uint16_t       count;
+    uint32_t       tFirst, tLast;
+
+    if (curOpen && seq == newestSeq) {
+      data = curBuf;  count = enc.p.count;  tFirst = curFirstT;  tLast = lastT;
+    } else {
+      TsdbHeader h;
+      if (!readHeader(seq, h)) continue;
+      count  = headerSealed(h) ? h.count : lastCommit(h);
+      tFirst = h.tFirst;
+      tLast  = headerSealed(h) ? h.tLast : UINT32_MAX;
+      if (tLast < from || tFirst > to || count == 0) continue;
+      if (esp_partition_read(part, blockBase(seq) + TSDB_HDR_SIZE, readBuf, sizeof(readBuf)) != ESP_OK) {
+        stats.flashErrors++;
+        continue;
+      }
+      data = readBuf;
+    }
+    if (tLast < from || tFirst > to) continue;
+
+    TsdbDecoder d;
+    TsdbSample  s;
+    tsdbDecBegin(d, data, TSDB_DATA_BYTES, count);
+    while (tsdbDecNext(d, s)) {
+      if (s.t < from) continue;
+      if (s.t > to) return visited;
+      visited++;
+      if (!fn(s, ctx)) return visited;
+    }
+  }
+  return visited;
+}
+
+TsdbStats tsdbGetStats() {
+  stats.newestT = lastT;
+  stats.oldestT = 0;
+  if (part && haveBlocks) {
+    uint32_t span = newestSeq + 1 < stats.blocks ? newestSeq + 1 : stats.blocks;
+    TsdbHeader h;
+    for (uint32_t seq = newestSeq + 1 - span; seq <= newestSeq; seq++)
+      if (readHeader(seq, h)) { stats.oldestT = h.tFirst; break; }
+  }
+  return stats;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  On-flash Time-series History  (delta + adaptive Rice codes)
+ *  V / I / T / SOC, averaged over TSDB_INTERVAL_MS, go into 4 KB
+ *  blocks on the "tsdb" flash partition (partitions.csv):
+ *    • timestamp – delta-of-delta, 1 bit for a steady cadence
+ *    • values    – rounded to a power-of-two step near the sensor
+ *                  resolution (≈1 mV, 8 mA, 0.06 °C, 0.01 %); the
+ *                  change in steps is Rice-coded with a parameter
+ *                  that follows each series' recent noise (1 bit
+ *                  if unchanged and quiet)
+ *  About 12 bits a sample on bench.cpp's noisy 1 Hz trace, 13–14
+ *  with motor starts (test_tsdb): the 768 KB partition holds ≈5
+ *  days of 1 Hz history.
+ *
+ *  Blocks form a ring over the partition (every sector erased
+ *  once per lap – wear levelling for free).  Each block header
+ *  holds its first / last timestamp, so a range query skips
+ *  whole blocks without decoding them.  The open block is
+ *  written every TSDB_FLUSH_MS and resumed after a reboot.
+ *
+ *  Timestamps are seconds: wall clock once SNTP has set it,
+ *  otherwise a device clock continued from the newest stored
+ *  sample.  They never go backwards.
+ * ============================================================
+ */
+
+#define TSDB_SERIES  4
+
+struct TsdbSample {
+  uint32_t t;                // s
+  float    v[TSDB_SERIES];   // pack V, current A, temp °C, SOC %
+};
+
+/* ──────────────────────────────────────────────────────────
+   BLOCK CODEC  (RAM only – used by the store and bench.cpp)
+   ────────────────────────────────────────────────────────── */
+
+struct TsdbPredictor {
+  uint32_t t;
+  int32_t  delta;
+  int32_t  q[TSDB_SERIES];     // previous value, in storage steps
+  int32_t  mean[TSDB_SERIES];  // running mean of the coded |change|, ×16
+  uint16_t count;
+};
+
+struct TsdbEncoder {
+  uint8_t*      buf;         // pre-filled with 0xFF (erased flash)
+  uint32_t      capBits;
+  uint32_t      bitPos;
+  TsdbPredictor p;
+};
+
+struct TsdbDecoder {
+  const uint8_t* buf;
+  uint32_t       capBits;
+  uint32_t       bitPos;
+  uint16_t       remaining;
+  TsdbPredictor  p;
+};
+
+/** Round each value to the series' storage step. */
+void tsdbQuantise(TsdbSample& s);
+
+void tsdbEncBegin(TsdbEncoder& e, uint8_t* buf, size_t len);
+
+/**
+ * @param s  already tsdbQuantise()d – values are stored in steps
+ * @return false if the block cannot take another worst-case sample
+ */
+bool tsdbEncAppend(TsdbEncoder& e, const TsdbSample& s);
+
+void tsdbDecBegin(TsdbDecoder& d, const uint8_t* buf, size_t len, uint16_t count);
+bool tsdbDecNext(TsdbDecoder& d, TsdbSample& s);
+
+/* ──────────────────────────────────────────────────────────
+   STORE
+   ────────────────────────────────────────────────────────── */
+
+struct TsdbStats {
+  bool     flashReady;
+  uint16_t blocks;           // partition capacity
+  uint16_t blocksUsed;
+  uint32_t samples;          // appended since boot
+  uint32_t bits;             // encoded since boot
+  uint32_t flushes;
+  uint32_t flashErrors;
+  uint32_t oldestT;
+  uint32_t newestT;
+};
+
+/** Find the partition, index blocks, resume the open one. */
+void tsdbInit();
+
+/** Call every loop; averages and appends every TSDB_INTERVAL_MS. */
+void tsdbUpdate(float packVoltage, float current, float temperature, float soc);
+
+/** Commit buffered samples now (before deep sleep / restart). */
+void tsdbFlush();
+
+/**
+ * Visit every stored sample with from ≤ t ≤ to, oldest first.
+ * The visitor returns false to stop.
+ * @return samples visited
+ */
+typedef bool (*TsdbVisitor)(const TsdbSample& s, void* ctx);
+uint32_t tsdbQuery(uint32_t from, uint32_t to, TsdbVisitor fn, void* ctx);
+
+/** Current tsdb timestamp (s). */
+uint32_t tsdbNow();
+
+TsdbStats tsdbGetStats();
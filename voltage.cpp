@@ -1,6 +1,12 @@
 #include <Arduino.h>
 #include "voltage.h"
 #include "config.h"
+#include "logger.h"
+#include "bus_lock.h"
+
+#if ENABLE_PLANT_SIM
+  #include "plant_sim.h"
+#endif
 
 /* ================= Calibration ================= */
 
@@ -21,7 +27,9 @@ static bool initialized = false;
 static float readADCVoltage() {
   uint32_t sum = 0;
   for (int i = 0; i < ADC_SAMPLES; i++) {
+    busLock(BUS_ADC);                 // per conversion: the sampler interleaves
     sum += (uint32_t)analogRead(VOLTAGE_PACK_PIN);
+    busUnlock(BUS_ADC);
     delayMicroseconds(80);
   }
   float avg = (float)sum / (float)ADC_SAMPLES;
@@ -37,19 +45,34 @@ void initVoltage() {
   analogSetPinAttenuation(VOLTAGE_PACK_PIN, ADC_11db);   // 0–3.3 V range
 
   initialized = true;
-  Serial.println("[VOLTAGE] Initialized");
+  LOGI("VOLTAGE", "Initialized");
 }
 
 void calibrateVoltage() {
-  Serial.printf("[VOLTAGE] Divider=%.2f  Correction=%.4f\n",
-                VOLTAGE_DIVIDER, VOLTAGE_CORR);
+  LOGI("VOLTAGE", "Divider=%.2f  Correction=%.4f",
+       VOLTAGE_DIVIDER, VOLTAGE_CORR);
 }
 
 float readPackVoltage() {
   if (!initialized) initVoltage();
+#if ENABLE_PLANT_SIM
+  return plantSimPackVoltage();
+#endif
   return readADCVoltage() * VOLTAGE_DIVIDER * VOLTAGE_CORR;
 }
 
+float readPackVoltageFast() {
+  if (!initialized) initVoltage();
+#if ENABLE_PLANT_SIM
+  return plantSimPackVoltage();
+#endif
+  busLock(BUS_ADC);
+  int raw = analogRead(VOLTAGE_PACK_PIN);
+  busUnlock(BUS_ADC);
+  float adcV = ((float)raw / ADC_RESOLUTION) * ADC_VREF;
+  return adcV * VOLTAGE_DIVIDER * VOLTAGE_CORR;
+}
+
 float readVoltage() { return readPackVoltage(); }
 
 bool voltageSystemHealthy() {
@@ -57,6 +80,6 @@ bool voltageSystemHealthy() {
   bool  ok = (v >= (CELL_MIN_VOLTAGE * NUM_CELLS * 0.9f) &&
               v <= (CELL_MAX_VOLTAGE * NUM_CELLS * 1.1f));
   if (!ok)
-    Serial.printf("[VOLTAGE] Out of range: %.2f V\n", v);
+    LOGW("VOLTAGE", "Out of range: %.2f V", v);
   return ok;
 }
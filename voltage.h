@@ -19,6 +19,12 @@ void initVoltage();
  */
 float readPackVoltage();
 
+/**
+ * One ADC conversion, no averaging (~15 µs) – for the high-rate
+ * sampler; readPackVoltage() averages ADC_SAMPLES.
+ */
+float readPackVoltageFast();
+
 /**
  * Legacy alias
  */
@@ -2,35 +2,128 @@
 #include <HTTPClient.h>
 #include "wifi_cloud.h"
 #include "config.h"
+#include "logger.h"
+#include "loop_profiler.h"
+#include "charge.h"
+#if ENABLE_RANGE_ESTIMATOR
+  #include "range.h"
+#endif
+
+#if ENABLE_OFFLINE_QUEUE
+  #include "telemetry_queue.h"
+#endif
+
+#if ENABLE_MQTT
+  #include "mqtt_client.h"
+#endif
 
 static unsigned long uploadCount    = 0;
 static unsigned long lastUploadTime = 0;
+static char          bearerHeader[8 + 256];   // "Bearer <key>", built once
 
-/* ================= WiFi ================= */
+/* ================= JSON Format ================= */
 
-void wifiInit() {
-  Serial.println("[WIFI] Connecting...");
-  WiFi.mode(WIFI_STA);
-  WiFi.setSleep(false);
-  WiFi.begin(WIFI_SSID, WIFI_PASS);
+size_t formatTelemetryJson(const TelemetrySnapshot& s, char* buf, size_t bufSize) {
+  int n = snprintf(buf, bufSize,
+    "{"
+      "\"device_id\":\"%s\","
+      "\"device_uptime_ms\":%lu,"
+      "\"pack_voltage\":%.2f,"
+      "\"current\":%.2f,"
+      "\"power\":%.2f,"
+      "\"temp_pack\":%.2f,"
+      "\"soc\":%.1f,"
+      "\"soh\":%.2f,"
+      "\"rul_cycles\":%d,"
+      "\"fault\":%s,"
+      "\"fault_message\":\"%s\","
+      "\"latitude\":%.6f,"
+      "\"longitude\":%.6f,"
+      "\"impact_count\":%u,"
+      "\"shock_count\":%u,"
+      "\"connection_quality\":%u,"
+      "\"is_charging\":%s,"
+      "\"is_discharging\":%s,"
+      "\"charger_relay_on\":%s,"
+      "\"motor_load_on\":%s,"
+      "\"fan_on\":%s,"
+      "\"cooling_active\":%s,"
+      "\"loop_p50_us\":%lu,"
+      "\"loop_p99_us\":%lu,"
+      "\"loop_max_us\":%lu,"
+      "\"loop_deadline_miss\":%lu,"
+      "\"wh_per_km\":%.1f,"
+      "\"range_km\":%.1f,"
+      "\"range_lo_km\":%.1f,"
+      "\"range_hi_km\":%.1f,"
+      "\"charge_phase\":\"%s\","
+      "\"charge_eta_min\":%.0f"
+    "}",
+    DEVICE_ID,
+    (unsigned long)s.uptimeMs,
+    s.packVoltage,
+    s.current,
+    s.power,
+    s.tempPack,
+    s.soc,
+    s.soh,
+    (int)s.rulCycles,
+    s.fault ? "true" : "false",
+    s.faultMessage,
+    s.latitude,
+    s.longitude,
+    (unsigned int)s.impactCount,
+    (unsigned int)s.shockCount,
+    (unsigned int)s.connectionQuality,
+    s.chargingActive ? "true"  : "false",
+    s.chargingActive ? "false" : "true",
+    s.chargerRelay   ? "true"  : "false",
+    s.motorRelay     ? "true"  : "false",
+    s.fanActive      ? "true"  : "false",
+    s.fanActive      ? "true"  : "false",
+    (unsigned long)s.loopP50Us,
+    (unsigned long)s.loopP99Us,
+    (unsigned long)s.loopMaxUs,
+    (unsigned long)s.loopDeadlineMiss,
+    s.whPerKm,
+    s.rangeKm,
+    s.rangeLoKm,
+    s.rangeHiKm,
+    chargePhaseName((ChargePhase)s.chargePhase),
+    s.chargeEtaMin
+  );
+
+  if (n < 0 || (size_t)n >= bufSize) return 0;
+  return (size_t)n;
 }
 
-void wifiEnsure() {
-  static unsigned long lastCheck = 0;
-  if (millis() - lastCheck < 5000) return;
-  lastCheck = millis();
+/* ================= Cloud Upload ================= */
 
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("[WIFI] Reconnecting...");
-    WiFi.disconnect(true);
-    delay(100);
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
-  }
+static int cloudPost(const char* url, const char* contentType,
+                     const uint8_t* body, size_t len) {
+  if (!bearerHeader[0])
+    snprintf(bearerHeader, sizeof(bearerHeader), "Bearer %s", SUPABASE_KEY);
+
+  HTTPClient http;
+  http.setTimeout(8000);
+  http.begin(url);
+  http.addHeader("Content-Type",  contentType);
+  http.addHeader("apikey",        SUPABASE_KEY);
+  http.addHeader("Authorization", bearerHeader);
+  http.addHeader("Prefer",        "return=minimal");
+
+  int code = http.POST((uint8_t*)body, len);
+  http.end();
+  return code;
 }
 
-bool wifiConnected() { return WiFi.status() == WL_CONNECTED; }
+int cloudPostJson(const char* body, size_t len) {
+  return cloudPost(SUPABASE_URL, "application/json", (const uint8_t*)body, len);
+}
 
-/* ================= Cloud Upload ================= */
+int cloudPostCbor(const uint8_t* body, size_t len) {
+  return cloudPost(CBOR_INGEST_URL, "application/cbor", body, len);
+}
 
 void uploadComprehensiveTelemetry(
   float       packVoltage,
@@ -52,84 +145,106 @@ void uploadComprehensiveTelemetry(
   bool        motorRelay
 ) {
   if ((millis() - lastUploadTime) < CLOUD_UPLOAD_INTERVAL_MS) return;
+#if !ENABLE_OFFLINE_QUEUE
   if (!wifiConnected()) {
-    Serial.println("[CLOUD] WiFi not connected – skipping upload");
+    LOGD("CLOUD", "WiFi not connected – skipping upload");
     return;
   }
+#endif
 
-  HTTPClient http;
-  http.setTimeout(8000);
-  http.begin(SUPABASE_URL);
-  http.addHeader("Content-Type",  "application/json");
-  http.addHeader("apikey",        SUPABASE_KEY);
-  http.addHeader("Authorization", String("Bearer ") + SUPABASE_KEY);
-  http.addHeader("Prefer",        "return=minimal");
+  TelemetrySnapshot snap;
+  snap.uptimeMs          = millis();
+  snap.packVoltage       = packVoltage;
+  snap.current           = current;
+  snap.power             = power;
+  snap.tempPack          = tempPack;
+  snap.soc               = soc;
+  snap.soh               = soh;
+  snap.rulCycles         = rulCycles;
+  snap.fault             = fault;
+  strncpy(snap.faultMessage, faultMessage ? faultMessage : "",
+          sizeof(snap.faultMessage) - 1);
+  snap.faultMessage[sizeof(snap.faultMessage) - 1] = '\0';
+  snap.latitude          = latitude;
+  snap.longitude         = longitude;
+  snap.impactCount       = impactCount;
+  snap.shockCount        = shockCount;
+  snap.connectionQuality = getConnectionQuality();
+  snap.chargingActive    = chargingActive;
+  snap.fanActive         = fanActive;
+  snap.chargerRelay      = chargerRelay;
+  snap.motorRelay        = motorRelay;
+
+  StageStats loopStats  = profilerGetStats(STAGE_LOOP_TOTAL);
+  snap.loopP50Us        = loopStats.p50Us;
+  snap.loopP99Us        = loopStats.p99Us;
+  snap.loopMaxUs        = loopStats.maxUs;
+  snap.loopDeadlineMiss = profilerDeadlineMisses();
+
+#if ENABLE_RANGE_ESTIMATOR
+  RangeEstimate range = rangeGetEstimate();
+  snap.whPerKm   = range.whPerKm;
+  snap.rangeKm   = range.rangeKm;
+  snap.rangeLoKm = range.rangeLoKm;
+  snap.rangeHiKm = range.rangeHiKm;
+#else
+  snap.whPerKm = snap.rangeKm = snap.rangeLoKm = snap.rangeHiKm = 0.0f;
+#endif
+
+#if ENABLE_CHARGE_CONTROL
+  ChargeStatus charge = chargeGetStatus();
+  snap.chargePhase  = charge.phase;
+  snap.chargeEtaMin = charge.etaMin;
+#else
+  snap.chargePhase  = CHG_IDLE;
+  snap.chargeEtaMin = -1.0f;
+#endif
+
+#if ENABLE_MQTT
+  /* Broker session up: one PUBLISH instead of a full HTTP request */
+  if (mqttPublishTelemetry(snap)) {
+    uploadCount++;
+    lastUploadTime = millis();
+    LOGD("CLOUD", "Published #%lu over MQTT", uploadCount);
+    return;
+  }
+#endif
+
+#if ENABLE_OFFLINE_QUEUE
+  /* Offline: store for replay instead of dropping the sample */
+  if (!wifiConnected()) {
+    telemetryQueuePush(snap);
+    lastUploadTime = millis();
+    return;
+  }
+#endif
 
   char body[1024];
-  snprintf(body, sizeof(body),
-    "{"
-      "\"device_id\":\"%s\","
-      "\"device_uptime_ms\":%lu,"
-      "\"pack_voltage\":%.2f,"
-      "\"current\":%.2f,"
-      "\"power\":%.2f,"
-      "\"temp_pack\":%.2f,"
-      "\"soc\":%.1f,"
-      "\"soh\":%.2f,"
-      "\"rul_cycles\":%d,"
-      "\"fault\":%s,"
-      "\"fault_message\":\"%s\","
-      "\"latitude\":%.6f,"
-      "\"longitude\":%.6f,"
-      "\"impact_count\":%u,"
-      "\"shock_count\":%u,"
-      "\"connection_quality\":%u,"
-      "\"is_charging\":%s,"
-      "\"is_discharging\":%s,"
-      "\"charger_relay_on\":%s,"
-      "\"motor_load_on\":%s,"
-      "\"fan_on\":%s,"
-      "\"cooling_active\":%s"
-    "}",
-    DEVICE_ID,
-    millis(),
-    packVoltage,
-    current,
-    power,
-    tempPack,
-    soc,
-    soh,
-    rulCycles,
-    fault ? "true" : "false",
-    faultMessage ? faultMessage : "",
-    latitude,
-    longitude,
-    (unsigned int)impactCount,
-    (unsigned int)shockCount,
-    (unsigned int)getConnectionQuality(),
-    chargingActive ? "true"  : "false",
-    chargingActive ? "false" : "true",
-    chargerRelay   ? "true"  : "false",
-    motorRelay     ? "true"  : "false",
-    fanActive      ? "true"  : "false",
-    fanActive      ? "true"  : "false"
-  );
+  size_t len = formatTelemetryJson(snap, body, sizeof(body));
+  if (len == 0) {
+    LOGE("CLOUD", "Telemetry JSON overflow – sample not sent");
+    return;
+  }
 
-  int code = http.POST((uint8_t*)body, strlen(body));
-  http.end();
+  int code = cloudPostJson(body, len);
 
   if (code >= 200 && code < 300) {
     uploadCount++;
     lastUploadTime = millis();
-    Serial.printf("[CLOUD] Uploaded #%lu\n", uploadCount);
+    LOGI("CLOUD", "Uploaded #%lu", uploadCount);
   } else {
-    Serial.printf("[CLOUD] Upload failed (HTTP %d)\n", code);
+    LOGW("CLOUD", "Upload failed (HTTP %d)", code);
+#if ENABLE_OFFLINE_QUEUE
+    telemetryQueuePush(snap);
+    lastUploadTime = millis();
+#endif
   }
 }
 
 /* ================= Status ================= */
 
-unsigned long getUploadCount() { return uploadCount; }
+unsigned long getUploadCount()    { return uploadCount;    }
+unsigned long getLastUploadTime() { return lastUploadTime; }
 
 uint8_t getConnectionQuality() {
   if (!wifiConnected()) return 0;
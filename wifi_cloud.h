@@ -1,14 +1,63 @@
 #pragma once
 #include <Arduino.h>
+#include "wifi_manager.h"
 
-/* ================= WiFi ================= */
+/* ================= Telemetry Snapshot ================= */
 
-void wifiInit();
-void wifiEnsure();
-bool wifiConnected();
+/**
+ * One cloud telemetry sample – everything the upload payload carries,
+ * captured at a single instant so it can be formatted (or later queued)
+ * independently of the live globals.
+ */
+struct TelemetrySnapshot {
+  uint32_t uptimeMs;
+  float    packVoltage;
+  float    current;
+  float    power;
+  float    tempPack;
+  float    soc;
+  float    soh;
+  int32_t  rulCycles;
+  bool     fault;
+  char     faultMessage[64];   // as FaultState::faultMessage
+  float    latitude;
+  float    longitude;
+  uint32_t impactCount;
+  uint32_t shockCount;
+  uint8_t  connectionQuality;
+  bool     chargingActive;
+  bool     fanActive;
+  bool     chargerRelay;
+  bool     motorRelay;
+  uint32_t loopP50Us;
+  uint32_t loopP99Us;
+  uint32_t loopMaxUs;
+  uint32_t loopDeadlineMiss;
+  float    whPerKm;            // 0 without ENABLE_RANGE_ESTIMATOR
+  float    rangeKm;
+  float    rangeLoKm;
+  float    rangeHiKm;
+  uint8_t  chargePhase;        // ChargePhase (charge.h), IDLE without ENABLE_CHARGE_CONTROL
+  float    chargeEtaMin;       // minutes to full, < 0 = unknown
+};
+
+/**
+ * Render a snapshot as the Supabase JSON row.
+ * @return Length written (excluding NUL), or 0 if the buffer was too small.
+ */
+size_t formatTelemetryJson(const TelemetrySnapshot& s, char* buf, size_t bufSize);
 
 /* ================= Cloud Upload ================= */
 
+/**
+ * POST a JSON row or array of rows to the Supabase table.
+ * @return HTTP status code (negative on transport error)
+ */
+int cloudPostJson(const char* body, size_t len);
+
+/** POST a CBOR batch (telemetry_codec.h) to CBOR_INGEST_URL. */
+int cloudPostCbor(const uint8_t* body, size_t len);
+
 void uploadComprehensiveTelemetry(
   float packVoltage,
   float current,
@@ -32,4 +81,5 @@ void uploadComprehensiveTelemetry(
 /* ================= Status ================= */
 
 unsigned long getUploadCount();
+unsigned long getLastUploadTime();   // last live upload or offline enqueue
 uint8_t getConnectionQuality();
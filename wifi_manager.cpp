@@ -0,0 +1,229 @@
+#include <WiFi.h>
+#include <Preferences.h>
+#include "wifi_manager.h"
+#include "config.h"
+#include "logger.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+/* ================= Event hand-off (WiFi event task → loop) ================= */
+
+#define EV_CONNECTED     (1u << 0)
+#define EV_GOT_IP        (1u << 1)
+#define EV_DISCONNECTED  (1u << 2)
+
+#define LINK_UP_BIT      (1u << 0)
+
+static std::atomic<uint32_t> evFlags{0};
+static volatile uint8_t      evReason  = 0;
+static uint8_t               evBssid[6];
+static volatile uint8_t      evChannel = 0;
+
+static EventGroupHandle_t    linkGroup = nullptr;
+
+static void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+      memcpy(evBssid, info.wifi_sta_connected.bssid, sizeof(evBssid));
+      evChannel = info.wifi_sta_connected.channel;
+      evFlags.fetch_or(EV_CONNECTED, std::memory_order_release);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      xEventGroupSetBits(linkGroup, LINK_UP_BIT);
+      evFlags.fetch_or(EV_GOT_IP, std::memory_order_release);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      xEventGroupClearBits(linkGroup, LINK_UP_BIT);
+      evReason = info.wifi_sta_disconnected.reason;
+      evFlags.fetch_or(EV_DISCONNECTED, std::memory_order_release);
+      break;
+    default:
+      break;
+  }
+}
+
+/* ================= State ================= */
+
+static Preferences prefs;
+
+static WifiStats     stats        = {};
+static uint32_t      linkEpoch    = 0;
+static unsigned long attemptMs    = 0;     // WiFi.begin() time
+static unsigned long upMs         = 0;     // GOT_IP time
+static unsigned long retryAtMs    = 0;
+static uint8_t       failStreak   = 0;
+static bool          fastAttempt  = false;
+static uint64_t      connectSumMs = 0;
+
+/* Last good AP, persisted so a reboot also reconnects without scanning */
+static uint8_t cachedBssid[6];
+static uint8_t cachedChannel = 0;          // 0 = no cache
+
+static void loadCache() {
+  prefs.begin("wifi", true);
+  if (prefs.getBytes("bssid", cachedBssid, sizeof(cachedBssid)) != sizeof(cachedBssid))
+    cachedChannel = 0;
+  else
+    cachedChannel = prefs.getUChar("chan", 0);
+  prefs.end();
+}
+
+static void storeCache(const uint8_t* bssid, uint8_t channel) {
+  if (channel == cachedChannel && memcmp(bssid, cachedBssid, sizeof(cachedBssid)) == 0)
+    return;                                  // unchanged – spare the flash
+  memcpy(cachedBssid, bssid, sizeof(cachedBssid));
+  cachedChannel = channel;
+  prefs.begin("wifi", false);
+  prefs.putBytes("bssid", cachedBssid, sizeof(cachedBssid));
+  prefs.putUChar("chan", cachedChannel);
+  prefs.end();
+}
+
+/* ================= Attempts ================= */
+
+static void beginAttempt() {
+  /* Use the cache only on the first try of a streak; a failed fast
+     attempt usually means the AP moved channel or was replaced. */
+  fastAttempt = (cachedChannel != 0 && failStreak == 0);
+
+  if (fastAttempt) {
+    WiFi.begin(WIFI_SSID, WIFI_PASS, cachedChannel, cachedBssid, true);
+    LOGI("WIFI", "Connecting (cached ch %u %02X:%02X:%02X:%02X:%02X:%02X)...",
+         cachedChannel, cachedBssid[0], cachedBssid[1], cachedBssid[2],
+         cachedBssid[3], cachedBssid[4], cachedBssid[5]);
+  } else {
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    LOGI("WIFI", "Connecting (scan)...");
+  }
+
+  stats.attempts++;
+  stats.state = WifiState::CONNECTING;
+  attemptMs   = millis();
+}
+
+static void scheduleRetry() {
+  uint32_t backoff = WIFI_RETRY_BASE_MS << (failStreak < 8 ? failStreak : 8);
+  if (backoff > WIFI_RETRY_MAX_MS) backoff = WIFI_RETRY_MAX_MS;
+
+  /* ±25 % jitter */
+  int32_t jitter = (int32_t)(esp_random() % (backoff / 2 + 1)) - (int32_t)(backoff / 4);
+  backoff += jitter;
+
+  if (failStreak < 255) failStreak++;
+  retryAtMs   = millis() + backoff;
+  stats.state = WifiState::BACKOFF;
+  LOGD("WIFI", "Retry in %lu ms", (unsigned long)backoff);
+}
+
+static void linkUp() {
+  uint32_t took = millis() - attemptMs;
+
+  stats.connects++;
+  if (fastAttempt) stats.fastConnects++;
+  stats.lastConnectMs = took;
+  if (stats.minConnectMs == 0 || took < stats.minConnectMs) stats.minConnectMs = took;
+  if (took > stats.maxConnectMs)                            stats.maxConnectMs = took;
+  connectSumMs      += took;
+  stats.avgConnectMs = (uint32_t)(connectSumMs / stats.connects);
+
+  stats.state = WifiState::UP;
+  upMs        = millis();
+  failStreak  = 0;
+  linkEpoch++;
+  if (linkEpoch == 1) configTime(0, 0, NTP_SERVER);   // SNTP keeps itself running from here
+
+  LOGI("WIFI", "Connected in %lu ms (%s) RSSI %d",
+       (unsigned long)took, fastAttempt ? "fast" : "scan", (int)WiFi.RSSI());
+}
+
+static void linkDown(uint8_t reason) {
+  stats.lastReason = reason;
+  if (stats.state == WifiState::UP) {
+    stats.disconnects++;
+    stats.totalUpS += (millis() - upMs) / 1000;
+    LOGW("WIFI", "Link lost (reason %u)", reason);
+  } else {
+    stats.failures++;
+    LOGW("WIFI", "Connect failed (reason %u)", reason);
+  }
+  scheduleRetry();
+}
+
+/* ================= API ================= */
+
+void wifiInit() {
+  linkGroup = xEventGroupCreate();
+  loadCache();
+
+  WiFi.persistent(false);          // credentials live in config.h, not NVS
+  WiFi.setAutoReconnect(false);    // retry policy is ours
+  WiFi.onEvent(onWifiEvent);
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);
+
+  beginAttempt();
+}
+
+void wifiEnsure() {
+  uint32_t ev = evFlags.exchange(0, std::memory_order_acquire);
+  if (stats.state == WifiState::OFF) return;   // events from the shutdown itself
+
+  if (ev & EV_CONNECTED) storeCache(evBssid, evChannel);
+
+  /* A disconnect that follows GOT_IP in the same batch wins */
+  if ((ev & EV_GOT_IP) && stats.state == WifiState::CONNECTING) linkUp();
+  if ((ev & EV_DISCONNECTED) && stats.state != WifiState::BACKOFF) linkDown(evReason);
+
+  unsigned long now = millis();
+
+  if (stats.state == WifiState::CONNECTING &&
+      now - attemptMs >= WIFI_CONNECT_TIMEOUT_MS) {
+    stats.failures++;
+    LOGW("WIFI", "Connect timed out after %lu ms", now - attemptMs);
+    WiFi.disconnect();                       // its DISCONNECTED event lands in BACKOFF
+    scheduleRetry();
+  }
+
+  if (stats.state == WifiState::BACKOFF && (int32_t)(now - retryAtMs) >= 0)
+    beginAttempt();
+}
+
+void wifiSuspend() {
+  if (stats.state == WifiState::OFF) return;
+  if (stats.state == WifiState::UP) stats.totalUpS += (millis() - upMs) / 1000;
+  stats.state = WifiState::OFF;
+  if (linkGroup) xEventGroupClearBits(linkGroup, LINK_UP_BIT);
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  LOGI("WIFI", "Radio off");
+}
+
+void wifiResume() {
+  if (stats.state != WifiState::OFF) return;
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false);
+  failStreak = 0;                  // fast (cached) attempt first
+  beginAttempt();
+}
+
+/* Event-group bit, so it is current even before wifiEnsure() runs */
+bool wifiConnected() {
+  return linkGroup && (xEventGroupGetBits(linkGroup) & LINK_UP_BIT);
+}
+
+uint32_t wifiLinkEpoch() { return linkEpoch; }
+
+bool wifiWaitLinkUp(uint32_t timeoutMs) {
+  if (!linkGroup) return false;
+  return xEventGroupWaitBits(linkGroup, LINK_UP_BIT, pdFALSE, pdTRUE,
+                             pdMS_TO_TICKS(timeoutMs)) & LINK_UP_BIT;
+}
+
+WifiStats wifiGetStats() {
+  WifiStats s = stats;
+  s.upSinceMs   = (s.state == WifiState::UP)      ? millis() - upMs      : 0;
+  s.nextRetryMs = (s.state == WifiState::BACKOFF) ? retryAtMs - millis() : 0;
+  if (s.state == WifiState::UP) s.totalUpS += s.upSinceMs / 1000;
+  return s;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+
+/*
+ * ============================================================
+ *  WiFi Connection Manager
+ *  Driven by the WiFi driver events (CONNECTED / GOT_IP /
+ *  DISCONNECTED); wifiEnsure() only advances a small state
+ *  machine and never waits or delays.
+ *
+ *  Fast reconnect: the BSSID + channel of the last good link are
+ *  kept in NVS and passed to WiFi.begin(), which skips the full
+ *  channel scan.  If that attempt fails the next one scans.
+ *
+ *  Retries back off exponentially (WIFI_RETRY_BASE_MS …
+ *  WIFI_RETRY_MAX_MS) with ±25 % jitter so a fleet behind one AP
+ *  does not reconnect in lock-step.
+ *
+ *  Link-up signal: wifiConnected() for loop code, wifiLinkEpoch()
+ *  to notice a reconnect, wifiWaitLinkUp() for worker tasks.
+ * ============================================================
+ */
+
+enum class WifiState : uint8_t {
+  BACKOFF,       // waiting for the next attempt
+  CONNECTING,    // WiFi.begin() issued, no IP yet
+  UP,            // got IP
+  OFF            // radio stopped by wifiSuspend()
+};
+
+struct WifiStats {
+  WifiState state;
+  uint32_t  attempts;
+  uint32_t  connects;
+  uint32_t  fastConnects;      // via cached BSSID/channel
+  uint32_t  failures;          // attempts that timed out or were refused
+  uint32_t  disconnects;       // link lost after being up
+  uint8_t   lastReason;        // wifi_err_reason_t of the last disconnect
+  uint32_t  lastConnectMs;     // begin() → GOT_IP
+  uint32_t  minConnectMs;
+  uint32_t  maxConnectMs;
+  uint32_t  avgConnectMs;
+  uint32_t  upSinceMs;         // current link uptime (0 if down)
+  uint32_t  totalUpS;          // accumulated link uptime
+  uint32_t  nextRetryMs;       // 0 unless in BACKOFF
+};
+
+/** Register event handlers and start the first attempt. */
+void wifiInit();
+
+/** Call every loop: attempt timeouts, backoff, retries.  Non-blocking. */
+void wifiEnsure();
+
+/** Stop the radio (parking / light sleep) until wifiResume(). */
+void wifiSuspend();
+
+/** Restart the radio and connect immediately (cached BSSID first). */
+void wifiResume();
+
+/** Station has an IP address. */
+bool wifiConnected();
+
+/** Increments on every link-up; compare to detect a reconnect. */
+uint32_t wifiLinkEpoch();
+
+/**
+ * Block the calling task until the link is up or timeout.
+ * For worker tasks only – never call from loop().
+ */
+bool wifiWaitLinkUp(uint32_t timeoutMs);
+
+WifiStats wifiGetStats();